@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _OVERLAY_H_
+#define _OVERLAY_H_
+
+#include "utils/types.h"
+
+/*
+ * Overlays listed in src/overlays.lst are linked to run from DRAM and kept
+ * as LZ4 blocks at the end of the image. Their entry points are wrapped by
+ * stubs that call ovl_load() on first use. Once loaded, an overlay stays.
+ * The optional <name>_ovl_init() hook runs right after loading.
+ */
+typedef struct _ovl_t
+{
+	u8 *start;
+	u8 *end;
+	u8 *bss_end;
+	const u8 *blob;
+	const u8 *blob_end;
+	void (*init)();
+} ovl_t;
+
+extern u8 ovl_loaded[];
+
+void ovl_load(u32 id);
+
+#endif
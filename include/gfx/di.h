@@ -365,5 +365,9 @@ void display_backlight_brightness(u32 brightness, u32 step_delay);
 u32 *display_init_framebuffer();
 
 void set_active_framebuffer(u32 *address);
+/*! Line stride in pixels, applied by the next set_active_framebuffer(). */
+void set_framebuffer_stride(u32 stride);
+/*! Scrolls the window along its lines, see gfx_con_ring(). */
+void set_framebuffer_offset(u32 offset);
 
 #endif
@@ -33,6 +33,17 @@
 #define CHAR_WIDTH 15
 #define CHAR_HEIGHT 32
 
+#define GFX_DIRTY_MAX 8
+
+// Framebuffer rows and pixels within them, ends exclusive.
+typedef struct _gfx_rect_t
+{
+	u32 row0;
+	u32 col0;
+	u32 row1;
+	u32 col1;
+} gfx_rect_t;
+
 typedef struct _gfx_ctxt_t
 {
 	u32 *fb;
@@ -40,6 +51,14 @@ typedef struct _gfx_ctxt_t
 	u32 width;
 	u32 height;
 	u32 stride;
+	// Drawn into next since the last swap, gfx_swap_buffer() copies only these to the new back buffer.
+	gfx_rect_t dirty[GFX_DIRTY_MAX];
+	u32 dirty_num;
+	// Bytes covered by drawing and copied by the swap, this frame and the last one.
+	u32 draw_bytes;
+	u32 sync_bytes;
+	u32 last_draw_bytes;
+	u32 last_sync_bytes;
 } gfx_ctxt_t;
 
 typedef struct _gfx_con_t
@@ -54,6 +73,11 @@ typedef struct _gfx_con_t
 	int fillbg;
 	u32 bgcol;
 	bool mute;
+	// Ring mode, see gfx_con_ring().
+	bool ring;
+	u32 ring_len; // Console y wraps here.
+	u32 ring_top; // Console y shown at the top of the screen.
+	u32 ring_end; // The current line is cleared up to here.
 } gfx_con_t;
 
 typedef struct 
@@ -64,8 +88,22 @@ typedef struct
     u32 offset;
     u32 pos_x;
     u32 pos_y;
+    u32 bpp;
+    u32 row_size;
+    bool top_down;
 } bmp_data_t;
 
+#define GFX_SPLASH_MAGIC 0x50534244 // "DBSP"
+
+// Header of the splash files made by tools/splash.py, an LZ4 stream follows.
+typedef struct _gfx_splash_hdr_t
+{
+    u32 magic;
+    u16 stride; // The image is stored as whole framebuffer rows.
+    u16 rows;
+    u32 bg;     // Fills the rows the image does not cover.
+} gfx_splash_hdr_t;
+
 extern gfx_ctxt_t g_gfx_ctxt;
 extern gfx_con_t g_gfx_con;
 
@@ -85,12 +123,16 @@ void gfx_con_init(gfx_con_t *con, gfx_ctxt_t *ctxt);
 void gfx_con_setcol(gfx_con_t *con, u32 fgcol, int fillbg, u32 bgcol);
 void gfx_con_getpos(gfx_con_t *con, u32 *x, u32 *y);
 void gfx_con_setpos(gfx_con_t *con, u32 x, u32 y);
+int gfx_con_ring(gfx_con_t *con, bool enable);
 void gfx_putc(gfx_con_t *con, char c);
 void gfx_puts(gfx_con_t *con, const char *s);
 void gfx_printf(gfx_con_t *con, const char *fmt, ...);
 void gfx_hexdump(gfx_con_t *con, u32 base, const u8 *buf, u32 len);
 
 void gfx_set_pixel(gfx_ctxt_t *ctxt, u32 x, u32 y, u32 color);
+// Copies an ARGB rectangle in console orientation to the rotated framebuffer, buf_stride may be negative.
+void gfx_blit(gfx_ctxt_t *ctxt, const u32 *buf, int buf_stride, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y);
+void gfx_blit_transparent(gfx_ctxt_t *ctxt, const u32 *buf, int buf_stride, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y, u32 transparent_color);
 void gfx_line(gfx_ctxt_t *ctxt, int x0, int y0, int x1, int y1, u32 color);
 void gfx_put_small_sep(gfx_con_t *con);
 void gfx_put_big_sep(gfx_con_t *con);
@@ -103,5 +145,6 @@ void gfx_render_bmp_arg_bitmap(gfx_ctxt_t *ctxt, u8* bitmap, u32 x, u32 y, u32 w
 void gfx_render_bmp_arg_bitmap_transparent(gfx_ctxt_t *ctxt, u8* bitmap, u32 x, u32 y, u32 width, u32 height, u32 transparent_color);
 void gfx_render_bmp_arg_file(gfx_ctxt_t *ctxt, char *path, u32 x, u32 y, u32 width, u32 height);
 void gfx_render_splash(gfx_ctxt_t *ctxt, u8 *bitmap);
+int gfx_render_splash_file(gfx_ctxt_t *ctxt, const char *path);
 
 #endif
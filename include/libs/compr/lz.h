@@ -43,6 +43,8 @@ extern "C" {
 
 void LZ_Uncompress( const unsigned char *in, unsigned char *out,
                     unsigned int insize );
+int LZ_Uncompress_safe( const unsigned char *in, unsigned int insize,
+                        unsigned char *out, unsigned int outsize );
 
 
 #ifdef __cplusplus
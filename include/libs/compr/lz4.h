@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LZ4_H_
+#define _LZ4_H_
+
+#include "utils/types.h"
+
+#define LZ4_FRAME_MAGIC  0x184D2204
+#define LZ4_LEGACY_MAGIC 0x184C2102
+
+typedef struct _lz4_stream_t
+{
+	u8 *dst;
+	u32 dst_size;
+	u32 pos;
+	u32 state;
+	u32 flags;
+	u32 block_left; // Input bytes left in the current block.
+	u32 token;
+	u32 len;        // Literal or match length being decoded.
+	u32 offset;
+	u32 need;       // Header bytes being collected into hdr.
+	u32 have;
+	u8 hdr[16];
+} lz4_stream_t;
+
+/*
+ * Streaming decoder, input can be fed in windows of any size. The whole
+ * output must stay in dst since matches may reach back into older blocks.
+ * raw is for a bare block as made by 'lz4 -l' with the 8 byte legacy
+ * header stripped, otherwise frame and legacy streams are accepted.
+ * Block and content checksums are skipped, not verified.
+ */
+void lz4_stream_init(lz4_stream_t *s, void *dst, u32 dst_size, bool raw);
+// Returns 0 on corrupt input or when dst is too small.
+int lz4_stream_feed(lz4_stream_t *s, const void *src, u32 size);
+// Returns the decompressed size, or -1 if the stream is truncated or was corrupt.
+int lz4_stream_end(lz4_stream_t *s);
+
+// One shot helpers, return the decompressed size or -1.
+int lz4_decompress(const void *src, u32 src_size, void *dst, u32 dst_size);
+int lz4_decompress_block(const void *src, u32 src_size, void *dst, u32 dst_size);
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _ELF_H_
+#define _ELF_H_
+
+#include "utils/types.h"
+
+// The subset of ELF32 needed to load ARM modules.
+
+#define EI_NIDENT  16
+#define EI_CLASS   4
+#define EI_DATA    5
+
+#define ELFMAG     "\177ELF"
+#define ELFCLASS32 1
+#define ELFDATA2LSB 1
+
+#define ET_DYN     3
+#define EM_ARM     40
+
+#define PT_LOAD    1
+#define PT_DYNAMIC 2
+
+#define SHF_ALLOC  0x2
+#define SHN_UNDEF  0
+
+#define STB_WEAK   2
+
+#define DT_NULL     0
+#define DT_PLTRELSZ 2
+#define DT_SYMTAB   6
+#define DT_RELA     7
+#define DT_REL      17
+#define DT_RELSZ    18
+#define DT_RELENT   19
+#define DT_PLTREL   20
+#define DT_JMPREL   23
+#define DT_RELCOUNT 0x6FFFFFFA
+
+#define R_ARM_NONE      0
+#define R_ARM_ABS32     2
+#define R_ARM_GLOB_DAT  21
+#define R_ARM_JUMP_SLOT 22
+#define R_ARM_RELATIVE  23
+
+#define ELF32_R_SYM(i)  ((i) >> 8)
+#define ELF32_R_TYPE(i) ((i) & 0xFF)
+#define ELF32_ST_BIND(i) ((i) >> 4)
+
+typedef struct _Elf32_Ehdr
+{
+	u8  e_ident[EI_NIDENT];
+	u16 e_type;
+	u16 e_machine;
+	u32 e_version;
+	u32 e_entry;
+	u32 e_phoff;
+	u32 e_shoff;
+	u32 e_flags;
+	u16 e_ehsize;
+	u16 e_phentsize;
+	u16 e_phnum;
+	u16 e_shentsize;
+	u16 e_shnum;
+	u16 e_shstrndx;
+} Elf32_Ehdr;
+
+typedef struct _Elf32_Phdr
+{
+	u32 p_type;
+	u32 p_offset;
+	u32 p_vaddr;
+	u32 p_paddr;
+	u32 p_filesz;
+	u32 p_memsz;
+	u32 p_flags;
+	u32 p_align;
+} Elf32_Phdr;
+
+typedef struct _Elf32_Shdr
+{
+	u32 sh_name;
+	u32 sh_type;
+	u32 sh_flags;
+	u32 sh_addr;
+	u32 sh_offset;
+	u32 sh_size;
+	u32 sh_link;
+	u32 sh_info;
+	u32 sh_addralign;
+	u32 sh_entsize;
+} Elf32_Shdr;
+
+typedef struct _Elf32_Sym
+{
+	u32 st_name;
+	u32 st_value;
+	u32 st_size;
+	u8  st_info;
+	u8  st_other;
+	u16 st_shndx;
+} Elf32_Sym;
+
+typedef struct _Elf32_Rel
+{
+	u32 r_offset;
+	u32 r_info;
+} Elf32_Rel;
+
+typedef struct _Elf32_Dyn
+{
+	s32 d_tag;
+	u32 d_val;
+} Elf32_Dyn;
+
+#endif
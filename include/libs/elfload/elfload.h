@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _ELFLOAD_H_
+#define _ELFLOAD_H_
+
+#include "utils/types.h"
+#include "libs/elfload/elf.h"
+
+/*
+ * Loader for position independent ARM modules (ET_DYN, linked with -shared).
+ * el_init() checks the file and sizes the image, el_load() copies it to a
+ * buffer of memsz bytes aligned to align, el_relocate() applies the dynamic
+ * relocations for that address. The file buffer must be word aligned.
+ */
+
+typedef enum
+{
+	EL_OK = 0,
+	EL_NOTELF,     // Bad magic, class or byte order.
+	EL_WRONGARCH,  // Not an ARM shared object.
+	EL_BADFILE,    // Headers or segments out of bounds.
+	EL_BADREL,     // Unsupported or out of bounds relocation.
+	EL_BADSYM      // Undefined symbol, modules can't import any.
+} el_status;
+
+typedef struct _el_ctx_t
+{
+	const u8 *elf;
+	u32 size;
+	const Elf32_Ehdr *ehdr;
+	const Elf32_Phdr *phdr;
+	u32 memsz;     // Size of the loaded image, vaddr 0 is its start.
+	u32 align;     // Largest alignment of its sections.
+	u32 dyn_vaddr; // Dynamic section, 0 when there is none.
+} el_ctx_t;
+
+el_status el_init(el_ctx_t *ctx, const void *elf, u32 size);
+el_status el_load(el_ctx_t *ctx, void *base);
+el_status el_relocate(el_ctx_t *ctx, void *base);
+
+#endif
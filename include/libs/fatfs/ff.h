@@ -208,6 +208,7 @@ typedef struct {
 
 typedef struct {
 	FSIZE_t	fsize;			/* File size */
+	DWORD	fclust;			/* Start cluster */
 	WORD	fdate;			/* Modified date */
 	WORD	ftime;			/* Modified time */
 	BYTE	fattrib;		/* File attribute */
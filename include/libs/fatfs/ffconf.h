@@ -117,6 +117,17 @@
 /  ff_memfree() in ffsystem.c, need to be added to the project. */
 
 
+#ifndef FF_LFN_FASTCMP
+#define FF_LFN_FASTCMP	1
+#endif
+/* The FF_LFN_FASTCMP switches the ASCII fast path of the LFN matching in dir_find.
+/  ASCII code units are up-case converted without the conversion tables and
+/  entries are rejected on name length before they are compared.
+/
+/   0: Compare every code unit with ff_wtoupper().
+/   1: Enable the ASCII fast path. */
+
+
 #define FF_LFN_UNICODE	0
 /* This option switches the character encoding on the API when LFN is enabled.
 /
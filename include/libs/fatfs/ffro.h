@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FFRO_H_
+#define _FFRO_H_
+
+#include "utils/types.h"
+#include "libs/fatfs/ff.h"
+
+/*
+ * Minimal read-only FAT32/exFAT reader for the boot path.
+ * Only "open path, read file" is supported: no write paths, no code pages,
+ * ASCII-only case folding. Anything it can't handle is reported as an error
+ * so the caller can fall back to the full FatFs module.
+ */
+
+#define FFRO_FAT32 1
+#define FFRO_EXFAT 2
+
+typedef struct _ffro_t
+{
+	u8  fs_type;     // 0 when not mounted, FFRO_FAT32 or FFRO_EXFAT.
+	u8  csize_shift; // log2(sectors per cluster).
+	u32 n_fatent;    // Number of FAT entries (number of clusters + 2).
+	u32 fatbase;     // FAT base sector.
+	u32 database;    // Data base sector.
+	u32 dirbase;     // Root directory start cluster.
+	u32 fatsect;     // Sector currently held in fat[].
+	u8  win[512] __attribute__((aligned(16)));  // Directory sector window.
+	u8  fat[512] __attribute__((aligned(16)));  // FAT sector cache.
+} ffro_t;
+
+typedef struct _ffro_file_t
+{
+	u32 sclust; // Start cluster.
+	u32 size;   // File size in bytes.
+	u8  attr;   // FAT attributes (AM_DIR, ...).
+	u8  contig; // exFAT: data is contiguous, FAT chain is not valid.
+} ffro_file_t;
+
+FRESULT ffro_mount(ffro_t *fs);
+FRESULT ffro_open(ffro_t *fs, ffro_file_t *fp, const char *path);
+FRESULT ffro_read(ffro_t *fs, ffro_file_t *fp, void *buf, u32 size);
+
+#endif
@@ -15,111 +15,139 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-static const u8 _dram_cfg_lz[1270] = {
+// Generated by tools/sdram_cfg.py, do not edit.
+
+#define SDRAM_CFG_IDS 7
+#define SDRAM_CFG_BASE_ID 0
+
+// sdram_params_t of SDRAM_CFG_BASE_ID, 1896 bytes once decoded.
+static const u8 _dram_cfg_base_lz[1033] = {
 	0x17, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00,
-	0x00, 0x2C, 0x17, 0x04, 0x09, 0x00, 0x17, 0x04, 0x04, 0x17, 0x08, 0x08,
-	0x17, 0x10, 0x10, 0x00, 0x00, 0x68, 0xBC, 0x01, 0x70, 0x0A, 0x00, 0x00,
-	0x00, 0x04, 0xB4, 0x01, 0x70, 0x01, 0x32, 0x54, 0x76, 0xC8, 0xE6, 0x00,
-	0x70, 0x17, 0x10, 0x24, 0x34, 0x00, 0x00, 0x00, 0x02, 0x80, 0x18, 0x40,
-	0x00, 0x00, 0x00, 0x17, 0x04, 0x04, 0x17, 0x09, 0x18, 0xFF, 0xFF, 0x1F,
-	0x00, 0xD8, 0x51, 0x1A, 0xA0, 0x00, 0x00, 0x50, 0x05, 0x00, 0x00, 0x77,
-	0x00, 0x17, 0x04, 0x04, 0x17, 0x08, 0x08, 0x17, 0x08, 0x08, 0xA6, 0xA6,
-	0xAF, 0xB3, 0x3C, 0x9E, 0x00, 0x00, 0x03, 0x03, 0xE0, 0xC1, 0x04, 0x04,
-	0x04, 0x04, 0x17, 0x04, 0x04, 0x17, 0x04, 0x3C, 0x1F, 0x1F, 0x1F, 0x1F,
-	0x17, 0x04, 0x04, 0x17, 0x06, 0x06, 0x00, 0x00, 0x04, 0x08, 0x17, 0x06,
+	0x00, 0x2C, 0x17, 0x04, 0x09, 0x17, 0x1F, 0x01, 0x68, 0xBC, 0x01, 0x70,
+	0x0A, 0x00, 0x00, 0x00, 0x04, 0xB4, 0x01, 0x70, 0x01, 0x32, 0x54, 0x76,
+	0xC8, 0xE6, 0x00, 0x70, 0x17, 0x10, 0x24, 0x34, 0x00, 0x00, 0x00, 0x02,
+	0x80, 0x18, 0x40, 0x00, 0x00, 0x00, 0x17, 0x04, 0x04, 0x17, 0x09, 0x01,
+	0xFF, 0xFF, 0x1F, 0x00, 0xD8, 0x51, 0x1A, 0xA0, 0x00, 0x00, 0x50, 0x05,
+	0x00, 0x00, 0x77, 0x00, 0x17, 0x14, 0x04, 0xA6, 0xA6, 0xAF, 0xB3, 0x3C,
+	0x9E, 0x00, 0x00, 0x03, 0x03, 0xE0, 0xC1, 0x04, 0x17, 0x07, 0x01, 0x17,
+	0x04, 0x3C, 0x1F, 0x17, 0x0D, 0x01, 0x00, 0x00, 0x04, 0x08, 0x17, 0x06,
 	0x46, 0xA1, 0x01, 0x00, 0x00, 0x32, 0x17, 0x0B, 0x64, 0x01, 0x17, 0x04,
-	0x7C, 0x17, 0x07, 0x0C, 0x03, 0x17, 0x04, 0x04, 0x00, 0x00, 0x00, 0x1E,
-	0x00, 0x00, 0x00, 0x0D, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x13,
-	0x17, 0x0B, 0x2C, 0x09, 0x00, 0x00, 0x00, 0x17, 0x05, 0x5D, 0x17, 0x07,
-	0x10, 0x0B, 0x17, 0x07, 0x28, 0x08, 0x17, 0x07, 0x0C, 0x17, 0x04, 0x1C,
-	0x20, 0x00, 0x00, 0x00, 0x06, 0x17, 0x04, 0x04, 0x17, 0x07, 0x08, 0x17,
-	0x04, 0x50, 0x17, 0x04, 0x2C, 0x17, 0x04, 0x1C, 0x17, 0x04, 0x10, 0x17,
-	0x08, 0x6C, 0x17, 0x04, 0x10, 0x17, 0x04, 0x38, 0x17, 0x04, 0x40, 0x05,
-	0x17, 0x07, 0x1C, 0x17, 0x08, 0x58, 0x17, 0x04, 0x24, 0x17, 0x04, 0x18,
-	0x17, 0x08, 0x64, 0x00, 0x00, 0x01, 0x00, 0x12, 0x00, 0x00, 0x00, 0x14,
-	0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x17, 0x09, 0x0C, 0x17, 0x05, 0x82,
-	0x58, 0x17, 0x07, 0x61, 0xC1, 0x17, 0x07, 0x50, 0x17, 0x04, 0x04, 0x17,
-	0x08, 0x81, 0x48, 0x17, 0x04, 0x04, 0x17, 0x04, 0x28, 0x17, 0x04, 0x60,
-	0x17, 0x08, 0x54, 0x27, 0x17, 0x04, 0x04, 0x17, 0x07, 0x14, 0x17, 0x04,
-	0x04, 0x04, 0x17, 0x07, 0x81, 0x58, 0x17, 0x0C, 0x0C, 0x1C, 0x03, 0x00,
-	0x00, 0x0D, 0xA0, 0x60, 0x91, 0xBF, 0x3B, 0x17, 0x04, 0x5A, 0xF3, 0x0C,
-	0x04, 0x05, 0x1B, 0x06, 0x02, 0x03, 0x07, 0x1C, 0x23, 0x25, 0x25, 0x05,
-	0x08, 0x1D, 0x09, 0x0A, 0x24, 0x0B, 0x1E, 0x0D, 0x0C, 0x26, 0x26, 0x03,
-	0x02, 0x1B, 0x1C, 0x23, 0x03, 0x04, 0x07, 0x05, 0x06, 0x25, 0x25, 0x02,
-	0x0A, 0x0B, 0x1D, 0x0D, 0x08, 0x0C, 0x09, 0x1E, 0x24, 0x26, 0x26, 0x08,
-	0x24, 0x06, 0x07, 0x9A, 0x12, 0x17, 0x05, 0x83, 0x41, 0x00, 0xFF, 0x17,
-	0x10, 0x83, 0x6C, 0x04, 0x00, 0x01, 0x08, 0x00, 0x00, 0x02, 0x08, 0x00,
-	0x00, 0x0D, 0x08, 0x00, 0x00, 0x00, 0xC0, 0x71, 0x71, 0x03, 0x08, 0x00,
-	0x00, 0x0B, 0x08, 0x72, 0x72, 0x0E, 0x0C, 0x17, 0x04, 0x20, 0x08, 0x08,
-	0x0D, 0x0C, 0x00, 0x00, 0x0D, 0x0C, 0x14, 0x14, 0x16, 0x08, 0x17, 0x06,
-	0x2C, 0x11, 0x08, 0x17, 0x10, 0x84, 0x67, 0x15, 0x00, 0xCC, 0x00, 0x0A,
-	0x00, 0x33, 0x00, 0x00, 0x00, 0x20, 0xF3, 0x05, 0x08, 0x11, 0x00, 0xFF,
-	0x0F, 0xFF, 0x0F, 0x17, 0x08, 0x83, 0x4C, 0x01, 0x03, 0x00, 0x70, 0x00,
-	0x0C, 0x00, 0x01, 0x17, 0x04, 0x0C, 0x08, 0x44, 0x00, 0x10, 0x04, 0x04,
-	0x00, 0x06, 0x13, 0x07, 0x00, 0x80, 0x17, 0x04, 0x10, 0xA0, 0x00, 0x2C,
-	0x00, 0x01, 0x37, 0x00, 0x00, 0x00, 0x80, 0x17, 0x06, 0x48, 0x08, 0x00,
-	0x04, 0x00, 0x1F, 0x22, 0x20, 0x80, 0x0F, 0xF4, 0x20, 0x02, 0x28, 0x28,
-	0x28, 0x28, 0x17, 0x04, 0x04, 0x11, 0x11, 0x11, 0x11, 0x17, 0x04, 0x04,
-	0xBE, 0x00, 0x00, 0x17, 0x05, 0x58, 0x17, 0x08, 0x5C, 0x17, 0x22, 0x85,
-	0x6A, 0x17, 0x1A, 0x1A, 0x14, 0x00, 0x12, 0x00, 0x10, 0x17, 0x05, 0x83,
+	0x7C, 0x17, 0x07, 0x0C, 0x03, 0x17, 0x07, 0x04, 0x1E, 0x00, 0x00, 0x00,
+	0x0D, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x13, 0x17, 0x0B, 0x2C,
+	0x09, 0x00, 0x00, 0x00, 0x17, 0x05, 0x5D, 0x17, 0x07, 0x01, 0x0B, 0x17,
+	0x07, 0x28, 0x08, 0x17, 0x07, 0x0C, 0x17, 0x04, 0x1C, 0x20, 0x00, 0x00,
+	0x00, 0x06, 0x17, 0x0B, 0x04, 0x17, 0x04, 0x50, 0x17, 0x04, 0x01, 0x17,
+	0x04, 0x1C, 0x17, 0x04, 0x10, 0x17, 0x08, 0x6C, 0x17, 0x04, 0x10, 0x17,
+	0x04, 0x38, 0x17, 0x04, 0x40, 0x05, 0x17, 0x07, 0x1C, 0x17, 0x08, 0x01,
+	0x17, 0x04, 0x24, 0x17, 0x04, 0x18, 0x17, 0x08, 0x64, 0x00, 0x00, 0x01,
+	0x00, 0x12, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00,
+	0x17, 0x09, 0x0C, 0x17, 0x05, 0x82, 0x58, 0x17, 0x07, 0x61, 0xC1, 0x17,
+	0x07, 0x50, 0x17, 0x04, 0x04, 0x17, 0x08, 0x81, 0x48, 0x17, 0x04, 0x04,
+	0x17, 0x04, 0x28, 0x17, 0x04, 0x60, 0x17, 0x08, 0x54, 0x27, 0x17, 0x07,
+	0x04, 0x17, 0x04, 0x14, 0x17, 0x04, 0x04, 0x04, 0x17, 0x07, 0x81, 0x58,
+	0x17, 0x0C, 0x0C, 0x1C, 0x03, 0x00, 0x00, 0x0D, 0xA0, 0x60, 0x91, 0xBF,
+	0x3B, 0x17, 0x04, 0x5A, 0xF3, 0x0C, 0x04, 0x05, 0x1B, 0x06, 0x02, 0x03,
+	0x07, 0x1C, 0x23, 0x25, 0x25, 0x05, 0x08, 0x1D, 0x09, 0x0A, 0x24, 0x0B,
+	0x1E, 0x0D, 0x0C, 0x26, 0x26, 0x03, 0x02, 0x1B, 0x1C, 0x23, 0x03, 0x04,
+	0x07, 0x05, 0x06, 0x25, 0x25, 0x02, 0x0A, 0x0B, 0x1D, 0x0D, 0x08, 0x0C,
+	0x09, 0x1E, 0x24, 0x26, 0x26, 0x08, 0x24, 0x06, 0x07, 0x9A, 0x12, 0x17,
+	0x05, 0x83, 0x41, 0x00, 0xFF, 0x17, 0x0B, 0x81, 0x57, 0x17, 0x07, 0x81,
+	0x78, 0x01, 0x08, 0x00, 0x00, 0x02, 0x08, 0x00, 0x00, 0x0D, 0x08, 0x00,
+	0x00, 0x00, 0xC0, 0x71, 0x71, 0x03, 0x08, 0x00, 0x00, 0x0B, 0x08, 0x72,
+	0x72, 0x0E, 0x0C, 0x17, 0x04, 0x20, 0x08, 0x08, 0x0D, 0x0C, 0x00, 0x00,
+	0x0D, 0x0C, 0x14, 0x14, 0x16, 0x08, 0x17, 0x06, 0x2C, 0x11, 0x08, 0x17,
+	0x10, 0x84, 0x67, 0x15, 0x00, 0xCC, 0x00, 0x0A, 0x00, 0x33, 0x00, 0x00,
+	0x00, 0x20, 0xF3, 0x05, 0x08, 0x11, 0x00, 0xFF, 0x0F, 0xFF, 0x0F, 0x17,
+	0x06, 0x82, 0x26, 0x00, 0x00, 0x01, 0x03, 0x00, 0x70, 0x00, 0x0C, 0x00,
+	0x01, 0x17, 0x04, 0x0C, 0x08, 0x44, 0x00, 0x10, 0x04, 0x04, 0x00, 0x06,
+	0x13, 0x07, 0x00, 0x80, 0x17, 0x04, 0x10, 0xA0, 0x00, 0x2C, 0x00, 0x01,
+	0x37, 0x00, 0x00, 0x00, 0x80, 0x17, 0x06, 0x48, 0x08, 0x00, 0x04, 0x00,
+	0x1F, 0x22, 0x20, 0x80, 0x0F, 0xF4, 0x20, 0x02, 0x28, 0x17, 0x07, 0x01,
+	0x11, 0x17, 0x07, 0x01, 0xBE, 0x00, 0x00, 0x17, 0x05, 0x58, 0x17, 0x08,
+	0x5C, 0x17, 0x3C, 0x01, 0x14, 0x00, 0x12, 0x00, 0x10, 0x17, 0x05, 0x83,
 	0x0A, 0x17, 0x16, 0x18, 0x30, 0x00, 0x2E, 0x00, 0x33, 0x00, 0x30, 0x00,
 	0x33, 0x00, 0x35, 0x00, 0x30, 0x00, 0x32, 0x17, 0x05, 0x83, 0x0C, 0x17,
-	0x04, 0x20, 0x17, 0x18, 0x18, 0x28, 0x00, 0x28, 0x17, 0x04, 0x04, 0x17,
-	0x08, 0x08, 0x17, 0x10, 0x10, 0x00, 0x14, 0x17, 0x05, 0x5A, 0x17, 0x04,
-	0x5C, 0x17, 0x04, 0x5E, 0x17, 0x04, 0x0E, 0x17, 0x0E, 0x78, 0x17, 0x09,
-	0x82, 0x50, 0x40, 0x06, 0x00, 0xCC, 0x00, 0x09, 0x00, 0x4F, 0x00, 0x51,
-	0x17, 0x08, 0x18, 0x80, 0x01, 0x00, 0x00, 0x40, 0x17, 0x04, 0x20, 0x03,
-	0x00, 0x00, 0x00, 0xAB, 0x00, 0x0A, 0x04, 0x11, 0x17, 0x08, 0x82, 0x58,
-	0x17, 0x0C, 0x38, 0x17, 0x1B, 0x81, 0x6C, 0x17, 0x08, 0x85, 0x60, 0x17,
-	0x08, 0x86, 0x50, 0x17, 0x08, 0x86, 0x60, 0x17, 0x06, 0x83, 0x21, 0x22,
-	0x04, 0xFF, 0xFF, 0xAF, 0x4F, 0x17, 0x0C, 0x86, 0x74, 0x17, 0x08, 0x2C,
-	0x8B, 0xFF, 0x07, 0x17, 0x06, 0x81, 0x04, 0x32, 0x54, 0x76, 0x10, 0x47,
-	0x32, 0x65, 0x10, 0x34, 0x76, 0x25, 0x01, 0x34, 0x67, 0x25, 0x01, 0x75,
-	0x64, 0x32, 0x01, 0x72, 0x56, 0x34, 0x10, 0x23, 0x74, 0x56, 0x01, 0x45,
-	0x32, 0x67, 0x17, 0x04, 0x24, 0x49, 0x92, 0x24, 0x17, 0x04, 0x04, 0x17,
-	0x11, 0x7C, 0x1B, 0x17, 0x04, 0x04, 0x17, 0x13, 0x81, 0x14, 0x2F, 0x41,
-	0x13, 0x1F, 0x14, 0x00, 0x01, 0x00, 0x17, 0x04, 0x7C, 0xFF, 0xFF, 0xFF,
-	0x7F, 0x0B, 0xD7, 0x06, 0x40, 0x00, 0x00, 0x02, 0x00, 0x08, 0x08, 0x03,
-	0x00, 0x00, 0x5C, 0x01, 0x00, 0x10, 0x10, 0x10, 0x17, 0x06, 0x86, 0x59,
-	0x17, 0x0F, 0x89, 0x14, 0x37, 0x17, 0x07, 0x82, 0x72, 0x10, 0x17, 0x06,
-	0x83, 0x0D, 0x00, 0x11, 0x01, 0x17, 0x05, 0x85, 0x39, 0x17, 0x04, 0x0E,
-	0x0A, 0x17, 0x07, 0x89, 0x29, 0x17, 0x04, 0x1B, 0x17, 0x08, 0x86, 0x77,
-	0x17, 0x09, 0x12, 0x20, 0x00, 0x00, 0x00, 0x81, 0x10, 0x09, 0x28, 0x93,
-	0x32, 0xA5, 0x44, 0x5B, 0x8A, 0x67, 0x76, 0x17, 0x18, 0x82, 0x2C, 0xFF,
-	0xEF, 0xFF, 0xEF, 0xC0, 0xC0, 0xC0, 0xC0, 0x17, 0x04, 0x04, 0xDC, 0xDC,
-	0xDC, 0xDC, 0x0A, 0x0A, 0x0A, 0x0A, 0x17, 0x04, 0x04, 0x17, 0x04, 0x04,
-	0x17, 0x05, 0x82, 0x24, 0x03, 0x07, 0x17, 0x04, 0x04, 0x00, 0x00, 0x24,
+	0x04, 0x01, 0x17, 0x18, 0x18, 0x28, 0x17, 0x1F, 0x02, 0x14, 0x17, 0x05,
+	0x5A, 0x17, 0x04, 0x5C, 0x17, 0x04, 0x5E, 0x17, 0x04, 0x02, 0x17, 0x0E,
+	0x01, 0x17, 0x09, 0x82, 0x50, 0x40, 0x06, 0x00, 0xCC, 0x00, 0x09, 0x00,
+	0x4F, 0x00, 0x51, 0x17, 0x08, 0x18, 0x80, 0x01, 0x00, 0x00, 0x40, 0x17,
+	0x04, 0x20, 0x03, 0x00, 0x00, 0x00, 0xAB, 0x00, 0x0A, 0x04, 0x11, 0x17,
+	0x08, 0x82, 0x58, 0x17, 0x0C, 0x38, 0x17, 0x1B, 0x01, 0x17, 0x08, 0x85,
+	0x60, 0x17, 0x04, 0x01, 0x17, 0x08, 0x88, 0x2C, 0x17, 0x04, 0x14, 0x17,
+	0x06, 0x83, 0x21, 0x22, 0x04, 0xFF, 0xFF, 0xAF, 0x4F, 0x17, 0x0C, 0x86,
+	0x74, 0x17, 0x08, 0x01, 0x8B, 0xFF, 0x07, 0x17, 0x06, 0x81, 0x04, 0x32,
+	0x54, 0x76, 0x10, 0x47, 0x32, 0x65, 0x10, 0x34, 0x76, 0x25, 0x01, 0x34,
+	0x67, 0x25, 0x01, 0x75, 0x64, 0x32, 0x01, 0x72, 0x56, 0x34, 0x10, 0x23,
+	0x74, 0x56, 0x01, 0x45, 0x32, 0x67, 0x17, 0x04, 0x24, 0x49, 0x92, 0x24,
+	0x17, 0x05, 0x04, 0x17, 0x10, 0x01, 0x1B, 0x17, 0x07, 0x04, 0x17, 0x10,
+	0x01, 0x2F, 0x41, 0x13, 0x1F, 0x14, 0x00, 0x01, 0x00, 0x17, 0x04, 0x7C,
+	0xFF, 0xFF, 0xFF, 0x7F, 0x0B, 0xD7, 0x06, 0x40, 0x00, 0x00, 0x02, 0x00,
+	0x08, 0x08, 0x03, 0x00, 0x00, 0x5C, 0x01, 0x00, 0x10, 0x10, 0x10, 0x17,
+	0x06, 0x86, 0x59, 0x17, 0x0B, 0x01, 0x34, 0x00, 0x00, 0x00, 0x37, 0x17,
+	0x07, 0x82, 0x72, 0x10, 0x17, 0x04, 0x05, 0x30, 0x00, 0x00, 0x11, 0x01,
+	0x17, 0x05, 0x85, 0x39, 0x17, 0x04, 0x01, 0x0A, 0x17, 0x07, 0x89, 0x29,
+	0x17, 0x04, 0x1B, 0x17, 0x08, 0x86, 0x77, 0x17, 0x09, 0x12, 0x20, 0x00,
+	0x00, 0x00, 0x81, 0x10, 0x09, 0x28, 0x93, 0x32, 0xA5, 0x44, 0x5B, 0x8A,
+	0x67, 0x76, 0x17, 0x13, 0x81, 0x13, 0x17, 0x05, 0x01, 0xFF, 0xEF, 0xFF,
+	0xEF, 0xC0, 0x17, 0x07, 0x01, 0xDC, 0xDC, 0xDC, 0xDC, 0x0A, 0x17, 0x0B,
+	0x01, 0x17, 0x05, 0x82, 0x24, 0x03, 0x07, 0x17, 0x05, 0x04, 0x00, 0x24,
 	0xFF, 0xFF, 0x00, 0x44, 0x57, 0x6E, 0x00, 0x28, 0x72, 0x39, 0x00, 0x10,
 	0x9C, 0x4B, 0x17, 0x04, 0x64, 0x01, 0x00, 0x00, 0x08, 0x4C, 0x00, 0x00,
 	0x80, 0x20, 0x10, 0x0A, 0x00, 0x28, 0x10, 0x17, 0x06, 0x85, 0x60, 0x17,
-	0x10, 0x82, 0x74, 0x17, 0x08, 0x08, 0x17, 0x08, 0x88, 0x00, 0x17, 0x04,
-	0x10, 0x04, 0x17, 0x0B, 0x87, 0x6C, 0x01, 0x00, 0x02, 0x02, 0x01, 0x02,
-	0x03, 0x00, 0x04, 0x05, 0xC3, 0x71, 0x0F, 0x0F, 0x17, 0x08, 0x8B, 0x18,
-	0x1F, 0x17, 0x09, 0x81, 0x73, 0x00, 0xFF, 0x00, 0xFF, 0x17, 0x05, 0x86,
-	0x48, 0x17, 0x04, 0x0C, 0x17, 0x07, 0x86, 0x34, 0x00, 0x00, 0xF0, 0x17,
-	0x09, 0x87, 0x54, 0x43, 0xC3, 0xBA, 0xE4, 0xD3, 0x1E, 0x17, 0x0C, 0x81,
-	0x52, 0x17, 0x0A, 0x1C, 0x17, 0x10, 0x81, 0x6C, 0x17, 0x0A, 0x82, 0x21,
-	0x17, 0x07, 0x82, 0x4D, 0x17, 0x0A, 0x8A, 0x1B, 0x17, 0x11, 0x2C, 0x76,
-	0x0C, 0x17, 0x0A, 0x8A, 0x67, 0x17, 0x0F, 0x84, 0x28, 0x17, 0x06, 0x34,
-	0x17, 0x17, 0x3A, 0x7E, 0x16, 0x40, 0x17, 0x0C, 0x8B, 0x1F, 0x17, 0x2A,
-	0x38, 0x1E, 0x17, 0x0A, 0x38, 0x17, 0x13, 0x81, 0x28, 0x00, 0xC0, 0x17,
-	0x17, 0x55, 0x46, 0x24, 0x17, 0x0A, 0x81, 0x28, 0x17, 0x14, 0x38, 0x17,
-	0x18, 0x81, 0x60, 0x46, 0x2C, 0x17, 0x06, 0x38, 0xEC, 0x00, 0x00, 0x00,
-	0x01, 0x77, 0x00, 0xFC, 0x00, 0x20, 0xCF, 0x22, 0x17, 0x10, 0x82, 0x3C,
-	0x17, 0x82, 0x0C, 0x8E, 0x68, 0x17, 0x04, 0x24, 0x17, 0x5C, 0x8E, 0x68,
-	0x17, 0x07, 0x82, 0x5F, 0x80, 0x17, 0x87, 0x01, 0x8E, 0x68, 0x02, 0x17,
-	0x81, 0x4A, 0x8E, 0x68, 0x17, 0x0C, 0x87, 0x78, 0x17, 0x85, 0x28, 0x8E,
-	0x68, 0x17, 0x8E, 0x68, 0x9D, 0x50, 0x17, 0x81, 0x24, 0x8E, 0x68, 0x17,
-	0x04, 0x2C, 0x17, 0x28, 0x8E, 0x68, 0x17, 0x04, 0x30, 0x17, 0x85, 0x3C,
-	0x8E, 0x68, 0x12, 0x17, 0x07, 0x85, 0x70, 0x17, 0x88, 0x74, 0x8E, 0x68,
-	0x17, 0x87, 0x3E, 0x9D, 0x50, 0x0C, 0x17, 0x04, 0x04, 0x17, 0x12, 0x8E,
-	0x68, 0x18, 0x17, 0x87, 0x12, 0xBB, 0x20, 0x17, 0x83, 0x04, 0x9D, 0x50,
-	0x15, 0x17, 0x05, 0x8D, 0x76, 0x17, 0x0F, 0x8B, 0x49, 0x17, 0x0B, 0x18,
-	0x32, 0x00, 0x2F, 0x00, 0x32, 0x00, 0x31, 0x00, 0x34, 0x00, 0x36, 0x00,
-	0x2F, 0x00, 0x33, 0x17, 0x09, 0x84, 0x0C, 0x17, 0x18, 0x18, 0x17, 0x20,
-	0x8E, 0x68, 0x15, 0x17, 0x07, 0x5A, 0x17, 0x06, 0x5E, 0x16, 0x00, 0x15,
-	0x17, 0x82, 0x40, 0x9D, 0x50, 0x17, 0x86, 0x5F, 0xBB, 0x20, 0x3A, 0x00,
-	0x00, 0x00, 0x1D, 0x17, 0x81, 0x4F, 0xAC, 0x38, 0x3B, 0x17, 0x04, 0x04,
-	0x17, 0x86, 0x30, 0x8E, 0x68, 0x17, 0x81, 0x53, 0xAC, 0x38, 0x07, 0x17,
-	0x0D, 0x8E, 0x68, 0xA3, 0x72, 0x17, 0x83, 0x10, 0x8E, 0x68
+	0x04, 0x01, 0x17, 0x0C, 0x82, 0x74, 0x17, 0x08, 0x08, 0x17, 0x08, 0x88,
+	0x00, 0x17, 0x04, 0x10, 0x04, 0x17, 0x0B, 0x87, 0x6C, 0x01, 0x00, 0x02,
+	0x02, 0x01, 0x02, 0x03, 0x00, 0x04, 0x05, 0xC3, 0x71, 0x0F, 0x0F, 0x17,
+	0x08, 0x8B, 0x18, 0x1F, 0x17, 0x09, 0x81, 0x73, 0x00, 0xFF, 0x00, 0xFF,
+	0x17, 0x05, 0x86, 0x48, 0x17, 0x04, 0x0C, 0x17, 0x07, 0x86, 0x34, 0x00,
+	0x00, 0xF0, 0x17, 0x09, 0x87, 0x54, 0x43, 0xC3, 0xBA, 0xE4, 0xD3, 0x1E,
+	0x17, 0x0C, 0x81, 0x52, 0x17, 0x0A, 0x1C, 0x17, 0x10, 0x01, 0x17, 0x0A,
+	0x82, 0x21, 0x17, 0x04, 0x01, 0x30, 0x17, 0x08, 0x81, 0x2B, 0x17, 0x15,
+	0x01, 0x76, 0x0C, 0x17, 0x0A, 0x8A, 0x67, 0x17, 0x0F, 0x84, 0x28, 0x17,
+	0x06, 0x34, 0x17, 0x17, 0x3A, 0x7E, 0x16, 0x40, 0x17, 0x0C, 0x8B, 0x1F,
+	0x17, 0x2A, 0x38, 0x1E, 0x17, 0x0A, 0x38, 0x17, 0x13, 0x81, 0x28, 0x00,
+	0xC0, 0x17, 0x17, 0x55, 0x46, 0x24, 0x17, 0x0A, 0x81, 0x28, 0x17, 0x14,
+	0x38, 0x17, 0x18, 0x01, 0x46, 0x2C, 0x17, 0x06, 0x38, 0xEC, 0x00, 0x00,
+	0x00, 0x01, 0x77, 0x00, 0xFC, 0x00, 0x20, 0xCF, 0x22, 0x17, 0x10, 0x82,
+	0x3C
+};
+
+// Words that differ from the base, id n owns [_dram_cfg_delta_idx[n], _dram_cfg_delta_idx[n + 1]).
+static const u16 _dram_cfg_delta_idx[SDRAM_CFG_IDS + 1] = {
+	0, 0, 5, 5, 9, 12, 39, 67
+};
+
+static const u16 _dram_cfg_delta_off[67] = {
+	// DRAM id 1.
+	0x043, 0x05B, 0x05C, 0x13D, 0x170,
+	// DRAM id 3.
+	0x06C, 0x077, 0x127, 0x128,
+	// DRAM id 4.
+	0x15B, 0x15C, 0x161,
+	// DRAM id 5.
+	0x043, 0x05B, 0x05C, 0x06C, 0x077, 0x0CD, 0x0CE, 0x0D3, 0x0D4, 0x0D5, 0x0D6, 0x0D7,
+	0x0D8, 0x0D9, 0x0DB, 0x0DC, 0x0DD, 0x0DE, 0x0DF, 0x0E9, 0x0EB, 0x0EC, 0x0ED, 0x127,
+	0x128, 0x13D, 0x170,
+	// DRAM id 6.
+	0x03B, 0x03C, 0x06C, 0x070, 0x071, 0x077, 0x0CD, 0x0CE, 0x0D3, 0x0D4, 0x0D5, 0x0D6,
+	0x0D7, 0x0D8, 0x0D9, 0x0DB, 0x0DC, 0x0DD, 0x0DE, 0x0DF, 0x0E9, 0x0EB, 0x0EC, 0x0ED,
+	0x127, 0x128, 0x172, 0x175
+};
+
+static const u32 _dram_cfg_delta_val[67] = {
+	// DRAM id 1.
+	0x0000000D, 0x00000001, 0x80000000, 0x00000210, 0x00000005,
+	// DRAM id 3.
+	0x00000012, 0x00000003, 0x00000012, 0x00000012,
+	// DRAM id 4.
+	0x000C0302, 0x000C0302, 0x00001800,
+	// DRAM id 5.
+	0x0000000D, 0x00000001, 0x80000000, 0x00000012, 0x00000003, 0x00120015, 0x00160012, 0x00120015,
+	0x00160012, 0x002F0032, 0x00310032, 0x00360034, 0x0033002F, 0x00000006, 0x002F0032, 0x00310032,
+	0x00360034, 0x0033002F, 0x00000006, 0x00150015, 0x00120012, 0x00160016, 0x00000015, 0x00000012,
+	0x00000012, 0x00000210, 0x00000005,
+	// DRAM id 6.
+	0x0000003A, 0x0000001D, 0x00000012, 0x0000003B, 0x0000003B, 0x00000003, 0x00120015, 0x00160012,
+	0x00120015, 0x00160012, 0x002F0032, 0x00310032, 0x00360034, 0x0033002F, 0x00000006, 0x002F0032,
+	0x00310032, 0x00360034, 0x0033002F, 0x00000006, 0x00150015, 0x00120012, 0x00160016, 0x00000015,
+	0x00000012, 0x00000012, 0x00000007, 0x72A30504
 };
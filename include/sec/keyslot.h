@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _KEYSLOT_H_
+#define _KEYSLOT_H_
+
+#include "utils/types.h"
+
+// Slots handed out by the manager. 14 holds the SBK and 15 the SSK.
+#define KEYSLOT_MANAGED_COUNT 14
+#define KEYSLOT_SBK           14
+
+/*
+ * Keyslot manager. Keys are identified by how they were obtained: a raw key
+ * by its content, a derived key by its parent slot and the wrapped seed that
+ * was unwrapped with it. Asking for a key that is already loaded returns its
+ * slot without touching the keytable. When no slot is free the least
+ * recently used one is cleared and reused.
+ * All functions return the slot number, or -1 on error.
+ */
+int keyslot_load(const void *key, u32 size);
+int keyslot_derive(u32 parent, const void *seed);
+// Chained unwraps of count 16-byte seeds starting from root.
+int keyslot_derive_path(u32 root, const void *seeds, u32 count);
+// Clears every slot written through the manager, done before leaving for a payload.
+void keyslot_clear_all();
+
+#endif
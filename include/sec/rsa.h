@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RSA_H_
+#define _RSA_H_
+
+#include "utils/types.h"
+
+#define RSA2048_SIZE 0x100
+
+typedef enum _rsa_padding_t
+{
+	RSA_PADDING_PKCS1_V15 = 0,
+	RSA_PADDING_PSS       = 1  // MGF1-SHA256, any salt length.
+} rsa_padding_t;
+
+/*! RSA-2048 public key, big endian. */
+typedef struct _rsa2048_key_t
+{
+	u8 mod[RSA2048_SIZE];
+	u8 exp[4];
+} rsa2048_key_t;
+
+/*
+ * SHA-256 signature verification. The key is loaded into RSA keyslot rs
+ * on first use and kept there, later calls with the same key skip the load.
+ * All functions return 1 when the signature is valid.
+ */
+int rsa2048_verify_hash(u32 rs, const rsa2048_key_t *key, const void *sig, const void *hash, u32 padding);
+int rsa2048_verify(u32 rs, const rsa2048_key_t *key, const void *sig, const void *data, u32 size, u32 padding);
+int rsa2048_verify_file(u32 rs, const rsa2048_key_t *key, const void *sig, const char *path, u32 padding);
+void rsa2048_key_forget(u32 rs);
+
+#endif
@@ -19,13 +19,87 @@
 
 #include "utils/types.h"
 
+typedef enum _se_op_type_t
+{
+	SE_OP_AES_ECB = 0,
+	SE_OP_AES_CTR,
+	SE_OP_AES_CBC,
+	SE_OP_AES_UNWRAP,
+	SE_OP_SHA256,
+	SE_OP_RSA,
+	SE_OP_TYPE_MAX
+} se_op_type_t;
+
+/*! SE operation. config/crypto are raw SE_CONFIG/SE_CRYPTO values. */
+typedef struct _se_job_t
+{
+	u32 type;        // se_op_type_t, used for the statistics.
+	u32 config;
+	u32 crypto;      // Ignored for hash operations.
+	u32 keytab_dst;  // Only used when the destination is the key table.
+	const void *ctr; // Optional initial counter.
+	const void *iv;  // Optional original IV, loaded into the key's slot.
+	void *dst;
+	u32 dst_size;
+	const void *src;
+	u32 src_size;    // Block count is derived from it for AES.
+} se_job_t;
+
+typedef struct _se_stats_t
+{
+	u32 ops;
+	u32 bytes;
+	u32 time_us;
+} se_stats_t;
+
+/*! Incremental SHA-256 state. */
+typedef struct _se_sha256_ctx_t
+{
+	u32 hash[8]; // Intermediate hash, as held in SE_HASH_RESULT.
+	u64 total;   // Bytes hashed so far.
+	u8  buf[0x40] __attribute__((aligned(0x10))); // Partial block.
+	u32 buf_len;
+	bool started;
+} se_sha256_ctx_t;
+
+#define SE_JOB_BUSY -1
+
+int se_job_submit(const se_job_t *job);
+/*
+ * Asynchronous submission. Only one operation can be in flight, starting
+ * another one or any synchronous call waits for it first and drops its
+ * result. se_job_poll() returns SE_JOB_BUSY while it runs, then its result.
+ */
+int se_job_start(const se_job_t *job);
+int se_job_poll();
+int se_job_wait();
+const se_stats_t *se_get_stats();
+void se_reset_stats();
+
 void se_rsa_acc_ctrl(u32 rs, u32 flags);
+/*! RSA keys are big endian, mod_size a multiple of 64 up to 256, exp_size a multiple of 4. */
+int se_rsa_key_set(u32 rs, const void *mod, u32 mod_size, const void *exp, u32 exp_size);
+void se_rsa_key_clear(u32 rs);
+int se_rsa_exp_mod(u32 rs, void *dst, u32 dst_size, const void *src, u32 src_size);
 void se_key_acc_ctrl(u32 ks, u32 flags);
 void se_aes_key_set(u32 ks, void *key, u32 size);
 void se_aes_key_clear(u32 ks);
 int se_aes_unwrap_key(u32 ks_dst, u32 ks_src, const void *input);
 int se_aes_crypt_block_ecb(u32 ks, u32 enc, void *dst, const void *src);
+int se_aes_crypt_ecb(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size);
 int se_aes_crypt_ctr(u32 ks, void *dst, u32 dst_size, const void *src, u32 src_size, void *ctr);
+// Asynchronous when src_size is whole blocks, else like se_aes_crypt_ctr().
+int se_aes_crypt_ctr_start(u32 ks, void *dst, u32 dst_size, const void *src, u32 src_size, void *ctr);
+// CBC over whole blocks, the IV is the chaining value of the first block.
+int se_aes_crypt_cbc(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size, const void *iv);
+int se_aes_crypt_cbc_start(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size, const void *iv);
+int se_aes_xts_crypt_sec(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *src, u32 secsize);
+int se_aes_xts_crypt(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *src, u32 secsize, u32 num_secs);
 int se_calc_sha256(void *dst, const void *src, u32 src_size);
+void se_sha256_init(se_sha256_ctx_t *ctx);
+int se_sha256_update(se_sha256_ctx_t *ctx, const void *src, u32 src_size);
+// Hashes asynchronously when src_size is whole blocks and nothing is buffered, else like update.
+int se_sha256_update_start(se_sha256_ctx_t *ctx, const void *src, u32 src_size);
+int se_sha256_final(se_sha256_ctx_t *ctx, void *dst);
 
 #endif
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DIRITER_H_
+#define _DIRITER_H_
+
+#include "utils/types.h"
+#include "libs/fatfs/ff.h"
+
+#define DIR_NAME_MAX (FF_LFN_BUF + 1)
+
+typedef struct _dir_entry_t
+{
+	const char *name; // Points into the iterator, valid until the next call.
+	u32 size;
+	u32 sclust;
+	u8  attr;
+} dir_entry_t;
+
+// Return true to keep the entry.
+typedef bool (*dir_filter_t)(const dir_entry_t *ent, void *arg);
+// strcmp-like ordering.
+typedef int (*dir_cmp_t)(const dir_entry_t *a, const dir_entry_t *b);
+
+typedef struct _dir_iter_t
+{
+	DIR dir;
+	FILINFO fno;
+	dir_entry_t ent;
+	const char *pattern;
+	dir_filter_t filter;
+	void *arg;
+	bool open;
+	bool primed; // fno already holds the first match of f_findfirst().
+} dir_iter_t;
+
+/*
+ * Streams the entries of a directory. pattern and filter are optional.
+ * Stopping early is done by calling dir_iter_close().
+ */
+int dir_iter_open(dir_iter_t *it, const char *path, const char *pattern, dir_filter_t filter, void *arg);
+const dir_entry_t *dir_iter_next(dir_iter_t *it);
+void dir_iter_close(dir_iter_t *it);
+
+/*
+ * Drains the iterator keeping only the first k entries in cmp order.
+ * Returns the number of entries in *out, sorted. *out is a single
+ * allocation that also backs the names and must be freed by the caller.
+ */
+u32 dir_iter_sorted(dir_iter_t *it, dir_cmp_t cmp, u32 k, dir_entry_t **out);
+
+bool dir_filter_files(const dir_entry_t *ent, void *include_hidden);
+int dir_cmp_name(const dir_entry_t *a, const dir_entry_t *b);
+
+#endif
@@ -3,17 +3,41 @@
 
 #include "utils/types.h"
 #include "libs/fatfs/ff.h"
+#include "libs/fatfs/ffro.h"
 #include "storage/sdmmc.h"
 #include "storage/sdmmc_driver.h"
 
 extern sdmmc_t g_sd_sdmmc;
 extern sdmmc_storage_t g_sd_storage;
 extern FATFS g_sd_fs;
+extern ffro_t g_sd_ffro;
 extern bool g_sd_mounted;
 
 bool sd_mount();
 void sd_unmount();
 void *sd_file_read(char *path, void *ext_buf);
+/*
+ * Pipelined reads, the SE processes a chunk while the next one is read.
+ * sd_read_pipelined() reads size bytes from the current position of fp and
+ * runs op on each chunk, op starts an asynchronous SE operation.
+ * sd_pipe_ctr() and sd_pipe_cbc_dec() decrypt in place, sd_file_sha256() hashes
+ * through buf, which holds 2 chunks and is allocated when NULL.
+ */
+#define SD_PIPE_CHUNK 0x10000
+#define SD_PIPE_TAIL  0x2000 // About what the last chunk is cut down to.
+
+typedef int (*sd_pipe_op_t)(void *chunk, u32 size, u32 offset, void *arg);
+
+typedef struct _sd_pipe_aes_t
+{
+	u32 ks;
+	u8  iv[0x10]; // Initial counter for CTR, chaining value for CBC.
+} sd_pipe_aes_t;
+
+int sd_read_pipelined(FIL *fp, void *buf, bool ring, u32 size, sd_pipe_op_t op, void *arg);
+int sd_pipe_ctr(void *chunk, u32 size, u32 offset, void *arg);
+int sd_pipe_cbc_dec(void *chunk, u32 size, u32 offset, void *arg);
+int sd_file_sha256(const char *path, void *hash, void *buf);
 int sd_save_to_file(void *buf, u32 size, const char *filename);
 bool sd_file_exists(const char* filename);
 void flipVertically(unsigned char* pixels_buffer, const unsigned int width, const unsigned int height, const int bytes_per_pixel);
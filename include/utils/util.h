@@ -48,6 +48,11 @@ void power_off(void);
 /* every 128 Bytes block. Intented only for Backup and Restore          */
 u32 memcmp32sparse(const u32 *buf1, const u32 *buf2, u32 len);
 
+/* Word fill and copy with 32 byte STM bursts, see mem32.s. Buffers must be */
+/* word aligned and len a multiple of 4.                                   */
+void memset32(u32 *dst, u32 val, u32 len);
+void memcpy32(u32 *dst, const u32 *src, u32 len);
+
 __attribute__((noreturn)) void wait_for_button_and_reboot(void);
 
 /**
@@ -25,6 +25,14 @@
 #include "gfx/gfx.h"
 #include "soc/hw_init.h"
 #include "mem/heap.h"
+#include "sec/keyslot.h"
+
+#ifdef PAYLOAD_SIGNED
+#include "sec/rsa.h"
+#include "payload_key.h"
+
+#define PAYLOAD_KEY_RS     0
+#endif
 
 // This is a safe and unused DRAM region for our payloads.
 #define IPL_LOAD_ADDR      0x40008000
@@ -34,6 +42,27 @@
 #define PAYLOAD_ENTRY      0x40010000
 #define CBFS_SDRAM_EN_ADDR 0x4003E000
 #define COREBOOT_ADDR      (0xD0000000 - 0x100000)
+#define PAYLOAD_MAX_SIZE   0x30000
+
+/*
+ * Encrypted payloads start with this header, the data follows it. The key
+ * is unwrapped from seed with the SBK, CBC data is a whole number of blocks
+ * and size is the plaintext size.
+ */
+#define ENC_PAYLOAD_MAGIC  0x50454944 // "DIEP"
+#define ENC_PAYLOAD_CTR    0
+#define ENC_PAYLOAD_CBC    1
+
+typedef struct _enc_payload_hdr_t
+{
+    u32 magic;
+    u32 mode;
+    u32 size;
+    u32 rsvd;
+    u8  iv[0x10];   // Initial counter or IV.
+    u8  seed[0x10];
+    u8  rsvd2[0x10];
+} enc_payload_hdr_t;
 
 void (*ext_payload_ptr)() = (void *)EXT_PAYLOAD_ADDR;
 
@@ -50,36 +79,155 @@ void reloc_patcher(u32 payload_size)
 	*(vu32 *)(EXT_PAYLOAD_ADDR + IPL_START_OFF) = PAYLOAD_ENTRY;
 }
 
-int launch_payload(char *path)
+// Decrypts in place as the chunks arrive, fp is positioned right after the header.
+static int _load_payload_encrypted(FIL *fp, const enc_payload_hdr_t *hdr, u32 *size)
+{
+    sd_pipe_aes_t aes;
+    u32 data_size = f_size(fp) - sizeof(enc_payload_hdr_t);
+
+    // The launch reads the last word of the payload.
+    if (hdr->mode > ENC_PAYLOAD_CBC || hdr->size < sizeof(u32) || hdr->size > data_size ||
+        data_size > PAYLOAD_MAX_SIZE || (hdr->mode == ENC_PAYLOAD_CBC && (data_size & 0xF)))
+    {
+        gfx_printf(&g_gfx_con, "Invalid encrypted payload!\n");
+        return 1;
+    }
+
+    int ks = keyslot_derive(KEYSLOT_SBK, hdr->seed);
+    if (ks < 0)
+        return 1;
+
+    aes.ks = ks;
+    memcpy(aes.iv, hdr->iv, 0x10);
+    if (!sd_read_pipelined(fp, (void *)RCM_PAYLOAD_ADDR, false, data_size,
+        hdr->mode == ENC_PAYLOAD_CBC ? sd_pipe_cbc_dec : sd_pipe_ctr, &aes))
+    {
+        gfx_printf(&g_gfx_con, "Error decrypting payload!\n");
+        return 1;
+    }
+
+    *size = hdr->size;
+    return 0;
+}
+
+static int _load_payload_fatfs(char *path, u32 *size)
 {
     FIL fp;
+    enc_payload_hdr_t hdr;
+    int res = 1;
+
     if (f_open(&fp, path, FA_READ))
     {
         return 1;
     }
 
-    // Read and copy the payload to our chosen address
-    u32 size = f_size(&fp);
+    *size = f_size(&fp);
 
-    if (size > 0x30000)
+    if (*size >= sizeof(enc_payload_hdr_t))
+    {
+        if (f_read(&fp, &hdr, sizeof(enc_payload_hdr_t), NULL))
+            goto out;
+        if (hdr.magic == ENC_PAYLOAD_MAGIC)
+        {
+            res = _load_payload_encrypted(&fp, &hdr, size);
+            goto out;
+        }
+        f_lseek(&fp, 0);
+    }
+
+    if (*size > PAYLOAD_MAX_SIZE)
     {
         gfx_printf(&g_gfx_con, "payload too large!\n");
-        return 1;
+        goto out;
     }
 
-    if (f_read(&fp, (void *)RCM_PAYLOAD_ADDR, size, NULL))
+    if (*size < sizeof(u32))
+    {
+        gfx_printf(&g_gfx_con, "payload too small!\n");
+        goto out;
+    }
+
+    if (f_read(&fp, (void *)RCM_PAYLOAD_ADDR, *size, NULL))
     {
-        f_close(&fp);
         gfx_printf(&g_gfx_con, "Error loading %s\n", path);
-        return 1;
+        goto out;
     }
 
+    res = 0;
+
+out:
     f_close(&fp);
+    return res;
+}
+
+#ifdef PAYLOAD_SIGNED
+/*
+ * Builds with PAYLOAD_KEY embed an RSA-2048 public key and only launch
+ * payloads with a valid <path>.sig next to them, a PKCS#1 v1.5 SHA-256
+ * signature of the plaintext, see tools/payload_key.py.
+ */
+static int _verify_payload(const char *path, u32 size)
+{
+    FIL fp;
+    u8 sig[RSA2048_SIZE];
+    char *sig_path = (char *)malloc(strlen(path) + 5);
+    int res = 1;
+
+    strcpy(sig_path, path);
+    strcat(sig_path, ".sig");
+    if (!f_open(&fp, sig_path, FA_READ))
+    {
+        if (f_size(&fp) == RSA2048_SIZE && !f_read(&fp, sig, RSA2048_SIZE, NULL) &&
+            rsa2048_verify(PAYLOAD_KEY_RS, &_payload_key, sig, (void *)RCM_PAYLOAD_ADDR, size, RSA_PADDING_PKCS1_V15))
+            res = 0;
+        f_close(&fp);
+    }
+    free(sig_path);
+
+    if (res)
+        gfx_printf(&g_gfx_con, "Payload signature invalid!\n");
+    return res;
+}
+#endif
+
+static bool _ffro_payload_is_encrypted(ffro_file_t *fo)
+{
+    u32 magic = 0;
+    return fo->size >= sizeof(enc_payload_hdr_t) &&
+        ffro_read(&g_sd_ffro, fo, &magic, sizeof(u32)) == FR_OK && magic == ENC_PAYLOAD_MAGIC;
+}
+
+int launch_payload(char *path)
+{
+    ffro_file_t fo;
+    u32 size;
+
+    // Read and copy the payload to our chosen address.
+    // The read-only fast path is tried first, FatFs handles anything it can't and encrypted payloads.
+    if (ffro_open(&g_sd_ffro, &fo, path) == FR_OK &&
+        fo.size >= sizeof(u32) && fo.size <= PAYLOAD_MAX_SIZE && !_ffro_payload_is_encrypted(&fo) &&
+        ffro_read(&g_sd_ffro, &fo, (void *)RCM_PAYLOAD_ADDR, fo.size) == FR_OK)
+    {
+        size = fo.size;
+    }
+    else if (_load_payload_fatfs(path, &size))
+    {
+        return 1;
+    }
+
+#ifdef PAYLOAD_SIGNED
+    if (_verify_payload(path, size))
+        return 1;
+#endif
+
     free(path);
     path = NULL;
 
     sd_unmount();
 
+    // Don't leave derived keys behind for the payload.
+    keyslot_clear_all();
+
     reloc_patcher(ALIGN(size, 0x10));
     reconfig_hw_workaround(false, byte_swap_32(*(vu32 *)(RCM_PAYLOAD_ADDR + size - sizeof(u32))));
 
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "core/overlay.h"
+
+#include <string.h>
+
+#include "libs/compr/lz4.h"
+#include "panic/panic.h"
+
+// Generated by tools/gen_ovl.py.
+extern const ovl_t __ovl_table[];
+
+void ovl_load(u32 id)
+{
+	const ovl_t *ovl = &__ovl_table[id];
+
+	if (ovl_loaded[id])
+		return;
+
+	int size = ovl->end - ovl->start;
+	if (lz4_decompress_block(ovl->blob, ovl->blob_end - ovl->blob, ovl->start, size) != size)
+		panic(0x30); // The blob is part of the image, it only breaks with the image.
+	memset(ovl->end, 0, ovl->bss_end - ovl->end);
+
+	ovl_loaded[id] = 1;
+	if (ovl->init)
+		ovl->init();
+}
@@ -256,10 +256,22 @@ void set_active_framebuffer(u32 *address)
     exec_cfg((u32 *)DISPLAY_A_BASE, cfg_display_framebuffer, 32);
 } 
 
+void set_framebuffer_stride(u32 stride)
+{
+    cfg_display_framebuffer[16].val = UV_LINE_STRIDE(stride * 2) | LINE_STRIDE(stride * 4);
+}
+
+void set_framebuffer_offset(u32 offset)
+{
+    // Pixels skipped at the start of each line, kept across buffer swaps.
+    cfg_display_framebuffer[20].val = offset * 4;
+    exec_cfg((u32 *)DISPLAY_A_BASE, cfg_display_framebuffer, 32);
+}
+
 u32 *display_init_framebuffer()
 {
 	// Sanitize framebuffer area.
-	memset((u32 *)0xC0000000, 0, 0x3C0000);
+	memset32((u32 *)0xC0000000, 0, 0x3C0000);
 	// This configures the framebuffer @ 0xC0000000 with a resolution of 1280x720 (line stride 768).
 	exec_cfg((u32 *)DISPLAY_A_BASE, cfg_display_framebuffer, 32);
 
@@ -22,6 +22,7 @@
 
 #include "utils/fs_utils.h"
 #include "utils/util.h"
+#include "libs/compr/lz4.h"
 #include "mem/heap.h"
 #include <string.h>
 
@@ -31,14 +32,90 @@
 
 void gfx_init_ctxt(gfx_ctxt_t *ctxt, u32 *fb, u32 width, u32 height, u32 stride)
 {
+    memset(ctxt, 0, sizeof(gfx_ctxt_t));
     ctxt->fb = fb;
     ctxt->width = width;
     ctxt->height = height;
     ctxt->stride = stride;
     ctxt->next = fb + ctxt->width * ctxt->stride * 4;
+    set_framebuffer_stride(stride);
     set_active_framebuffer(fb);
 }
 
+static u32 _gfx_rect_area(u32 row0, u32 col0, u32 row1, u32 col1)
+{
+    return (row1 - row0) * (col1 - col0);
+}
+
+/*
+ * Records rows [row, row + rows) and row pixels [col, col + cols) of buf as
+ * drawn. Only what went into the back buffer is kept for the next swap, what
+ * was drawn straight into the shown buffer is left behind by it as before.
+ */
+static void _gfx_dirty(gfx_ctxt_t *ctxt, const u32 *buf, u32 row, u32 col, u32 rows, u32 cols)
+{
+    u32 row1 = MIN(row + rows, ctxt->width);
+    u32 col1 = MIN(col + cols, ctxt->stride);
+    gfx_rect_t *dst = NULL;
+
+    if (row >= row1 || col >= col1)
+        return;
+    ctxt->draw_bytes += _gfx_rect_area(row, col, row1, col1) * 4;
+    if (buf != ctxt->next)
+        return;
+
+    // Join a region it touches, if any.
+    for (u32 i = 0; i < ctxt->dirty_num && !dst; i++)
+    {
+        gfx_rect_t *r = &ctxt->dirty[i];
+        if (row <= r->row1 && r->row0 <= row1 && col <= r->col1 && r->col0 <= col1)
+            dst = r;
+    }
+
+    if (!dst && ctxt->dirty_num < GFX_DIRTY_MAX)
+    {
+        dst = &ctxt->dirty[ctxt->dirty_num++];
+        dst->row0 = row;
+        dst->col0 = col;
+        dst->row1 = row1;
+        dst->col1 = col1;
+        return;
+    }
+
+    // Out of regions, grow the one that grows the least.
+    if (!dst)
+    {
+        u32 best = ~0;
+        for (u32 i = 0; i < GFX_DIRTY_MAX; i++)
+        {
+            gfx_rect_t *r = &ctxt->dirty[i];
+            u32 growth = _gfx_rect_area(MIN(r->row0, row), MIN(r->col0, col), MAX(r->row1, row1), MAX(r->col1, col1)) -
+                _gfx_rect_area(r->row0, r->col0, r->row1, r->col1);
+            if (growth < best)
+            {
+                best = growth;
+                dst = r;
+            }
+        }
+    }
+
+    dst->row0 = MIN(dst->row0, row);
+    dst->col0 = MIN(dst->col0, col);
+    dst->row1 = MAX(dst->row1, row1);
+    dst->col1 = MAX(dst->col1, col1);
+}
+
+// Same for a console rectangle in fb, console x runs backwards through the rows.
+static void _gfx_dirty_con(gfx_ctxt_t *ctxt, u32 x, u32 y, u32 w, u32 h)
+{
+    if (!w || x > ctxt->width)
+        return;
+
+    u32 last = x + w - 1;
+    u32 row = last < ctxt->width ? ctxt->width - last : 0;
+    _gfx_dirty(ctxt, ctxt->fb, row, y, ctxt->width - x + 1 - row, h);
+}
+
 void gfx_end_ctxt(gfx_ctxt_t *ctxt)
 {
     gfx_clear_buffer(ctxt);
@@ -48,8 +125,8 @@ void gfx_end_ctxt(gfx_ctxt_t *ctxt)
 
 void gfx_clear_buffer(gfx_ctxt_t *ctxt)
 {
-    for(int i = 0; i < ctxt->width * ctxt->stride; i++)
-        ctxt->fb[i] = 0xFF000000;
+    memset32(ctxt->fb, 0xFF000000, ctxt->width * ctxt->stride * 4);
+    _gfx_dirty(ctxt, ctxt->fb, 0, 0, ctxt->width, ctxt->stride);
 }
 void gfx_swap_buffer(gfx_ctxt_t *ctxt)
 {
@@ -58,22 +135,43 @@ void gfx_swap_buffer(gfx_ctxt_t *ctxt)
     ctxt->next = tmp;
     set_active_framebuffer(ctxt->fb);
     //gfx_clear_buffer(ctxt);
+
+    // The new back buffer only lacks what was drawn since the last swap.
+    for (u32 i = 0; i < ctxt->dirty_num; i++)
+    {
+        gfx_rect_t *r = &ctxt->dirty[i];
+        u32 size = (r->col1 - r->col0) * 4;
+        if (size == ctxt->stride * 4)
+            memcpy32(&ctxt->next[r->row0 * ctxt->stride], &ctxt->fb[r->row0 * ctxt->stride], size * (r->row1 - r->row0));
+        else
+            for (u32 row = r->row0; row < r->row1; row++)
+                memcpy32(&ctxt->next[r->col0 + row * ctxt->stride], &ctxt->fb[r->col0 + row * ctxt->stride], size);
+        ctxt->sync_bytes += size * (r->row1 - r->row0);
+    }
+    ctxt->dirty_num = 0;
+
+    ctxt->last_draw_bytes = ctxt->draw_bytes;
+    ctxt->last_sync_bytes = ctxt->sync_bytes;
+    ctxt->draw_bytes = 0;
+    ctxt->sync_bytes = 0;
 }
 
 void gfx_clear_grey(gfx_ctxt_t *ctxt, u8 color)
 {
-	memset(ctxt->next, color, ctxt->width * ctxt->stride * 4);
+	memset32(ctxt->next, color * 0x01010101u, ctxt->width * ctxt->stride * 4);
+	_gfx_dirty(ctxt, ctxt->next, 0, 0, ctxt->width, ctxt->stride);
 }
 
 void gfx_clear_color(gfx_ctxt_t *ctxt, u32 color)
 {
-    for(int i = 0; i < ctxt->width * ctxt->stride; i++)
-        ctxt->fb[i] = color;
+    memset32(ctxt->fb, color, ctxt->width * ctxt->stride * 4);
+    _gfx_dirty(ctxt, ctxt->fb, 0, 0, ctxt->width, ctxt->stride);
 }
 
 void gfx_clear_partial_grey(gfx_ctxt_t *ctxt, u8 color, u32 pos_x, u32 height)
 {
-    memset(ctxt->next + pos_x * ctxt->stride, color, height * 4 * ctxt->stride);
+    memset32(ctxt->next + pos_x * ctxt->stride, color * 0x01010101u, height * 4 * ctxt->stride);
+    _gfx_dirty(ctxt, ctxt->next, pos_x, 0, height, ctxt->stride);
 }
 
 void gfx_con_init(gfx_con_t *con, gfx_ctxt_t *ctxt)
@@ -88,6 +186,10 @@ void gfx_con_init(gfx_con_t *con, gfx_ctxt_t *ctxt)
     con->fillbg = 0;
     con->bgcol = 0xFF000000;
     con->mute = 0;
+    con->ring = false;
+    con->ring_len = 0;
+    con->ring_top = 0;
+    con->ring_end = 0;
 }
 
 void gfx_con_setcol(gfx_con_t *con, u32 fgcol, int fillbg, u32 bgcol)
@@ -109,46 +211,229 @@ void gfx_con_setpos(gfx_con_t *con, u32 x, u32 y)
     con->y = y;
 }
 
-void gfx_putc(gfx_con_t *con, char c)
+#define GFX_GLYPHS (176 - 32)
+#define GFX_GLYPH_SETS 4
+
+typedef struct _gfx_glyph_set_t
 {
-    int shift_amount = 0;
-    if (c >= 32 && (unsigned char)c <= 175)
+    u8 scale;
+    u32 fgcol;
+    u32 bgcol;
+    u32 *glyphs[GFX_GLYPHS]; // Scaled glyph columns, each a run of CHAR_HEIGHT * scale pixels.
+} gfx_glyph_set_t;
+
+// Font columns as they lie in the rotated framebuffer, bit n is row n.
+static u32 *_gfx_font_cols;
+// Glyphs drawn with a background are cached per scale and colors.
+static gfx_glyph_set_t *_gfx_glyph_sets;
+static u32 _gfx_glyph_set_next;
+
+static void _gfx_font_rotate()
+{
+    _gfx_font_cols = (u32 *)calloc(GFX_GLYPHS * CHAR_WIDTH, sizeof(u32));
+    for (u32 g = 0; g < GFX_GLYPHS; g++)
     {
-        u8 *cbuf = (u8 *)&_gfx_font[(CHAR_HEIGHT * CHAR_WIDTH) / 8 * (c - 32)];
-        u8 v = *cbuf;
-        for (u32 i = 0; i < CHAR_HEIGHT * con->scale; i += con->scale)
+        const u8 *cbuf = &_gfx_font[(CHAR_HEIGHT * CHAR_WIDTH) / 8 * g];
+        u32 *cols = &_gfx_font_cols[CHAR_WIDTH * g];
+        for (u32 n = 0; n < CHAR_HEIGHT * CHAR_WIDTH; n++)
+            if (cbuf[n >> 3] & (0x80 >> (n & 7)))
+                cols[n % CHAR_WIDTH] |= 1u << (n / CHAR_WIDTH);
+    }
+}
+
+static const u32 *_gfx_glyph_get(gfx_con_t *con, u32 g)
+{
+    gfx_glyph_set_t *set = NULL;
+    u32 run = CHAR_HEIGHT * con->scale;
+
+    if (!_gfx_glyph_sets)
+        _gfx_glyph_sets = (gfx_glyph_set_t *)calloc(GFX_GLYPH_SETS, sizeof(gfx_glyph_set_t));
+
+    for (u32 i = 0; i < GFX_GLYPH_SETS; i++)
+    {
+        gfx_glyph_set_t *s = &_gfx_glyph_sets[i];
+        if (s->scale == con->scale && s->fgcol == con->fgcol && s->bgcol == con->bgcol)
+        {
+            set = s;
+            break;
+        }
+    }
+
+    // Replace the oldest set.
+    if (!set)
+    {
+        set = &_gfx_glyph_sets[_gfx_glyph_set_next];
+        _gfx_glyph_set_next = (_gfx_glyph_set_next + 1) % GFX_GLYPH_SETS;
+        for (u32 i = 0; i < GFX_GLYPHS; i++)
         {
-            for (u32 j = 0; j < CHAR_WIDTH; j++)
+            free(set->glyphs[i]);
+            set->glyphs[i] = NULL;
+        }
+        set->scale = con->scale;
+        set->fgcol = con->fgcol;
+        set->bgcol = con->bgcol;
+    }
+
+    if (!set->glyphs[g])
+    {
+        const u32 *cols = &_gfx_font_cols[CHAR_WIDTH * g];
+        u32 *p = (u32 *)malloc(CHAR_WIDTH * con->scale * run * sizeof(u32));
+        set->glyphs[g] = p;
+        for (u32 j = 0; j < CHAR_WIDTH; j++)
+        {
+            for (u32 i = 0; i < CHAR_HEIGHT; i++)
             {
-                for(u32 z = 0; z < con->scale; z++)
-                {
-                   if (v & (0x80 >> shift_amount))
-                    {
-                        for(u32 k = 0; k < con->scale; k++)
-                        {
-                            gfx_set_pixel(con->gfx_ctxt, con->x + k + j * con->scale, con->y + i + z, con->fgcol);   
-                        }
-                    }
-                    else if (con->fillbg)
-                    {
-                        for(u32 k = 0; k < con->scale; k++)
-                        {
-                            gfx_set_pixel(con->gfx_ctxt, con->x + k + j * con->scale, con->y + i + z, con->bgcol);
-                        }
-                    }
-                }
-                shift_amount = (shift_amount + 1) % 8;
-                if(shift_amount == 0)
-                {
-                    cbuf++;
-                    v = *cbuf;
-                }
+                u32 color = (cols[j] >> i) & 1 ? con->fgcol : con->bgcol;
+                for (u32 z = 0; z < con->scale; z++)
+                    *p++ = color;
+            }
+            for (u32 k = 1; k < con->scale; k++, p += run)
+                memcpy32(p, p - run, run * sizeof(u32));
+        }
+    }
+
+    return set->glyphs[g];
+}
+
+static void _gfx_con_glyph(gfx_con_t *con, u32 g, u32 y)
+{
+    gfx_ctxt_t *ctxt = con->gfx_ctxt;
+    u32 run = CHAR_HEIGHT * con->scale;
+    // Console x runs backwards through the framebuffer rows, y along them.
+    u32 *dst = &ctxt->fb[y + (ctxt->width - con->x) * ctxt->stride];
+
+    if (con->fillbg)
+    {
+        const u32 *glyph = _gfx_glyph_get(con, g);
+        for (u32 k = 0; k < CHAR_WIDTH * con->scale; k++, dst -= ctxt->stride, glyph += run)
+            memcpy32(dst, glyph, run * sizeof(u32));
+    }
+    else
+    {
+        const u32 *cols = &_gfx_font_cols[CHAR_WIDTH * g];
+        for (u32 j = 0; j < CHAR_WIDTH; j++)
+        {
+            for (u32 k = 0; k < con->scale; k++, dst -= ctxt->stride)
+            {
+                u32 *p = dst;
+                for (u32 m = cols[j]; m; m >>= 1, p += con->scale)
+                    if (m & 1)
+                        for (u32 z = 0; z < con->scale; z++)
+                            p[z] = con->fgcol;
             }
         }
+    }
+    _gfx_dirty_con(ctxt, con->x, y, CHAR_WIDTH * con->scale, run);
+}
+
+/*
+ * Ring mode keeps every line twice, at y and y + ring_len, so any ring_len
+ * long stretch of a framebuffer row reads as the ring rotated. Scrolling is
+ * then only a new display offset, each new line costs one line clear.
+ */
+static void _gfx_con_ring_clear(gfx_con_t *con, u32 y, u32 len)
+{
+    gfx_ctxt_t *ctxt = con->gfx_ctxt;
+
+    for (u32 i = 0; i < 2; i++, y += con->ring_len)
+    {
+        u32 *dst = &ctxt->fb[y];
+        for (u32 row = 0; row < ctxt->width; row++, dst += ctxt->stride)
+            memset32(dst, con->bgcol, len * sizeof(u32));
+        _gfx_dirty(ctxt, ctxt->fb, 0, y, ctxt->width, len);
+    }
+}
+
+// Clears the current line up to len, if not done yet, and scrolls it into view.
+static void _gfx_con_ring_line(gfx_con_t *con, u32 len)
+{
+    // Distance from the top of the screen to the end of what was cleared.
+    u32 fill = (con->ring_end + con->ring_len - con->ring_top) % con->ring_len;
+
+    // A line never straddles the end of the ring.
+    if (con->y + len > con->ring_len)
+    {
+        _gfx_con_ring_clear(con, con->ring_end, con->ring_len - con->ring_end);
+        fill += con->ring_len - con->ring_end;
+        con->y = 0;
+        con->ring_end = 0;
+    }
+
+    u32 end = con->y + len;
+    if (end <= con->ring_end)
+        return;
+    _gfx_con_ring_clear(con, con->ring_end, end - con->ring_end);
+    fill += end - con->ring_end;
+    con->ring_end = end;
+
+    if (fill > con->gfx_ctxt->height)
+    {
+        con->ring_top = (con->ring_top + fill - con->gfx_ctxt->height) % con->ring_len;
+        set_framebuffer_offset(con->ring_top);
+    }
+}
+
+static void _gfx_con_ring_newline(gfx_con_t *con)
+{
+    u32 line = CHAR_HEIGHT * con->scale;
+
+    con->x = 0;
+    con->y = MIN(con->y + line, con->ring_len);
+    _gfx_con_ring_line(con, line);
+}
+
+/*
+ * Switches the console to a scrolling ring of lines. The context needs a
+ * stride of at least twice its height, rounded up to whole lines of the
+ * current scale (1536 for 720 at scale 2). Console y is a ring position
+ * while enabled.
+ */
+int gfx_con_ring(gfx_con_t *con, bool enable)
+{
+    gfx_ctxt_t *ctxt = con->gfx_ctxt;
+    u32 line = CHAR_HEIGHT * con->scale;
+    u32 len = (ctxt->height + line - 1) / line * line;
+
+    if (enable && ctxt->stride < len * 2)
+        return 0;
+
+    con->ring = enable;
+    con->ring_len = enable ? len : 0;
+    con->ring_top = 0;
+    con->ring_end = 0;
+    con->x = 0;
+    con->y = 0;
+    if (enable)
+        _gfx_con_ring_clear(con, 0, len);
+    set_framebuffer_offset(0);
+
+    return 1;
+}
+
+void gfx_putc(gfx_con_t *con, char c)
+{
+    if (c >= 32 && (unsigned char)c <= 175)
+    {
+        u32 g = (unsigned char)c - 32;
+        u32 run = CHAR_HEIGHT * con->scale;
+
+        if (!_gfx_font_cols)
+            _gfx_font_rotate();
+
+        if (con->ring)
+            _gfx_con_ring_line(con, run);
+        _gfx_con_glyph(con, g, con->y);
+        if (con->ring && con->y + con->ring_len + run <= con->gfx_ctxt->stride)
+            _gfx_con_glyph(con, g, con->y + con->ring_len);
         con->x += CHAR_WIDTH * con->scale;
     }
     else if (c == '\n')
     {
+        if (con->ring)
+        {
+            _gfx_con_ring_newline(con);
+            return;
+        }
         con->x = 0;
         con->y += CHAR_HEIGHT * con->scale;
         if (con->y > con->gfx_ctxt->height - CHAR_HEIGHT)
@@ -348,20 +633,90 @@ static int abs(int x)
     return x;
 }
 
-void gfx_set_pixel(gfx_ctxt_t *ctxt, u32 x, u32 y, u32 color)
+static void _gfx_set_pixel(gfx_ctxt_t *ctxt, u32 x, u32 y, u32 color)
 {
     ctxt->fb[y + (ctxt->width - x) * ctxt->stride] = color;
 }
 
+void gfx_set_pixel(gfx_ctxt_t *ctxt, u32 x, u32 y, u32 color)
+{
+    _gfx_set_pixel(ctxt, x, y, color);
+    _gfx_dirty_con(ctxt, x, y, 1, 1);
+}
+
+#define GFX_BLIT_TILE 16
+
+/*
+ * A console row is a framebuffer column, so a plain row by row copy writes
+ * one pixel per framebuffer row. Copying 16x16 tiles keeps the writes
+ * contiguous and the source rows they read from in cache.
+ */
+static void _gfx_blit_tile(gfx_ctxt_t *ctxt, const u32 *buf, int buf_stride, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y)
+{
+    for (u32 i = 0; i < size_x; i++)
+    {
+        u32 *dst = &ctxt->fb[pos_y + (ctxt->width - pos_x - i) * ctxt->stride];
+        const u32 *src = buf + i;
+        for (u32 j = 0; j < size_y; j++, src += buf_stride)
+            dst[j] = *src;
+    }
+}
+
+static void _gfx_blit_tile_transparent(gfx_ctxt_t *ctxt, const u32 *buf, int buf_stride, u32 size_x, u32 size_y,
+    u32 pos_x, u32 pos_y, u32 transparent_color)
+{
+    for (u32 i = 0; i < size_x; i++)
+    {
+        u32 *dst = &ctxt->fb[pos_y + (ctxt->width - pos_x - i) * ctxt->stride];
+        const u32 *src = buf + i;
+        for (u32 j = 0; j < size_y; j++, src += buf_stride)
+            if (*src != transparent_color)
+                dst[j] = *src;
+    }
+}
+
+static void _gfx_blit(gfx_ctxt_t *ctxt, const u32 *buf, int buf_stride, u32 size_x, u32 size_y,
+    u32 pos_x, u32 pos_y, bool transparent, u32 transparent_color)
+{
+    _gfx_dirty_con(ctxt, pos_x, pos_y, size_x, size_y);
+
+    for (u32 ty = 0; ty < size_y; ty += GFX_BLIT_TILE)
+    {
+        u32 th = MIN(GFX_BLIT_TILE, size_y - ty);
+        for (u32 tx = 0; tx < size_x; tx += GFX_BLIT_TILE)
+        {
+            u32 tw = MIN(GFX_BLIT_TILE, size_x - tx);
+            const u32 *src = buf + (int)ty * buf_stride + tx;
+            if (transparent)
+                _gfx_blit_tile_transparent(ctxt, src, buf_stride, tw, th, pos_x + tx, pos_y + ty, transparent_color);
+            else
+                _gfx_blit_tile(ctxt, src, buf_stride, tw, th, pos_x + tx, pos_y + ty);
+        }
+    }
+}
+
+void gfx_blit(gfx_ctxt_t *ctxt, const u32 *buf, int buf_stride, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y)
+{
+    _gfx_blit(ctxt, buf, buf_stride, size_x, size_y, pos_x, pos_y, false, 0);
+}
+
+void gfx_blit_transparent(gfx_ctxt_t *ctxt, const u32 *buf, int buf_stride, u32 size_x, u32 size_y,
+    u32 pos_x, u32 pos_y, u32 transparent_color)
+{
+    _gfx_blit(ctxt, buf, buf_stride, size_x, size_y, pos_x, pos_y, true, transparent_color);
+}
+
 void gfx_line(gfx_ctxt_t *ctxt, int x0, int y0, int x1, int y1, u32 color)
 {
     int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
     int dy = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
     int err = (dx > dy ? dx : -dy) / 2, e2;
 
+    _gfx_dirty_con(ctxt, MIN(x0, x1), MIN(y0, y1), dx + 1, dy + 1);
+
     while (1)
     {
-        gfx_set_pixel(ctxt, x0, y0, color);
+        _gfx_set_pixel(ctxt, x0, y0, color);
         if (x0 == x1 && y0 == y1)
             break;
         e2 = err;
@@ -385,10 +740,11 @@ void gfx_set_rect_grey(gfx_ctxt_t *ctxt, const u8 *buf, u32 size_x, u32 size_y,
     {
         for (u32 x = pos_x; x < (pos_x + size_x); x++)
         {
-            memset(&ctxt->next[x + y * ctxt->stride], buf[pos], 4);
+            ctxt->next[x + y * ctxt->stride] = buf[pos] * 0x01010101u;
             pos++;
         }
     }
+    _gfx_dirty(ctxt, ctxt->next, pos_y, pos_x, size_y, size_x);
 }
 
 void gfx_set_rect_rgb(gfx_ctxt_t *ctxt, const u8 *buf, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y)
@@ -402,14 +758,15 @@ void gfx_set_rect_rgb(gfx_ctxt_t *ctxt, const u8 *buf, u32 size_x, u32 size_y, u
             pos += 3;
         }
     }
+    _gfx_dirty(ctxt, ctxt->next, pos_y, pos_x, size_y, size_x);
 }
 
 void gfx_set_rect_argb(gfx_ctxt_t *ctxt, const u32 *buf, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y)
 {
-    u32 *ptr = (u32 *)buf;
-    for (u32 y = pos_y; y < (pos_y + size_y); y++)
-        for (u32 x = pos_x; x < (pos_x + size_x); x++)
-            ctxt->next[x + y * ctxt->stride] = *ptr++;
+    // Already in framebuffer orientation, each row is one copy.
+    for (u32 y = pos_y; y < (pos_y + size_y); y++, buf += size_x)
+        memcpy32(&ctxt->next[pos_x + y * ctxt->stride], buf, size_x * 4);
+    _gfx_dirty(ctxt, ctxt->next, pos_y, pos_x, size_y, size_x);
 }
 
 void gfx_render_bmp_argb(gfx_ctxt_t *ctxt, const u32 *buf, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y)
@@ -419,73 +776,176 @@ void gfx_render_bmp_argb(gfx_ctxt_t *ctxt, const u32 *buf, u32 size_x, u32 size_
 
 void gfx_render_bmp_argb_transparent(gfx_ctxt_t *ctxt, const u32 *buf, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y, u32 transparent_color)
 {
-    for (u32 y = pos_y; y < (pos_y + size_y); y++)
+    if (!size_x || !size_y)
+        return;
+
+    // BMP rows are stored bottom up.
+    gfx_blit_transparent(ctxt, buf + (size_y - 1) * size_x, -(int)size_x, size_x, size_y, pos_x, pos_y, transparent_color);
+}
+
+
+#define GFX_BMP_HDR_SIZE 54
+// With BI_BITFIELDS the masks follow, alpha only in V3 and later info headers.
+#define GFX_BMP_MASKS_SIZE 70
+#define GFX_BMP_RGB        0
+#define GFX_BMP_BITFIELDS  3
+#define GFX_BMP_CHUNK    0x10000
+
+typedef int (*gfx_bmp_read_t)(void *src, void *buf, u32 offset, u32 size);
+
+static u32 _gfx_get_u32(const u8 *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+}
+
+// Only the usual masks are drawn, the pixels are used as they are.
+static bool _gfx_bmp_masks_ok(const u8 *hdr, u32 hdr_size, u32 offset)
+{
+    u32 info_size = _gfx_get_u32(hdr + 14);
+    u32 end = info_size >= 56 ? GFX_BMP_MASKS_SIZE : GFX_BMP_HDR_SIZE + 12;
+
+    if (hdr_size < end || offset < end)
+        return false;
+    if (_gfx_get_u32(hdr + 54) != 0x00FF0000 || _gfx_get_u32(hdr + 58) != 0x0000FF00 ||
+        _gfx_get_u32(hdr + 62) != 0x000000FF)
+        return false;
+
+    return end == GFX_BMP_HDR_SIZE + 12 || !_gfx_get_u32(hdr + 66) || _gfx_get_u32(hdr + 66) == 0xFF000000;
+}
+
+// hdr holds the first hdr_size bytes of the file.
+static bool _gfx_bmp_parse(const u8 *hdr, u32 hdr_size, u32 file_size, u32 width, u32 height, bmp_data_t *bmp)
+{
+    if (hdr_size < GFX_BMP_HDR_SIZE)
+        return false;
+
+    // Get values manually to avoid unaligned access.
+    s32 size_y = (s32)_gfx_get_u32(hdr + 22);
+    u32 compression = _gfx_get_u32(hdr + 30);
+
+    bmp->size = file_size;
+    bmp->offset = _gfx_get_u32(hdr + 10);
+    bmp->size_x = _gfx_get_u32(hdr + 18);
+    bmp->top_down = size_y < 0;
+    bmp->size_y = bmp->top_down ? 0 - (u32)size_y : (u32)size_y;
+    bmp->bpp = hdr[28];
+
+    // Sanity check. Uncompressed data only, 32-bit files may carry the usual bitfields.
+    if (hdr[0] != 'B' || hdr[1] != 'M' ||
+        !bmp->size_x || bmp->size_x > width ||
+        !bmp->size_y || bmp->size_y > height)
+        return false;
+    if (compression == GFX_BMP_BITFIELDS)
+    {
+        if (bmp->bpp != 32 || !_gfx_bmp_masks_ok(hdr, hdr_size, bmp->offset))
+            return false;
+    }
+    else if (compression != GFX_BMP_RGB || (bmp->bpp != 32 && bmp->bpp != 24))
+        return false;
+
+    // Rows are padded to 4 bytes.
+    bmp->row_size = ALIGN(bmp->size_x * (bmp->bpp >> 3), 4);
+    if (bmp->offset < GFX_BMP_HDR_SIZE || bmp->offset > file_size ||
+        bmp->row_size * bmp->size_y > file_size - bmp->offset)
+        return false;
+
+    bmp->pos_x = (width - bmp->size_x) >> 1;
+    bmp->pos_y = (height - bmp->size_y) >> 1;
+
+    return true;
+}
+
+/*
+ * Reads the pixel data a few rows at a time and blits each chunk as soon as
+ * it is read, so no copy of the whole image is ever made.
+ */
+static void _gfx_bmp_render(gfx_ctxt_t *ctxt, const bmp_data_t *bmp, gfx_bmp_read_t read, void *src,
+    u32 x, u32 y, u32 width, u32 height, u32 transparent_color)
+{
+    // Whole rows of tiles per chunk, as long as they fit.
+    u32 rows = MAX(GFX_BMP_CHUNK / bmp->row_size / GFX_BLIT_TILE, 1) * GFX_BLIT_TILE;
+    rows = MIN(rows, bmp->size_y);
+
+    u8 *raw = (u8 *)malloc(bmp->row_size * rows);
+    u32 *pixels = (bmp->bpp == 32) ? (u32 *)raw : (u32 *)malloc(bmp->size_x * rows * 4);
+
+    for (u32 row = 0; row < bmp->size_y; row += rows)
     {
-        for (u32 x = pos_x; x < (pos_x + size_x); x++) 
+        u32 num = MIN(rows, bmp->size_y - row);
+        if (!read(src, raw, bmp->offset + row * bmp->row_size, num * bmp->row_size))
+            break;
+
+        if (bmp->bpp == 24)
         {
-            u32 render_color = buf[(size_y + pos_y - 1 - y) * size_x + x - pos_x];
-        
-            if (render_color != transparent_color)
-                gfx_set_pixel(ctxt, x, y, render_color);
+            u32 *dst = pixels;
+            for (u32 i = 0; i < num; i++)
+            {
+                const u8 *p = raw + i * bmp->row_size;
+                for (u32 j = 0; j < bmp->size_x; j++, p += 3)
+                    *dst++ = 0xFF000000 | p[0] | (p[1] << 8) | (p[2] << 16);
+            }
         }
+
+        // Get background color from 1st pixel.
+        if (!row && (bmp->size_x < width || bmp->size_y < height))
+            gfx_clear_color(ctxt, pixels[0]);
+
+        if (bmp->top_down)
+            gfx_blit_transparent(ctxt, pixels, bmp->size_x, bmp->size_x, num,
+                bmp->pos_x + x, bmp->pos_y + y + row, transparent_color);
+        else
+            gfx_blit_transparent(ctxt, pixels + (num - 1) * bmp->size_x, -(int)bmp->size_x, bmp->size_x, num,
+                bmp->pos_x + x, bmp->pos_y + y + bmp->size_y - row - num, transparent_color);
     }
+
+    if (pixels != (u32 *)raw)
+        free(pixels);
+    free(raw);
 }
 
+static int _gfx_bmp_read_file(void *src, void *buf, u32 offset, u32 size)
+{
+    FIL *fp = (FIL *)src;
+    UINT br;
+
+    if (f_tell(fp) != offset && f_lseek(fp, offset) != FR_OK)
+        return 0;
+
+    return f_read(fp, buf, size, &br) == FR_OK && br == size;
+}
+
+static int _gfx_bmp_read_mem(void *src, void *buf, u32 offset, u32 size)
+{
+    // Avoid unaligned access from BM 2-byte MAGIC.
+    memcpy(buf, (u8 *)src + offset, size);
+    return 1;
+}
 
 void gfx_render_bmp_arg_file(gfx_ctxt_t *ctxt, char *path, u32 x, u32 y, u32 width, u32 height)
 {
-    u8 *bitmap = (u8 *)sd_file_read(path, NULL);
-    gfx_render_bmp_arg_bitmap(ctxt, bitmap, x, y, width, height);
-    free(bitmap);
-    bitmap = NULL;
+    FIL fp;
+    u8 hdr[GFX_BMP_MASKS_SIZE];
+    bmp_data_t bmp_data;
+    UINT br;
+
+    if (f_open(&fp, path, FA_READ) != FR_OK)
+        return;
+
+    if (f_read(&fp, hdr, GFX_BMP_MASKS_SIZE, &br) == FR_OK &&
+        _gfx_bmp_parse(hdr, br, f_size(&fp), width, height, &bmp_data))
+        _gfx_bmp_render(ctxt, &bmp_data, _gfx_bmp_read_file, &fp, x, y, width, height, TRANSPARENT_COLOR);
+
+    f_close(&fp);
 }
 
 void gfx_render_bmp_arg_bitmap_transparent(gfx_ctxt_t *ctxt, u8 *bitmap, u32 x, u32 y, u32 width, u32 height, u32 transparent_color)
 {
     bmp_data_t bmp_data;
-    u8 *image = NULL;
-    bool image_found = false;
 
-    if (bitmap != NULL)
-    {
-        // Get values manually to avoid unaligned access.
-        bmp_data.size = bitmap[2] | bitmap[3] << 8 |
-                        bitmap[4] << 16 | bitmap[5] << 24;
-        bmp_data.offset = bitmap[10] | bitmap[11] << 8 |
-                          bitmap[12] << 16 | bitmap[13] << 24;
-        bmp_data.size_x = bitmap[18] | bitmap[19] << 8 |
-                          bitmap[20] << 16 | bitmap[21] << 24;
-        bmp_data.size_y = bitmap[22] | bitmap[23] << 8 |
-                          bitmap[24] << 16 | bitmap[25] << 24;
-        // Sanity check.
-        if (bitmap[0] == 'B' &&
-            bitmap[1] == 'M' &&
-            bitmap[28] == 32 && //
-            bmp_data.size_x <= width &&
-            bmp_data.size_y <= height)
-        {
-            if ((bmp_data.size - bmp_data.offset) <= 0x400000)
-            {
-                // Avoid unaligned access from BM 2-byte MAGIC and remove header.
-                image = (u8 *)malloc(0x400000);
-                memcpy(image, bitmap + bmp_data.offset, bmp_data.size - bmp_data.offset);
-                bmp_data.pos_x = (width - bmp_data.size_x) >> 1;
-                bmp_data.pos_y = (height - bmp_data.size_y) >> 1;
-
-                // Get background color from 1st pixel.
-				if (bmp_data.size_x < width || bmp_data.size_y < height)
-                    gfx_clear_color(ctxt, *(u32 *)image);
-                    
-                image_found = true;
-            }
-        }
-    }
-    if (image_found)
-    {
-        gfx_render_bmp_argb_transparent(ctxt, (u32 *)image, bmp_data.size_x, bmp_data.size_y,
-                            bmp_data.pos_x + x, bmp_data.pos_y + y, transparent_color);
-    }
-    free(image);
+    // The in-memory file can only be trusted for the size its header gives.
+    u32 size = bitmap ? _gfx_get_u32(bitmap + 2) : 0;
+    if (bitmap != NULL && _gfx_bmp_parse(bitmap, size, size, width, height, &bmp_data))
+        _gfx_bmp_render(ctxt, &bmp_data, _gfx_bmp_read_mem, bitmap, x, y, width, height, transparent_color);
 }
 
 
@@ -503,14 +963,10 @@ void gfx_render_splash(gfx_ctxt_t *ctxt, u8 *bitmap)
     if (bitmap != NULL)
     {
         // Get values manually to avoid unaligned access.
-        bmp_data.size = bitmap[2] | bitmap[3] << 8 |
-                        bitmap[4] << 16 | bitmap[5] << 24;
-        bmp_data.offset = bitmap[10] | bitmap[11] << 8 |
-                          bitmap[12] << 16 | bitmap[13] << 24;
-        bmp_data.size_x = bitmap[18] | bitmap[19] << 8 |
-                          bitmap[20] << 16 | bitmap[21] << 24;
-        bmp_data.size_y = bitmap[22] | bitmap[23] << 8 |
-                          bitmap[24] << 16 | bitmap[25] << 24;
+        bmp_data.size = _gfx_get_u32(bitmap + 2);
+        bmp_data.offset = _gfx_get_u32(bitmap + 10);
+        bmp_data.size_x = _gfx_get_u32(bitmap + 18);
+        bmp_data.size_y = _gfx_get_u32(bitmap + 22);
         // Sanity check.
         if (bitmap[0] == 'B' &&
             bitmap[1] == 'M' &&
@@ -536,13 +992,62 @@ void gfx_render_splash(gfx_ctxt_t *ctxt, u8 *bitmap)
     }
     if (image_found)
     {
-        u32* buf = (u32*)image;
+        // The splash is already in framebuffer orientation, its rows are copied bottom up.
+        u32* buf = (u32*)image + bmp_data.size_y * bmp_data.size_x;
         for (u32 y = bmp_data.pos_y; y < (bmp_data.pos_y + bmp_data.size_y); y++)
         {
-            for (u32 x =  bmp_data.pos_x; x < (bmp_data.pos_x + bmp_data.size_x); x++)
-	            ctxt->next[x + y * ctxt->stride] = buf[(bmp_data.size_y + bmp_data.pos_y - 1 - y ) * bmp_data.size_x + x - bmp_data.pos_x];        
+            buf -= bmp_data.size_x;
+            memcpy32(&ctxt->next[bmp_data.pos_x + y * ctxt->stride], buf, bmp_data.size_x * 4);
         }
+        _gfx_dirty(ctxt, ctxt->next, bmp_data.pos_y, bmp_data.pos_x, bmp_data.size_y, bmp_data.size_x);
 
     }
     free(image);
 }
+
+#define GFX_SPLASH_CHUNK 0x8000
+
+/*
+ * The compressed splash is stored in framebuffer order, rows included, so it
+ * is decoded straight into the back buffer while it is read.
+ */
+int gfx_render_splash_file(gfx_ctxt_t *ctxt, const char *path)
+{
+    FIL fp;
+    gfx_splash_hdr_t hdr;
+    lz4_stream_t lz4;
+    UINT br;
+    int res = 0;
+
+    if (f_open(&fp, path, FA_READ) != FR_OK)
+        return 0;
+
+    if (f_read(&fp, &hdr, sizeof(hdr), &br) != FR_OK || br != sizeof(hdr) ||
+        hdr.magic != GFX_SPLASH_MAGIC || hdr.stride != ctxt->stride ||
+        !hdr.rows || hdr.rows > ctxt->width)
+        goto out;
+
+    u32 pos_y = (ctxt->width - hdr.rows) >> 1;
+    u32 size = hdr.rows * ctxt->stride * 4;
+    u8 *buf = (u8 *)malloc(GFX_SPLASH_CHUNK);
+
+    lz4_stream_init(&lz4, ctxt->next + pos_y * ctxt->stride, size, false);
+    while (f_read(&fp, buf, GFX_SPLASH_CHUNK, &br) == FR_OK && br)
+        if (!lz4_stream_feed(&lz4, buf, br))
+            break;
+    res = lz4_stream_end(&lz4) == (int)size;
+    free(buf);
+
+    if (res)
+    {
+        u32 end = pos_y + hdr.rows;
+        memset32(ctxt->next, hdr.bg, pos_y * ctxt->stride * 4);
+        memset32(ctxt->next + end * ctxt->stride, hdr.bg, (ctxt->width - end) * ctxt->stride * 4);
+    }
+    // Even a failed decode may have written some rows.
+    _gfx_dirty(ctxt, ctxt->next, 0, 0, ctxt->width, ctxt->stride);
+
+out:
+    f_close(&fp);
+    return res;
+}
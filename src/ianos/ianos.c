@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ianos/ianos.h"
+
+#include <string.h>
+
+#include "libs/elfload/elfload.h"
+#include "utils/fs_utils.h"
+#include "utils/util.h"
+
+#define IANOS_CACHE_MAX 8
+
+typedef struct _ianos_mod_t
+{
+	u32 hash; // crc32c of the path, compared before the path itself.
+	char *path;
+	moduleEntrypoint_t entry;
+} ianos_mod_t;
+
+extern heap_t _heap;
+
+// Modules loaded with KEEP_IN_RAM, they are relocated once and never freed.
+static ianos_mod_t _ianos_cache[IANOS_CACHE_MAX];
+static u32 _ianos_cache_num;
+
+static struct _bdkParams_t _ianos_params;
+
+static ianos_mod_t *_ianos_cache_find(const char *path, u32 hash)
+{
+	for (u32 i = 0; i < _ianos_cache_num; i++)
+		if (_ianos_cache[i].hash == hash && !strcmp(_ianos_cache[i].path, path))
+			return &_ianos_cache[i];
+
+	return NULL;
+}
+
+static void _ianos_call(moduleEntrypoint_t entry, void *config)
+{
+	_ianos_params.gfxCon = &g_gfx_con;
+	_ianos_params.gfxCtx = &g_gfx_ctxt;
+	_ianos_params.sharedHeap = &_heap;
+	_ianos_params.memcpy = (memcpy_t)memcpy;
+	_ianos_params.memset = (memset_t)memset;
+
+	entry(config, &_ianos_params);
+}
+
+static void *_ianos_read(const char *path, u32 *size)
+{
+	FIL fp;
+	if (f_open(&fp, path, FA_READ) != FR_OK)
+		return NULL;
+
+	*size = f_size(&fp);
+	void *buf = malloc(*size);
+	if (f_read(&fp, buf, *size, NULL) != FR_OK)
+	{
+		free(buf);
+		buf = NULL;
+	}
+	f_close(&fp);
+
+	return buf;
+}
+
+int ianos_loader(bool sdmount, char *path, elfType_t type, void *moduleConfig)
+{
+	u32 hash = crc32c(path, strlen(path));
+	bool keep = (type & KEEP_IN_RAM) != 0;
+	int res = 1;
+
+	// A cached module is called straight away, without touching the SD card.
+	ianos_mod_t *mod = _ianos_cache_find(path, hash);
+	if (mod)
+	{
+		_ianos_call(mod->entry, moduleConfig);
+		return 0;
+	}
+
+	// Only 32-bit modules run here, AArch64 ones need the CCPLEX.
+	type &= ~KEEP_IN_RAM;
+	if (type != DRAM_LIB && type != EXEC_ELF)
+		return 1;
+
+	if (sdmount && !sd_mount())
+		return 1;
+
+	u32 size;
+	void *file = _ianos_read(path, &size);
+	if (!file)
+		return 1;
+
+	el_ctx_t ctx;
+	void *mem = NULL;
+	if (el_init(&ctx, file, size) != EL_OK)
+		goto out;
+
+	// The heap only hands out 0x10 aligned buffers.
+	mem = malloc(ctx.memsz + ctx.align - 0x10);
+	u8 *base = (u8 *)ALIGN((u32)mem, ctx.align);
+	if (el_load(&ctx, base) != EL_OK || el_relocate(&ctx, base) != EL_OK)
+		goto out;
+
+	moduleEntrypoint_t entry = (moduleEntrypoint_t)(base + ctx.ehdr->e_entry);
+	free(file);
+	file = NULL;
+
+	if (keep && _ianos_cache_num < IANOS_CACHE_MAX)
+	{
+		mod = &_ianos_cache[_ianos_cache_num++];
+		mod->hash = hash;
+		mod->path = (char *)malloc(strlen(path) + 1);
+		strcpy(mod->path, path);
+		mod->entry = entry;
+	}
+
+	_ianos_call(entry, moduleConfig);
+	res = 0;
+
+out:
+	if (!mod)
+		free(mem);
+	free(file);
+
+	return res;
+}
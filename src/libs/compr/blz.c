@@ -32,25 +32,75 @@ const blz_footer *blz_get_footer(const unsigned char *compData, unsigned int com
 	return srcFooter;
 }
 
+// Literals are copied highest byte first, same as one at a time, since dst may overlap the end of src.
+static void _blz_copy_literals8(unsigned char *dst, const unsigned char *src)
+{
+	for (unsigned int i = 8; i > 0; i--)
+		dst[i - 1] = src[i - 1];
+}
+
+// The source is always above dst and never reads what this copy wrote, so it can run ahead.
+static void _blz_copy_segment(unsigned char *dst, u32 seg_ofs, u32 seg_size)
+{
+	const unsigned char *src = dst + seg_ofs;
+
+	if (!(((u32)dst | seg_ofs) & 3))
+	{
+		for (; seg_size >= 4; seg_size -= 4, dst += 4, src += 4)
+			*(u32 *)dst = *(const u32 *)src;
+	}
+	else if (seg_ofs >= 4)
+	{
+		for (; seg_size >= 4; seg_size -= 4, dst += 4, src += 4)
+		{
+			unsigned char b0 = src[0], b1 = src[1], b2 = src[2], b3 = src[3];
+			dst[0] = b0;
+			dst[1] = b1;
+			dst[2] = b2;
+			dst[3] = b3;
+		}
+	}
+
+	while (seg_size--)
+		*dst++ = *src++;
+}
+
 // From https://github.com/SciresM/hactool/blob/master/kip.c which is exactly how kernel does it, thanks SciresM!
-int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const blz_footer *footer) 
+int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const blz_footer *footer)
 {
 	u32 addl_size = footer->addl_size;
 	u32 header_size = footer->header_size;
 	u32 cmp_and_hdr_size = footer->cmp_and_hdr_size;
-	
+
+	if (cmp_and_hdr_size > compSize || header_size > cmp_and_hdr_size)
+		return 0;
+
 	unsigned char* cmp_start = &dataBuf[compSize] - cmp_and_hdr_size;
 	u32 cmp_ofs = cmp_and_hdr_size - header_size;
 	u32 out_ofs = cmp_and_hdr_size + addl_size;
-	
-	while (out_ofs) 
+	u32 out_size = out_ofs;
+
+	while (out_ofs)
 	{
+		if (cmp_ofs < 1)
+			return 0; // Out of bounds.
+
 		unsigned char control = cmp_start[--cmp_ofs];
-		for (unsigned int i=0; i<8; i++) 
+
+		// A zero control byte is 8 literals in a row.
+		if (!control && cmp_ofs >= 8 && out_ofs >= 8)
 		{
-			if (control & 0x80) 
+			cmp_ofs -= 8;
+			out_ofs -= 8;
+			_blz_copy_literals8(&cmp_start[out_ofs], &cmp_start[cmp_ofs]);
+			continue;
+		}
+
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			if (control & 0x80)
 			{
-				if (cmp_ofs < 2) 
+				if (cmp_ofs < 2)
 					return 0; // Out of bounds.
 
 				cmp_ofs -= 2;
@@ -61,23 +111,24 @@ int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const
 					seg_size = out_ofs;
 
 				out_ofs -= seg_size;
+				if (seg_ofs > out_size - out_ofs - seg_size)
+					return 0; // Reaches past the decompressed data.
 
-				for (unsigned int j = 0; j < seg_size; j++)
-					cmp_start[out_ofs + j] = cmp_start[out_ofs + j + seg_ofs];
+				_blz_copy_segment(&cmp_start[out_ofs], seg_ofs, seg_size);
 			}
-			else 
+			else
 			{
 				// Copy directly.
-				if (cmp_ofs < 1) 
+				if (cmp_ofs < 1)
 					return 0; //out of bounds
 
 				cmp_start[--out_ofs] = cmp_start[--cmp_ofs];
 			}
 			control <<= 1;
 			if (out_ofs == 0) // Blz works backwards, so if it reaches byte 0, it's done.
-				return 1; 
-			}
+				return 1;
 		}
+	}
 
 	return 1;
 }
@@ -89,10 +140,14 @@ int blz_uncompress_srcdest(const unsigned char *compData, unsigned int compDataL
 	if (compFooterPtr == NULL)
 		return 0;
 
-	// Decompression must be done in-place, so need to copy the relevant compressed data first.
-	unsigned int numCompBytes = (const unsigned char*)(compFooterPtr)-compData;
-	memcpy(dstData, compData, numCompBytes);
-	memset(&dstData[numCompBytes], 0, dstSize - numCompBytes);
+	u32 out_end = compDataLen + footer.addl_size;
+	if (out_end < compDataLen || out_end > dstSize)
+		return 0;
+
+	// Decompression must be done in-place, so need to copy the compressed data first.
+	// The decoder writes everything up to out_end, only the tail past it needs clearing.
+	memcpy(dstData, compData, compDataLen);
+	memset(&dstData[out_end], 0, dstSize - out_end);
 
 	return blz_uncompress_inplace(dstData, compDataLen, &footer);
 }
@@ -112,6 +112,93 @@ static int _LZ_ReadVarSize( unsigned int * x, const unsigned char * buf )
 
 
 
+/*************************************************************************
+* _LZ_ReadVarSizeSafe() - Bounds-checked _LZ_ReadVarSize(). Returns the
+* number of bytes read, or 0 if the value runs past the input or does not
+* fit in 32 bits.
+*************************************************************************/
+
+static unsigned int _LZ_ReadVarSizeSafe( unsigned int * x,
+    const unsigned char * buf, unsigned int avail )
+{
+    unsigned int y, b, num_bytes;
+
+    y = 0;
+    num_bytes = 0;
+    do
+    {
+        if( num_bytes >= avail || num_bytes >= 5 || (y >> 25) )
+        {
+            return 0;
+        }
+        b = (unsigned int) buf[ num_bytes ++ ];
+        y = (y << 7) | (b & 0x0000007f);
+    }
+    while( b & 0x00000080 );
+
+    *x = y;
+    return num_bytes;
+}
+
+
+/*************************************************************************
+* _LZ_Copy() - Forward copy of length bytes where dst is at least 4 bytes
+* after src, or does not overlap it. When both pointers share the same
+* word alignment the bulk is moved as words, 4 at a time when they are at
+* least 16 bytes apart so the compiler can use LDM/STM.
+*************************************************************************/
+
+static void _LZ_Copy( unsigned char *dst, const unsigned char *src,
+    unsigned int length )
+{
+    unsigned int dist = (unsigned int) (dst - src);
+
+    if( !(((unsigned int) dst ^ (unsigned int) src) & 3) && length >= 8 )
+    {
+        unsigned int *wdst;
+        const unsigned int *wsrc;
+
+        while( (unsigned int) dst & 3 )
+        {
+            *dst ++ = *src ++;
+            -- length;
+        }
+
+        wdst = (unsigned int *) dst;
+        wsrc = (const unsigned int *) src;
+        if( dist >= 16 || src > dst )
+        {
+            while( length >= 16 )
+            {
+                unsigned int w0 = wsrc[ 0 ], w1 = wsrc[ 1 ];
+                unsigned int w2 = wsrc[ 2 ], w3 = wsrc[ 3 ];
+                wdst[ 0 ] = w0;
+                wdst[ 1 ] = w1;
+                wdst[ 2 ] = w2;
+                wdst[ 3 ] = w3;
+                wdst += 4;
+                wsrc += 4;
+                length -= 16;
+            }
+        }
+        while( length >= 4 )
+        {
+            *wdst ++ = *wsrc ++;
+            length -= 4;
+        }
+
+        dst = (unsigned char *) wdst;
+        src = (const unsigned char *) wsrc;
+    }
+
+    while( length -- )
+    {
+        *dst ++ = *src ++;
+    }
+}
+
+
+
 /*************************************************************************
 *                            PUBLIC FUNCTIONS                            *
 *************************************************************************/
@@ -177,3 +264,100 @@ void LZ_Uncompress( const unsigned char *in, unsigned char *out,
     }
     while( inpos < insize );
 }
+
+
+/*************************************************************************
+* LZ_Uncompress_safe() - Uncompress a block of data using an LZ77 decoder,
+* checking every read against insize and every write against outsize.
+*  in      - Input (compressed) buffer.
+*  insize  - Number of input bytes.
+*  out     - Output (uncompressed) buffer.
+*  outsize - Capacity of the output buffer.
+* Returns the number of bytes written, or -1 if the input is malformed or
+* would not fit.
+*************************************************************************/
+
+int LZ_Uncompress_safe( const unsigned char *in, unsigned int insize,
+    unsigned char *out, unsigned int outsize )
+{
+    unsigned char marker;
+    unsigned int  n, inpos, outpos, length, offset;
+
+    if( insize < 1 )
+    {
+        return 0;
+    }
+
+    marker = in[ 0 ];
+    inpos = 1;
+    outpos = 0;
+
+    while( inpos < insize )
+    {
+        /* Run of literals up to the next marker */
+        for( n = inpos; n < insize && in[ n ] != marker; ++ n )
+            ;
+        if( n > inpos )
+        {
+            length = n - inpos;
+            if( length > outsize - outpos )
+            {
+                return -1;
+            }
+            _LZ_Copy( &out[ outpos ], &in[ inpos ], length );
+            outpos += length;
+            inpos = n;
+            continue;
+        }
+
+        /* Marker byte */
+        if( ++ inpos >= insize )
+        {
+            return -1;
+        }
+        if( in[ inpos ] == 0 )
+        {
+            if( outpos >= outsize )
+            {
+                return -1;
+            }
+            out[ outpos ++ ] = marker;
+            ++ inpos;
+            continue;
+        }
+
+        n = _LZ_ReadVarSizeSafe( &length, &in[ inpos ], insize - inpos );
+        if( !n )
+        {
+            return -1;
+        }
+        inpos += n;
+        n = _LZ_ReadVarSizeSafe( &offset, &in[ inpos ], insize - inpos );
+        if( !n )
+        {
+            return -1;
+        }
+        inpos += n;
+
+        if( !offset || offset > outpos || length > outsize - outpos )
+        {
+            return -1;
+        }
+
+        /* Short distances overlap within a word, copy them bytewise */
+        if( offset < 4 )
+        {
+            for( n = 0; n < length; ++ n )
+            {
+                out[ outpos + n ] = out[ outpos + n - offset ];
+            }
+        }
+        else
+        {
+            _LZ_Copy( &out[ outpos ], &out[ outpos - offset ], length );
+        }
+        outpos += length;
+    }
+
+    return (int) outpos;
+}
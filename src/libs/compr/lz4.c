@@ -0,0 +1,539 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "libs/compr/lz4.h"
+
+#define LZ4_SKIP_MAGIC      0x184D2A50
+#define LZ4_SKIP_MAGIC_MASK 0xFFFFFFF0
+
+#define LZ4_FLG_VERSION_MASK   0xC0
+#define LZ4_FLG_VERSION        0x40
+#define LZ4_FLG_BLOCK_CHKSUM   (1 << 4)
+#define LZ4_FLG_CONTENT_SIZE   (1 << 3)
+#define LZ4_FLG_CONTENT_CHKSUM (1 << 2)
+#define LZ4_FLG_RESERVED       (1 << 1)
+#define LZ4_FLG_DICT_ID        (1 << 0)
+#define LZ4_BD_RESERVED        0x8F
+
+#define LZ4_BLOCK_STORED (1u << 31)
+
+// Stream flags above the frame FLG byte.
+#define LZ4_F_RAW    (1 << 8)
+#define LZ4_F_LEGACY (1 << 9)
+#define LZ4_F_DONE   (1 << 10)
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LEN_MAX   0x80000000
+
+enum
+{
+	LZ4_ST_MAGIC,
+	LZ4_ST_FRAME_DESC,
+	LZ4_ST_FRAME_HDR,
+	LZ4_ST_SKIP_SIZE,
+	LZ4_ST_SKIP,
+	LZ4_ST_BLOCK_SIZE,
+	LZ4_ST_BLOCK_CHKSUM,
+	LZ4_ST_CONTENT_CHKSUM,
+	LZ4_ST_STORED,
+	// Sequence states, only reached inside a compressed block.
+	LZ4_ST_TOKEN,
+	LZ4_ST_LIT_LEN,
+	LZ4_ST_LIT,
+	LZ4_ST_OFFSET,
+	LZ4_ST_MATCH_LEN,
+	LZ4_ST_ERROR
+};
+
+static u32 _lz4_le32(const u8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+// Forward copy. Overlapping is fine as long as src is at least 8 bytes behind dst.
+static void _lz4_copy(u8 *dst, const u8 *src, u32 len)
+{
+	if (len >= 16)
+	{
+		while ((u32)dst & 3)
+		{
+			*dst++ = *src++;
+			len--;
+		}
+
+		u32 *d = (u32 *)dst;
+		u32 sh = ((u32)src & 3) << 3;
+		if (!sh)
+		{
+			const u32 *w = (const u32 *)src;
+			for (; len >= 4; len -= 4)
+				*d++ = *w++;
+			src = (const u8 *)w;
+		}
+		else
+		{
+			// No unaligned loads on ARMv4, merge aligned words instead.
+			const u32 *w = (const u32 *)(src - (sh >> 3));
+			u32 lo = *w++;
+			for (; len >= 4; len -= 4)
+			{
+				u32 hi = *w++;
+				*d++ = (lo >> sh) | (hi << (32 - sh));
+				lo = hi;
+			}
+			src = (const u8 *)(w - 1) + (sh >> 3);
+		}
+		dst = (u8 *)d;
+	}
+
+	while (len--)
+		*dst++ = *src++;
+}
+
+static void _lz4_match_copy(u8 *dst, u32 offset, u32 len)
+{
+	if (offset >= 8)
+		_lz4_copy(dst, dst - offset, len);
+	else if (offset == 1)
+		memset(dst, dst[-1], len);
+	else
+	{
+		// Lay down enough of the pattern that a whole period is 8 bytes or more behind.
+		u32 period = offset * ((8 + offset - 1) / offset);
+		u32 head = MIN(len, period - offset);
+		const u8 *src = dst - offset;
+		for (u32 i = 0; i < head; i++)
+			dst[i] = src[i];
+		_lz4_copy(dst + head, dst + head - period, len - head);
+	}
+}
+
+static void _lz4_expect(lz4_stream_t *s, u32 state, u32 need)
+{
+	s->state = state;
+	s->need = need;
+	s->have = 0;
+}
+
+static void _lz4_block_done(lz4_stream_t *s)
+{
+	if (s->flags & LZ4_F_LEGACY)
+		_lz4_expect(s, LZ4_ST_BLOCK_SIZE, 4);
+	else if (s->flags & LZ4_FLG_BLOCK_CHKSUM)
+		_lz4_expect(s, LZ4_ST_BLOCK_CHKSUM, 4);
+	else
+		_lz4_expect(s, LZ4_ST_BLOCK_SIZE, 4);
+}
+
+static void _lz4_frame_done(lz4_stream_t *s)
+{
+	s->flags |= LZ4_F_DONE;
+	_lz4_expect(s, LZ4_ST_MAGIC, 4);
+}
+
+static void _lz4_header(lz4_stream_t *s)
+{
+	u32 v = _lz4_le32(s->hdr);
+
+	switch (s->state)
+	{
+	case LZ4_ST_MAGIC:
+		s->flags &= LZ4_F_DONE;
+		if (v == LZ4_FRAME_MAGIC)
+			_lz4_expect(s, LZ4_ST_FRAME_DESC, 2);
+		else if (v == LZ4_LEGACY_MAGIC)
+		{
+			s->flags |= LZ4_F_LEGACY;
+			_lz4_expect(s, LZ4_ST_BLOCK_SIZE, 4);
+		}
+		else if ((v & LZ4_SKIP_MAGIC_MASK) == LZ4_SKIP_MAGIC)
+			_lz4_expect(s, LZ4_ST_SKIP_SIZE, 4);
+		else
+			s->state = LZ4_ST_ERROR;
+		break;
+
+	case LZ4_ST_FRAME_DESC:
+		// No preset dictionaries here.
+		if ((s->hdr[0] & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION ||
+			(s->hdr[0] & (LZ4_FLG_RESERVED | LZ4_FLG_DICT_ID)) || (s->hdr[1] & LZ4_BD_RESERVED))
+		{
+			s->state = LZ4_ST_ERROR;
+			break;
+		}
+		s->flags |= s->hdr[0];
+		_lz4_expect(s, LZ4_ST_FRAME_HDR, (s->flags & LZ4_FLG_CONTENT_SIZE) ? 9 : 1);
+		break;
+
+	case LZ4_ST_FRAME_HDR:
+		// Refuse early if the content cannot fit.
+		if ((s->flags & LZ4_FLG_CONTENT_SIZE) && (_lz4_le32(s->hdr + 4) || v > s->dst_size - s->pos))
+		{
+			s->state = LZ4_ST_ERROR;
+			break;
+		}
+		_lz4_expect(s, LZ4_ST_BLOCK_SIZE, 4);
+		break;
+
+	case LZ4_ST_SKIP_SIZE:
+		s->len = v;
+		if (v)
+			s->state = LZ4_ST_SKIP;
+		else
+			_lz4_expect(s, LZ4_ST_MAGIC, 4);
+		break;
+
+	case LZ4_ST_BLOCK_SIZE:
+		if (s->flags & LZ4_F_LEGACY)
+		{
+			// Concatenated legacy streams repeat the magic.
+			if (v == LZ4_LEGACY_MAGIC)
+				_lz4_expect(s, LZ4_ST_BLOCK_SIZE, 4);
+			else if (!v)
+				s->state = LZ4_ST_ERROR;
+			else
+			{
+				s->block_left = v;
+				s->state = LZ4_ST_TOKEN;
+			}
+		}
+		else if (!v)
+		{
+			if (s->flags & LZ4_FLG_CONTENT_CHKSUM)
+				_lz4_expect(s, LZ4_ST_CONTENT_CHKSUM, 4);
+			else
+				_lz4_frame_done(s);
+		}
+		else
+		{
+			s->block_left = v & ~LZ4_BLOCK_STORED;
+			s->state = (v & LZ4_BLOCK_STORED) ? LZ4_ST_STORED : LZ4_ST_TOKEN;
+			if (!s->block_left)
+				_lz4_block_done(s);
+		}
+		break;
+
+	case LZ4_ST_BLOCK_CHKSUM:
+		_lz4_expect(s, LZ4_ST_BLOCK_SIZE, 4);
+		break;
+
+	case LZ4_ST_CONTENT_CHKSUM:
+		_lz4_frame_done(s);
+		break;
+	}
+}
+
+// Returns 0 while it still needs more input.
+static int _lz4_collect(lz4_stream_t *s, const u8 **ip, const u8 *iend)
+{
+	u32 n = MIN(s->need - s->have, (u32)(iend - *ip));
+	memcpy(s->hdr + s->have, *ip, n);
+	s->have += n;
+	*ip += n;
+
+	return s->have == s->need;
+}
+
+static u32 _lz4_len_add(u32 len, u32 b)
+{
+	// Saturate, anything this large fails the output check anyway.
+	return len < LZ4_LEN_MAX ? len + b : len;
+}
+
+static int _lz4_literals(lz4_stream_t *s, const u8 *src, u32 len)
+{
+	if (len > s->dst_size - s->pos)
+		return 0;
+
+	_lz4_copy(s->dst + s->pos, src, len);
+	s->pos += len;
+
+	return 1;
+}
+
+static int _lz4_match(lz4_stream_t *s, u32 offset, u32 len)
+{
+	len += LZ4_MIN_MATCH;
+	if (!offset || offset > s->pos || len > s->dst_size - s->pos)
+		return 0;
+
+	_lz4_match_copy(s->dst + s->pos, offset, len);
+	s->pos += len;
+
+	return 1;
+}
+
+// Extension bytes of a length. Returns 0 if they run past end.
+static int _lz4_var_len(const u8 **p, const u8 *end, u32 *len)
+{
+	u32 b;
+
+	do
+	{
+		if (*p >= end)
+			return 0;
+		b = *(*p)++;
+		*len = _lz4_len_add(*len, b);
+	} while (b == 0xFF);
+
+	return 1;
+}
+
+/*
+ * Decodes sequences that are whole inside [ip, end) without going through
+ * the state machine. at_end tells that end is also the end of the block,
+ * so a sequence made of literals only is the final one.
+ */
+static const u8 *_lz4_fast(lz4_stream_t *s, const u8 *ip, const u8 *end, bool at_end)
+{
+	while (ip < end)
+	{
+		const u8 *p = ip;
+		u32 token = *p++;
+		u32 lit = token >> 4;
+		if (lit == 15 && !_lz4_var_len(&p, end, &lit))
+			break;
+		if (lit > (u32)(end - p))
+			break;
+
+		const u8 *lits = p;
+		p += lit;
+		if (p == end)
+		{
+			if (!at_end)
+				break;
+
+			if (!_lz4_literals(s, lits, lit))
+				s->state = LZ4_ST_ERROR;
+			else
+				_lz4_expect(s, LZ4_ST_OFFSET, 2);
+			return p;
+		}
+
+		if (end - p < 2)
+			break;
+		u32 offset = p[0] | (p[1] << 8);
+		p += 2;
+
+		u32 mlen = token & 0xF;
+		if (mlen == 15 && !_lz4_var_len(&p, end, &mlen))
+			break;
+
+		if (!_lz4_literals(s, lits, lit) || !_lz4_match(s, offset, mlen))
+		{
+			s->state = LZ4_ST_ERROR;
+			return p;
+		}
+		ip = p;
+	}
+
+	return ip;
+}
+
+static void _lz4_block(lz4_stream_t *s, const u8 **pip, const u8 *iend)
+{
+	const u8 *ip = *pip;
+	u32 avail = MIN((u32)(iend - ip), s->block_left);
+	const u8 *end = ip + avail;
+
+	// A block cannot stop in the middle of a sequence.
+	if (!avail)
+	{
+		s->state = LZ4_ST_ERROR;
+		return;
+	}
+
+	if (s->state == LZ4_ST_TOKEN)
+		ip = _lz4_fast(s, ip, end, avail == s->block_left);
+
+	// Sequences split across input windows go byte by byte.
+	while (ip < end && s->state != LZ4_ST_ERROR)
+	{
+		u32 b;
+
+		switch (s->state)
+		{
+		case LZ4_ST_TOKEN:
+			s->token = *ip++;
+			s->len = s->token >> 4;
+			if (s->len == 15)
+				s->state = LZ4_ST_LIT_LEN;
+			else if (s->len)
+				s->state = LZ4_ST_LIT;
+			else
+				_lz4_expect(s, LZ4_ST_OFFSET, 2);
+			break;
+
+		case LZ4_ST_LIT_LEN:
+			b = *ip++;
+			s->len = _lz4_len_add(s->len, b);
+			if (b != 0xFF)
+				s->state = LZ4_ST_LIT;
+			break;
+
+		case LZ4_ST_LIT:
+			b = MIN(s->len, (u32)(end - ip));
+			if (!_lz4_literals(s, ip, b))
+			{
+				s->state = LZ4_ST_ERROR;
+				break;
+			}
+			ip += b;
+			s->len -= b;
+			if (!s->len)
+				_lz4_expect(s, LZ4_ST_OFFSET, 2);
+			break;
+
+		case LZ4_ST_OFFSET:
+			s->hdr[s->have++] = *ip++;
+			if (s->have < 2)
+				break;
+			s->offset = s->hdr[0] | (s->hdr[1] << 8);
+			s->len = s->token & 0xF;
+			if (s->len == 15)
+				s->state = LZ4_ST_MATCH_LEN;
+			else
+				s->state = _lz4_match(s, s->offset, s->len) ? LZ4_ST_TOKEN : LZ4_ST_ERROR;
+			break;
+
+		case LZ4_ST_MATCH_LEN:
+			b = *ip++;
+			s->len = _lz4_len_add(s->len, b);
+			if (b != 0xFF)
+				s->state = _lz4_match(s, s->offset, s->len) ? LZ4_ST_TOKEN : LZ4_ST_ERROR;
+			break;
+		}
+
+		// Back in sync, let the fast path take the rest of the window.
+		if (s->state == LZ4_ST_TOKEN && ip < end)
+			ip = _lz4_fast(s, ip, end, avail == s->block_left);
+	}
+
+	s->block_left -= ip - *pip;
+	*pip = ip;
+
+	if (s->state == LZ4_ST_ERROR || s->block_left)
+		return;
+
+	// Blocks end right after the last literals.
+	if (s->state == LZ4_ST_OFFSET && !s->have)
+		_lz4_block_done(s);
+	else
+		s->state = LZ4_ST_ERROR;
+}
+
+void lz4_stream_init(lz4_stream_t *s, void *dst, u32 dst_size, bool raw)
+{
+	memset(s, 0, sizeof(lz4_stream_t));
+	s->dst = (u8 *)dst;
+	s->dst_size = dst_size;
+
+	if (raw)
+	{
+		s->flags = LZ4_F_RAW;
+		s->block_left = 0xFFFFFFFF;
+		s->state = LZ4_ST_TOKEN;
+	}
+	else
+		_lz4_expect(s, LZ4_ST_MAGIC, 4);
+}
+
+int lz4_stream_feed(lz4_stream_t *s, const void *src, u32 size)
+{
+	const u8 *ip = (const u8 *)src;
+	const u8 *iend = ip + size;
+
+	while (ip < iend && s->state != LZ4_ST_ERROR)
+	{
+		u32 n;
+
+		switch (s->state)
+		{
+		case LZ4_ST_MAGIC:
+		case LZ4_ST_FRAME_DESC:
+		case LZ4_ST_FRAME_HDR:
+		case LZ4_ST_SKIP_SIZE:
+		case LZ4_ST_BLOCK_SIZE:
+		case LZ4_ST_BLOCK_CHKSUM:
+		case LZ4_ST_CONTENT_CHKSUM:
+			if (_lz4_collect(s, &ip, iend))
+				_lz4_header(s);
+			break;
+
+		case LZ4_ST_SKIP:
+			n = MIN(s->len, (u32)(iend - ip));
+			ip += n;
+			s->len -= n;
+			if (!s->len)
+				_lz4_expect(s, LZ4_ST_MAGIC, 4);
+			break;
+
+		case LZ4_ST_STORED:
+			n = MIN(s->block_left, (u32)(iend - ip));
+			if (!_lz4_literals(s, ip, n))
+			{
+				s->state = LZ4_ST_ERROR;
+				break;
+			}
+			ip += n;
+			s->block_left -= n;
+			if (!s->block_left)
+				_lz4_block_done(s);
+			break;
+
+		default:
+			_lz4_block(s, &ip, iend);
+			break;
+		}
+	}
+
+	return s->state != LZ4_ST_ERROR;
+}
+
+int lz4_stream_end(lz4_stream_t *s)
+{
+	bool ok;
+
+	if (s->flags & LZ4_F_RAW)
+		ok = s->state == LZ4_ST_OFFSET && !s->have;
+	else if (s->flags & LZ4_F_LEGACY)
+		ok = s->state == LZ4_ST_BLOCK_SIZE && !s->have;
+	else
+		ok = s->state == LZ4_ST_MAGIC && !s->have && (s->flags & LZ4_F_DONE);
+
+	return ok ? (int)s->pos : -1;
+}
+
+int lz4_decompress(const void *src, u32 src_size, void *dst, u32 dst_size)
+{
+	lz4_stream_t s;
+
+	lz4_stream_init(&s, dst, dst_size, false);
+	lz4_stream_feed(&s, src, src_size);
+
+	return lz4_stream_end(&s);
+}
+
+int lz4_decompress_block(const void *src, u32 src_size, void *dst, u32 dst_size)
+{
+	lz4_stream_t s;
+
+	lz4_stream_init(&s, dst, dst_size, true);
+	lz4_stream_feed(&s, src, src_size);
+
+	return lz4_stream_end(&s);
+}
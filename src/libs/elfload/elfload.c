@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libs/elfload/elfload.h"
+
+#include <string.h>
+
+// True when [ofs, ofs + len) lies in a buffer of size bytes.
+static int _el_in_bounds(u32 ofs, u32 len, u32 size)
+{
+	return ofs <= size && len <= size - ofs;
+}
+
+el_status el_init(el_ctx_t *ctx, const void *elf, u32 size)
+{
+	const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)elf;
+
+	memset(ctx, 0, sizeof(el_ctx_t));
+	ctx->elf = (const u8 *)elf;
+	ctx->size = size;
+	ctx->ehdr = ehdr;
+
+	if (((u32)elf & 3) || size < sizeof(Elf32_Ehdr) || memcmp(ehdr->e_ident, ELFMAG, 4) ||
+		ehdr->e_ident[EI_CLASS] != ELFCLASS32 || ehdr->e_ident[EI_DATA] != ELFDATA2LSB)
+		return EL_NOTELF;
+	if (ehdr->e_type != ET_DYN || ehdr->e_machine != EM_ARM)
+		return EL_WRONGARCH;
+
+	if (ehdr->e_phentsize != sizeof(Elf32_Phdr) || (ehdr->e_phoff & 3) ||
+		!_el_in_bounds(ehdr->e_phoff, ehdr->e_phnum * sizeof(Elf32_Phdr), size))
+		return EL_BADFILE;
+	ctx->phdr = (const Elf32_Phdr *)&ctx->elf[ehdr->e_phoff];
+
+	for (u32 i = 0; i < ehdr->e_phnum; i++)
+	{
+		const Elf32_Phdr *ph = &ctx->phdr[i];
+
+		if (ph->p_type == PT_DYNAMIC)
+			ctx->dyn_vaddr = ph->p_vaddr;
+		if (ph->p_type != PT_LOAD)
+			continue;
+
+		if (ph->p_filesz > ph->p_memsz || !_el_in_bounds(ph->p_offset, ph->p_filesz, size) ||
+			ph->p_vaddr + ph->p_memsz < ph->p_vaddr)
+			return EL_BADFILE;
+		ctx->memsz = MAX(ctx->memsz, ph->p_vaddr + ph->p_memsz);
+	}
+
+	if (!ctx->memsz || (ehdr->e_entry & ~1) >= ctx->memsz || (ctx->dyn_vaddr & 3) || !_el_in_bounds(ctx->dyn_vaddr, sizeof(Elf32_Dyn), ctx->memsz))
+		return EL_BADFILE;
+
+	// Segments are page aligned, only the alignment of what is in them matters.
+	ctx->align = 0x10;
+	if (ehdr->e_shentsize == sizeof(Elf32_Shdr) && !(ehdr->e_shoff & 3) &&
+		_el_in_bounds(ehdr->e_shoff, ehdr->e_shnum * sizeof(Elf32_Shdr), size))
+	{
+		const Elf32_Shdr *sh = (const Elf32_Shdr *)&ctx->elf[ehdr->e_shoff];
+		for (u32 i = 0; i < ehdr->e_shnum; i++)
+			if ((sh[i].sh_flags & SHF_ALLOC) && sh[i].sh_addralign > ctx->align)
+				ctx->align = sh[i].sh_addralign;
+	}
+	if (ctx->align & (ctx->align - 1))
+		return EL_BADFILE;
+
+	return EL_OK;
+}
+
+el_status el_load(el_ctx_t *ctx, void *base)
+{
+	u8 *dst = (u8 *)base;
+
+	memset(dst, 0, ctx->memsz);
+	for (u32 i = 0; i < ctx->ehdr->e_phnum; i++)
+	{
+		const Elf32_Phdr *ph = &ctx->phdr[i];
+		if (ph->p_type == PT_LOAD)
+			memcpy(&dst[ph->p_vaddr], &ctx->elf[ph->p_offset], ph->p_filesz);
+	}
+
+	return EL_OK;
+}
+
+static el_status _el_reloc_sym(el_ctx_t *ctx, u8 *base, u32 symtab, u32 info, u32 *val)
+{
+	u32 idx = ELF32_R_SYM(info);
+
+	if (!symtab || symtab > ctx->memsz || idx >= (ctx->memsz - symtab) / sizeof(Elf32_Sym))
+		return EL_BADREL;
+
+	const Elf32_Sym *sym = (const Elf32_Sym *)&base[symtab] + idx;
+	if (sym->st_shndx != SHN_UNDEF)
+		*val = (u32)base + sym->st_value;
+	else if (ELF32_ST_BIND(sym->st_info) == STB_WEAK)
+		*val = 0;
+	else
+		return EL_BADSYM;
+
+	return EL_OK;
+}
+
+static el_status _el_reloc_table(el_ctx_t *ctx, u8 *base, u32 symtab, u32 rel_vaddr, u32 rel_size, u32 relcount)
+{
+	if ((rel_vaddr & 3) || !_el_in_bounds(rel_vaddr, rel_size, ctx->memsz))
+		return EL_BADREL;
+
+	const Elf32_Rel *rel = (const Elf32_Rel *)&base[rel_vaddr];
+	u32 num = rel_size / sizeof(Elf32_Rel);
+	u32 i = 0;
+
+	// The linker sorts the relative relocations first and counts them,
+	// those need no symbol and are applied without going through the switch.
+	for (relcount = MIN(relcount, num); i < relcount; i++)
+	{
+		u32 ofs = rel[i].r_offset;
+		if (ELF32_R_TYPE(rel[i].r_info) != R_ARM_RELATIVE)
+			break;
+		if ((ofs & 3) || !_el_in_bounds(ofs, 4, ctx->memsz))
+			return EL_BADREL;
+		*(u32 *)&base[ofs] += (u32)base;
+	}
+
+	for (; i < num; i++)
+	{
+		u32 ofs = rel[i].r_offset;
+		u32 val;
+		el_status res;
+
+		if ((ofs & 3) || !_el_in_bounds(ofs, 4, ctx->memsz))
+			return EL_BADREL;
+
+		u32 *where = (u32 *)&base[ofs];
+		switch (ELF32_R_TYPE(rel[i].r_info))
+		{
+		case R_ARM_NONE:
+			break;
+		case R_ARM_RELATIVE:
+			*where += (u32)base;
+			break;
+		case R_ARM_ABS32:
+			if ((res = _el_reloc_sym(ctx, base, symtab, rel[i].r_info, &val)) != EL_OK)
+				return res;
+			*where += val;
+			break;
+		case R_ARM_GLOB_DAT:
+		case R_ARM_JUMP_SLOT:
+			if ((res = _el_reloc_sym(ctx, base, symtab, rel[i].r_info, &val)) != EL_OK)
+				return res;
+			*where = val;
+			break;
+		default:
+			return EL_BADREL;
+		}
+	}
+
+	return EL_OK;
+}
+
+el_status el_relocate(el_ctx_t *ctx, void *base)
+{
+	u8 *img = (u8 *)base;
+	u32 rel = 0, relsz = 0, relent = sizeof(Elf32_Rel), relcount = 0;
+	u32 jmprel = 0, pltrelsz = 0, pltrel = DT_REL;
+	u32 symtab = 0;
+	el_status res;
+
+	if (!ctx->dyn_vaddr)
+		return EL_OK;
+
+	for (const Elf32_Dyn *dyn = (const Elf32_Dyn *)&img[ctx->dyn_vaddr];; dyn++)
+	{
+		if (!_el_in_bounds((u32)dyn - (u32)img, sizeof(Elf32_Dyn), ctx->memsz))
+			return EL_BADFILE;
+		if (dyn->d_tag == DT_NULL)
+			break;
+
+		switch (dyn->d_tag)
+		{
+		case DT_REL:
+			rel = dyn->d_val;
+			break;
+		case DT_RELSZ:
+			relsz = dyn->d_val;
+			break;
+		case DT_RELENT:
+			relent = dyn->d_val;
+			break;
+		case DT_RELCOUNT:
+			relcount = dyn->d_val;
+			break;
+		case DT_JMPREL:
+			jmprel = dyn->d_val;
+			break;
+		case DT_PLTRELSZ:
+			pltrelsz = dyn->d_val;
+			break;
+		case DT_PLTREL:
+			pltrel = dyn->d_val;
+			break;
+		case DT_SYMTAB:
+			if (dyn->d_val & 3)
+				return EL_BADFILE;
+			symtab = dyn->d_val;
+			break;
+		case DT_RELA:
+			return EL_BADREL; // ARM uses REL only.
+		}
+	}
+
+	if (relent != sizeof(Elf32_Rel) || pltrel != DT_REL)
+		return EL_BADREL;
+
+	if (relsz && (res = _el_reloc_table(ctx, img, symtab, rel, relsz, relcount)) != EL_OK)
+		return res;
+	if (pltrelsz && (res = _el_reloc_table(ctx, img, symtab, jmprel, pltrelsz, 0)) != EL_OK)
+		return res;
+
+	return EL_OK;
+}
@@ -1857,6 +1857,37 @@ static void st_clust (
 
 
 #if FF_USE_LFN
+/*--------------------------------------------------------*/
+/* LFN: Up-case conversion with an ASCII fast path        */
+/*--------------------------------------------------------*/
+
+static WCHAR wtoupper_fast (	/* Returns up-case code unit */
+	WCHAR chr					/* UTF-16 code unit to be converted */
+)
+{
+#if FF_LFN_FASTCMP
+	if (chr < 0x80) {	/* ASCII: fold without the conversion tables */
+		return chr - (((UINT)(chr - 'a') < 26) << 5);
+	}
+#endif
+	return (WCHAR)ff_wtoupper(chr);
+}
+
+
+#if FF_LFN_FASTCMP
+static DWORD wtoupper2_ascii (	/* Returns two up-case code units */
+	DWORD chr2					/* Two ASCII code units packed in a word */
+)
+{
+	DWORD ge_a = chr2 + 0x001F001F;		/* b7 of a lane is set when it is >= 'a' */
+	DWORD gt_z = chr2 + 0x00050005;		/* b7 of a lane is set when it is > 'z' */
+
+	return chr2 - ((ge_a & ~gt_z & 0x00800080) >> 2);
+}
+#endif
+
+
+
 /*--------------------------------------------------------*/
 /* FAT-LFN: Compare a part of file name with an LFN entry */
 /*--------------------------------------------------------*/
@@ -1868,16 +1899,30 @@ static int cmp_lfn (		/* 1:matched, 0:not matched */
 {
 	UINT i, s;
 	WCHAR wc, uc;
+#if FF_LFN_FASTCMP
+	DWORD dc, nc;
+#endif
 
 
 	if (ld_word(dir + LDIR_FstClusLO) != 0) return 0;	/* Check LDIR_FstClusLO */
 
 	i = ((dir[LDIR_Ord] & 0x3F) - 1) * 13;	/* Offset in the LFN buffer */
 
-	for (wc = 1, s = 0; s < 13; s++) {		/* Process all characters in the entry */
+	s = 0;
+#if FF_LFN_FASTCMP
+	/* ASCII fast path: compare two code units at a time */
+	for (; s < 12 && i + 2 <= FF_MAX_LFN; s += 2, i += 2) {
+		dc = ld_word(dir + LfnOfs[s]) | (DWORD)ld_word(dir + LfnOfs[s + 1]) << 16;
+		nc = lfnbuf[i] | (DWORD)lfnbuf[i + 1] << 16;
+		if (((dc | nc) & 0xFF80FF80) || !(dc & 0xFFFF) || !(dc >> 16)) break;	/* Non-ASCII, terminator or filler goes to the slow path */
+		if (wtoupper2_ascii(dc) != wtoupper2_ascii(nc)) return 0;	/* Not matched */
+	}
+#endif
+
+	for (wc = 1; s < 13; s++) {		/* Process rest of the characters in the entry */
 		uc = ld_word(dir + LfnOfs[s]);		/* Pick an LFN character */
 		if (wc != 0) {
-			if (i >= FF_MAX_LFN || ff_wtoupper(uc) != ff_wtoupper(lfnbuf[i++])) {	/* Compare it */
+			if (i >= FF_MAX_LFN || wtoupper_fast(uc) != wtoupper_fast(lfnbuf[i++])) {	/* Compare it */
 				return 0;					/* Not matched */
 			}
 			wc = uc;
@@ -2082,7 +2127,7 @@ static WORD xname_sum (	/* Get check sum (to be used as hash) of the file name *
 
 
 	while ((chr = *name++) != 0) {
-		chr = (WCHAR)ff_wtoupper(chr);		/* File name needs to be up-case converted */
+		chr = wtoupper_fast(chr);		/* File name needs to be up-case converted */
 		sum = ((sum & 1) ? 0x8000 : 0) + (sum >> 1) + (chr & 0xFF);
 		sum = ((sum & 1) ? 0x8000 : 0) + (sum >> 1) + (chr >> 8);
 	}
@@ -2137,6 +2182,7 @@ static void get_xfileinfo (
 
 	fno->fattrib = dirb[XDIR_Attr];			/* Attribute */
 	fno->fsize = (fno->fattrib & AM_DIR) ? 0 : ld_qword(dirb + XDIR_FileSize);	/* Size */
+	fno->fclust = ld_dword(dirb + XDIR_FstClus);	/* Start cluster */
 	fno->ftime = ld_word(dirb + XDIR_ModTime + 0);	/* Time */
 	fno->fdate = ld_word(dirb + XDIR_ModTime + 2);	/* Date */
 }
@@ -2411,10 +2457,14 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 	BYTE c;
 #if FF_USE_LFN
 	BYTE a, ord, sum;
+	UINT nlen;
 #endif
 
 	res = dir_sdi(dp, 0);			/* Rewind directory object */
 	if (res != FR_OK) return res;
+#if FF_USE_LFN
+	for (nlen = 0; fs->lfnbuf[nlen]; nlen++) ;	/* Length of the name to find */
+#endif
 #if FF_FS_EXFAT
 	if (fs->fs_type == FS_EXFAT) {	/* On the exFAT volume */
 		BYTE nc;
@@ -2424,11 +2474,14 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 		while ((res = dir_read_file(dp)) == FR_OK) {	/* Read an item */
 #if FF_MAX_LFN < 255
 			if (fs->dirbuf[XDIR_NumName] > FF_MAX_LFN) continue;			/* Skip comparison if inaccessible object name */
+#endif
+#if FF_LFN_FASTCMP
+			if (fs->dirbuf[XDIR_NumName] != nlen) continue;				/* Skip comparison if length mismatched */
 #endif
 			if (ld_word(fs->dirbuf + XDIR_NameHash) != hash) continue;	/* Skip comparison if hash mismatched */
 			for (nc = fs->dirbuf[XDIR_NumName], di = SZDIRE * 2, ni = 0; nc; nc--, di += 2, ni++) {	/* Compare the name */
 				if ((di % SZDIRE) == 0) di += 2;
-				if (ff_wtoupper(ld_word(fs->dirbuf + di)) != ff_wtoupper(fs->lfnbuf[ni])) break;
+				if (wtoupper_fast(ld_word(fs->dirbuf + di)) != wtoupper_fast(fs->lfnbuf[ni])) break;
 			}
 			if (nc == 0 && !fs->lfnbuf[ni]) break;	/* Name matched? */
 		}
@@ -2455,6 +2508,9 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 						sum = dp->dir[LDIR_Chksum];
 						c &= (BYTE)~LLEF; ord = c;	/* LFN start order */
 						dp->blk_ofs = dp->dptr;	/* Start offset of LFN */
+#if FF_LFN_FASTCMP
+						if (nlen > c * 13u || nlen <= (c - 1) * 13u) ord = 0xFF;	/* Reject early if length mismatched */
+#endif
 					}
 					/* Check validity of the LFN entry and compare it with given name */
 					ord = (c == ord && sum == dp->dir[LDIR_Chksum] && cmp_lfn(fs->lfnbuf, dp->dir)) ? ord - 1 : 0xFF;
@@ -2726,6 +2782,7 @@ static void get_fileinfo (
 
 	fno->fattrib = dp->dir[DIR_Attr];					/* Attribute */
 	fno->fsize = ld_dword(dp->dir + DIR_FileSize);		/* Size */
+	fno->fclust = ld_clust(dp->obj.fs, dp->dir);		/* Start cluster */
 	fno->ftime = ld_word(dp->dir + DIR_ModTime + 0);	/* Time */
 	fno->fdate = ld_word(dp->dir + DIR_ModTime + 2);	/* Date */
 }
@@ -3765,8 +3822,10 @@ FRESULT f_read (
 	FSIZE_t remain;
 	UINT rcnt, cc, csect;
 	BYTE *rbuff = (BYTE*)buff;
+	UINT br_unused;
 
 
+	if (!br) br = &br_unused;	/* The firmware passes NULL when only the result matters */
 	*br = 0;	/* Clear read byte counter */
 	res = validate(&fp->obj, &fs);				/* Check validity of the file object */
 	if (res != FR_OK || (res = (FRESULT)fp->err) != FR_OK) {
@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "libs/fatfs/ffro.h"
+#include "libs/fatfs/diskio.h"
+
+#define FFRO_SECT_SIZE 512
+#define FFRO_DIR_SIZE  32
+#define FFRO_LFN_MAX   255
+#define FFRO_LFN_ENT   20 // Max LFN entries per name.
+// Largest directories FatFs handles, a longer chain is broken.
+#define FFRO_MAX_DIR    0x200000
+#define FFRO_MAX_DIR_EX 0x10000000
+
+#define AM_VOL 0x08 // Volume label.
+#define AM_LFN 0x0F // LFN entry.
+
+// exFAT directory entry types.
+#define ET_FILEDIR 0x85
+#define ET_STREAM  0xC0
+#define ET_FILENAME 0xC1
+
+static u32 _ffro_ld16(const u8 *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static u32 _ffro_ld32(const u8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static u32 _ffro_fold(u32 c)
+{
+	return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+}
+
+// Case-insensitive compare of a NUL terminated ASCII name against a path component.
+static bool _ffro_name_eq(const char *name, const char *comp, u32 len)
+{
+	for (u32 i = 0; i < len; i++)
+		if (!name[i] || _ffro_fold((u8)name[i]) != _ffro_fold((u8)comp[i]))
+			return false;
+	return !name[len];
+}
+
+static int _ffro_check_vbr(const u8 *win)
+{
+	if (_ffro_ld16(win + 510) != 0xAA55)
+		return 0;
+	if (!memcmp(win + 3, "EXFAT   ", 8))
+		return FFRO_EXFAT;
+	if (!memcmp(win + 82, "FAT32   ", 8))
+		return FFRO_FAT32;
+	return 0;
+}
+
+// Returns the FAT entry of a cluster or 1 on disk error.
+static u32 _ffro_get_fat(ffro_t *fs, u32 clst)
+{
+	u32 sect = fs->fatbase + (clst >> 7);
+
+	if (sect != fs->fatsect)
+	{
+		if (disk_read(0, fs->fat, sect, 1) != RES_OK)
+			return 1;
+		fs->fatsect = sect;
+	}
+
+	u32 val = _ffro_ld32(fs->fat + ((clst & 0x7F) << 2));
+	return fs->fs_type == FFRO_FAT32 ? val & 0x0FFFFFFF : val;
+}
+
+static u32 _ffro_clst2sect(ffro_t *fs, u32 clst)
+{
+	return fs->database + ((clst - 2) << fs->csize_shift);
+}
+
+FRESULT ffro_mount(ffro_t *fs)
+{
+	u32 bsect = 0;
+
+	fs->fs_type = 0;
+	fs->fatsect = 0xFFFFFFFF;
+
+	if (disk_read(0, fs->win, 0, 1) != RES_OK)
+		return FR_DISK_ERR;
+
+	int fmt = _ffro_check_vbr(fs->win);
+	if (!fmt && _ffro_ld16(fs->win + 510) == 0xAA55)
+	{
+		// Not a VBR, try the first MBR partition.
+		bsect = _ffro_ld32(fs->win + 446 + 8);
+		if (disk_read(0, fs->win, bsect, 1) != RES_OK)
+			return FR_DISK_ERR;
+		fmt = _ffro_check_vbr(fs->win);
+	}
+	if (!fmt)
+		return FR_NO_FILESYSTEM;
+
+	if (fmt == FFRO_EXFAT)
+	{
+		if (fs->win[108] != 9 || fs->win[109] > 16)
+			return FR_NO_FILESYSTEM;
+		fs->csize_shift = fs->win[109];
+		fs->fatbase = bsect + _ffro_ld32(fs->win + 80);
+		fs->database = bsect + _ffro_ld32(fs->win + 88);
+		fs->n_fatent = _ffro_ld32(fs->win + 92) + 2;
+		fs->dirbase = _ffro_ld32(fs->win + 96);
+	}
+	else
+	{
+		u32 csize = fs->win[13];
+		if (_ffro_ld16(fs->win + 11) != FFRO_SECT_SIZE || !csize || (csize & (csize - 1)))
+			return FR_NO_FILESYSTEM;
+		for (fs->csize_shift = 0; (1u << fs->csize_shift) < csize; fs->csize_shift++)
+			;
+
+		u32 tsect = _ffro_ld16(fs->win + 19);
+		if (!tsect)
+			tsect = _ffro_ld32(fs->win + 32);
+		fs->fatbase = bsect + _ffro_ld16(fs->win + 14);
+		fs->database = fs->fatbase + fs->win[16] * _ffro_ld32(fs->win + 36);
+		if (tsect < fs->database - bsect)
+			return FR_NO_FILESYSTEM;
+		fs->n_fatent = ((tsect - (fs->database - bsect)) >> fs->csize_shift) + 2;
+		fs->dirbase = _ffro_ld32(fs->win + 44);
+	}
+
+	if (fs->dirbase < 2 || fs->dirbase >= fs->n_fatent)
+		return FR_NO_FILESYSTEM;
+
+	fs->fs_type = fmt;
+	return FR_OK;
+}
+
+/*
+ * Name matcher state. It's fed one 32-byte directory entry at a time and
+ * spans sector and cluster boundaries.
+ */
+typedef struct _ffro_match_t
+{
+	const char *comp;
+	u32 len;
+	ffro_file_t *out;
+	// FAT32 LFN assembly.
+	char lfn[FFRO_LFN_ENT * 13 + 1];
+	u8 lfn_ord;
+	u8 lfn_sum;
+	bool lfn_ok;
+	// exFAT entry set.
+	u8 set_left;
+	u8 name_len;
+	u8 name_pos;
+	bool set_ok;
+} ffro_match_t;
+
+static const u8 _ffro_lfn_ofs[13] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+
+// Returns 1 on match, -1 on end of directory, 0 otherwise.
+static int _ffro_match_fat32(ffro_match_t *m, const u8 *e)
+{
+	if (!e[0])
+		return -1;
+
+	if (e[0] == 0xE5)
+	{
+		m->lfn_ord = 0;
+		m->lfn_ok = false;
+		return 0;
+	}
+
+	if (e[11] == AM_LFN)
+	{
+		u32 ord = e[0] & 0x3F;
+		if (e[0] & 0x40)
+		{
+			if (ord > FFRO_LFN_ENT)
+				ord = 0;
+			m->lfn_ord = ord;
+			m->lfn_sum = e[13];
+			m->lfn_ok = false;
+			m->lfn[ord * 13] = 0;
+		}
+		if (!ord || ord != m->lfn_ord || e[13] != m->lfn_sum)
+		{
+			m->lfn_ord = 0;
+			return 0;
+		}
+
+		char *p = m->lfn + (ord - 1) * 13;
+		for (u32 i = 0; i < 13; i++)
+		{
+			u32 c = _ffro_ld16(e + _ffro_lfn_ofs[i]);
+			if (c == 0xFFFF)
+				break;
+			if (c > 0x7F)
+			{
+				// Non-ASCII names are never matched, the SFN still may be.
+				m->lfn_ord = 0;
+				return 0;
+			}
+			p[i] = c;
+			if (!c)
+				break;
+		}
+
+		m->lfn_ord--;
+		m->lfn_ok = !m->lfn_ord;
+		return 0;
+	}
+
+	bool lfn_ok = m->lfn_ok;
+	m->lfn_ord = 0;
+	m->lfn_ok = false;
+
+	if (e[11] & AM_VOL)
+		return 0;
+
+	if (lfn_ok)
+	{
+		u8 sum = 0;
+		for (u32 i = 0; i < 11; i++)
+			sum = ((sum & 1) << 7) + (sum >> 1) + e[i];
+		if (sum == m->lfn_sum && _ffro_name_eq(m->lfn, m->comp, m->len))
+			goto found;
+	}
+
+	// Build "NAME.EXT" from the SFN.
+	char sfn[13];
+	u32 n = 0;
+	for (u32 i = 0; i < 8 && e[i] != ' '; i++)
+		sfn[n++] = e[i];
+	if (e[8] != ' ')
+	{
+		sfn[n++] = '.';
+		for (u32 i = 8; i < 11 && e[i] != ' '; i++)
+			sfn[n++] = e[i];
+	}
+	sfn[n] = 0;
+	if (!_ffro_name_eq(sfn, m->comp, m->len))
+		return 0;
+
+found:
+	m->out->sclust = _ffro_ld16(e + 26) | (_ffro_ld16(e + 20) << 16);
+	m->out->size = _ffro_ld32(e + 28);
+	m->out->attr = e[11];
+	m->out->contig = 0;
+	return 1;
+}
+
+// Returns 1 on match, -1 on end of directory, 0 otherwise.
+static int _ffro_match_exfat(ffro_match_t *m, const u8 *e)
+{
+	if (!e[0])
+		return -1;
+
+	switch (e[0])
+	{
+	case ET_FILEDIR:
+		m->set_left = e[1];
+		m->set_ok = m->set_left >= 2;
+		m->name_pos = 0;
+		m->out->attr = e[4];
+		return 0;
+	case ET_STREAM:
+		if (!m->set_left)
+			return 0;
+		m->name_len = e[3];
+		// Early rejection on name length and files we can't address.
+		if (m->name_len != m->len || _ffro_ld32(e + 28))
+			m->set_ok = false;
+		m->out->contig = (e[1] & 2) ? 1 : 0;
+		m->out->sclust = _ffro_ld32(e + 20);
+		m->out->size = _ffro_ld32(e + 24);
+		break;
+	case ET_FILENAME:
+		if (!m->set_left)
+			return 0;
+		for (u32 i = 0; i < 15 && m->set_ok && m->name_pos < m->name_len; i++, m->name_pos++)
+		{
+			u32 c = _ffro_ld16(e + 2 + i * 2);
+			if (c > 0x7F || _ffro_fold(c) != _ffro_fold((u8)m->comp[m->name_pos]))
+				m->set_ok = false;
+		}
+		break;
+	default:
+		if (!(e[0] & 0x80))
+		{
+			// Deleted entry, the current set is broken.
+			m->set_left = 0;
+			return 0;
+		}
+		if (!m->set_left)
+			return 0;
+		break;
+	}
+
+	if (--m->set_left)
+		return 0;
+
+	return (m->set_ok && m->name_pos == m->name_len) ? 1 : 0;
+}
+
+static FRESULT _ffro_find(ffro_t *fs, const ffro_file_t *dir, const char *comp, u32 len, ffro_file_t *out)
+{
+	ffro_match_t m;
+	u32 clst = dir->sclust;
+	u32 csize = 1 << fs->csize_shift;
+	// Contiguous exFAT directories are bounded by their size, chains by the
+	// largest directory so one that loops back ends too.
+	u32 left = dir->contig ? ALIGN(dir->size, FFRO_SECT_SIZE) / FFRO_SECT_SIZE :
+		(fs->fs_type == FFRO_EXFAT ? FFRO_MAX_DIR_EX : FFRO_MAX_DIR) / FFRO_SECT_SIZE;
+
+	m.comp = comp;
+	m.len = len;
+	m.out = out;
+	m.lfn_ord = 0;
+	m.lfn_ok = false;
+	m.set_left = 0;
+
+	while (left)
+	{
+		if (clst == 1)
+			return FR_DISK_ERR;
+		if (clst < 2 || clst >= fs->n_fatent)
+			return FR_NO_FILE;
+
+		u32 sect = _ffro_clst2sect(fs, clst);
+		for (u32 s = 0; s < csize && left; s++, left--)
+		{
+			if (disk_read(0, fs->win, sect + s, 1) != RES_OK)
+				return FR_DISK_ERR;
+
+			for (u32 i = 0; i < FFRO_SECT_SIZE; i += FFRO_DIR_SIZE)
+			{
+				int res = fs->fs_type == FFRO_EXFAT ?
+					_ffro_match_exfat(&m, fs->win + i) : _ffro_match_fat32(&m, fs->win + i);
+				if (res > 0)
+					return FR_OK;
+				if (res < 0)
+					return FR_NO_FILE;
+			}
+		}
+
+		clst = dir->contig ? clst + 1 : _ffro_get_fat(fs, clst);
+	}
+
+	return FR_NO_FILE;
+}
+
+FRESULT ffro_open(ffro_t *fs, ffro_file_t *fp, const char *path)
+{
+	if (!fs->fs_type)
+		return FR_NOT_ENABLED;
+
+	// Non-ASCII paths need code page conversion, leave them to FatFs.
+	for (const char *p = path; *p; p++)
+		if ((u8)*p > 0x7E)
+			return FR_INVALID_NAME;
+
+	fp->sclust = fs->dirbase;
+	fp->size = 0;
+	fp->attr = AM_DIR;
+	fp->contig = 0;
+
+	while (*path)
+	{
+		while (*path == '/' || *path == '\\')
+			path++;
+		if (!*path)
+			break;
+
+		u32 len = 0;
+		while (path[len] && path[len] != '/' && path[len] != '\\')
+			len++;
+		if (len > FFRO_LFN_MAX)
+			return FR_INVALID_NAME;
+
+		if (!(fp->attr & AM_DIR))
+			return FR_NO_PATH;
+
+		ffro_file_t dir = *fp;
+		FRESULT res = _ffro_find(fs, &dir, path, len, fp);
+		if (res != FR_OK)
+			return res;
+
+		path += len;
+	}
+
+	return (fp->attr & AM_DIR) ? FR_NO_FILE : FR_OK;
+}
+
+FRESULT ffro_read(ffro_t *fs, ffro_file_t *fp, void *buf, u32 size)
+{
+	u8 *pbuf = (u8 *)buf;
+	u32 clst = fp->sclust;
+
+	if (size > fp->size)
+		return FR_INVALID_PARAMETER;
+
+	while (size)
+	{
+		if (clst < 2 || clst >= fs->n_fatent)
+			return FR_INT_ERR;
+
+		// Extract the run of contiguous clusters that covers as much of the request as possible.
+		u32 need = ALIGN(size, FFRO_SECT_SIZE) / FFRO_SECT_SIZE;
+		u32 max = (need + (1 << fs->csize_shift) - 1) >> fs->csize_shift;
+		u32 nclst = 1;
+		u32 next = clst + 1;
+		if (fp->contig)
+		{
+			nclst = max;
+			next = clst + max;
+		}
+		else
+		{
+			while (1)
+			{
+				next = _ffro_get_fat(fs, clst + nclst - 1);
+				if (next == 1)
+					return FR_DISK_ERR;
+				if (nclst >= max || next != clst + nclst)
+					break;
+				nclst++;
+			}
+		}
+
+		// Whole sectors go straight to the destination in one multi-block read.
+		u32 sect = _ffro_clst2sect(fs, clst);
+		u32 run = nclst << fs->csize_shift;
+		u32 nsect = MIN(run, size / FFRO_SECT_SIZE);
+		if (nsect)
+		{
+			if (disk_read(0, pbuf, sect, nsect) != RES_OK)
+				return FR_DISK_ERR;
+			pbuf += nsect * FFRO_SECT_SIZE;
+			size -= nsect * FFRO_SECT_SIZE;
+		}
+
+		// Partial last sector.
+		if (size && size < FFRO_SECT_SIZE && nsect < run)
+		{
+			if (disk_read(0, fs->win, sect + nsect, 1) != RES_OK)
+				return FR_DISK_ERR;
+			memcpy(pbuf, fs->win, size);
+			size = 0;
+		}
+
+		clst = next;
+	}
+
+	return FR_OK;
+}
@@ -35,6 +35,7 @@
 sdmmc_t g_sd_sdmmc;
 sdmmc_storage_t g_sd_storage;
 FATFS g_sd_fs;
+ffro_t g_sd_ffro;
 bool g_sd_mounted;
 gfx_ctxt_t g_gfx_ctxt;
 gfx_con_t g_gfx_con;
@@ -24,6 +24,7 @@
 #include "power/max77620.h"
 #include "mem/sdram_param_t210.h"
 #include "soc/clock.h"
+#include "panic/panic.h"
 
 #define CONFIG_SDRAM_COMPRESS_CFG
 
@@ -491,14 +492,23 @@ break_nosleep:
 
 const void *sdram_get_params()
 {
-	//TODO: sdram_id should be in [0, 7].
+	u32 sdram_id = get_sdram_id();
 
 #ifdef CONFIG_SDRAM_COMPRESS_CFG
-	u8 *buf = (u8 *)0x40030000;
-	LZ_Uncompress(_dram_cfg_lz, buf, sizeof(_dram_cfg_lz));
-	return (const void *)&buf[sizeof(sdram_params_t) * get_sdram_id()];
+	// Only the base table is decoded, the id's own words are patched over it.
+	u32 *buf = (u32 *)0x40030000;
+	if (LZ_Uncompress_safe(_dram_cfg_base_lz, sizeof(_dram_cfg_base_lz), (u8 *)buf, sizeof(sdram_params_t)) != sizeof(sdram_params_t))
+		return NULL;
+
+	// Ids without a table of their own use the first one.
+	if (sdram_id >= SDRAM_CFG_IDS)
+		sdram_id = 0;
+	for (u32 i = _dram_cfg_delta_idx[sdram_id]; i < _dram_cfg_delta_idx[sdram_id + 1]; i++)
+		buf[_dram_cfg_delta_off[i]] = _dram_cfg_delta_val[i];
+
+	return (const void *)buf;
 #else
-	return _dram_cfgs[get_sdram_id()];
+	return _dram_cfgs[sdram_id];
 #endif
 }
 
@@ -506,6 +516,8 @@ void sdram_init()
 {
 	//TODO: sdram_id should be in [0,4].
 	const sdram_params_t *params = (const sdram_params_t *)sdram_get_params();
+	if (!params)
+		panic(0x30); // The table is part of the image, it only breaks with the image.
 
 	i2c_send_byte(I2C_5, MAX77620_I2C_ADDR, MAX77620_REG_SD_CFG2, 0x05);
 	i2c_send_byte(I2C_5, MAX77620_I2C_ADDR, MAX77620_REG_SD1, 40); //40 = (1000 * 1100 - 600000) / 12500 -> 1.1V
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "sec/keyslot.h"
+#include "sec/se.h"
+#include "sec/se_t210.h"
+
+#define KEYSLOT_RAW 0xFF
+
+typedef struct _keyslot_ent_t
+{
+	u8  id[0x10];  // Seed for derived keys, truncated SHA-256 for raw keys.
+	u8  parent;    // Parent slot, KEYSLOT_RAW for raw keys.
+	u8  used;
+	u16 size;
+	u32 parent_gen; // Generation of the parent when the key was derived.
+	u32 lru;
+} keyslot_ent_t;
+
+static keyslot_ent_t _keyslots[KEYSLOT_MANAGED_COUNT];
+// Bumped every time a slot gets new content, so children of a replaced key stop matching.
+static u32 _keyslot_gen[TEGRA_SE_KEYSLOT_COUNT];
+static u32 _keyslot_tick;
+
+static int _keyslot_find(u32 parent, const u8 *id)
+{
+	u32 gen = parent == KEYSLOT_RAW ? 0 : _keyslot_gen[parent];
+
+	for (u32 i = 0; i < KEYSLOT_MANAGED_COUNT; i++)
+	{
+		keyslot_ent_t *ent = &_keyslots[i];
+		if (ent->used && ent->parent == parent && ent->parent_gen == gen && !memcmp(ent->id, id, 0x10))
+		{
+			ent->lru = ++_keyslot_tick;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+// Free slot, else the least recently used one that isn't pinned.
+static int _keyslot_alloc(u32 pin)
+{
+	int slot = -1;
+
+	for (u32 i = 0; i < KEYSLOT_MANAGED_COUNT; i++)
+	{
+		if (i == pin)
+			continue;
+		if (!_keyslots[i].used)
+		{
+			slot = i;
+			break;
+		}
+		if (slot < 0 || _keyslots[i].lru < _keyslots[slot].lru)
+			slot = i;
+	}
+
+	if (slot >= 0 && _keyslots[slot].used)
+	{
+		se_aes_key_clear(slot);
+		_keyslots[slot].used = 0;
+	}
+
+	return slot;
+}
+
+static void _keyslot_commit(int slot, u32 parent, const u8 *id, u32 size)
+{
+	keyslot_ent_t *ent = &_keyslots[slot];
+
+	memcpy(ent->id, id, 0x10);
+	ent->parent = parent;
+	ent->parent_gen = parent == KEYSLOT_RAW ? 0 : _keyslot_gen[parent];
+	ent->size = size;
+	ent->used = 1;
+	ent->lru = ++_keyslot_tick;
+	_keyslot_gen[slot]++;
+}
+
+int keyslot_load(const void *key, u32 size)
+{
+	u8 hash[0x20];
+
+	if ((size != 0x10 && size != 0x18 && size != 0x20) || !se_calc_sha256(hash, key, size))
+		return -1;
+
+	int slot = _keyslot_find(KEYSLOT_RAW, hash);
+	if (slot >= 0)
+		return slot;
+
+	slot = _keyslot_alloc(KEYSLOT_RAW);
+	if (slot < 0)
+		return -1;
+
+	se_aes_key_set(slot, (void *)key, size);
+	_keyslot_commit(slot, KEYSLOT_RAW, hash, size);
+
+	return slot;
+}
+
+int keyslot_derive(u32 parent, const void *seed)
+{
+	if (parent >= TEGRA_SE_KEYSLOT_COUNT)
+		return -1;
+
+	int slot = _keyslot_find(parent, (const u8 *)seed);
+	if (slot >= 0)
+		return slot;
+
+	slot = _keyslot_alloc(parent);
+	if (slot < 0)
+		return -1;
+
+	if (!se_aes_unwrap_key(slot, parent, seed))
+	{
+		se_aes_key_clear(slot);
+		_keyslot_gen[slot]++;
+		return -1;
+	}
+	_keyslot_commit(slot, parent, (const u8 *)seed, 0x10);
+
+	return slot;
+}
+
+int keyslot_derive_path(u32 root, const void *seeds, u32 count)
+{
+	const u8 *pseeds = (const u8 *)seeds;
+	int slot = root;
+
+	if (root >= TEGRA_SE_KEYSLOT_COUNT)
+		return -1;
+
+	// Skip the prefix that is already loaded, then unwrap the rest back to back.
+	u32 i = 0;
+	for (; i < count; i++)
+	{
+		int next = _keyslot_find(slot, pseeds + i * 0x10);
+		if (next < 0)
+			break;
+		slot = next;
+	}
+
+	for (; i < count && slot >= 0; i++)
+		slot = keyslot_derive(slot, pseeds + i * 0x10);
+
+	return slot;
+}
+
+void keyslot_clear_all()
+{
+	for (u32 i = 0; i < KEYSLOT_MANAGED_COUNT; i++)
+	{
+		if (_keyslots[i].used)
+			se_aes_key_clear(i);
+		_keyslots[i].used = 0;
+		_keyslot_gen[i]++;
+	}
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "sec/rsa.h"
+#include "sec/se.h"
+#include "sec/se_t210.h"
+#include "utils/fs_utils.h"
+
+#define SHA256_SIZE 0x20
+#define PSS_DB_SIZE (RSA2048_SIZE - SHA256_SIZE - 1)
+
+// DER DigestInfo prefix for SHA-256.
+static const u8 _rsa_sha256_prefix[] = {
+	0x30, 0x31, 0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+};
+
+// Fingerprint of the key held by each RSA keyslot.
+static u8 _rsa_slot_ids[TEGRA_SE_RSA_KEYSLOT_COUNT][SHA256_SIZE];
+static bool _rsa_slot_loaded[TEGRA_SE_RSA_KEYSLOT_COUNT];
+
+static u8 _rsa_em[RSA2048_SIZE] __attribute__((aligned(0x10)));
+static u8 _rsa_buf[8 + SHA256_SIZE + PSS_DB_SIZE] __attribute__((aligned(0x10)));
+
+static bool _rsa_memeq(const u8 *a, const u8 *b, u32 size)
+{
+	u8 diff = 0;
+	for (u32 i = 0; i < size; i++)
+		diff |= a[i] ^ b[i];
+	return !diff;
+}
+
+static int _rsa_key_load(u32 rs, const rsa2048_key_t *key)
+{
+	u8 id[SHA256_SIZE];
+
+	if (rs >= TEGRA_SE_RSA_KEYSLOT_COUNT || !se_calc_sha256(id, key, sizeof(rsa2048_key_t)))
+		return 0;
+
+	if (_rsa_slot_loaded[rs] && !memcmp(id, _rsa_slot_ids[rs], SHA256_SIZE))
+		return 1;
+
+	_rsa_slot_loaded[rs] = se_rsa_key_set(rs, key->mod, RSA2048_SIZE, key->exp, sizeof(key->exp));
+	memcpy(_rsa_slot_ids[rs], id, SHA256_SIZE);
+
+	return _rsa_slot_loaded[rs];
+}
+
+static int _rsa_verify_pkcs1(const u8 *em, const u8 *hash)
+{
+	u8 *expected = _rsa_buf;
+	u32 ps_size = RSA2048_SIZE - 3 - sizeof(_rsa_sha256_prefix) - SHA256_SIZE;
+
+	// 00 01 FF..FF 00 DigestInfo hash.
+	expected[0] = 0;
+	expected[1] = 1;
+	memset(expected + 2, 0xFF, ps_size);
+	expected[2 + ps_size] = 0;
+	if (!_rsa_memeq(em, expected, 3 + ps_size))
+		return 0;
+
+	em += 3 + ps_size;
+	return _rsa_memeq(em, _rsa_sha256_prefix, sizeof(_rsa_sha256_prefix)) &&
+		_rsa_memeq(em + sizeof(_rsa_sha256_prefix), hash, SHA256_SIZE);
+}
+
+// db ^= MGF1-SHA256(seed).
+static int _rsa_mgf1_xor(u8 *db, u32 size, const u8 *seed)
+{
+	u8 *in = _rsa_buf;
+	u8 mask[SHA256_SIZE];
+
+	memcpy(in, seed, SHA256_SIZE);
+	for (u32 ctr = 0, off = 0; off < size; ctr++, off += SHA256_SIZE)
+	{
+		in[SHA256_SIZE] = ctr >> 24;
+		in[SHA256_SIZE + 1] = ctr >> 16;
+		in[SHA256_SIZE + 2] = ctr >> 8;
+		in[SHA256_SIZE + 3] = ctr;
+		if (!se_calc_sha256(mask, in, SHA256_SIZE + 4))
+			return 0;
+		for (u32 i = 0; i < SHA256_SIZE && off + i < size; i++)
+			db[off + i] ^= mask[i];
+	}
+
+	return 1;
+}
+
+static int _rsa_verify_pss(u8 *em, const u8 *hash)
+{
+	u8 *db = em;
+	const u8 *h = em + PSS_DB_SIZE;
+	u8 hash2[SHA256_SIZE];
+	u32 i;
+
+	// emBits is 2047, so the top bit is always clear.
+	if (em[RSA2048_SIZE - 1] != 0xBC || (em[0] & 0x80))
+		return 0;
+
+	if (!_rsa_mgf1_xor(db, PSS_DB_SIZE, h))
+		return 0;
+	db[0] &= 0x7F;
+
+	// DB = 00..00 01 salt.
+	for (i = 0; i < PSS_DB_SIZE && !db[i]; i++)
+		;
+	if (i == PSS_DB_SIZE || db[i] != 1)
+		return 0;
+	i++;
+
+	// H' = SHA256(00 * 8 | mHash | salt).
+	u32 salt_size = PSS_DB_SIZE - i;
+	memset(_rsa_buf, 0, 8);
+	memcpy(_rsa_buf + 8, hash, SHA256_SIZE);
+	memcpy(_rsa_buf + 8 + SHA256_SIZE, db + i, salt_size);
+	if (!se_calc_sha256(hash2, _rsa_buf, 8 + SHA256_SIZE + salt_size))
+		return 0;
+
+	return _rsa_memeq(hash2, h, SHA256_SIZE);
+}
+
+int rsa2048_verify_hash(u32 rs, const rsa2048_key_t *key, const void *sig, const void *hash, u32 padding)
+{
+	if (!_rsa_key_load(rs, key))
+		return 0;
+
+	if (!se_rsa_exp_mod(rs, _rsa_em, RSA2048_SIZE, sig, RSA2048_SIZE))
+		return 0;
+
+	if (padding == RSA_PADDING_PSS)
+		return _rsa_verify_pss(_rsa_em, (const u8 *)hash);
+	return _rsa_verify_pkcs1(_rsa_em, (const u8 *)hash);
+}
+
+int rsa2048_verify(u32 rs, const rsa2048_key_t *key, const void *sig, const void *data, u32 size, u32 padding)
+{
+	u8 hash[SHA256_SIZE];
+
+	if (!se_calc_sha256(hash, data, size))
+		return 0;
+	return rsa2048_verify_hash(rs, key, sig, hash, padding);
+}
+
+int rsa2048_verify_file(u32 rs, const rsa2048_key_t *key, const void *sig, const char *path, u32 padding)
+{
+	u8 hash[SHA256_SIZE];
+
+	if (!sd_file_sha256(path, hash, NULL))
+		return 0;
+	return rsa2048_verify_hash(rs, key, sig, hash, padding);
+}
+
+void rsa2048_key_forget(u32 rs)
+{
+	if (rs >= TEGRA_SE_RSA_KEYSLOT_COUNT)
+		return;
+
+	se_rsa_key_clear(rs);
+	_rsa_slot_loaded[rs] = false;
+}
@@ -16,10 +16,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// Hardware backend, se_sw.c provides the same API when SE_SW_BACKEND is set.
+#ifndef SE_SW_BACKEND
+
 #include <string.h>
 
 #include "sec/se.h"
-#include "mem/heap.h"
 #include "soc/t210.h"
 #include "sec/se_t210.h"
 #include "utils/util.h"
@@ -31,12 +33,52 @@ typedef struct _se_ll_t
 	vu32 size;
 } se_ll_t;
 
+// Input/output descriptor pair, padded to a cache line.
+typedef struct _se_ll_pair_t
+{
+	se_ll_t in;
+	se_ll_t out;
+	u32 rsvd[2];
+} se_ll_pair_t;
+
+/*
+ * Everything the engine DMAs to or from is statically allocated, so no
+ * operation goes through the heap.
+ */
+#define SE_LL_RING_SIZE 2
+static se_ll_pair_t _se_ll_ring[SE_LL_RING_SIZE] __attribute__((aligned(0x20)));
+static u32 _se_ll_idx;
+static u8 _se_block[0x10] __attribute__((aligned(0x10)));
+static u8 _se_tweak[0x10] __attribute__((aligned(0x10)));
+static u8 _se_sha_pad[0x80] __attribute__((aligned(0x10)));
+static u8 _se_rsa_buf[TEGRA_SE_RSA2048_DIGEST_SIZE] __attribute__((aligned(0x10)));
+
+static u32 _se_rsa_mod_sizes[TEGRA_SE_RSA_KEYSLOT_COUNT];
+static u32 _se_rsa_exp_sizes[TEGRA_SE_RSA_KEYSLOT_COUNT];
+
+// Tweak stream for batched XTS, holds a run of whole sectors.
+#define SE_XTS_RUN_SIZE 0x1000
+static u8 _se_xts_tweaks[SE_XTS_RUN_SIZE] __attribute__((aligned(0x10)));
+
+static se_stats_t _se_stats[SE_OP_TYPE_MAX];
+
+// Operation started by se_job_start() and not yet collected.
+static struct
+{
+	se_job_t job;
+	se_sha256_ctx_t *sha; // Hash state to save on completion.
+	u32 start;
+	int res;
+	bool busy;
+} _se_async = { .res = 1 };
+
+// Multiplication by x in GF(2^128), the tweak is little endian as in IEEE 1619.
 static void _gf256_mul_x(void *block)
 {
 	u8 *pdata = (u8 *)block;
 	u32 carry = 0;
 
-	for (u32 i = 0xF; i >= 0; i--)
+	for (u32 i = 0; i < 0x10; i++)
 	{
 		u8 b = pdata[i];
 		pdata[i] = (b << 1) | carry;
@@ -44,7 +86,7 @@ static void _gf256_mul_x(void *block)
 	}
 
 	if (carry)
-		pdata[0xF] ^= 0x87;
+		pdata[0] ^= 0x87;
 }
 
 static void _se_ll_init(se_ll_t *ll, u32 addr, u32 size)
@@ -60,10 +102,13 @@ static void _se_ll_set(se_ll_t *dst, se_ll_t *src)
 	SE(SE_OUT_LL_ADDR_REG_OFFSET) = (u32)dst;
 }
 
-static int _se_wait()
+static bool _se_done()
+{
+	return SE(SE_INT_STATUS_REG_OFFSET) & SE_INT_OP_DONE(INT_SET);
+}
+
+static int _se_check_status()
 {
-	while (!(SE(SE_INT_STATUS_REG_OFFSET) & SE_INT_OP_DONE(INT_SET)))
-		;
 	if (SE(SE_INT_STATUS_REG_OFFSET) & SE_INT_ERROR(INT_SET) ||
 		SE(SE_STATUS_0) & 3 ||
 		SE(SE_ERR_STATUS_0) != 0)
@@ -71,36 +116,31 @@ static int _se_wait()
 	return 1;
 }
 
-static int _se_execute(u32 op, void *dst, u32 dst_size, const void *src, u32 src_size)
+static int _se_wait()
 {
-	se_ll_t *ll_dst = NULL, *ll_src = NULL;
-
-	if (dst)
-	{
-		ll_dst = (se_ll_t *)malloc(sizeof(se_ll_t));
-		_se_ll_init(ll_dst, (u32)dst, dst_size);
-	}
+	while (!_se_done())
+		;
+	return _se_check_status();
+}
 
-	if (src)
-	{
-		ll_src = (se_ll_t *)malloc(sizeof(se_ll_t));
-		_se_ll_init(ll_src, (u32)src, src_size);
-	}
+static void _se_start(u32 op, void *dst, u32 dst_size, const void *src, u32 src_size)
+{
+	se_ll_pair_t *ll = &_se_ll_ring[_se_ll_idx];
+	_se_ll_idx = (_se_ll_idx + 1) % SE_LL_RING_SIZE;
 
-	_se_ll_set(ll_dst, ll_src);
+	_se_ll_init(&ll->in, (u32)src, src_size);
+	_se_ll_init(&ll->out, (u32)dst, dst_size);
+	_se_ll_set(dst ? &ll->out : NULL, src ? &ll->in : NULL);
 
 	SE(SE_ERR_STATUS_0) = SE(SE_ERR_STATUS_0);
 	SE(SE_INT_STATUS_REG_OFFSET) = SE(SE_INT_STATUS_REG_OFFSET);
 	SE(SE_OPERATION_REG_OFFSET) = SE_OPERATION(op);
+}
 
-	int res = _se_wait();
-
-	if (src)
-		free(ll_src);
-	if (dst)
-		free(ll_dst);
-
-	return res;
+static int _se_execute(u32 op, void *dst, u32 dst_size, const void *src, u32 src_size)
+{
+	_se_start(op, dst, dst_size, src, src_size);
+	return _se_wait();
 }
 
 static int _se_execute_one_block(u32 op, void *dst, u32 dst_size, const void *src, u32 src_size)
@@ -108,26 +148,181 @@ static int _se_execute_one_block(u32 op, void *dst, u32 dst_size, const void *sr
 	if (!src || !dst)
 		return 0;
 
-	u8 *block = (u8 *)malloc(0x10);
-	memset(block, 0, 0x10);
+	memset(_se_block, 0, 0x10);
 
 	SE(SE_BLOCK_COUNT_REG_OFFSET) = 0;
 
-	memcpy(block, src, src_size);
-	int res = _se_execute(op, block, 0x10, block, 0x10);
-	memcpy(dst, block, dst_size);
-	
-	free(block);
+	memcpy(_se_block, src, src_size);
+	int res = _se_execute(op, _se_block, 0x10, _se_block, 0x10);
+	memcpy(dst, _se_block, dst_size);
+
 	return res;
 }
 
-static void _se_aes_ctr_set(void *ctr)
+static void _se_aes_iv_set(u32 ks, const void *iv)
 {
-	u32 *data = (u32 *)ctr;
+	const u32 *data = (const u32 *)iv;
+	for (u32 i = 0; i < 4; i++)
+	{
+		SE(SE_KEYTABLE_REG_OFFSET) = SE_KEYTABLE_SLOT(ks) | SE_KEYTABLE_QUAD(QUAD_ORG_IV) | i;
+		SE(SE_KEYTABLE_DATA0_REG_OFFSET) = data[i];
+	}
+}
+
+static void _se_aes_ctr_set(const void *ctr)
+{
+	const u32 *data = (const u32 *)ctr;
 	for (u32 i = 0; i < 4; i++)
 		SE(SE_CRYPTO_CTR_REG_OFFSET + 4 * i) = data[i];
 }
 
+// SHA and RSA operations don't use SE_CRYPTO or the block count.
+static bool _se_is_aes(u32 config)
+{
+	u32 alg = (config >> SE_CONFIG_ENC_ALG_SHIFT) & 0xF;
+	return alg != ALG_SHA && alg != ALG_RSA;
+}
+
+// Registers can't be touched while an asynchronous operation runs.
+static void _se_drain()
+{
+	if (_se_async.busy)
+		se_job_wait();
+}
+
+static void _se_job_setup(const se_job_t *job)
+{
+	_se_drain();
+	if (job->ctr)
+	{
+		SE(SE_SPARE_0_REG_OFFSET) = 1;
+		_se_aes_ctr_set(job->ctr);
+	}
+	if (job->iv)
+		_se_aes_iv_set((job->crypto >> SE_CRYPTO_KEY_INDEX_SHIFT) & 0xF, job->iv);
+	SE(SE_CONFIG_REG_OFFSET) = job->config;
+	if (_se_is_aes(job->config))
+		SE(SE_CRYPTO_REG_OFFSET) = job->crypto;
+	if (((job->config >> SE_CONFIG_DST_SHIFT) & 7) == DST_KEYTAB)
+		SE(SE_CRYPTO_KEYTABLE_DST_REG_OFFSET) = job->keytab_dst;
+}
+
+static void _se_job_account(const se_job_t *job, u32 start)
+{
+	se_stats_t *stats = &_se_stats[job->type];
+	stats->ops++;
+	stats->bytes += job->src_size;
+	stats->time_us += get_tmr_us() - start;
+}
+
+static void _se_job_kick(const se_job_t *job)
+{
+	if (_se_is_aes(job->config))
+		SE(SE_BLOCK_COUNT_REG_OFFSET) = job->src_size ? (job->src_size >> 4) - 1 : 0;
+	_se_start(OP_START, job->dst, job->dst_size, job->src, job->src_size);
+}
+
+static int _se_job_run(const se_job_t *job)
+{
+	u32 start = get_tmr_us();
+
+	_se_job_kick(job);
+	int res = _se_wait();
+
+	_se_job_account(job, start);
+	return res;
+}
+
+// The block count can't express an empty AES operation, there is nothing to run.
+static bool _se_job_empty(const se_job_t *job)
+{
+	return _se_is_aes(job->config) && !job->src_size;
+}
+
+int se_job_submit(const se_job_t *job)
+{
+	if (_se_job_empty(job))
+		return 1;
+
+	_se_job_setup(job);
+	return _se_job_run(job);
+}
+
+static void _se_sha256_save(se_sha256_ctx_t *ctx);
+
+static void _se_job_launch(const se_job_t *job, se_sha256_ctx_t *sha)
+{
+	memcpy(&_se_async.job, job, sizeof(se_job_t));
+	_se_async.sha = sha;
+	_se_async.start = get_tmr_us();
+	_se_async.busy = true;
+	_se_job_kick(job);
+}
+
+int se_job_start(const se_job_t *job)
+{
+	if (_se_job_empty(job))
+	{
+		_se_drain();
+		_se_async.res = 1;
+		return 1;
+	}
+
+	_se_job_setup(job);
+	_se_job_launch(job, NULL);
+	return 1;
+}
+
+int se_job_poll()
+{
+	if (!_se_async.busy)
+		return _se_async.res;
+	if (!_se_done())
+		return SE_JOB_BUSY;
+
+	_se_async.busy = false;
+	_se_async.res = _se_check_status();
+	if (_se_async.sha)
+		_se_sha256_save(_se_async.sha);
+	_se_job_account(&_se_async.job, _se_async.start);
+
+	return _se_async.res;
+}
+
+int se_job_wait()
+{
+	int res;
+	while ((res = se_job_poll()) == SE_JOB_BUSY)
+		;
+	return res;
+}
+
+const se_stats_t *se_get_stats()
+{
+	return _se_stats;
+}
+
+void se_reset_stats()
+{
+	memset(_se_stats, 0, sizeof(_se_stats));
+}
+
+static void _se_job_aes(se_job_t *job, u32 type, u32 ks, u32 enc)
+{
+	memset(job, 0, sizeof(se_job_t));
+	job->type = type;
+	if (enc)
+	{
+		job->config = SE_CONFIG_ENC_ALG(ALG_AES_ENC) | SE_CONFIG_DST(DST_MEMORY);
+		job->crypto = SE_CRYPTO_KEY_INDEX(ks) | SE_CRYPTO_CORE_SEL(CORE_ENCRYPT);
+	}
+	else
+	{
+		job->config = SE_CONFIG_DEC_ALG(ALG_AES_DEC) | SE_CONFIG_DST(DST_MEMORY);
+		job->crypto = SE_CRYPTO_KEY_INDEX(ks) | SE_CRYPTO_CORE_SEL(CORE_DECRYPT);
+	}
+}
+
 void se_rsa_acc_ctrl(u32 rs, u32 flags)
 {
 	if (flags & 0x7F)
@@ -136,6 +331,86 @@ void se_rsa_acc_ctrl(u32 rs, u32 flags)
 		SE(SE_RSA_KEYTABLE_ACCESS_LOCK_OFFSET) &= ~(1 << rs);
 }
 
+static void _se_rsa_key_write(u32 rs, u32 type, const u8 *data, u32 size)
+{
+	// Words go in least significant first, each read big endian.
+	for (u32 i = 0; i < size / 4; i++)
+	{
+		const u8 *w = data + size - 4 * i - 4;
+		SE(SE_RSA_KEYTABLE_ADDR) = RSA_KEY_NUM(rs) | RSA_KEY_TYPE(type) | RSA_KEY_WORD_ADDR(i);
+		SE(SE_RSA_KEYTABLE_DATA) = ((u32)w[0] << 24) | (w[1] << 16) | (w[2] << 8) | w[3];
+	}
+}
+
+int se_rsa_key_set(u32 rs, const void *mod, u32 mod_size, const void *exp, u32 exp_size)
+{
+	if (rs >= TEGRA_SE_RSA_KEYSLOT_COUNT || mod_size > TEGRA_SE_RSA2048_DIGEST_SIZE ||
+		exp_size > mod_size || (mod_size & 0x3F) || (exp_size & 3))
+		return 0;
+
+	_se_drain();
+	_se_rsa_key_write(rs, RSA_KEY_TYPE_MOD, (const u8 *)mod, mod_size);
+	_se_rsa_key_write(rs, RSA_KEY_TYPE_EXP, (const u8 *)exp, exp_size);
+	_se_rsa_mod_sizes[rs] = mod_size;
+	_se_rsa_exp_sizes[rs] = exp_size;
+
+	return 1;
+}
+
+void se_rsa_key_clear(u32 rs)
+{
+	if (rs >= TEGRA_SE_RSA_KEYSLOT_COUNT)
+		return;
+
+	_se_drain();
+	for (u32 i = 0; i < TEGRA_SE_RSA2048_DIGEST_SIZE / 4; i++)
+	{
+		SE(SE_RSA_KEYTABLE_ADDR) = RSA_KEY_NUM(rs) | RSA_KEY_TYPE(RSA_KEY_TYPE_MOD) | RSA_KEY_WORD_ADDR(i);
+		SE(SE_RSA_KEYTABLE_DATA) = 0;
+		SE(SE_RSA_KEYTABLE_ADDR) = RSA_KEY_NUM(rs) | RSA_KEY_TYPE(RSA_KEY_TYPE_EXP) | RSA_KEY_WORD_ADDR(i);
+		SE(SE_RSA_KEYTABLE_DATA) = 0;
+	}
+	_se_rsa_mod_sizes[rs] = 0;
+	_se_rsa_exp_sizes[rs] = 0;
+}
+
+// se_rsa_exp_mod() was derived from Atmosphère's se_synchronous_exp_mod.
+int se_rsa_exp_mod(u32 rs, void *dst, u32 dst_size, const void *src, u32 src_size)
+{
+	se_job_t job;
+	u32 mod_size = rs < TEGRA_SE_RSA_KEYSLOT_COUNT ? _se_rsa_mod_sizes[rs] : 0;
+
+	if (!mod_size || src_size != mod_size || dst_size > mod_size)
+		return 0;
+
+	// The engine takes the input little endian.
+	for (u32 i = 0; i < src_size; i++)
+		_se_rsa_buf[i] = ((const u8 *)src)[src_size - i - 1];
+
+	memset(&job, 0, sizeof(se_job_t));
+	job.type = SE_OP_RSA;
+	job.config = SE_CONFIG_ENC_ALG(ALG_RSA) | SE_CONFIG_DST(DST_RSAREG);
+	job.src = _se_rsa_buf;
+	job.src_size = src_size;
+
+	_se_job_setup(&job);
+	SE(SE_RSA_CONFIG) = RSA_KEY_SLOT(rs);
+	SE(SE_RSA_KEY_SIZE_REG_OFFSET) = (mod_size >> 6) - 1;
+	SE(SE_RSA_EXP_SIZE_REG_OFFSET) = _se_rsa_exp_sizes[rs] >> 2;
+
+	int res = _se_job_run(&job);
+
+	// Output is little endian too, the last dst_size bytes of the big endian result are kept.
+	u8 *pdst = (u8 *)dst;
+	for (u32 i = 0; i < dst_size; i++)
+	{
+		u32 w = SE(SE_RSA_OUTPUT + ((i >> 2) << 2));
+		pdst[dst_size - i - 1] = w >> ((i & 3) << 3);
+	}
+
+	return res;
+}
+
 void se_key_acc_ctrl(u32 ks, u32 flags)
 {
 	if (flags & 0x7F)
@@ -147,6 +422,7 @@ void se_key_acc_ctrl(u32 ks, u32 flags)
 void se_aes_key_set(u32 ks, void *key, u32 size)
 {
 	u32 *data = (u32 *)key;
+	_se_drain();
 	for (u32 i = 0; i < size / 4; i++)
 	{
 		SE(SE_KEYTABLE_REG_OFFSET) = SE_KEYTABLE_SLOT(ks) | i;
@@ -156,6 +432,7 @@ void se_aes_key_set(u32 ks, void *key, u32 size)
 
 void se_aes_key_clear(u32 ks)
 {
+	_se_drain();
 	for (u32 i = 0; i < TEGRA_SE_AES_MAX_KEY_SIZE / 4; i++)
 	{
 		SE(SE_KEYTABLE_REG_OFFSET) = SE_KEYTABLE_SLOT(ks) | i;
@@ -165,71 +442,179 @@ void se_aes_key_clear(u32 ks)
 
 int se_aes_unwrap_key(u32 ks_dst, u32 ks_src, const void *input)
 {
-	SE(SE_CONFIG_REG_OFFSET) = SE_CONFIG_DEC_ALG(ALG_AES_DEC) | SE_CONFIG_DST(DST_KEYTAB);
-	SE(SE_CRYPTO_REG_OFFSET) = SE_CRYPTO_KEY_INDEX(ks_src) | SE_CRYPTO_CORE_SEL(CORE_DECRYPT);
-	SE(SE_BLOCK_COUNT_REG_OFFSET) = 0;
-	SE(SE_CRYPTO_KEYTABLE_DST_REG_OFFSET) = SE_CRYPTO_KEYTABLE_DST_KEY_INDEX(ks_dst);
+	se_job_t job;
 
-	return _se_execute(OP_START, NULL, 0, input, 0x10);
+	_se_job_aes(&job, SE_OP_AES_UNWRAP, ks_src, 0);
+	job.config = SE_CONFIG_DEC_ALG(ALG_AES_DEC) | SE_CONFIG_DST(DST_KEYTAB);
+	job.keytab_dst = SE_CRYPTO_KEYTABLE_DST_KEY_INDEX(ks_dst);
+	job.src = input;
+	job.src_size = 0x10;
+
+	return se_job_submit(&job);
 }
 
 int se_aes_crypt_block_ecb(u32 ks, u32 enc, void *dst, const void *src)
 {
-	if (enc)
-	{
-		SE(SE_CONFIG_REG_OFFSET) = SE_CONFIG_ENC_ALG(ALG_AES_ENC) | SE_CONFIG_DST(DST_MEMORY);
-		SE(SE_CRYPTO_REG_OFFSET) = SE_CRYPTO_KEY_INDEX(ks) | SE_CRYPTO_CORE_SEL(CORE_ENCRYPT);
-	}
-	else
-	{
-		SE(SE_CONFIG_REG_OFFSET) = SE_CONFIG_DEC_ALG(ALG_AES_DEC) | SE_CONFIG_DST(DST_MEMORY);
-		SE(SE_CRYPTO_REG_OFFSET) = SE_CRYPTO_KEY_INDEX(ks) | SE_CRYPTO_CORE_SEL(CORE_DECRYPT);
-	}
-	SE(SE_BLOCK_COUNT_REG_OFFSET) = 0;
-	return _se_execute(OP_START, dst, 0x10, src, 0x10);
+	return se_aes_crypt_ecb(ks, enc, dst, 0x10, src, 0x10);
+}
+
+int se_aes_crypt_ecb(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size)
+{
+	se_job_t job;
+
+	_se_job_aes(&job, SE_OP_AES_ECB, ks, enc);
+	job.dst = dst;
+	job.dst_size = dst_size;
+	job.src = src;
+	job.src_size = src_size;
+
+	return se_job_submit(&job);
 }
 
 int se_aes_crypt_ctr(u32 ks, void *dst, u32 dst_size, const void *src, u32 src_size, void *ctr)
 {
-	SE(SE_SPARE_0_REG_OFFSET) = 1;
-	SE(SE_CONFIG_REG_OFFSET) = SE_CONFIG_ENC_ALG(ALG_AES_ENC) | SE_CONFIG_DST(DST_MEMORY);
-	SE(SE_CRYPTO_REG_OFFSET) = SE_CRYPTO_KEY_INDEX(ks) | SE_CRYPTO_CORE_SEL(CORE_ENCRYPT) |
-		SE_CRYPTO_XOR_POS(XOR_BOTTOM) | SE_CRYPTO_INPUT_SEL(INPUT_LNR_CTR) | SE_CRYPTO_CTR_VAL(1);
-	_se_aes_ctr_set(ctr);
+	se_job_t job;
+
+	_se_job_aes(&job, SE_OP_AES_CTR, ks, 1);
+	job.crypto |= SE_CRYPTO_XOR_POS(XOR_BOTTOM) | SE_CRYPTO_INPUT_SEL(INPUT_LNR_CTR) | SE_CRYPTO_CTR_VAL(1);
+	job.ctr = ctr;
+	_se_job_setup(&job);
 
 	u32 src_size_aligned = src_size & 0xFFFFFFF0;
 	u32 src_size_delta = src_size & 0xF;
 
 	if (src_size_aligned)
 	{
-		SE(SE_BLOCK_COUNT_REG_OFFSET) = (src_size >> 4) - 1;
-		if (!_se_execute(OP_START, dst, dst_size, src, src_size_aligned))
+		job.dst = dst;
+		job.dst_size = dst_size;
+		job.src = src;
+		job.src_size = src_size_aligned;
+		if (!_se_job_run(&job))
 			return 0;
 	}
 
 	if (src_size - src_size_aligned && src_size_aligned < dst_size)
-		return _se_execute_one_block(OP_START, dst + src_size_aligned,
+	{
+		u32 start = get_tmr_us();
+		int res = _se_execute_one_block(OP_START, dst + src_size_aligned,
 			MIN(src_size_delta, dst_size - src_size_aligned),
 			src + src_size_aligned, src_size_delta);
+		job.src_size = src_size_delta;
+		_se_job_account(&job, start);
+		return res;
+	}
 
 	return 1;
 }
 
-int se_aes_xts_crypt_sec(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *src, u32 secsize)
+int se_aes_crypt_ctr_start(u32 ks, void *dst, u32 dst_size, const void *src, u32 src_size, void *ctr)
 {
-	int res = 0;
-	u8 *tweak = (u8 *)malloc(0x10);
-	u8 *pdst = (u8 *)dst;
-	u8 *psrc = (u8 *)src;
+	se_job_t job;
 
-	//Generate tweak.
+	if ((src_size & 0xF) || dst_size < src_size)
+	{
+		_se_drain();
+		_se_async.res = se_aes_crypt_ctr(ks, dst, dst_size, src, src_size, ctr);
+		return _se_async.res;
+	}
+
+	_se_job_aes(&job, SE_OP_AES_CTR, ks, 1);
+	job.crypto |= SE_CRYPTO_XOR_POS(XOR_BOTTOM) | SE_CRYPTO_INPUT_SEL(INPUT_LNR_CTR) | SE_CRYPTO_CTR_VAL(1);
+	job.ctr = ctr;
+	job.dst = dst;
+	job.dst_size = dst_size;
+	job.src = src;
+	job.src_size = src_size;
+
+	return se_job_start(&job);
+}
+
+static void _se_job_cbc(se_job_t *job, u32 ks, u32 enc, const void *iv)
+{
+	_se_job_aes(job, SE_OP_AES_CBC, ks, enc);
+	if (enc)
+		job->crypto |= SE_CRYPTO_VCTRAM_SEL(VCTRAM_AESOUT) | SE_CRYPTO_XOR_POS(XOR_TOP);
+	else
+		job->crypto |= SE_CRYPTO_VCTRAM_SEL(VCTRAM_PREVAHB) | SE_CRYPTO_XOR_POS(XOR_BOTTOM);
+	job->crypto |= SE_CRYPTO_IV_SEL(IV_ORIGINAL);
+	job->iv = iv;
+}
+
+int se_aes_crypt_cbc(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size, const void *iv)
+{
+	se_job_t job;
+
+	if (src_size & 0xF)
+		return 0;
+
+	_se_job_cbc(&job, ks, enc, iv);
+	job.dst = dst;
+	job.dst_size = dst_size;
+	job.src = src;
+	job.src_size = src_size;
+
+	return se_job_submit(&job);
+}
+
+int se_aes_crypt_cbc_start(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size, const void *iv)
+{
+	se_job_t job;
+
+	if (src_size & 0xF)
+	{
+		_se_drain();
+		_se_async.res = 0;
+		return 0;
+	}
+
+	_se_job_cbc(&job, ks, enc, iv);
+	job.dst = dst;
+	job.dst_size = dst_size;
+	job.src = src;
+	job.src_size = src_size;
+
+	return se_job_start(&job);
+}
+
+static void _se_xor(void *dst, const void *src1, const void *src2, u32 size)
+{
+	if (!(((u32)dst | (u32)src1 | (u32)src2) & 3))
+	{
+		u32 *pdst = (u32 *)dst;
+		const u32 *psrc1 = (const u32 *)src1;
+		const u32 *psrc2 = (const u32 *)src2;
+		for (u32 i = 0; i < size / 4; i++)
+			pdst[i] = psrc1[i] ^ psrc2[i];
+	}
+	else
+	{
+		u8 *pdst = (u8 *)dst;
+		const u8 *psrc1 = (const u8 *)src1;
+		const u8 *psrc2 = (const u8 *)src2;
+		for (u32 i = 0; i < size; i++)
+			pdst[i] = psrc1[i] ^ psrc2[i];
+	}
+}
+
+static void _se_xts_tweak_set(u8 *tweak, u64 sec)
+{
 	for (int i = 0xF; i >= 0; i--)
 	{
 		tweak[i] = sec & 0xFF;
 		sec >>= 8;
 	}
+}
+
+int se_aes_xts_crypt_sec(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *src, u32 secsize)
+{
+	u8 *tweak = _se_tweak;
+	u8 *pdst = (u8 *)dst;
+	u8 *psrc = (u8 *)src;
+
+	//Generate tweak.
+	_se_xts_tweak_set(tweak, sec);
 	if (!se_aes_crypt_block_ecb(ks1, 1, tweak, tweak))
-		goto out;
+		return 0;
 
 	//We are assuming a 0x10-aligned sector size in this implementation.
 	for (u32 i = 0; i < secsize / 0x10; i++)
@@ -237,7 +622,7 @@ int se_aes_xts_crypt_sec(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *sr
 		for (u32 j = 0; j < 0x10; j++)
 			pdst[j] = psrc[j] ^ tweak[j];
 		if (!se_aes_crypt_block_ecb(ks2, enc, pdst, pdst))
-			goto out;
+			return 0;
 		for (u32 j = 0; j < 0x10; j++)
 			pdst[j] = pdst[j] ^ tweak[j];
 		_gf256_mul_x(tweak);
@@ -245,22 +630,63 @@ int se_aes_xts_crypt_sec(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *sr
 		pdst += 0x10;
 	}
 
-	res = 1;
-
-out:;
-	free(tweak);
-	return res;
+	return 1;
 }
 
+/*
+ * Batched XTS. For each run of sectors that fits in the tweak buffer, the
+ * sector tweaks are encrypted in one ECB operation and expanded into the full
+ * tweak stream. The data is then whitened, crypted as a single multi-block ECB
+ * operation and whitened again.
+ */
 int se_aes_xts_crypt(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *src, u32 secsize, u32 num_secs)
 {
 	u8 *pdst = (u8 *)dst;
 	u8 *psrc = (u8 *)src;
+	u32 run_secs = SE_XTS_RUN_SIZE / secsize;
+
+	if (!run_secs || (secsize & 0xF))
+	{
+		for (u32 i = 0; i < num_secs; i++)
+			if (!se_aes_xts_crypt_sec(ks1, ks2, enc, sec + i, pdst + secsize * i, psrc + secsize * i, secsize))
+				return 0;
+		return 1;
+	}
+
+	while (num_secs)
+	{
+		u32 n = MIN(num_secs, run_secs);
+		u32 size = n * secsize;
 
-	for (u32 i = 0; i < num_secs; i++)
-		if (!se_aes_xts_crypt_sec(ks1, ks2, enc, sec + i, pdst + secsize * i, psrc + secsize * i, secsize))
+		// Sector tweaks, packed at the start of the buffer.
+		for (u32 i = 0; i < n; i++)
+			_se_xts_tweak_set(_se_xts_tweaks + i * 0x10, sec + i);
+		if (!se_aes_crypt_ecb(ks1, 1, _se_xts_tweaks, n * 0x10, _se_xts_tweaks, n * 0x10))
 			return 0;
 
+		// Expand them in place, last sector first so nothing is overwritten before use.
+		for (int i = n - 1; i >= 0; i--)
+		{
+			u8 *tweak = _se_xts_tweaks + i * secsize;
+			memmove(tweak, _se_xts_tweaks + i * 0x10, 0x10);
+			for (u32 j = 0x10; j < secsize; j += 0x10)
+			{
+				memcpy(tweak + j, tweak + j - 0x10, 0x10);
+				_gf256_mul_x(tweak + j);
+			}
+		}
+
+		_se_xor(pdst, psrc, _se_xts_tweaks, size);
+		if (!se_aes_crypt_ecb(ks2, enc, pdst, size, pdst, size))
+			return 0;
+		_se_xor(pdst, pdst, _se_xts_tweaks, size);
+
+		sec += n;
+		psrc += size;
+		pdst += size;
+		num_secs -= n;
+	}
+
 	return 1;
 }
 
@@ -268,8 +694,16 @@ int se_aes_xts_crypt(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *src, u
 int se_calc_sha256(void *dst, const void *src, u32 src_size)
 {
 	int res;
+	se_job_t job;
+
+	memset(&job, 0, sizeof(se_job_t));
+	job.type = SE_OP_SHA256;
+	job.config = SE_CONFIG_ENC_MODE(MODE_SHA256) | SE_CONFIG_ENC_ALG(ALG_SHA) | SE_CONFIG_DST(DST_HASHREG);
+	job.src = src;
+	job.src_size = src_size;
+
 	// Setup config for SHA256, size = BITS(src_size).
-	SE(SE_CONFIG_REG_OFFSET) = SE_CONFIG_ENC_MODE(MODE_SHA256) | SE_CONFIG_ENC_ALG(ALG_SHA) | SE_CONFIG_DST(DST_HASHREG);
+	_se_job_setup(&job);
 	SE(SE_SHA_CONFIG_REG_OFFSET) = 1;
 	SE(SE_SHA_MSG_LENGTH_REG_OFFSET) = (u32)(src_size << 3);
 	SE(0x208) = 0;
@@ -277,11 +711,11 @@ int se_calc_sha256(void *dst, const void *src, u32 src_size)
 	SE(0x210) = 0;
 	SE(SE_SHA_MSG_LEFT_REG_OFFSET) = (u32)(src_size << 3);
 	SE(0x218) = 0;
-   	SE(0x21C) = 0;
+	SE(0x21C) = 0;
 	SE(0x220) = 0;
 
 	// Trigger the operation.
-	res = _se_execute(OP_START, NULL, 0, src, src_size);
+	res = _se_job_run(&job);
 
 	// Copy output hash.
 	u32 *dst32 = (u32 *)dst;
@@ -291,3 +725,133 @@ int se_calc_sha256(void *dst, const void *src, u32 src_size)
 	return res;
 }
 
+/*
+ * Sets up hashing of whole 64-byte blocks, continuing from the context state.
+ * Message length and left are kept one block ahead of the data so the engine
+ * never pads, padding is done by se_sha256_final().
+ */
+static void _se_sha256_setup(se_sha256_ctx_t *ctx, se_job_t *job, const void *src, u32 src_size)
+{
+	u64 bits = ((u64)src_size + 0x40) << 3;
+
+	memset(job, 0, sizeof(se_job_t));
+	job->type = SE_OP_SHA256;
+	job->config = SE_CONFIG_ENC_MODE(MODE_SHA256) | SE_CONFIG_ENC_ALG(ALG_SHA) | SE_CONFIG_DST(DST_HASHREG);
+	job->src = src;
+	job->src_size = src_size;
+
+	_se_job_setup(job);
+	SE(SE_SHA_CONFIG_REG_OFFSET) = ctx->started ? SHA_DISABLE : SHA_ENABLE; // Continue or init hash.
+	SE(SE_SHA_MSG_LENGTH_REG_OFFSET) = (u32)bits;
+	SE(0x208) = (u32)(bits >> 32);
+	SE(0x20C) = 0;
+	SE(0x210) = 0;
+	SE(SE_SHA_MSG_LEFT_REG_OFFSET) = (u32)bits;
+	SE(0x218) = (u32)(bits >> 32);
+	SE(0x21C) = 0;
+	SE(0x220) = 0;
+
+	// Restore the intermediate hash.
+	if (ctx->started)
+		for (u32 i = 0; i < 8; i++)
+			SE(SE_HASH_RESULT_REG_OFFSET + (i << 2)) = ctx->hash[i];
+}
+
+// Saves the intermediate hash for the next call.
+static void _se_sha256_save(se_sha256_ctx_t *ctx)
+{
+	for (u32 i = 0; i < 8; i++)
+		ctx->hash[i] = SE(SE_HASH_RESULT_REG_OFFSET + (i << 2));
+	ctx->started = true;
+}
+
+static int _se_sha256_blocks(se_sha256_ctx_t *ctx, const void *src, u32 src_size)
+{
+	se_job_t job;
+
+	_se_sha256_setup(ctx, &job, src, src_size);
+	int res = _se_job_run(&job);
+	_se_sha256_save(ctx);
+
+	return res;
+}
+
+void se_sha256_init(se_sha256_ctx_t *ctx)
+{
+	memset(ctx, 0, sizeof(se_sha256_ctx_t));
+}
+
+int se_sha256_update(se_sha256_ctx_t *ctx, const void *src, u32 src_size)
+{
+	const u8 *psrc = (const u8 *)src;
+
+	ctx->total += src_size;
+
+	// Top up a previously buffered partial block.
+	if (ctx->buf_len)
+	{
+		u32 n = MIN(src_size, 0x40 - ctx->buf_len);
+		memcpy(ctx->buf + ctx->buf_len, psrc, n);
+		ctx->buf_len += n;
+		psrc += n;
+		src_size -= n;
+		if (ctx->buf_len < 0x40)
+			return 1;
+		if (!_se_sha256_blocks(ctx, ctx->buf, 0x40))
+			return 0;
+		ctx->buf_len = 0;
+	}
+
+	// Whole blocks are hashed straight from the source.
+	u32 size_aligned = src_size & ~0x3F;
+	if (size_aligned && !_se_sha256_blocks(ctx, psrc, size_aligned))
+		return 0;
+
+	ctx->buf_len = src_size - size_aligned;
+	memcpy(ctx->buf, psrc + size_aligned, ctx->buf_len);
+
+	return 1;
+}
+
+int se_sha256_update_start(se_sha256_ctx_t *ctx, const void *src, u32 src_size)
+{
+	se_job_t job;
+
+	if (ctx->buf_len || (src_size & 0x3F))
+	{
+		_se_async.res = se_sha256_update(ctx, src, src_size);
+		return _se_async.res;
+	}
+
+	// Also collects a previous operation on the same context before its state is restored.
+	_se_sha256_setup(ctx, &job, src, src_size);
+	ctx->total += src_size;
+	_se_job_launch(&job, ctx);
+
+	return 1;
+}
+
+int se_sha256_final(se_sha256_ctx_t *ctx, void *dst)
+{
+	u64 bits = ctx->total << 3;
+	u32 len = ctx->buf_len;
+	u8 *pad = _se_sha_pad;
+
+	// Message padding: 0x80, zeroes, then the bit length in big endian.
+	memcpy(pad, ctx->buf, len);
+	pad[len++] = 0x80;
+	u32 pad_size = len > 0x38 ? 0x80 : 0x40;
+	memset(pad + len, 0, pad_size - len);
+	for (u32 i = 0; i < 8; i++)
+		pad[pad_size - 1 - i] = (u8)(bits >> (i << 3));
+
+	int res = _se_sha256_blocks(ctx, pad, pad_size);
+
+	u32 *dst32 = (u32 *)dst;
+	for (u32 i = 0; i < 8; i++)
+		dst32[i] = byte_swap_32(ctx->hash[i]);
+
+	return res;
+}
+
+#endif
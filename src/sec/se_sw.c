@@ -0,0 +1,822 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Software implementation of the se_* API, built instead of se.c when
+ * SE_SW_BACKEND is defined (make SE_BACKEND=sw). It touches no registers so
+ * it also builds on a host. Keyslots, the linear counter and the operation
+ * statistics are emulated so results match the engine bit for bit,
+ * including the CTR tail going through a zero padded block.
+ */
+
+#ifdef SE_SW_BACKEND
+
+#include <string.h>
+
+#include "sec/se.h"
+#include "sec/se_t210.h"
+#include "utils/util.h"
+
+typedef struct _se_sw_key_t
+{
+	u32 ek[60]; // Encryption round keys.
+	u32 dk[60]; // Equivalent inverse cipher round keys.
+	u32 rounds; // 0 when the slot is empty.
+} se_sw_key_t;
+
+static se_sw_key_t _se_sw_keys[TEGRA_SE_KEYSLOT_COUNT];
+static u32 _se_sw_ctr[4]; // Linear counter, kept across operations like the engine does.
+static u32 _se_sw_ivs[TEGRA_SE_KEYSLOT_COUNT][4]; // Original IVs.
+
+#define SE_SW_RSA_WORDS (TEGRA_SE_RSA2048_DIGEST_SIZE / 4)
+
+typedef struct _se_sw_rsa_key_t
+{
+	u32 mod[SE_SW_RSA_WORDS]; // Little endian words.
+	u32 r2[SE_SW_RSA_WORDS];  // R^2 mod n, for entering the Montgomery domain.
+	u32 n0inv;                // -n^-1 mod 2^32.
+	u8  exp[TEGRA_SE_RSA2048_DIGEST_SIZE]; // Big endian.
+	u32 words;
+	u32 exp_size;
+} se_sw_rsa_key_t;
+
+static se_sw_rsa_key_t _se_sw_rsa_keys[TEGRA_SE_RSA_KEYSLOT_COUNT];
+
+static u8 _se_sw_sbox[256];
+static u8 _se_sw_isbox[256];
+static u32 _se_sw_te[256]; // Te0, the other tables are rotations of it.
+static u32 _se_sw_td[256]; // Td0.
+static bool _se_sw_tables_ready;
+
+static se_stats_t _se_stats[SE_OP_TYPE_MAX];
+static int _se_sw_async_res = 1; // Asynchronous operations complete on start.
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define XTIME(x) ((u8)(((x) << 1) ^ (((x) & 0x80) ? 0x1B : 0)))
+
+static u32 _se_sw_load_be(const u8 *p)
+{
+	return ((u32)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void _se_sw_store_be(u8 *p, u32 v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static u8 _se_sw_gmul(u8 a, u8 b)
+{
+	u8 res = 0;
+	while (b)
+	{
+		if (b & 1)
+			res ^= a;
+		a = XTIME(a);
+		b >>= 1;
+	}
+	return res;
+}
+
+// Generated once instead of shipping 2KB of constant tables in the image.
+static void _se_sw_tables_init()
+{
+	u8 p = 1, q = 1;
+
+	if (_se_sw_tables_ready)
+		return;
+
+	// Walk the multiplicative group with generator 3, q tracks the inverse of p.
+	do
+	{
+		p = p ^ XTIME(p);
+		q ^= q << 1;
+		q ^= q << 2;
+		q ^= q << 4;
+		if (q & 0x80)
+			q ^= 0x09;
+		u8 x = q ^ (q << 1 | q >> 7) ^ (q << 2 | q >> 6) ^ (q << 3 | q >> 5) ^ (q << 4 | q >> 4);
+		_se_sw_sbox[p] = x ^ 0x63;
+	} while (p != 1);
+	_se_sw_sbox[0] = 0x63;
+
+	for (u32 i = 0; i < 256; i++)
+	{
+		u8 s = _se_sw_sbox[i];
+		_se_sw_isbox[s] = i;
+		_se_sw_te[i] = ((u32)XTIME(s) << 24) | (s << 16) | (s << 8) | (XTIME(s) ^ s);
+	}
+
+	for (u32 i = 0; i < 256; i++)
+	{
+		u8 s = _se_sw_isbox[i];
+		_se_sw_td[i] = ((u32)_se_sw_gmul(s, 0x0E) << 24) | (_se_sw_gmul(s, 0x09) << 16) |
+			(_se_sw_gmul(s, 0x0D) << 8) | _se_sw_gmul(s, 0x0B);
+	}
+
+	_se_sw_tables_ready = true;
+}
+
+static u32 _se_sw_sub_word(u32 w)
+{
+	return ((u32)_se_sw_sbox[w >> 24] << 24) | (_se_sw_sbox[(w >> 16) & 0xFF] << 16) |
+		(_se_sw_sbox[(w >> 8) & 0xFF] << 8) | _se_sw_sbox[w & 0xFF];
+}
+
+static u32 _se_sw_inv_mix(u32 w)
+{
+	return _se_sw_td[_se_sw_sbox[w >> 24]] ^ ROR32(_se_sw_td[_se_sw_sbox[(w >> 16) & 0xFF]], 8) ^
+		ROR32(_se_sw_td[_se_sw_sbox[(w >> 8) & 0xFF]], 16) ^ ROR32(_se_sw_td[_se_sw_sbox[w & 0xFF]], 24);
+}
+
+static void _se_sw_key_expand(se_sw_key_t *key, const u8 *raw, u32 size)
+{
+	u32 nk = size / 4;
+	u32 total = 4 * (nk + 7);
+	u8 rcon = 1;
+
+	_se_sw_tables_init();
+
+	key->rounds = nk + 6;
+	for (u32 i = 0; i < nk; i++)
+		key->ek[i] = _se_sw_load_be(raw + 4 * i);
+	for (u32 i = nk; i < total; i++)
+	{
+		u32 t = key->ek[i - 1];
+		if (!(i % nk))
+		{
+			t = _se_sw_sub_word((t << 8) | (t >> 24)) ^ ((u32)rcon << 24);
+			rcon = XTIME(rcon);
+		}
+		else if (nk > 6 && i % nk == 4)
+			t = _se_sw_sub_word(t);
+		key->ek[i] = key->ek[i - nk] ^ t;
+	}
+
+	// Decryption uses the round keys in reverse, with InvMixColumns applied to the inner ones.
+	for (u32 r = 0; r <= key->rounds; r++)
+		for (u32 j = 0; j < 4; j++)
+		{
+			u32 w = key->ek[4 * (key->rounds - r) + j];
+			key->dk[4 * r + j] = (r && r != key->rounds) ? _se_sw_inv_mix(w) : w;
+		}
+}
+
+#define TE(i, s) ((i) ? ROR32(_se_sw_te[(s) & 0xFF], 8 * (i)) : _se_sw_te[(s) & 0xFF])
+#define TD(i, s) ((i) ? ROR32(_se_sw_td[(s) & 0xFF], 8 * (i)) : _se_sw_td[(s) & 0xFF])
+
+static void _se_sw_encrypt(const se_sw_key_t *key, u32 *s)
+{
+	const u32 *rk = key->ek;
+	u32 s0 = s[0] ^ rk[0], s1 = s[1] ^ rk[1], s2 = s[2] ^ rk[2], s3 = s[3] ^ rk[3];
+	u32 t0, t1, t2, t3;
+
+	for (u32 r = 1; r < key->rounds; r++)
+	{
+		rk += 4;
+		t0 = TE(0, s0 >> 24) ^ TE(1, s1 >> 16) ^ TE(2, s2 >> 8) ^ TE(3, s3) ^ rk[0];
+		t1 = TE(0, s1 >> 24) ^ TE(1, s2 >> 16) ^ TE(2, s3 >> 8) ^ TE(3, s0) ^ rk[1];
+		t2 = TE(0, s2 >> 24) ^ TE(1, s3 >> 16) ^ TE(2, s0 >> 8) ^ TE(3, s1) ^ rk[2];
+		t3 = TE(0, s3 >> 24) ^ TE(1, s0 >> 16) ^ TE(2, s1 >> 8) ^ TE(3, s2) ^ rk[3];
+		s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+	}
+
+	rk += 4;
+	const u8 *sb = _se_sw_sbox;
+	s[0] = (((u32)sb[s0 >> 24] << 24) | (sb[(s1 >> 16) & 0xFF] << 16) | (sb[(s2 >> 8) & 0xFF] << 8) | sb[s3 & 0xFF]) ^ rk[0];
+	s[1] = (((u32)sb[s1 >> 24] << 24) | (sb[(s2 >> 16) & 0xFF] << 16) | (sb[(s3 >> 8) & 0xFF] << 8) | sb[s0 & 0xFF]) ^ rk[1];
+	s[2] = (((u32)sb[s2 >> 24] << 24) | (sb[(s3 >> 16) & 0xFF] << 16) | (sb[(s0 >> 8) & 0xFF] << 8) | sb[s1 & 0xFF]) ^ rk[2];
+	s[3] = (((u32)sb[s3 >> 24] << 24) | (sb[(s0 >> 16) & 0xFF] << 16) | (sb[(s1 >> 8) & 0xFF] << 8) | sb[s2 & 0xFF]) ^ rk[3];
+}
+
+static void _se_sw_decrypt(const se_sw_key_t *key, u32 *s)
+{
+	const u32 *rk = key->dk;
+	u32 s0 = s[0] ^ rk[0], s1 = s[1] ^ rk[1], s2 = s[2] ^ rk[2], s3 = s[3] ^ rk[3];
+	u32 t0, t1, t2, t3;
+
+	for (u32 r = 1; r < key->rounds; r++)
+	{
+		rk += 4;
+		t0 = TD(0, s0 >> 24) ^ TD(1, s3 >> 16) ^ TD(2, s2 >> 8) ^ TD(3, s1) ^ rk[0];
+		t1 = TD(0, s1 >> 24) ^ TD(1, s0 >> 16) ^ TD(2, s3 >> 8) ^ TD(3, s2) ^ rk[1];
+		t2 = TD(0, s2 >> 24) ^ TD(1, s1 >> 16) ^ TD(2, s0 >> 8) ^ TD(3, s3) ^ rk[2];
+		t3 = TD(0, s3 >> 24) ^ TD(1, s2 >> 16) ^ TD(2, s1 >> 8) ^ TD(3, s0) ^ rk[3];
+		s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+	}
+
+	rk += 4;
+	const u8 *isb = _se_sw_isbox;
+	s[0] = (((u32)isb[s0 >> 24] << 24) | (isb[(s3 >> 16) & 0xFF] << 16) | (isb[(s2 >> 8) & 0xFF] << 8) | isb[s1 & 0xFF]) ^ rk[0];
+	s[1] = (((u32)isb[s1 >> 24] << 24) | (isb[(s0 >> 16) & 0xFF] << 16) | (isb[(s3 >> 8) & 0xFF] << 8) | isb[s2 & 0xFF]) ^ rk[1];
+	s[2] = (((u32)isb[s2 >> 24] << 24) | (isb[(s1 >> 16) & 0xFF] << 16) | (isb[(s0 >> 8) & 0xFF] << 8) | isb[s3 & 0xFF]) ^ rk[2];
+	s[3] = (((u32)isb[s3 >> 24] << 24) | (isb[(s2 >> 16) & 0xFF] << 16) | (isb[(s1 >> 8) & 0xFF] << 8) | isb[s0 & 0xFF]) ^ rk[3];
+}
+
+static void _se_sw_block_load(u32 *s, const u8 *src)
+{
+	for (u32 i = 0; i < 4; i++)
+		s[i] = _se_sw_load_be(src + 4 * i);
+}
+
+static void _se_sw_block_store(u8 *dst, const u32 *s)
+{
+	for (u32 i = 0; i < 4; i++)
+		_se_sw_store_be(dst + 4 * i, s[i]);
+}
+
+static void _se_sw_account(u32 type, u32 size, u32 start)
+{
+	se_stats_t *stats = &_se_stats[type];
+	stats->ops++;
+	stats->bytes += size;
+	stats->time_us += get_tmr_us() - start;
+}
+
+static int _se_sw_ecb(u32 ks, u32 enc, u8 *dst, u32 dst_size, const u8 *src, u32 src_size)
+{
+	const se_sw_key_t *key = &_se_sw_keys[ks];
+	u32 s[4];
+
+	if (ks >= TEGRA_SE_KEYSLOT_COUNT || !key->rounds)
+		return 0;
+
+	for (u32 i = 0; i + 0x10 <= MIN(src_size, dst_size); i += 0x10)
+	{
+		_se_sw_block_load(s, src + i);
+		if (enc)
+			_se_sw_encrypt(key, s);
+		else
+			_se_sw_decrypt(key, s);
+		_se_sw_block_store(dst + i, s);
+	}
+
+	return 1;
+}
+
+/*
+ * Counter mode on the emulated linear counter, 128-bit big endian increment.
+ * Like the engine's zero padded tail block, output stops at the end of the
+ * source or the destination, whichever comes first.
+ */
+static int _se_sw_ctr_crypt(u32 ks, u8 *dst, u32 dst_size, const u8 *src, u32 src_size)
+{
+	const se_sw_key_t *key = &_se_sw_keys[ks];
+	u32 size = MIN(src_size, dst_size);
+	u32 s[4];
+	u8 ks_block[0x10];
+
+	if (ks >= TEGRA_SE_KEYSLOT_COUNT || !key->rounds)
+		return 0;
+
+	for (u32 i = 0; i < size; i += 0x10)
+	{
+		memcpy(s, _se_sw_ctr, 0x10);
+		_se_sw_encrypt(key, s);
+		_se_sw_block_store(ks_block, s);
+		for (u32 j = 0; j < 0x10 && i + j < size; j++)
+			dst[i + j] = src[i + j] ^ ks_block[j];
+
+		for (int j = 3; j >= 0; j--)
+			if (++_se_sw_ctr[j])
+				break;
+	}
+
+	return 1;
+}
+
+static int _se_sw_cbc(u32 ks, u32 enc, u8 *dst, u32 dst_size, const u8 *src, u32 src_size)
+{
+	const se_sw_key_t *key = &_se_sw_keys[ks];
+	u32 s[4], v[4], c[4];
+
+	if (ks >= TEGRA_SE_KEYSLOT_COUNT || !key->rounds || (src_size & 0xF))
+		return 0;
+
+	memcpy(v, _se_sw_ivs[ks], 0x10);
+	for (u32 i = 0; i + 0x10 <= MIN(src_size, dst_size); i += 0x10)
+	{
+		_se_sw_block_load(s, src + i);
+		if (enc)
+		{
+			for (u32 j = 0; j < 4; j++)
+				s[j] ^= v[j];
+			_se_sw_encrypt(key, s);
+			memcpy(v, s, 0x10);
+		}
+		else
+		{
+			// Ciphertext is kept before the block is overwritten in place.
+			memcpy(c, s, 0x10);
+			_se_sw_decrypt(key, s);
+			for (u32 j = 0; j < 4; j++)
+				s[j] ^= v[j];
+			memcpy(v, c, 0x10);
+		}
+		_se_sw_block_store(dst + i, s);
+	}
+
+	return 1;
+}
+
+static void _se_sw_iv_set(u32 ks, const void *iv)
+{
+	if (ks < TEGRA_SE_KEYSLOT_COUNT)
+		_se_sw_block_load(_se_sw_ivs[ks], (const u8 *)iv);
+}
+
+static void _se_sw_ctr_set(const void *ctr)
+{
+	_se_sw_block_load(_se_sw_ctr, (const u8 *)ctr);
+}
+
+static int _se_sw_unwrap(u32 ks_dst, u32 ks_src, const void *input)
+{
+	u8 key[0x10];
+
+	if (!_se_sw_ecb(ks_src, 0, key, 0x10, (const u8 *)input, 0x10))
+		return 0;
+	se_aes_key_set(ks_dst, key, 0x10);
+	memset(key, 0, 0x10);
+
+	return 1;
+}
+
+int se_job_submit(const se_job_t *job)
+{
+	u32 start = get_tmr_us();
+	u32 ks = (job->crypto >> SE_CRYPTO_KEY_INDEX_SHIFT) & 0xF;
+	u32 enc = (job->crypto >> SE_CRYPTO_CORE_SEL_SHIFT) & 1;
+	int res;
+
+	if (((job->config >> SE_CONFIG_ENC_ALG_SHIFT) & 0xF) == ALG_SHA)
+		return 0; // Hashes into the hash registers, use se_calc_sha256() or se_sha256_*().
+	if (((job->config >> SE_CONFIG_ENC_ALG_SHIFT) & 0xF) == ALG_RSA)
+		return 0; // Needs the RSA registers, use se_rsa_exp_mod().
+
+	if (job->ctr)
+		_se_sw_ctr_set(job->ctr);
+	if (job->iv)
+		_se_sw_iv_set(ks, job->iv);
+
+	if (((job->config >> SE_CONFIG_DST_SHIFT) & 7) == DST_KEYTAB)
+		res = _se_sw_unwrap(job->keytab_dst >> SE_KEY_INDEX_SHIFT, ks, job->src);
+	else if (((job->crypto >> SE_CRYPTO_INPUT_SEL_SHIFT) & 3) == INPUT_LNR_CTR)
+		res = _se_sw_ctr_crypt(ks, job->dst, job->dst_size, job->src, job->src_size);
+	else if (((job->crypto >> SE_CRYPTO_VCTRAM_SEL_SHIFT) & 3) == VCTRAM_PREVAHB)
+		res = _se_sw_cbc(ks, 0, job->dst, job->dst_size, job->src, job->src_size);
+	else if (((job->crypto >> SE_CRYPTO_VCTRAM_SEL_SHIFT) & 3) == VCTRAM_AESOUT)
+		res = _se_sw_cbc(ks, 1, job->dst, job->dst_size, job->src, job->src_size);
+	else
+		res = _se_sw_ecb(ks, enc, job->dst, job->dst_size, job->src, job->src_size);
+
+	_se_sw_account(job->type, job->src_size, start);
+	return res;
+}
+
+int se_job_start(const se_job_t *job)
+{
+	_se_sw_async_res = se_job_submit(job);
+	return _se_sw_async_res;
+}
+
+int se_job_poll()
+{
+	return _se_sw_async_res;
+}
+
+int se_job_wait()
+{
+	return _se_sw_async_res;
+}
+
+const se_stats_t *se_get_stats()
+{
+	return _se_stats;
+}
+
+void se_reset_stats()
+{
+	memset(_se_stats, 0, sizeof(_se_stats));
+}
+
+static void _se_sw_bn_load(u32 *dst, const u8 *src, u32 size)
+{
+	for (u32 i = 0; i < size / 4; i++)
+		dst[i] = _se_sw_load_be(src + size - 4 * i - 4);
+}
+
+// a >= b
+static bool _se_sw_bn_ge(const u32 *a, const u32 *b, u32 words)
+{
+	for (int i = words - 1; i >= 0; i--)
+		if (a[i] != b[i])
+			return a[i] > b[i];
+	return true;
+}
+
+static u32 _se_sw_bn_sub(u32 *a, const u32 *b, u32 words)
+{
+	u32 borrow = 0;
+	for (u32 i = 0; i < words; i++)
+	{
+		u64 d = (u64)a[i] - b[i] - borrow;
+		a[i] = (u32)d;
+		borrow = (d >> 32) & 1;
+	}
+	return borrow;
+}
+
+// r = a * b * R^-1 mod n, CIOS Montgomery multiplication. r may alias a or b.
+static void _se_sw_mont_mul(u32 *r, const u32 *a, const u32 *b, const se_sw_rsa_key_t *key)
+{
+	u32 t[SE_SW_RSA_WORDS + 2];
+	u32 n = key->words;
+	const u32 *m = key->mod;
+
+	memset(t, 0, (n + 2) * 4);
+	for (u32 i = 0; i < n; i++)
+	{
+		u64 c = 0;
+		for (u32 j = 0; j < n; j++)
+		{
+			c += (u64)a[j] * b[i] + t[j];
+			t[j] = (u32)c;
+			c >>= 32;
+		}
+		c += t[n];
+		t[n] = (u32)c;
+		t[n + 1] = (u32)(c >> 32);
+
+		u32 q = t[0] * key->n0inv;
+		c = ((u64)q * m[0] + t[0]) >> 32;
+		for (u32 j = 1; j < n; j++)
+		{
+			c += (u64)q * m[j] + t[j];
+			t[j - 1] = (u32)c;
+			c >>= 32;
+		}
+		c += t[n];
+		t[n - 1] = (u32)c;
+		t[n] = t[n + 1] + (u32)(c >> 32);
+	}
+
+	if (t[n] || _se_sw_bn_ge(t, m, n))
+		_se_sw_bn_sub(t, m, n);
+	memcpy(r, t, n * 4);
+}
+
+int se_rsa_key_set(u32 rs, const void *mod, u32 mod_size, const void *exp, u32 exp_size)
+{
+	se_sw_rsa_key_t *key = &_se_sw_rsa_keys[rs];
+
+	if (rs >= TEGRA_SE_RSA_KEYSLOT_COUNT || mod_size > TEGRA_SE_RSA2048_DIGEST_SIZE ||
+		exp_size > mod_size || (mod_size & 0x3F) || (exp_size & 3))
+		return 0;
+
+	key->words = mod_size / 4;
+	key->exp_size = exp_size;
+	_se_sw_bn_load(key->mod, (const u8 *)mod, mod_size);
+	memcpy(key->exp, exp, exp_size);
+
+	// Newton iteration for the inverse of the odd low word.
+	u32 inv = 1;
+	for (u32 i = 0; i < 5; i++)
+		inv *= 2 - key->mod[0] * inv;
+	key->n0inv = -inv;
+
+	// R^2 mod n by doubling 1 up 2 * bits times.
+	memset(key->r2, 0, sizeof(key->r2));
+	key->r2[0] = 1;
+	for (u32 i = 0; i < 64 * key->words; i++)
+	{
+		u32 carry = key->r2[key->words - 1] >> 31;
+		for (u32 j = key->words - 1; j > 0; j--)
+			key->r2[j] = (key->r2[j] << 1) | (key->r2[j - 1] >> 31);
+		key->r2[0] <<= 1;
+		if (carry || _se_sw_bn_ge(key->r2, key->mod, key->words))
+			_se_sw_bn_sub(key->r2, key->mod, key->words);
+	}
+
+	return 1;
+}
+
+void se_rsa_key_clear(u32 rs)
+{
+	if (rs < TEGRA_SE_RSA_KEYSLOT_COUNT)
+		memset(&_se_sw_rsa_keys[rs], 0, sizeof(se_sw_rsa_key_t));
+}
+
+int se_rsa_exp_mod(u32 rs, void *dst, u32 dst_size, const void *src, u32 src_size)
+{
+	u32 start = get_tmr_us();
+	const se_sw_rsa_key_t *key = &_se_sw_rsa_keys[rs];
+	u32 x[SE_SW_RSA_WORDS], acc[SE_SW_RSA_WORDS];
+
+	if (rs >= TEGRA_SE_RSA_KEYSLOT_COUNT || !key->words || src_size != key->words * 4 || dst_size > src_size)
+		return 0;
+
+	// Square and multiply, left to right, in the Montgomery domain.
+	_se_sw_bn_load(x, (const u8 *)src, src_size);
+	_se_sw_mont_mul(x, x, key->r2, key);
+	memset(acc, 0, sizeof(acc));
+	acc[0] = 1;
+	_se_sw_mont_mul(acc, acc, key->r2, key);
+
+	for (u32 i = 0; i < key->exp_size * 8; i++)
+	{
+		_se_sw_mont_mul(acc, acc, acc, key);
+		if (key->exp[i >> 3] & (0x80 >> (i & 7)))
+			_se_sw_mont_mul(acc, acc, x, key);
+	}
+
+	memset(x, 0, sizeof(x));
+	x[0] = 1;
+	_se_sw_mont_mul(acc, acc, x, key);
+
+	u8 *pdst = (u8 *)dst;
+	for (u32 i = 0; i < dst_size; i++)
+		pdst[dst_size - i - 1] = acc[i >> 2] >> ((i & 3) << 3);
+
+	_se_sw_account(SE_OP_RSA, src_size, start);
+	return 1;
+}
+
+// Access control has no meaning without the engine.
+void se_rsa_acc_ctrl(u32 rs, u32 flags) {}
+void se_key_acc_ctrl(u32 ks, u32 flags) {}
+
+void se_aes_key_set(u32 ks, void *key, u32 size)
+{
+	if (ks < TEGRA_SE_KEYSLOT_COUNT && (size == 0x10 || size == 0x18 || size == 0x20))
+		_se_sw_key_expand(&_se_sw_keys[ks], (const u8 *)key, size);
+}
+
+void se_aes_key_clear(u32 ks)
+{
+	if (ks < TEGRA_SE_KEYSLOT_COUNT)
+		memset(&_se_sw_keys[ks], 0, sizeof(se_sw_key_t));
+}
+
+int se_aes_unwrap_key(u32 ks_dst, u32 ks_src, const void *input)
+{
+	u32 start = get_tmr_us();
+	int res = _se_sw_unwrap(ks_dst, ks_src, input);
+	_se_sw_account(SE_OP_AES_UNWRAP, 0x10, start);
+	return res;
+}
+
+int se_aes_crypt_block_ecb(u32 ks, u32 enc, void *dst, const void *src)
+{
+	return se_aes_crypt_ecb(ks, enc, dst, 0x10, src, 0x10);
+}
+
+int se_aes_crypt_ecb(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size)
+{
+	u32 start = get_tmr_us();
+	int res = _se_sw_ecb(ks, enc, dst, dst_size, src, src_size);
+	_se_sw_account(SE_OP_AES_ECB, src_size, start);
+	return res;
+}
+
+int se_aes_crypt_ctr(u32 ks, void *dst, u32 dst_size, const void *src, u32 src_size, void *ctr)
+{
+	u32 start = get_tmr_us();
+	_se_sw_ctr_set(ctr);
+	int res = _se_sw_ctr_crypt(ks, dst, dst_size, src, src_size);
+	_se_sw_account(SE_OP_AES_CTR, src_size, start);
+	return res;
+}
+
+int se_aes_crypt_ctr_start(u32 ks, void *dst, u32 dst_size, const void *src, u32 src_size, void *ctr)
+{
+	_se_sw_async_res = se_aes_crypt_ctr(ks, dst, dst_size, src, src_size, ctr);
+	return _se_sw_async_res;
+}
+
+int se_aes_crypt_cbc(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size, const void *iv)
+{
+	u32 start = get_tmr_us();
+	_se_sw_iv_set(ks, iv);
+	int res = _se_sw_cbc(ks, enc, dst, dst_size, src, src_size);
+	_se_sw_account(SE_OP_AES_CBC, src_size, start);
+	return res;
+}
+
+int se_aes_crypt_cbc_start(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size, const void *iv)
+{
+	_se_sw_async_res = se_aes_crypt_cbc(ks, enc, dst, dst_size, src, src_size, iv);
+	return _se_sw_async_res;
+}
+
+/*
+ * Multiplication by x in GF(2^128). The tweak is a little endian value as in
+ * IEEE 1619, so within the big endian words the bits carry from the low byte
+ * of a word into the byte above it and from word to word upwards.
+ */
+static void _se_sw_xts_mul_x(u32 *t)
+{
+	u32 carry = (t[3] & 0x80) ? 0x87000000 : 0;
+	for (int i = 3; i > 0; i--)
+		t[i] = ((t[i] << 1) & 0xFEFEFEFE) | ((t[i] >> 15) & 0x00010101) | ((t[i - 1] & 0x80) << 17);
+	t[0] = (((t[0] << 1) & 0xFEFEFEFE) | ((t[0] >> 15) & 0x00010101)) ^ carry;
+}
+
+int se_aes_xts_crypt_sec(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *src, u32 secsize)
+{
+	const se_sw_key_t *key = &_se_sw_keys[ks2];
+	u8 *pdst = (u8 *)dst;
+	const u8 *psrc = (const u8 *)src;
+	u32 t[4], s[4];
+
+	if (ks1 >= TEGRA_SE_KEYSLOT_COUNT || ks2 >= TEGRA_SE_KEYSLOT_COUNT ||
+		!_se_sw_keys[ks1].rounds || !key->rounds)
+		return 0;
+
+	t[0] = 0;
+	t[1] = 0;
+	t[2] = sec >> 32;
+	t[3] = (u32)sec;
+	_se_sw_encrypt(&_se_sw_keys[ks1], t);
+
+	for (u32 i = 0; i < secsize / 0x10; i++)
+	{
+		_se_sw_block_load(s, psrc);
+		for (u32 j = 0; j < 4; j++)
+			s[j] ^= t[j];
+		if (enc)
+			_se_sw_encrypt(key, s);
+		else
+			_se_sw_decrypt(key, s);
+		for (u32 j = 0; j < 4; j++)
+			s[j] ^= t[j];
+		_se_sw_block_store(pdst, s);
+
+		_se_sw_xts_mul_x(t);
+		psrc += 0x10;
+		pdst += 0x10;
+	}
+
+	return 1;
+}
+
+int se_aes_xts_crypt(u32 ks1, u32 ks2, u32 enc, u64 sec, void *dst, void *src, u32 secsize, u32 num_secs)
+{
+	u32 start = get_tmr_us();
+	u8 *pdst = (u8 *)dst;
+	u8 *psrc = (u8 *)src;
+	int res = 1;
+
+	for (u32 i = 0; i < num_secs && res; i++)
+		res = se_aes_xts_crypt_sec(ks1, ks2, enc, sec + i, pdst + secsize * i, psrc + secsize * i, secsize);
+
+	_se_sw_account(SE_OP_AES_ECB, secsize * num_secs, start);
+	return res;
+}
+
+static const u32 _se_sw_sha256_k[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static const u32 _se_sw_sha256_iv[8] = {
+	0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+// Hashes whole 64-byte blocks. The message schedule is kept as a rolling 16 word window.
+static void _se_sw_sha256_blocks(u32 *h, const u8 *src, u32 src_size)
+{
+	u32 w[16];
+
+	for (u32 off = 0; off < src_size; off += 0x40)
+	{
+		u32 a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+
+		for (u32 i = 0; i < 64; i++)
+		{
+			if (i < 16)
+				w[i] = _se_sw_load_be(src + off + 4 * i);
+			else
+			{
+				u32 w15 = w[(i - 15) & 0xF], w2 = w[(i - 2) & 0xF];
+				w[i & 0xF] += (ROR32(w15, 7) ^ ROR32(w15, 18) ^ (w15 >> 3)) + w[(i - 7) & 0xF] +
+					(ROR32(w2, 17) ^ ROR32(w2, 19) ^ (w2 >> 10));
+			}
+
+			u32 t1 = k + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) + ((e & f) ^ (~e & g)) +
+				_se_sw_sha256_k[i] + w[i & 0xF];
+			u32 t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+			k = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+		h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+	}
+}
+
+int se_calc_sha256(void *dst, const void *src, u32 src_size)
+{
+	se_sha256_ctx_t ctx;
+
+	se_sha256_init(&ctx);
+	se_sha256_update(&ctx, src, src_size);
+	return se_sha256_final(&ctx, dst);
+}
+
+void se_sha256_init(se_sha256_ctx_t *ctx)
+{
+	memset(ctx, 0, sizeof(se_sha256_ctx_t));
+	memcpy(ctx->hash, _se_sw_sha256_iv, sizeof(ctx->hash));
+	ctx->started = true;
+}
+
+int se_sha256_update(se_sha256_ctx_t *ctx, const void *src, u32 src_size)
+{
+	u32 start = get_tmr_us();
+	const u8 *psrc = (const u8 *)src;
+	u32 size = src_size;
+
+	ctx->total += size;
+
+	if (ctx->buf_len)
+	{
+		u32 n = MIN(size, 0x40 - ctx->buf_len);
+		memcpy(ctx->buf + ctx->buf_len, psrc, n);
+		ctx->buf_len += n;
+		psrc += n;
+		size -= n;
+		if (ctx->buf_len == 0x40)
+		{
+			_se_sw_sha256_blocks(ctx->hash, ctx->buf, 0x40);
+			ctx->buf_len = 0;
+		}
+	}
+
+	if (size >= 0x40 || !ctx->buf_len)
+	{
+		u32 size_aligned = size & ~0x3F;
+		_se_sw_sha256_blocks(ctx->hash, psrc, size_aligned);
+		ctx->buf_len = size - size_aligned;
+		memcpy(ctx->buf, psrc + size_aligned, ctx->buf_len);
+	}
+
+	_se_sw_account(SE_OP_SHA256, src_size, start);
+	return 1;
+}
+
+int se_sha256_update_start(se_sha256_ctx_t *ctx, const void *src, u32 src_size)
+{
+	_se_sw_async_res = se_sha256_update(ctx, src, src_size);
+	return _se_sw_async_res;
+}
+
+int se_sha256_final(se_sha256_ctx_t *ctx, void *dst)
+{
+	u8 pad[0x80];
+	u64 bits = ctx->total << 3;
+	u32 len = ctx->buf_len;
+
+	memcpy(pad, ctx->buf, len);
+	pad[len++] = 0x80;
+	u32 pad_size = len > 0x38 ? 0x80 : 0x40;
+	memset(pad + len, 0, pad_size - len);
+	_se_sw_store_be(pad + pad_size - 8, bits >> 32);
+	_se_sw_store_be(pad + pad_size - 4, (u32)bits);
+
+	_se_sw_sha256_blocks(ctx->hash, pad, pad_size);
+
+	for (u32 i = 0; i < 8; i++)
+		_se_sw_store_be((u8 *)dst + 4 * i, ctx->hash[i]);
+
+	return 1;
+}
+
+#endif
@@ -34,6 +34,11 @@ _start:
 	CMP R0, R1
 	BEQ _real_start
 
+	/* Packed images decompress themselves to the right place instead. */
+	LDR R2, _pack_size
+	CMP R2, #0
+	BNE _unpack
+
 	/* If we are not in the right location already, copy a relocator to upper IRAM. */
 	ADR R2, _reloc_ipl
 	LDR R3, =0x4003FF00
@@ -70,6 +75,90 @@ _real_start:
 	BL ipl_main
 	B .
 
+_unpack:
+	/* The compressed IPL follows the header at the end of this file. */
+	ADR R4, _pack_end
+	ADD R5, R4, R2
+	/* Like in a plain image, the payload number sits 4 bytes past the end. */
+	LDRB R8, [R5, #4]
+
+	/* Move the compressed IPL to the top of IRAM, backwards as it may overlap. */
+	ADD R5, R5, #3
+	BIC R5, R5, #3
+	LDR R6, =0x4003FF00
+_unpack_move:
+	LDR R7, [R5, #-4]!
+	STR R7, [R6, #-4]!
+	CMP R5, R4
+	BHI _unpack_move
+
+	/* The unpacker takes the relocator's place in upper IRAM. */
+	ADR R2, _unpack_lz4
+	LDR R3, =0x4003FF00
+	MOV R4, #(_unpack_end - _unpack_lz4)
+_unpack_copy:
+	LDMIA R2!, {R5}
+	STMIA R3!, {R5}
+	SUBS R4, #4
+	BGE _unpack_copy
+
+	LDR R2, _pack_size
+	MOV R0, R6
+	ADD R2, R0, R2
+	LDR R1, =__ipl_start
+	LDR R3, =_real_start
+	LDR R9, =__payload_num
+	LDR R4, =0x4003FF00
+	BX R4
+
+/* LZ4 block decoder, R0 = src, R1 = dst, R2 = src end, R3 = entry once done. */
+_unpack_lz4:
+	CMP R0, R2
+	BHS _unpack_done
+	LDRB R4, [R0], #1
+	MOVS R5, R4, LSR #4
+	BEQ _unpack_match
+	CMP R5, #15
+	BNE _unpack_lit
+_unpack_lit_len:
+	LDRB R6, [R0], #1
+	ADD R5, R5, R6
+	CMP R6, #255
+	BEQ _unpack_lit_len
+_unpack_lit:
+	LDRB R6, [R0], #1
+	STRB R6, [R1], #1
+	SUBS R5, R5, #1
+	BNE _unpack_lit
+_unpack_match:
+	/* The last sequence is literals only. */
+	CMP R0, R2
+	BHS _unpack_done
+	LDRB R6, [R0], #1
+	LDRB R7, [R0], #1
+	ORR R6, R6, R7, LSL #8
+	SUB R6, R1, R6
+	AND R5, R4, #15
+	CMP R5, #15
+	BNE _unpack_match_copy
+_unpack_match_len:
+	LDRB R7, [R0], #1
+	ADD R5, R5, R7
+	CMP R7, #255
+	BEQ _unpack_match_len
+_unpack_match_copy:
+	ADD R5, R5, #4
+_unpack_match_loop:
+	LDRB R7, [R6], #1
+	STRB R7, [R1], #1
+	SUBS R5, R5, #1
+	BNE _unpack_match_loop
+	B _unpack_lz4
+_unpack_done:
+	STRB R8, [R9]
+	BX R3
+_unpack_end:
+
 .globl pivot_stack
 .type pivot_stack, %function
 pivot_stack:
@@ -85,4 +174,13 @@ get_payload_num:
   LDRB R0, [R0]
   BX LR
 
-.pool
\ No newline at end of file
+.pool
+
+/* Filled in by tools/pack_ipl.py, a packed size of 0 is a plain image. */
+.align 2
+_pack_hdr:
+	.word 0x4B504244 /* "DBPK" */
+	.word 0          /* Unpacked size. */
+_pack_size:
+	.word 0
+_pack_end:
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "utils/diriter.h"
+#include "mem/heap.h"
+
+int dir_iter_open(dir_iter_t *it, const char *path, const char *pattern, dir_filter_t filter, void *arg)
+{
+	int res;
+
+	it->pattern = pattern;
+	it->filter = filter;
+	it->arg = arg;
+	it->primed = pattern != NULL;
+
+	if (pattern)
+		res = f_findfirst(&it->dir, &it->fno, path, pattern);
+	else
+		res = f_opendir(&it->dir, path);
+
+	it->open = res == FR_OK;
+	return res;
+}
+
+const dir_entry_t *dir_iter_next(dir_iter_t *it)
+{
+	while (it->open)
+	{
+		int res = FR_OK;
+		if (it->primed)
+			it->primed = false;
+		else if (it->pattern)
+			res = f_findnext(&it->dir, &it->fno);
+		else
+			res = f_readdir(&it->dir, &it->fno);
+
+		if (res || !it->fno.fname[0])
+			break;
+
+		it->ent.name = it->fno.fname;
+		it->ent.size = it->fno.fsize;
+		it->ent.sclust = it->fno.fclust;
+		it->ent.attr = it->fno.fattrib;
+
+		if (!it->filter || it->filter(&it->ent, it->arg))
+			return &it->ent;
+	}
+
+	dir_iter_close(it);
+	return NULL;
+}
+
+void dir_iter_close(dir_iter_t *it)
+{
+	if (it->open)
+	{
+		f_closedir(&it->dir);
+		it->open = false;
+	}
+}
+
+static void _dir_ent_swap(dir_entry_t *a, dir_entry_t *b)
+{
+	dir_entry_t tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+static void _dir_heap_down(dir_entry_t *heap, u32 n, u32 i, dir_cmp_t cmp)
+{
+	while (1)
+	{
+		u32 l = 2 * i + 1;
+		u32 m = i;
+		if (l < n && cmp(&heap[l], &heap[m]) > 0)
+			m = l;
+		if (l + 1 < n && cmp(&heap[l + 1], &heap[m]) > 0)
+			m = l + 1;
+		if (m == i)
+			break;
+		_dir_ent_swap(&heap[i], &heap[m]);
+		i = m;
+	}
+}
+
+static void _dir_heap_up(dir_entry_t *heap, u32 i, dir_cmp_t cmp)
+{
+	while (i)
+	{
+		u32 p = (i - 1) / 2;
+		if (cmp(&heap[i], &heap[p]) <= 0)
+			break;
+		_dir_ent_swap(&heap[i], &heap[p]);
+		i = p;
+	}
+}
+
+u32 dir_iter_sorted(dir_iter_t *it, dir_cmp_t cmp, u32 k, dir_entry_t **out)
+{
+	const dir_entry_t *ent;
+	u32 n = 0;
+
+	*out = NULL;
+	if (!k)
+	{
+		dir_iter_close(it);
+		return 0;
+	}
+
+	// Max-heap of the k smallest entries so far. Names live in fixed slots after it.
+	dir_entry_t *heap = (dir_entry_t *)malloc(k * (sizeof(dir_entry_t) + DIR_NAME_MAX));
+	char *names = (char *)(heap + k);
+
+	while ((ent = dir_iter_next(it)))
+	{
+		dir_entry_t *slot;
+		if (n < k)
+		{
+			slot = &heap[n];
+			slot->name = names + n * DIR_NAME_MAX;
+		}
+		else if (cmp(ent, &heap[0]) < 0)
+			slot = &heap[0];
+		else
+			continue;
+
+		char *name = (char *)slot->name;
+		strcpy(name, ent->name);
+		*slot = *ent;
+		slot->name = name;
+
+		if (n < k)
+			_dir_heap_up(heap, n++, cmp);
+		else
+			_dir_heap_down(heap, n, 0, cmp);
+	}
+
+	// Heapsort in place, largest goes last.
+	for (u32 i = n; i > 1; i--)
+	{
+		_dir_ent_swap(&heap[0], &heap[i - 1]);
+		_dir_heap_down(heap, i - 1, 0, cmp);
+	}
+
+	*out = heap;
+	return n;
+}
+
+bool dir_filter_files(const dir_entry_t *ent, void *include_hidden)
+{
+	return !(ent->attr & AM_DIR) && ent->name[0] != '.' && (include_hidden || !(ent->attr & AM_HID));
+}
+
+int dir_cmp_name(const dir_entry_t *a, const dir_entry_t *b)
+{
+	const u8 *pa = (const u8 *)a->name;
+	const u8 *pb = (const u8 *)b->name;
+
+	while (1)
+	{
+		u32 ca = (*pa >= 'A' && *pa <= 'Z') ? *pa + 32 : *pa;
+		u32 cb = (*pb >= 'A' && *pb <= 'Z') ? *pb + 32 : *pb;
+		if (ca != cb || !ca)
+			return ca - cb;
+		pa++;
+		pb++;
+	}
+}
@@ -18,96 +18,30 @@
 
 #include "libs/fatfs/ff.h"
 #include "mem/heap.h"
+#include "utils/diriter.h"
 #include "utils/types.h"
 
 char *dirlist(const char *directory, const char *pattern, bool includeHiddenFiles)
 {
-	u8 max_entries = 61;
+	u32 max_entries = 61;
+	dir_iter_t it;
+	dir_entry_t *entries;
 
-	int res = 0;
-	u32 i = 0, j = 0, k = 0;
-	DIR dir;
-	static FILINFO fno;
-	
-	char *dir_entries = (char *)calloc(max_entries, 256);
-	char *copy_entries = (char *)calloc(max_entries, 256);
-	char *temp = (char *)calloc(1, 256);
-
-	if (!pattern && !f_opendir(&dir, directory))
-	{
-		for (;;)
-		{
-			res = f_readdir(&dir, &fno);
-			if (res || !fno.fname[0])
-				break;
-			if (!(fno.fattrib & AM_DIR) && (fno.fname[0] != '.') && (includeHiddenFiles || !(fno.fattrib & AM_HID)))
-			{
-				memcpy(dir_entries + (k * 256), fno.fname, strlen(fno.fname) + 1);
-				k++;
-				if (k > (max_entries - 1))
-					break;
-			}
-		}
-		f_closedir(&dir);
-	}
-	else if (pattern && !f_findfirst(&dir, &fno, directory, pattern) && fno.fname[0])
-	{
-		do
-		{
-			if (!(fno.fattrib & AM_DIR) && (fno.fname[0] != '.') && (includeHiddenFiles || !(fno.fattrib & AM_HID)))
-			{
-				memcpy(dir_entries + (k * 256), fno.fname, strlen(fno.fname) + 1);
-				k++;
-				if (k > (max_entries - 1))
-					break;
-			}
-			res = f_findnext(&dir, &fno);
-		} while (fno.fname[0] && !res);
-		f_closedir(&dir);
-	}
+	if (dir_iter_open(&it, directory, pattern, dir_filter_files, (void *)includeHiddenFiles))
+		return NULL;
 
+	// Keep the first entries in case-insensitive order, the rest of the directory is streamed past.
+	u32 k = dir_iter_sorted(&it, dir_cmp_name, max_entries, &entries);
 	if (!k)
 	{
-		free(temp);
-		free(dir_entries);
-		free(copy_entries);
-
+		free(entries);
 		return NULL;
 	}
 
-	// make copy_entries lowercase version of dir_entries
-	for(i = 0; i < k; i++) 
-	{
-		j = i * 256;
-		while(dir_entries[j]) 
-		{
-			copy_entries[j] = dir_entries[j];
-
-			if(dir_entries[j] >= 'A' && dir_entries[j] <= 'Z')
-				copy_entries[j] += 32;
-			
-			j++;
-		}
-		
-		copy_entries[j] = '\0';
-	}
-
-	// compare copy_entries but sort dir_entries
-	for (i = 0; i < k - 1 ; i++)
-	{
-		for (j = i + 1; j < k; j++)
-		{
-			if (strcmp(&copy_entries[i * 256], &copy_entries[j * 256]) > 0) 
-			{
-				memcpy(temp, &dir_entries[i * 256], strlen(&dir_entries[i * 256]) + 1);
-				memcpy(&dir_entries[i * 256], &dir_entries[j * 256], strlen(&dir_entries[j * 256]) + 1);
-				memcpy(&dir_entries[j * 256], temp, strlen(temp) + 1);
-			}
-		}
-	}
-
-	free(temp);
-	free(copy_entries);
+	char *dir_entries = (char *)calloc(max_entries, 256);
+	for (u32 i = 0; i < k; i++)
+		strcpy(dir_entries + (i * 256), entries[i].name);
 
+	free(entries);
 	return dir_entries;
 }
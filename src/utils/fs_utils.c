@@ -20,8 +20,27 @@
 
 #include "mem/heap.h"
 #include "gfx/gfx.h"
+#include "sec/se.h"
 #include <string.h>
 
+static bool _sd_fatfs_loaded;
+static bool _sd_fatfs_attached;
+
+static int _sd_fatfs_attach(u8 opt)
+{
+	int res = f_mount(&g_sd_fs, "", opt);
+	_sd_fatfs_attached = res == FR_OK;
+	return res;
+}
+
+// Runs once the FatFs overlay is loaded, see core/overlay.h.
+void fatfs_ovl_init()
+{
+	_sd_fatfs_loaded = true;
+	if (g_sd_mounted)
+		_sd_fatfs_attach(0);
+}
+
 bool sd_mount()
 {
 	if (g_sd_mounted)
@@ -29,8 +48,13 @@ bool sd_mount()
 
 	if (sdmmc_storage_init_sd(&g_sd_storage, &g_sd_sdmmc, SDMMC_1, SDMMC_BUS_WIDTH_4, 11))
 	{
-		int res = 0;
-		res = f_mount(&g_sd_fs, "", 1);
+		// When the read-only fast path can handle the volume, FatFs is left
+		// in its overlay and only attached by fatfs_ovl_init() on first use.
+		int res;
+		if (ffro_mount(&g_sd_ffro) == FR_OK)
+			res = _sd_fatfs_loaded ? _sd_fatfs_attach(0) : FR_OK;
+		else
+			res = _sd_fatfs_attach(1);
 		if (res == FR_OK)
 		{
 			g_sd_mounted = 1;
@@ -45,7 +69,12 @@ void sd_unmount()
 {
 	if (g_sd_mounted)
 	{
-		f_mount(NULL, "", 1);
+		if (_sd_fatfs_attached)
+		{
+			f_mount(NULL, "", 1);
+			_sd_fatfs_attached = false;
+		}
+		g_sd_ffro.fs_type = 0;
 		sdmmc_storage_end(&g_sd_storage);
 		g_sd_mounted = false;
 	}
@@ -86,6 +115,109 @@ void *sd_file_read(char *path, void *ext_buf)
 	return buf;
 }
 
+/*
+ * Pipelined read. Starts the SE on each chunk, then reads the next one while
+ * the engine works, so SE and SDMMC DMA run at the same time. Chunks either
+ * follow each other in buf or, with ring set, alternate between two halves.
+ */
+int sd_read_pipelined(FIL *fp, void *buf, bool ring, u32 size, sd_pipe_op_t op, void *arg)
+{
+	u8 *pbuf = (u8 *)buf;
+	u8 *chunk = pbuf;
+	u32 offset = 0;
+	// Ending the first chunk on a sector of the file lets FatFs read the
+	// others straight into buf. Chunks stay whole SHA and AES blocks.
+	u32 chunk_size = MIN(size, SD_PIPE_CHUNK - (f_tell(fp) & 0x1C0));
+
+	if (f_read(fp, chunk, chunk_size, NULL) != FR_OK)
+		return 0;
+
+	while (chunk_size)
+	{
+		if (!op(chunk, chunk_size, offset, arg))
+		{
+			se_job_wait();
+			return 0;
+		}
+
+		u8 *next = ring ? pbuf + (chunk == pbuf ? SD_PIPE_CHUNK : 0) : chunk + chunk_size;
+		u32 left = size - offset - chunk_size;
+		u32 next_size = MIN(left, SD_PIPE_CHUNK);
+		// Nothing hides the SE time of the last chunk, so a short one is split off.
+		if (left > SD_PIPE_TAIL * 2 && left <= SD_PIPE_CHUNK + SD_PIPE_TAIL)
+			next_size = (left - SD_PIPE_TAIL) & ~0x1FF;
+		int res = next_size ? f_read(fp, next, next_size, NULL) : FR_OK;
+
+		if (se_job_wait() != 1 || res != FR_OK)
+			return 0;
+
+		offset += chunk_size;
+		chunk = next;
+		chunk_size = next_size;
+	}
+
+	return 1;
+}
+
+int sd_pipe_ctr(void *chunk, u32 size, u32 offset, void *arg)
+{
+	sd_pipe_aes_t *aes = (sd_pipe_aes_t *)arg;
+	u8 ctr[0x10];
+	u32 carry = offset >> 4;
+
+	// Counter of the chunk, 128-bit big endian add.
+	for (int i = 0xF; i >= 0; i--)
+	{
+		carry += aes->iv[i];
+		ctr[i] = carry & 0xFF;
+		carry >>= 8;
+	}
+
+	return se_aes_crypt_ctr_start(aes->ks, chunk, size, chunk, size, ctr);
+}
+
+int sd_pipe_cbc_dec(void *chunk, u32 size, u32 offset, void *arg)
+{
+	sd_pipe_aes_t *aes = (sd_pipe_aes_t *)arg;
+	u8 iv[0x10];
+
+	if (size < 0x10)
+		return 0;
+
+	// The last ciphertext block chains into the next chunk, keep it before it's decrypted in place.
+	memcpy(iv, aes->iv, 0x10);
+	memcpy(aes->iv, (u8 *)chunk + size - 0x10, 0x10);
+
+	return se_aes_crypt_cbc_start(aes->ks, 0, chunk, size, chunk, size, iv);
+}
+
+static int _sd_pipe_sha256(void *chunk, u32 size, u32 offset, void *arg)
+{
+	return se_sha256_update_start((se_sha256_ctx_t *)arg, chunk, size);
+}
+
+int sd_file_sha256(const char *path, void *hash, void *buf)
+{
+	FIL fp;
+	se_sha256_ctx_t ctx;
+	int res = 0;
+
+	if (f_open(&fp, path, FA_READ) != FR_OK)
+		return 0;
+
+	u8 *pbuf = buf ? (u8 *)buf : (u8 *)malloc(SD_PIPE_CHUNK * 2);
+
+	se_sha256_init(&ctx);
+	res = sd_read_pipelined(&fp, pbuf, true, f_size(&fp), _sd_pipe_sha256, &ctx);
+	if (res)
+		res = se_sha256_final(&ctx, hash);
+
+	if (!buf)
+		free(pbuf);
+	f_close(&fp);
+	return res;
+}
+
 int sd_save_to_file(void *buf, u32 size, const char *filename)
 {
 	FIL fp;
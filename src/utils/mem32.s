@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2018 DragonInjector Project
+*
+* This program is free software; you can redistribute it and/or modify it
+* under the terms and conditions of the GNU General Public License,
+* version 2, as published by the Free Software Foundation.
+*
+* This program is distributed in the hope it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+* Word fill and copy for framebuffers. Buffers are word aligned and len is a
+* multiple of 4. Single words are written up to a 32 byte boundary, then
+* whole 32 byte blocks with 8 register STMs.
+*/
+
+.section .text.memset32
+.arm
+
+/* void memset32(u32 *dst, u32 val, u32 len) */
+.globl memset32
+.type memset32, %function
+memset32:
+	STMFD SP!, {R4-R8}
+	MOVS R2, R2, LSR #2
+	BEQ _memset32_done
+_memset32_head:
+	TST R0, #0x1F
+	BEQ _memset32_body
+	STR R1, [R0], #4
+	SUBS R2, R2, #1
+	BNE _memset32_head
+	B _memset32_done
+_memset32_body:
+	MOV R3, R1
+	MOV R4, R1
+	MOV R5, R1
+	MOV R6, R1
+	MOV R7, R1
+	MOV R8, R1
+	MOV R12, R1
+	SUBS R2, R2, #8
+	BLT _memset32_tail
+_memset32_loop:
+	STMIA R0!, {R1, R3-R8, R12}
+	SUBS R2, R2, #8
+	BGE _memset32_loop
+_memset32_tail:
+	ADDS R2, R2, #8
+	BEQ _memset32_done
+_memset32_word:
+	STR R1, [R0], #4
+	SUBS R2, R2, #1
+	BNE _memset32_word
+_memset32_done:
+	LDMFD SP!, {R4-R8}
+	BX LR
+
+.section .text.memcpy32
+.arm
+
+/* void memcpy32(u32 *dst, const u32 *src, u32 len), the buffers don't overlap. */
+.globl memcpy32
+.type memcpy32, %function
+memcpy32:
+	STMFD SP!, {R4-R10}
+	MOVS R2, R2, LSR #2
+	BEQ _memcpy32_done
+_memcpy32_head:
+	TST R0, #0x1F
+	BEQ _memcpy32_body
+	LDR R3, [R1], #4
+	STR R3, [R0], #4
+	SUBS R2, R2, #1
+	BNE _memcpy32_head
+	B _memcpy32_done
+_memcpy32_body:
+	SUBS R2, R2, #8
+	BLT _memcpy32_tail
+_memcpy32_loop:
+	LDMIA R1!, {R3-R10}
+	STMIA R0!, {R3-R10}
+	SUBS R2, R2, #8
+	BGE _memcpy32_loop
+_memcpy32_tail:
+	ADDS R2, R2, #8
+	BEQ _memcpy32_done
+_memcpy32_word:
+	LDR R3, [R1], #4
+	STR R3, [R0], #4
+	SUBS R2, R2, #1
+	BNE _memcpy32_word
+_memcpy32_done:
+	LDMFD SP!, {R4-R10}
+	BX LR
@@ -0,0 +1,639 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "arm_model.h"
+#include "host.h"
+
+#define STACK_SIZE 0x1000
+#define RET_ADDR 0xFFFFFFFC
+
+enum
+{
+	OP_MOV,
+	OP_ADD,
+	OP_SUB,
+	OP_CMP,
+	OP_TST,
+	OP_LDR,
+	OP_STR,
+	OP_LDMIA,
+	OP_STMIA,
+	OP_STMDB,
+	OP_B,
+	OP_BX,
+};
+
+// Longer names first, so B does not take BX.
+static const struct
+{
+	const char *name;
+	u8 op;
+} ops[] = {
+	{ "STMFD", OP_STMDB }, { "STMDB", OP_STMDB }, { "STMIA", OP_STMIA }, { "STMEA", OP_STMIA },
+	{ "LDMFD", OP_LDMIA }, { "LDMIA", OP_LDMIA },
+	{ "MOV", OP_MOV }, { "ADD", OP_ADD }, { "SUB", OP_SUB }, { "CMP", OP_CMP }, { "TST", OP_TST },
+	{ "LDR", OP_LDR }, { "STR", OP_STR }, { "BX", OP_BX }, { "B", OP_B },
+};
+
+static const char *conds[] = { "EQ", "NE", "CS", "CC", "MI", "PL", "VS", "VC", "HI", "LS", "GE", "LT", "GT", "LE", "AL" };
+#define COND_AL 14
+
+// Strips comments, keeps the line breaks.
+static char *_strip(const char *src)
+{
+	char *out = malloc(strlen(src) + 1), *p = out;
+
+	while (*src)
+	{
+		if (src[0] == '/' && src[1] == '*')
+		{
+			for (src += 2; *src && !(src[0] == '*' && src[1] == '/'); src++)
+				if (*src == '\n')
+					*p++ = '\n';
+			src += *src ? 2 : 0;
+		}
+		else if (*src == '@' || (src[0] == '/' && src[1] == '/'))
+		{
+			while (*src && *src != '\n')
+				src++;
+		}
+		else
+			*p++ = *src++;
+	}
+	*p = 0;
+
+	return out;
+}
+
+static char *_trim(char *s)
+{
+	while (isspace((unsigned char)*s))
+		s++;
+	char *e = s + strlen(s);
+	while (e > s && isspace((unsigned char)e[-1]))
+		*--e = 0;
+
+	return s;
+}
+
+static int _reg(const char *s)
+{
+	if (!strcasecmp(s, "SP"))
+		return 13;
+	if (!strcasecmp(s, "LR"))
+		return 14;
+	if (!strcasecmp(s, "PC"))
+		return 15;
+	if (toupper((unsigned char)s[0]) != 'R' || !isdigit((unsigned char)s[1]))
+		return -1;
+
+	char *end;
+	long r = strtol(s + 1, &end, 10);
+	return *end || r > 15 ? -1 : (int)r;
+}
+
+static int _imm(const char *s, u32 *val)
+{
+	char *end;
+
+	if (*s != '#')
+		return 0;
+	*val = strtoul(s + 1, &end, 0);
+
+	return !*end;
+}
+
+// Splits at commas outside of brackets and braces.
+static u32 _split(char *s, char **args, u32 max)
+{
+	u32 n = 0, depth = 0;
+
+	if (!*s)
+		return 0;
+	args[n++] = s;
+	for (; *s; s++)
+	{
+		if (*s == '[' || *s == '{')
+			depth++;
+		else if (*s == ']' || *s == '}')
+			depth--;
+		else if (*s == ',' && !depth)
+		{
+			*s = 0;
+			if (n == max)
+				return max + 1;
+			args[n++] = s + 1;
+		}
+	}
+	for (u32 i = 0; i < n; i++)
+		args[i] = _trim(args[i]);
+
+	return n;
+}
+
+// "Rm" or "Rm, LSR #n" in args[0..1].
+static int _operand2(arm_insn_t *in, char **args, u32 n)
+{
+	static const char *shifts[] = { "LSL", "LSR", "ASR" };
+
+	if (n == 1 && _imm(args[0], &in->val))
+	{
+		in->imm = true;
+		return 1;
+	}
+	if (n < 1 || n > 2)
+		return 0;
+
+	int rm = _reg(args[0]);
+	if (rm < 0)
+		return 0;
+	in->rm = rm;
+	if (n == 1)
+		return 1;
+
+	for (u32 i = 0; i < 3; i++)
+	{
+		u32 amount;
+		if (!strncasecmp(args[1], shifts[i], 3) && _imm(_trim(args[1] + 3), &amount) && amount && amount < 32)
+		{
+			in->shift = i;
+			in->shift_imm = amount;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int _reglist(const char *s, u32 *list)
+{
+	char buf[128], *args[16];
+
+	if (*s != '{' || s[strlen(s) - 1] != '}' || strlen(s) >= sizeof(buf))
+		return 0;
+	strcpy(buf, s + 1);
+	buf[strlen(buf) - 1] = 0;
+
+	*list = 0;
+	u32 n = _split(buf, args, 16);
+	if (!n || n > 16)
+		return 0;
+	for (u32 i = 0; i < n; i++)
+	{
+		char *dash = strchr(args[i], '-');
+		if (dash)
+			*dash = 0;
+		int lo = _reg(_trim(args[i])), hi = dash ? _reg(_trim(dash + 1)) : lo;
+		if (lo < 0 || hi < lo)
+			return 0;
+		for (int r = lo; r <= hi; r++)
+			*list |= 1u << r;
+	}
+
+	return 1;
+}
+
+static int _label(arm_model_t *m, const char *name)
+{
+	for (u32 i = 0; i < m->num_labels; i++)
+		if (!strcmp(m->labels[i].name, name))
+			return i;
+
+	return -1;
+}
+
+static int _parse(arm_model_t *m, arm_insn_t *in, char *text)
+{
+	char *args[5];
+	char *mn = text, *rest = text;
+	u32 i, len = 0, n;
+
+	while (*rest && !isspace((unsigned char)*rest))
+		rest++;
+	if (*rest)
+		*rest++ = 0;
+	n = _split(_trim(rest), args, 4);
+	if (n > 4)
+		return 0;
+
+	for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+	{
+		len = strlen(ops[i].name);
+		if (!strncasecmp(mn, ops[i].name, len))
+		{
+			// Also take the condition and S the other way around.
+			const char *sfx = mn + len;
+			in->cond = COND_AL;
+			in->s = false;
+			if (toupper((unsigned char)*sfx) == 'S' && ops[i].op <= OP_SUB)
+			{
+				in->s = true;
+				sfx++;
+			}
+			if (*sfx && strlen(sfx) >= 2)
+			{
+				u32 c;
+				for (c = 0; c <= COND_AL; c++)
+					if (!strncasecmp(sfx, conds[c], 2))
+						break;
+				if (c > COND_AL)
+					continue;
+				in->cond = c;
+				sfx += 2;
+			}
+			if (toupper((unsigned char)*sfx) == 'S' && ops[i].op <= OP_SUB && !in->s)
+			{
+				in->s = true;
+				sfx++;
+			}
+			if (!*sfx)
+				break;
+		}
+	}
+	if (i == sizeof(ops) / sizeof(ops[0]))
+		return 0;
+	in->op = ops[i].op;
+
+	switch (in->op)
+	{
+	case OP_MOV:
+		if (n < 2 || _reg(args[0]) < 0)
+			return 0;
+		in->rd = _reg(args[0]);
+		return _operand2(in, args + 1, n - 1);
+	case OP_ADD:
+	case OP_SUB:
+		if (n < 3 || _reg(args[0]) < 0 || _reg(args[1]) < 0)
+			return 0;
+		in->rd = _reg(args[0]);
+		in->rn = _reg(args[1]);
+		return _operand2(in, args + 2, n - 2);
+	case OP_CMP:
+	case OP_TST:
+		if (n < 2 || _reg(args[0]) < 0)
+			return 0;
+		in->rn = _reg(args[0]);
+		in->s = true;
+		return _operand2(in, args + 1, n - 1);
+	case OP_LDR:
+	case OP_STR:
+	{
+		// [Rn], #imm or [Rn] or [Rn, #imm].
+		u32 off = 0;
+		if (n < 2 || _reg(args[0]) < 0 || args[1][0] != '[')
+			return 0;
+		in->rd = _reg(args[0]);
+		char *close = strchr(args[1], ']');
+		if (!close || close[1])
+			return 0;
+		*close = 0;
+		char *inner[2];
+		u32 k = _split(args[1] + 1, inner, 2);
+		if (k < 1 || k > 2 || _reg(inner[0]) < 0 || (k == 2 && !_imm(inner[1], &off)))
+			return 0;
+		in->rn = _reg(inner[0]);
+		if (n == 3)
+		{
+			if (k != 1 || !_imm(args[2], &off))
+				return 0;
+			in->post = true;
+		}
+		else if (n != 2)
+			return 0;
+		in->offset = (s32)off;
+		return 1;
+	}
+	case OP_LDMIA:
+	case OP_STMIA:
+	case OP_STMDB:
+	{
+		if (n != 2)
+			return 0;
+		u32 l = strlen(args[0]);
+		if (l && args[0][l - 1] == '!')
+		{
+			in->writeback = true;
+			args[0][l - 1] = 0;
+		}
+		if (_reg(args[0]) < 0)
+			return 0;
+		in->rn = _reg(args[0]);
+		return _reglist(args[1], &in->val) && !(in->val & (1u << 15));
+	}
+	case OP_B:
+	{
+		int l = n == 1 ? _label(m, args[0]) : -1;
+		if (l < 0)
+			return 0;
+		in->val = m->labels[l].insn;
+		return 1;
+	}
+	case OP_BX:
+		if (n != 1 || _reg(args[0]) < 0)
+			return 0;
+		in->rm = _reg(args[0]);
+		return 1;
+	}
+
+	return 0;
+}
+
+// Runs fn on each label or instruction line, with the line number.
+static int _lines(arm_model_t *m, char *src, int (*fn)(arm_model_t *, char *, u32))
+{
+	u32 line = 1;
+
+	for (char *p = src; p; line++)
+	{
+		char *next = strchr(p, '\n');
+		if (next)
+			*next++ = 0;
+		char *s = _trim(p);
+		char *colon = strchr(s, ':');
+		if (colon && !strchr(s, ' ') && !strchr(s, '\t'))
+		{
+			*colon = 0;
+			if (!fn(m, s, 0))
+				return 0;
+			s = _trim(colon + 1);
+		}
+		if (*s && *s != '.' && !fn(m, s, line))
+		{
+			printf("arm_model: line %u: %s\n", line, s);
+			return 0;
+		}
+		p = next;
+	}
+
+	return 1;
+}
+
+static int _add_label(arm_model_t *m, char *s, u32 line)
+{
+	if (line)
+	{
+		m->num_insns++;
+		return m->num_insns <= ARM_MODEL_INSNS;
+	}
+	if (m->num_labels == ARM_MODEL_LABELS || strlen(s) >= sizeof(m->labels[0].name) || _label(m, s) >= 0)
+		return 0;
+	strcpy(m->labels[m->num_labels].name, s);
+	m->labels[m->num_labels++].insn = m->num_insns;
+
+	return 1;
+}
+
+static int _add_insn(arm_model_t *m, char *s, u32 line)
+{
+	if (!line)
+		return 1;
+
+	arm_insn_t *in = &m->insns[m->num_insns++];
+	memset(in, 0, sizeof(*in));
+	in->line = line;
+
+	return _parse(m, in, s);
+}
+
+int arm_model_load(arm_model_t *m, const char *src)
+{
+	char *text;
+	int res;
+
+	memset(m, 0, sizeof(*m));
+	text = _strip(src);
+	res = _lines(m, text, _add_label);
+	free(text);
+	if (!res)
+		return 0;
+
+	m->num_insns = 0;
+	text = _strip(src);
+	res = _lines(m, text, _add_insn);
+	free(text);
+	if (res)
+		m->stack = host_alloc32(STACK_SIZE);
+
+	return res;
+}
+
+void arm_model_end(arm_model_t *m)
+{
+	if (m->stack)
+		host_free32(m->stack, STACK_SIZE);
+	m->stack = NULL;
+}
+
+static bool _cond(const arm_model_t *m, u32 cond)
+{
+	switch (cond)
+	{
+	case 0: return m->z;
+	case 1: return !m->z;
+	case 2: return m->c;
+	case 3: return !m->c;
+	case 4: return m->n;
+	case 5: return !m->n;
+	case 6: return m->v;
+	case 7: return !m->v;
+	case 8: return m->c && !m->z;
+	case 9: return !m->c || m->z;
+	case 10: return m->n == m->v;
+	case 11: return m->n != m->v;
+	case 12: return !m->z && m->n == m->v;
+	case 13: return m->z || m->n != m->v;
+	default: return true;
+	}
+}
+
+// The second operand, with the shifter carry.
+static u32 _op2(const arm_model_t *m, const arm_insn_t *in, bool *carry)
+{
+	u32 v = m->r[in->rm];
+
+	*carry = m->c;
+	if (in->imm)
+		return in->val;
+	if (!in->shift_imm)
+		return v;
+
+	switch (in->shift)
+	{
+	case 0:
+		*carry = (v >> (32 - in->shift_imm)) & 1;
+		return v << in->shift_imm;
+	case 1:
+		*carry = (v >> (in->shift_imm - 1)) & 1;
+		return v >> in->shift_imm;
+	default:
+		*carry = ((s32)v >> (in->shift_imm - 1)) & 1;
+		return (u32)((s32)v >> in->shift_imm);
+	}
+}
+
+static u32 *_mem(arm_model_t *m, u32 addr)
+{
+	(void)m;
+	return (u32 *)(unsigned long)addr;
+}
+
+int arm_model_call(arm_model_t *m, const char *label, u32 r0, u32 r1, u32 r2, u64 max_insns)
+{
+	int l = _label(m, label);
+	u32 sp = (u32)(unsigned long)m->stack + STACK_SIZE;
+	u32 pc;
+
+	if (l < 0)
+		return 0;
+	pc = m->labels[l].insn;
+	m->r[0] = r0;
+	m->r[1] = r1;
+	m->r[2] = r2;
+	m->r[13] = sp;
+	m->r[14] = RET_ADDR;
+
+	for (u64 count = 0; count < max_insns; count++)
+	{
+		if (pc >= m->num_insns)
+			return 0;
+
+		const arm_insn_t *in = &m->insns[pc++];
+		if (!_cond(m, in->cond))
+		{
+			m->cycles++;
+			continue;
+		}
+
+		bool carry;
+		u32 a = m->r[in->rn], b, res;
+		switch (in->op)
+		{
+		case OP_MOV:
+			res = _op2(m, in, &carry);
+			m->r[in->rd] = res;
+			if (in->s)
+			{
+				m->n = res >> 31;
+				m->z = !res;
+				m->c = carry;
+			}
+			m->cycles++;
+			break;
+		case OP_TST:
+			res = a & _op2(m, in, &carry);
+			m->n = res >> 31;
+			m->z = !res;
+			m->c = carry;
+			m->cycles++;
+			break;
+		case OP_ADD:
+			b = _op2(m, in, &carry);
+			res = a + b;
+			m->r[in->rd] = res;
+			if (in->s)
+			{
+				m->n = res >> 31;
+				m->z = !res;
+				m->c = res < a;
+				m->v = (~(a ^ b) & (a ^ res)) >> 31;
+			}
+			m->cycles++;
+			break;
+		case OP_SUB:
+		case OP_CMP:
+			b = _op2(m, in, &carry);
+			res = a - b;
+			if (in->op == OP_SUB)
+				m->r[in->rd] = res;
+			if (in->s)
+			{
+				m->n = res >> 31;
+				m->z = !res;
+				m->c = a >= b;
+				m->v = ((a ^ b) & (a ^ res)) >> 31;
+			}
+			m->cycles++;
+			break;
+		case OP_LDR:
+		case OP_STR:
+		{
+			u32 addr = in->post ? a : a + in->offset;
+			if (addr & 3)
+				return 0;
+			if (in->op == OP_LDR)
+			{
+				m->r[in->rd] = *_mem(m, addr);
+				m->cycles += 3;
+			}
+			else
+			{
+				*_mem(m, addr) = m->r[in->rd];
+				m->cycles += 2;
+			}
+			if (in->post)
+				m->r[in->rn] = a + in->offset;
+			break;
+		}
+		case OP_LDMIA:
+		case OP_STMIA:
+		case OP_STMDB:
+		{
+			u32 num = __builtin_popcount(in->val);
+			u32 addr = in->op == OP_STMDB ? a - num * 4 : a;
+			if (addr & 3)
+				return 0;
+			// Pushes and pops have to stay on the stack.
+			if (in->rn == 13 && (addr < sp - STACK_SIZE || addr + num * 4 > sp))
+				return 0;
+			for (u32 r = 0; r < 16; r++)
+			{
+				if (!(in->val & (1u << r)))
+					continue;
+				if (in->op == OP_LDMIA)
+					m->r[r] = *_mem(m, addr);
+				else
+					*_mem(m, addr) = m->r[r];
+				addr += 4;
+			}
+			if (in->writeback)
+				m->r[in->rn] = in->op == OP_STMDB ? a - num * 4 : a + num * 4;
+			m->cycles += in->op == OP_LDMIA ? num + 2 : num + 1;
+			break;
+		}
+		case OP_B:
+			pc = in->val;
+			m->cycles += 3;
+			break;
+		case OP_BX:
+			m->cycles += 3;
+			if (m->r[in->rm] != RET_ADDR)
+				return 0;
+			return m->r[13] == sp;
+		}
+
+		// The stack may only be used within its bounds.
+		if (m->r[13] > sp || m->r[13] < sp - STACK_SIZE)
+			return 0;
+	}
+
+	return 0;
+}
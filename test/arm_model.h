@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ARM_MODEL_H_
+#define _ARM_MODEL_H_
+
+#include "utils/types.h"
+
+/*
+ * Runs ARM assembly from its source text, so the kernels of mem32.s can be
+ * checked without an ARM toolchain. Only the data processing, load/store
+ * and branch instructions those kernels use are known, anything else fails
+ * the load. Cycles are counted as on the ARM7TDMI with memory that has no
+ * wait states: S, N and I cycles all count 1.
+ */
+
+#define ARM_MODEL_INSNS 256
+#define ARM_MODEL_LABELS 64
+
+typedef struct _arm_insn_t
+{
+	u8 op;
+	u8 cond;
+	bool s;
+	bool writeback;
+	u8 rd, rn, rm;
+	u8 shift; // For register operands, 0 LSL, 1 LSR, 2 ASR.
+	u8 shift_imm;
+	bool imm;
+	u32 val;     // Immediate, label index or register list.
+	s32 offset;  // Load and store offset.
+	bool post;   // Post-indexed load and store.
+	u32 line;
+} arm_insn_t;
+
+typedef struct _arm_model_t
+{
+	u32 r[16];
+	bool n, z, c, v;
+	u64 cycles;
+
+	arm_insn_t insns[ARM_MODEL_INSNS];
+	u32 num_insns;
+	struct
+	{
+		char name[32];
+		u32 insn;
+	} labels[ARM_MODEL_LABELS];
+	u32 num_labels;
+
+	u32 *stack;
+} arm_model_t;
+
+/* Parses the source, returns 0 and prints the line on anything unknown. */
+int arm_model_load(arm_model_t *m, const char *src);
+void arm_model_end(arm_model_t *m);
+
+/*
+ * Calls a label with up to four arguments, it has to return with BX LR.
+ * Returns 0 if it does not within max_insns or touches the stack wrongly.
+ */
+int arm_model_call(arm_model_t *m, const char *label, u32 r0, u32 r1, u32 r2, u64 max_insns);
+
+#endif
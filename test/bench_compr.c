@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * LZ4 against LZ_Uncompress() and blz on real payloads, given as
+ * arguments. Each one is compressed the way the build would: lz4 -l -9
+ * with the legacy header stripped, tools/blz.py, and the reference LZ77
+ * encoder for lz.c.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libs/compr/blz.h"
+#include "libs/compr/lz.h"
+#include "libs/compr/lz4.h"
+#include "host.h"
+#include "ref.h"
+
+#define TOTAL 0x4000000
+
+typedef int (*decode_t)(const u8 *src, u32 src_size, u8 *dst, u32 dst_size);
+
+static int _lz(const u8 *src, u32 src_size, u8 *dst, u32 dst_size)
+{
+	LZ_Uncompress(src, dst, src_size);
+	return dst_size;
+}
+
+static int _lz_safe(const u8 *src, u32 src_size, u8 *dst, u32 dst_size)
+{
+	return LZ_Uncompress_safe(src, src_size, dst, dst_size);
+}
+
+static int _lz4(const u8 *src, u32 src_size, u8 *dst, u32 dst_size)
+{
+	return lz4_decompress_block(src, src_size, dst, dst_size);
+}
+
+static int _blz(const u8 *src, u32 src_size, u8 *dst, u32 dst_size)
+{
+	return blz_uncompress_srcdest(src, src_size, dst, dst_size) ? (int)dst_size : -1;
+}
+
+static void _bench(const char *what, decode_t decode, const u8 *comp, u32 csize, const u8 *data, u32 size)
+{
+	char name[96];
+	u8 *out = host_alloc32(size);
+	u32 rounds = TOTAL / size + 1;
+	u64 start;
+
+	CHECK(decode(comp, csize, out, size) == (int)size);
+	CHECK(!memcmp(out, data, size));
+
+	start = host_time_ns();
+	for (u32 i = 0; i < rounds; i++)
+		decode(comp, csize, out, size);
+	snprintf(name, sizeof(name), "%-20s %3u%%", what, csize * 100 / size);
+	host_report(name, (u64)rounds * size >> 20, "MiB", host_time_ns() - start);
+
+	host_free32(out, size);
+}
+
+static u8 *_run(const char *fmt, const char *in, const char *out, u32 *size)
+{
+	char cmd[512];
+
+	snprintf(cmd, sizeof(cmd), fmt, in, out);
+	if (system(cmd))
+		return NULL;
+	return host_read_file(out, size);
+}
+
+int main(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		u32 size, csize;
+		u8 *data = host_read_file(argv[i], &size);
+		u8 *comp;
+
+		if (!data || !size)
+		{
+			printf("%s: cannot read\n", argv[i]);
+			return 1;
+		}
+		printf("%s, %u bytes\n", argv[i], size);
+
+		comp = _run("lz4 -c -f -l -9 '%s' > '%s'", argv[i], "build/payload.lz4", &csize);
+		CHECK(comp && csize > 8);
+		if (comp)
+		{
+			_bench("lz4_decompress_block", _lz4, comp + 8, csize - 8, data, size);
+			host_free32(comp, csize);
+		}
+
+		comp = _run("python3 ../tools/blz.py c '%s' '%s' > /dev/null", argv[i], "build/payload.blz", &csize);
+		CHECK(comp != NULL);
+		if (comp)
+		{
+			_bench("blz", _blz, comp, csize, data, size);
+			host_free32(comp, csize);
+		}
+
+		comp = host_alloc32(size * 257 / 256 + 2);
+		csize = ref_lz_compress(comp, data, size);
+		_bench("LZ_Uncompress", _lz, comp, csize, data, size);
+		_bench("LZ_Uncompress_safe", _lz_safe, comp, csize, data, size);
+		host_free32(comp, size * 257 / 256 + 2);
+
+		host_free32(data, size);
+	}
+
+	return host_done("bench_compr");
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * dir_find on large directories of long file names, through f_stat.
+ * Built as bench_dir_find with the ASCII fast path of FF_LFN_FASTCMP and
+ * as bench_dir_find_ref without it.
+ */
+
+#include <string.h>
+
+#include "libs/fatfs/ff.h"
+#include "host.h"
+#include "ramdisk.h"
+
+#define ROUNDS 3
+
+static FATFS fs;
+
+static void _name(char *buf, const char *dir, u32 i, int upper)
+{
+	// Payload names of mixed lengths, sharing long prefixes.
+	static const char *const stems[] = { "payload", "Payload_backup", "fusee-primary", "hekate_ctcaer_4.2" };
+
+	sprintf(buf, "%s/%s_%04d.bin", dir, stems[i & 3], i);
+	if (upper)
+		for (char *p = buf + strlen(dir); *p; p++)
+			if (*p >= 'a' && *p <= 'z')
+				*p -= 32;
+}
+
+static int _fill(const char *dir, u32 files)
+{
+	char path[64];
+	FIL fp;
+
+	if (f_mkdir(dir) != FR_OK)
+		return 0;
+	for (u32 i = 0; i < files; i++)
+	{
+		_name(path, dir, i, 0);
+		if (f_open(&fp, path, FA_CREATE_NEW | FA_WRITE) != FR_OK)
+			return 0;
+		f_close(&fp);
+	}
+	return 1;
+}
+
+static void _bench(const char *dir, u32 files)
+{
+	char path[64], what[64];
+	FILINFO fno;
+	u32 errors = 0;
+
+	if (!_fill(dir, files))
+	{
+		printf("  %s: can't create %d files\n", dir, files);
+		CHECK(0);
+		return;
+	}
+
+	// Hits in a random order, as typed and upper case, then misses that
+	// scan the whole directory.
+	for (int kind = 0; kind < 3; kind++)
+	{
+		u64 reads = ramdisk_reads;
+		u64 start = host_time_ns();
+		u32 lookups = 0;
+
+		host_seed(files);
+		for (int r = 0; r < ROUNDS; r++)
+		{
+			for (u32 n = 0; n < files; n++, lookups++)
+			{
+				u32 i = host_rand() % files;
+				if (kind == 2)
+					i += files;
+				_name(path, dir, i, kind == 1);
+				if (f_stat(path, &fno) != (kind == 2 ? FR_NO_FILE : FR_OK))
+					errors++;
+			}
+		}
+
+		u64 ns = host_time_ns() - start;
+		static const char *const kinds[] = { "hit", "hit, other case", "miss" };
+		sprintf(what, "%d files, %s", files, kinds[kind]);
+		host_report(what, lookups, "lookup", ns);
+		printf("  %-40s %12.1f sectors/lookup\n", "", (double)(ramdisk_reads - reads) / lookups);
+	}
+
+	CHECK(!errors);
+}
+
+int main()
+{
+	printf("FF_LFN_FASTCMP %d\n", FF_LFN_FASTCMP);
+
+	if (!ramdisk_format(0) || f_mount(&fs, "", 1) != FR_OK)
+	{
+		printf("can't mount the RAM disk\n");
+		return 1;
+	}
+
+	_bench("small", 64);
+	_bench("medium", 512);
+	_bench("large", 2048);
+
+	return host_done("bench_dir_find");
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// gfx.c drawing rates against the per pixel code it replaced.
+
+#include "gfx/gfx.h"
+#include "fb_model.h"
+#include "host.h"
+#include "ref.h"
+
+#define CHARS 200000
+
+typedef void (*putc_t)(gfx_con_t *con, char c);
+
+static gfx_ctxt_t ctxt;
+
+static void _bench_putc(const char *what, putc_t put, int fillbg)
+{
+	gfx_con_t con;
+	u64 start;
+
+	gfx_con_init(&con, &ctxt);
+	con.fillbg = fillbg;
+
+	start = host_time_ns();
+	for (u32 i = 0; i < CHARS; i++)
+	{
+		// 40 columns and 11 lines at scale 2, like the boot console.
+		con.x = i % 40 * CHAR_WIDTH * 2;
+		con.y = i / 40 % 11 * CHAR_HEIGHT * 2;
+		put(&con, 33 + i % 90);
+	}
+	host_report(what, CHARS, "char", host_time_ns() - start);
+}
+
+#define BLITS 200
+
+static void _bench_bmp(const char *what, bool ref, const u32 *img, u32 size)
+{
+	u64 start = host_time_ns();
+
+	for (u32 i = 0; i < BLITS; i++)
+		if (ref)
+			ref_gfx_render_bmp_argb(&ctxt, img, size, size, 10, 10, true, 0xFF1D1919);
+		else
+			gfx_render_bmp_argb(&ctxt, img, size, size, 10, 10);
+	host_report(what, (u64)BLITS * size * size >> 20, "Mpx", host_time_ns() - start);
+}
+
+#define FRAMES 100
+
+static void _bench_clear(void)
+{
+	u64 start;
+
+	start = host_time_ns();
+	for (u32 i = 0; i < FRAMES; i++)
+		gfx_clear_grey(&ctxt, i);
+	host_report("gfx_clear_grey", FRAMES, "frame", host_time_ns() - start);
+
+	start = host_time_ns();
+	for (u32 i = 0; i < FRAMES; i++)
+		gfx_clear_color(&ctxt, 0xFF000000 | i);
+	host_report("gfx_clear_color", FRAMES, "frame", host_time_ns() - start);
+
+	start = host_time_ns();
+	for (u32 i = 0; i < FRAMES; i++)
+		ref_gfx_clear_color(&ctxt, 0xFF000000 | i);
+	host_report("gfx_clear_color, per pixel", FRAMES, "frame", host_time_ns() - start);
+
+	// A full frame of dirty region copied on each swap.
+	start = host_time_ns();
+	for (u32 i = 0; i < FRAMES; i++)
+	{
+		gfx_clear_grey(&ctxt, i);
+		gfx_swap_buffer(&ctxt);
+	}
+	host_report("gfx_clear_grey and gfx_swap_buffer", FRAMES, "frame", host_time_ns() - start);
+}
+
+int main()
+{
+	fb_model_init(&ctxt, FB_STRIDE);
+
+	_bench_putc("gfx_putc", gfx_putc, 0);
+	_bench_putc("gfx_putc, per pixel", ref_gfx_putc, 0);
+	_bench_putc("gfx_putc with background", gfx_putc, 1);
+	_bench_putc("gfx_putc with background, per pixel", ref_gfx_putc, 1);
+
+	_bench_clear();
+
+	u32 *img = host_alloc32(700 * 700 * 4);
+	for (u32 i = 0; i < 700 * 700; i++)
+		img[i] = 0xFF000000 | host_rand();
+	_bench_bmp("gfx_render_bmp_argb 700x700", false, img, 700);
+	_bench_bmp("gfx_render_bmp_argb 700x700, per pixel", true, img, 700);
+	host_free32(img, 700 * 700 * 4);
+
+	fb_model_end(&ctxt);
+
+	return 0;
+}
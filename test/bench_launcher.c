@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * launch_payload() of a plain payload, which ffro reads in one go, against
+ * the same payload encrypted, which FatFs reads in chunks while the SE
+ * decrypts the one before. On the host the disk and the engine cost
+ * nothing, so this is the time ramdisk.c and se_model.c charge: an SD card
+ * with a command overhead and a transfer rate, and the SE at a few speeds.
+ * Overlap shows up as the encrypted load taking little more than the SD time.
+ */
+
+#include <string.h>
+
+#include "libs/fatfs/ff.h"
+#include "sec/keyslot.h"
+#include "sec/se.h"
+#include "utils/fs_utils.h"
+#include "launcher_env.h"
+#include "ramdisk.h"
+#include "se_model.h"
+#include "host.h"
+
+#define PATH "payload.bin"
+#define FILE_MAX (sizeof(launcher_enc_hdr_t) + LAUNCHER_PAYLOAD_MAX)
+
+// About a UHS-I card in SDR104, 20us a command and 90MB/s.
+#define SD_CMD_NS    20000
+#define SD_SECTOR_NS 5700
+
+static u8 seed[0x10];
+
+static u64 _launch(bool encrypted)
+{
+	u32 size;
+
+	// The launcher unwraps the key from a header on its stack, which the SE
+	// model can't reach above 4GiB. Its lookup finds this slot instead, so
+	// the one block unwrap is left out.
+	if (encrypted)
+		CHECK(keyslot_derive(KEYSLOT_SBK, seed) >= 0);
+
+	// Unmounted as it is at boot, FatFs only mounts on first use.
+	sd_unmount();
+	CHECK(sd_mount());
+
+	u64 start = host_model_ns;
+	CHECK(launcher_env_launch(PATH, &size));
+	return launcher_env_entry_ns - start;
+}
+
+static void _report(const u8 *data, u8 *file, u32 size)
+{
+	static const u32 se_block_ns[] = { 0, 16, 32, 64 };
+	char what[64];
+
+	se_model_block_ns = 0;
+	CHECK(launcher_env_write(PATH, data, size));
+	u64 plain = _launch(false);
+	printf("  0x%05X bytes plain %29s %10.1f us\n", size, "", plain / 1e3);
+
+	for (u32 mode = LAUNCHER_ENC_CTR; mode <= LAUNCHER_ENC_CBC; mode++)
+	{
+		se_model_block_ns = 0;
+		u32 file_size = launcher_env_encrypt(file, mode, seed, data, size);
+		CHECK(file_size && launcher_env_write(PATH, file, file_size));
+
+		for (u32 i = 0; i < sizeof(se_block_ns) / sizeof(se_block_ns[0]); i++)
+		{
+			se_model_block_ns = se_block_ns[i];
+			u64 enc = _launch(true);
+			if (se_block_ns[i])
+				snprintf(what, sizeof(what), "%s, SE at %u MB/s", mode == LAUNCHER_ENC_CBC ? "CBC" : "CTR",
+					16000 / se_block_ns[i]);
+			else
+				snprintf(what, sizeof(what), "%s, SE taking no time", mode == LAUNCHER_ENC_CBC ? "CBC" : "CTR");
+			printf("  0x%05X bytes %-35s %10.1f us %+6.1f%%\n", size, what, enc / 1e3,
+				((double)enc / plain - 1) * 100);
+		}
+	}
+}
+
+int main()
+{
+	u8 sbk[0x10];
+
+	// exFAT with 128KiB clusters, as SDXC cards come.
+	if (!launcher_env_init(FS_EXFAT, 64, 8))
+		return 1;
+
+	for (u32 i = 0; i < 0x10; i++)
+	{
+		sbk[i] = host_rand();
+		seed[i] = host_rand();
+	}
+	se_aes_key_set(KEYSLOT_SBK, sbk, 0x10);
+
+	u8 *data = host_alloc32(LAUNCHER_PAYLOAD_MAX);
+	u8 *file = host_alloc32(FILE_MAX);
+	for (u32 i = 0; i < LAUNCHER_PAYLOAD_MAX; i++)
+		data[i] = host_rand();
+
+	ramdisk_cmd_ns = SD_CMD_NS;
+	ramdisk_sector_ns = SD_SECTOR_NS;
+	_report(data, file, 0x20000);
+	_report(data, file, LAUNCHER_PAYLOAD_MAX);
+
+
+	host_free32(file, FILE_MAX);
+	host_free32(data, LAUNCHER_PAYLOAD_MAX);
+
+	return host_done("bench_launcher");
+}
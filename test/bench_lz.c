@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// LZ_Uncompress_safe() against the original byte wise LZ_Uncompress().
+
+#include <string.h>
+
+#include "utils/types.h"
+#include "libs/compr/lz.h"
+#include "mem/sdram_param_t210.h"
+#include "mem/sdram_config_lz.inl"
+#include "host.h"
+#include "ref.h"
+
+#define DATA_SIZE 0x10000
+#define TOTAL 0x4000000
+
+static void _bench(const char *what, const u8 *comp, u32 csize, u8 *out, u32 size)
+{
+	char name[96];
+	u32 rounds = TOTAL / size;
+	u64 start;
+
+	start = host_time_ns();
+	for (u32 i = 0; i < rounds; i++)
+		LZ_Uncompress(comp, out, csize);
+	snprintf(name, sizeof(name), "%s, LZ_Uncompress", what);
+	host_report(name, (u64)rounds * size >> 20, "MiB", host_time_ns() - start);
+
+	start = host_time_ns();
+	for (u32 i = 0; i < rounds; i++)
+		LZ_Uncompress_safe(comp, csize, out, size);
+	snprintf(name, sizeof(name), "%s, LZ_Uncompress_safe", what);
+	host_report(name, (u64)rounds * size >> 20, "MiB", host_time_ns() - start);
+}
+
+int main()
+{
+	u8 *data = host_alloc32(DATA_SIZE);
+	u8 *comp = host_alloc32(DATA_SIZE * 2);
+	u8 *out = host_alloc32(DATA_SIZE);
+	u32 pos = 0;
+
+	_bench("SDRAM parameters", _dram_cfg_base_lz, sizeof(_dram_cfg_base_lz), out, sizeof(sdram_params_t));
+
+	// Mostly long matches, like code and tables.
+	while (pos < DATA_SIZE)
+	{
+		if (pos >= 256 && host_rand() & 1)
+		{
+			u32 off = 4 + host_rand() % 252;
+			for (u32 len = 8 + host_rand() % 120; len && pos < DATA_SIZE; len--, pos++)
+				data[pos] = data[pos - off];
+		}
+		else
+			data[pos++] = host_rand();
+	}
+	_bench("long matches", comp, ref_lz_compress(comp, data, DATA_SIZE), out, DATA_SIZE);
+
+	for (pos = 0; pos < DATA_SIZE; pos++)
+		data[pos] = host_rand() & 0xF;
+	_bench("short matches", comp, ref_lz_compress(comp, data, DATA_SIZE), out, DATA_SIZE);
+
+	for (pos = 0; pos < DATA_SIZE; pos++)
+		data[pos] = host_rand();
+	_bench("literals", comp, ref_lz_compress(comp, data, DATA_SIZE), out, DATA_SIZE);
+
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Throughput of the software SE backend, with the byte wise reference AES for scale.
+
+#include <string.h>
+
+#include "sec/se.h"
+#include "host.h"
+#include "ref.h"
+
+#define BUF_SIZE 0x100000
+#define TOTAL 0x4000000
+
+static u8 *src, *dst;
+
+static void _report(const char *what, u64 start)
+{
+	host_report(what, TOTAL >> 20, "MiB", host_time_ns() - start);
+}
+
+int main()
+{
+	u8 key[16], ctr[16];
+	se_sha256_ctx_t ctx;
+	ref_aes_t aes;
+	u64 start;
+
+	src = host_alloc32(BUF_SIZE);
+	dst = host_alloc32(BUF_SIZE);
+	for (u32 i = 0; i < BUF_SIZE; i++)
+		src[i] = host_rand();
+	memset(key, 0x42, 16);
+	memset(ctr, 0, 16);
+	se_aes_key_set(0, key, 16);
+	se_aes_key_set(1, key, 16);
+
+	start = host_time_ns();
+	for (u32 n = 0; n < TOTAL; n += BUF_SIZE)
+		se_aes_crypt_ecb(0, 1, dst, BUF_SIZE, src, BUF_SIZE);
+	_report("AES-128 ECB encrypt", start);
+
+	start = host_time_ns();
+	for (u32 n = 0; n < TOTAL; n += BUF_SIZE)
+		se_aes_crypt_ecb(0, 0, dst, BUF_SIZE, src, BUF_SIZE);
+	_report("AES-128 ECB decrypt", start);
+
+	start = host_time_ns();
+	for (u32 n = 0; n < TOTAL; n += BUF_SIZE)
+		se_aes_crypt_ctr(0, dst, BUF_SIZE, src, BUF_SIZE, ctr);
+	_report("AES-128 CTR", start);
+
+	start = host_time_ns();
+	for (u32 n = 0; n < TOTAL; n += BUF_SIZE)
+		se_aes_crypt_cbc(0, 0, dst, BUF_SIZE, src, BUF_SIZE, ctr);
+	_report("AES-128 CBC decrypt", start);
+
+	start = host_time_ns();
+	for (u32 n = 0; n < TOTAL; n += BUF_SIZE)
+		se_aes_xts_crypt(1, 0, 0, n, dst, src, 0x200, BUF_SIZE / 0x200);
+	_report("AES-128 XTS decrypt, 0x200 sectors", start);
+
+	start = host_time_ns();
+	for (u32 n = 0; n < TOTAL; n += BUF_SIZE)
+		se_aes_xts_crypt(1, 0, 0, n, dst, src, 0x4000, BUF_SIZE / 0x4000);
+	_report("AES-128 XTS decrypt, 0x4000 sectors", start);
+
+	start = host_time_ns();
+	se_sha256_init(&ctx);
+	for (u32 n = 0; n < TOTAL; n += BUF_SIZE)
+		se_sha256_update(&ctx, src, BUF_SIZE);
+	se_sha256_final(&ctx, dst);
+	_report("SHA-256", start);
+
+	ref_aes_init(&aes, key, 16);
+	start = host_time_ns();
+	for (u32 n = 0; n < TOTAL / 16; n += BUF_SIZE)
+		for (u32 i = 0; i < BUF_SIZE; i += 16)
+			ref_aes_encrypt(&aes, dst + i);
+	host_report("reference AES-128 encrypt", (TOTAL / 16) >> 20, "MiB", host_time_ns() - start);
+
+	return 0;
+}
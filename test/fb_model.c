@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gfx/di.h"
+#include "fb_model.h"
+#include "host.h"
+
+fb_model_t fb_model;
+
+static u32 _fb_model_size(u32 stride)
+{
+	// gfx_init_ctxt() puts next width * stride * 4 words after fb.
+	return (FB_WIDTH * stride * 5 + stride) * 4;
+}
+
+void set_active_framebuffer(u32 *address)
+{
+	fb_model.active = address;
+	fb_model.stride = fb_model.stride_pending;
+}
+
+void set_framebuffer_stride(u32 stride)
+{
+	fb_model.stride_pending = stride;
+}
+
+void set_framebuffer_offset(u32 offset)
+{
+	fb_model.offset = offset;
+	fb_model.stride = fb_model.stride_pending;
+}
+
+void fb_model_init(gfx_ctxt_t *ctxt, u32 stride)
+{
+	u32 *fb = host_alloc32(_fb_model_size(stride));
+
+	memset(&fb_model, 0, sizeof(fb_model));
+	gfx_init_ctxt(ctxt, fb, FB_WIDTH, FB_HEIGHT, stride);
+}
+
+void fb_model_end(gfx_ctxt_t *ctxt)
+{
+	host_free32(ctxt->fb < ctxt->next ? ctxt->fb : ctxt->next, _fb_model_size(ctxt->stride));
+}
+
+void fb_model_screen(u32 *dst)
+{
+	for (u32 row = 0; row < FB_WIDTH; row++, dst += FB_HEIGHT)
+		memcpy(dst, &fb_model.active[row * fb_model.stride + fb_model.offset], FB_HEIGHT * 4);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FB_MODEL_H_
+#define _FB_MODEL_H_
+
+#include "gfx/gfx.h"
+
+#define FB_WIDTH 1280
+#define FB_HEIGHT 720
+#define FB_STRIDE 768
+
+/*
+ * Host model of the display registers di.c programs. A stride set with
+ * set_framebuffer_stride() takes effect when the configuration is next
+ * written, as on the hardware, the line offset right away.
+ */
+typedef struct _fb_model_t
+{
+	u32 *active;
+	u32 stride;
+	u32 offset;
+	u32 stride_pending;
+} fb_model_t;
+
+extern fb_model_t fb_model;
+
+/*
+ * Sets up ctxt like the firmware does, on memory below 4GiB sized for
+ * where gfx_init_ctxt() puts the back buffer. fb_model_end() frees it.
+ */
+void fb_model_init(gfx_ctxt_t *ctxt, u32 stride);
+void fb_model_end(gfx_ctxt_t *ctxt);
+
+/* The FB_WIDTH lines of FB_HEIGHT pixels the panel scans out. */
+void fb_model_screen(u32 *dst);
+
+#endif
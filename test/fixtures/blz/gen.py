@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Writes the data test_blz.c decodes as <name>.bin and what tools/blz.py
+# makes of it as <name>.blz. The data is seeded, so this only has to be run
+# again when blz.py changes.
+#
+# usage: gen.py (run in this directory)
+
+import random
+import struct
+import sys
+
+sys.path.insert(0, '../../../tools')
+import blz
+
+def text(rnd, size):
+	words = [''.join(rnd.choice('etaoinshrdlu_') for _ in range(rnd.randint(2, 9))) for _ in range(200)]
+	out = ''
+	while len(out) < size:
+		out += ' '.join(rnd.choice(words) for _ in range(rnd.randint(3, 12))) + ';\n'
+	return out[:size].encode()
+
+def code(rnd, size):
+	# ARM words, a few opcodes with random registers and offsets.
+	ops = [0xE5900000, 0xE5800000, 0xE1A00000, 0xE2800000, 0xEB000000, 0xE3500000]
+	return b''.join(struct.pack('<I', rnd.choice(ops) | rnd.getrandbits(12) | rnd.getrandbits(4) << 12)
+		for _ in range(size // 4))
+
+def mixed(rnd, size):
+	# Random runs with repeats of earlier data at every offset blz can reach.
+	out = bytearray()
+	while len(out) < size:
+		if len(out) > 32 and rnd.random() < 0.6:
+			ofs = rnd.randint(3, min(len(out), 0x1002))
+			for _ in range(rnd.randint(3, 40)):
+				out.append(out[-ofs])
+		else:
+			out += bytes(rnd.getrandbits(8) for _ in range(rnd.randint(1, 20)))
+	return bytes(out[:size])
+
+def zeros(rnd, size):
+	out = bytearray(size)
+	for _ in range(size // 256):
+		out[rnd.randrange(size)] = rnd.getrandbits(8)
+	return bytes(out)
+
+FIXTURES = [
+	('text', text, 12288),
+	('code', code, 16384),
+	('mixed', mixed, 20000),
+	('zeros', zeros, 8191),
+	('small', mixed, 61),
+]
+
+def main():
+	rnd = random.Random(0x626C7A)
+	for name, gen, size in FIXTURES:
+		data = gen(rnd, size)
+		comp = blz.compress(data)
+		if comp is None or blz.decompress(comp) != data:
+			raise SystemExit('%s: no round trip' % name)
+		open(name + '.bin', 'wb').write(data)
+		open(name + '.blz', 'wb').write(comp)
+		hdr = struct.unpack('<III', comp[-12:])
+		print('%s: %d -> %d bytes, %d stored' % (name, size, len(comp), len(comp) - hdr[0]))
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Writes the ARM ET_DYN modules test_elfload.c loads. Each is laid out by
+# hand so one relocation path is hit at a time:
+#
+#   0x000 ELF header, 0x034 PT_LOAD and PT_DYNAMIC
+#   0x078 dynamic section, 0x0C0 symbols, 0x100 DT_REL table
+#   0x140 the words relocated, 0x160 DT_JMPREL table
+#   0x180 end of file, 0x1C0 end of the image (bss)
+#
+# Symbols: 1 is a thumb function at 0x101, 2 weak undefined, 3 undefined.
+#
+# usage: gen.py (run in this directory)
+
+import struct
+
+DYN, SYMTAB, REL, DATA, JMPREL = 0x78, 0xC0, 0x100, 0x140, 0x160
+FILE_SIZE, MEM_SIZE = 0x180, 0x1C0
+
+DT_NULL, DT_PLTRELSZ, DT_SYMTAB, DT_REL, DT_RELSZ, DT_RELENT, DT_PLTREL, DT_JMPREL = 0, 2, 6, 17, 18, 19, 20, 23
+DT_RELCOUNT = 0x6FFFFFFA
+
+R_ARM_NONE, R_ARM_ABS32, R_ARM_GLOB_DAT, R_ARM_JUMP_SLOT, R_ARM_RELATIVE = 0, 2, 21, 22, 23
+
+FUNC, WEAK, UNDEF = 1, 2, 3
+
+def rel(ofs, type, sym=0):
+	return (ofs, sym << 8 | type)
+
+def module(words, rels, relcount=0, jmprels=(), symtab=True, relsz=None):
+	e = bytearray(FILE_SIZE)
+	struct.pack_into('<4sBBBBB7xHHIIIIIHHHHHH', e, 0, b'\x7fELF', 1, 1, 1, 0, 0,
+		3, 40, 1, 0x21, 52, 0, 0, 52, 32, 2, 40, 0, 0)
+	struct.pack_into('<8I', e, 52, 1, 0, 0, 0, FILE_SIZE, MEM_SIZE, 7, 0x10000)
+	struct.pack_into('<8I', e, 84, 2, DYN, DYN, DYN, SYMTAB - DYN, SYMTAB - DYN, 6, 4)
+
+	dyn = [(DT_REL, REL), (DT_RELSZ, len(rels) * 8 if relsz is None else relsz), (DT_RELENT, 8)]
+	if relcount:
+		dyn.append((DT_RELCOUNT, relcount))
+	if jmprels:
+		dyn += [(DT_JMPREL, JMPREL), (DT_PLTRELSZ, len(jmprels) * 8), (DT_PLTREL, DT_REL)]
+	if symtab:
+		dyn.append((DT_SYMTAB, SYMTAB))
+	dyn.append((DT_NULL, 0))
+	assert len(dyn) <= 9 and len(rels) <= 8 and len(jmprels) <= 4 and len(words) <= 8
+	for i, (tag, val) in enumerate(dyn):
+		struct.pack_into('<iI', e, DYN + 8 * i, tag, val)
+
+	syms = [(0, 0, 0, 0, 0, 0), (0, 0x101, 0, 0x12, 0, 1), (0, 0, 0, 0x22, 0, 0), (0, 0, 0, 0x12, 0, 0)]
+	for i, s in enumerate(syms):
+		struct.pack_into('<IIIBBH', e, SYMTAB + 16 * i, *s)
+
+	for i, (ofs, info) in enumerate(rels):
+		struct.pack_into('<II', e, REL + 8 * i, ofs, info)
+	for i, (ofs, info) in enumerate(jmprels):
+		struct.pack_into('<II', e, JMPREL + 8 * i, ofs, info)
+	struct.pack_into('<%dI' % len(words), e, DATA, *words)
+
+	return e
+
+def main():
+	w = lambda i: DATA + 4 * i
+	out = {}
+
+	# RELCOUNT covers the first three, the fourth goes through the switch.
+	out['relative'] = module([0x10, 0x20, 0x30, 0x40, 0x55],
+		[rel(w(0), R_ARM_RELATIVE), rel(w(1), R_ARM_RELATIVE), rel(w(2), R_ARM_RELATIVE),
+		 rel(w(3), R_ARM_RELATIVE), rel(w(4), R_ARM_NONE)], relcount=3)
+	# A RELCOUNT too large, the loop has to stop at the first ABS32.
+	out['abs32'] = module([4, 8, 0x55],
+		[rel(w(0), R_ARM_ABS32, FUNC), rel(w(1), R_ARM_ABS32, WEAK)], relcount=5)
+	out['glob_dat'] = module([0xDEAD, 0xBEEF, 0x55],
+		[rel(w(0), R_ARM_GLOB_DAT, FUNC), rel(w(1), R_ARM_GLOB_DAT, WEAK)])
+	# A RELCOUNT past DT_RELSZ must not reach the entry after the table.
+	out['relcount_past_table'] = module([0x10, 0x20],
+		[rel(w(0), R_ARM_RELATIVE), rel(w(1), R_ARM_RELATIVE)], relcount=2, relsz=8)
+	# Both tables, the DT_REL one is applied first.
+	out['jump_slot'] = module([0xDEAD, 0xBEEF, 0x10],
+		[rel(w(2), R_ARM_RELATIVE)], relcount=1,
+		jmprels=[rel(w(0), R_ARM_JUMP_SLOT, FUNC), rel(w(1), R_ARM_JUMP_SLOT, WEAK)])
+
+	out['truncated'] = out['relative'][:FILE_SIZE - 0x20]
+	# Offsets past the image, in the RELCOUNT loop and in the switch.
+	out['bad_offset'] = module([0x10], [rel(w(0), R_ARM_RELATIVE), rel(MEM_SIZE, R_ARM_RELATIVE)], relcount=2)
+	out['bad_offset_sym'] = module([0x10], [rel(w(0), R_ARM_RELATIVE), rel(MEM_SIZE - 2, R_ARM_ABS32, FUNC)])
+	out['misaligned_offset'] = module([0x10], [rel(w(0) + 2, R_ARM_RELATIVE)], relcount=1)
+	out['bad_table'] = module([0x10], [rel(w(0), R_ARM_RELATIVE)], relsz=MEM_SIZE - REL + 8)
+	out['bad_sym'] = module([0x10], [rel(w(0), R_ARM_ABS32, (MEM_SIZE - SYMTAB) // 16)])
+	out['no_symtab'] = module([0x10], [rel(w(0), R_ARM_GLOB_DAT, FUNC)], symtab=False)
+	out['undef_sym'] = module([0x10], [rel(w(0), R_ARM_GLOB_DAT, UNDEF)])
+	out['bad_type'] = module([0x10], [rel(w(0), 99)])
+
+	for name, data in out.items():
+		open(name + '.elf', 'wb').write(data)
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <time.h>
+
+#include "host.h"
+
+u64 host_model_ns;
+
+static int failures;
+static u32 rand_state = 0x2545F491;
+
+void host_fail(const char *file, int line, const char *what)
+{
+	if (failures++ < 20)
+		printf("%s:%d: check failed: %s\n", file, line, what);
+}
+
+int host_done(const char *name)
+{
+	if (failures)
+	{
+		printf("%s: %d checks failed\n", name, failures);
+		return 1;
+	}
+	printf("%s: ok\n", name);
+	return 0;
+}
+
+u64 host_time_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void host_report(const char *what, u64 count, const char *unit, u64 ns)
+{
+	if (!ns)
+		ns = 1;
+	printf("  %-40s %12.1f %s/s %10.1f ns/%s\n", what,
+		(double)count * 1e9 / ns, unit, (double)ns / (count ? count : 1), unit);
+}
+
+void *host_alloc32(u32 size)
+{
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_32BIT
+	flags |= MAP_32BIT;
+#endif
+	void *buf = mmap(NULL, size ? size : 1, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+	if (buf == MAP_FAILED || (u64)(unsigned long)buf + size > 0x100000000ull)
+	{
+		printf("host_alloc32: no memory below 4GiB for %d bytes\n", size);
+		return NULL;
+	}
+	return buf;
+}
+
+void host_free32(void *buf, u32 size)
+{
+	if (buf)
+		munmap(buf, size ? size : 1);
+}
+
+u8 *host_read_file(const char *path, u32 *size)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f)
+	{
+		printf("%s: can't open\n", path);
+		return NULL;
+	}
+
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	u8 *buf = host_alloc32(*size);
+	if (buf && fread(buf, 1, *size, f) != *size)
+	{
+		host_free32(buf, *size);
+		buf = NULL;
+	}
+	fclose(f);
+	return buf;
+}
+
+void host_seed(u32 seed)
+{
+	rand_state = seed ? seed : 0x2545F491;
+}
+
+u32 host_rand()
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+	return rand_state;
+}
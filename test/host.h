@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HOST_H_
+#define _HOST_H_
+
+#include <stdio.h>
+#include "utils/types.h"
+
+/* Counts a failure and reports it, the test keeps going. */
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) \
+			host_fail(__FILE__, __LINE__, #cond); \
+	} while (0)
+
+void host_fail(const char *file, int line, const char *what);
+/* Prints the result line, returns the exit code of the test. */
+int host_done(const char *name);
+
+u64 host_time_ns();
+/*
+ * Time of the modeled hardware, which the RAM disk and the SE model advance
+ * once a benchmark gives them a speed. The code between their calls is free.
+ */
+extern u64 host_model_ns;
+/* Prints a benchmark result line for bytes or items processed in ns. */
+void host_report(const char *what, u64 count, const char *unit, u64 ns);
+
+/*
+ * Memory below 4GiB, the firmware code casts pointers to u32.
+ * Freed with host_free32.
+ */
+void *host_alloc32(u32 size);
+void host_free32(void *buf, u32 size);
+
+/* Reads a whole file into host_alloc32 memory, NULL on error. */
+u8 *host_read_file(const char *path, u32 *size);
+
+/* xorshift32, seeded with host_seed. */
+void host_seed(u32 seed);
+u32 host_rand();
+
+#endif
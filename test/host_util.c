@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Host stand-ins for the parts of utils/util.c and mem32.s the tests link.
+
+#include "host.h"
+#include "utils/util.h"
+
+u32 get_tmr_us()
+{
+	return host_time_ns() / 1000;
+}
+
+u32 get_tmr_ms()
+{
+	return host_time_ns() / 1000000;
+}
+
+void memset32(u32 *dst, u32 val, u32 len)
+{
+	for (u32 i = 0; i < len / 4; i++)
+		dst[i] = val;
+}
+
+void memcpy32(u32 *dst, const u32 *src, u32 len)
+{
+	for (u32 i = 0; i < len / 4; i++)
+		dst[i] = src[i];
+}
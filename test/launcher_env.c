@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "core/launcher.h"
+#include "gfx/gfx.h"
+#include "sec/keyslot.h"
+#include "sec/se.h"
+#include "soc/hw_init.h"
+#include "utils/fs_utils.h"
+#include "launcher_env.h"
+#include "ramdisk.h"
+#include "host.h"
+
+// The relocator launcher.c copies from, and the payload behind its patched copy.
+#define IPL_LOAD_ADDR    0x40008000
+#define IPL_MAP          0x1000
+#define EXT_PAYLOAD_ADDR 0xC03C0000
+#define EXT_MAP          ((LAUNCHER_PAYLOAD_ADDR - EXT_PAYLOAD_ADDR + LAUNCHER_PAYLOAD_MAX + 0xFFF) & ~0xFFF)
+#define PAYLOAD_ENTRY    0x40010000
+#define PAYLOAD_END_OFF  0x84
+
+// What main.c defines.
+sdmmc_t g_sd_sdmmc;
+sdmmc_storage_t g_sd_storage;
+FATFS g_sd_fs;
+ffro_t g_sd_ffro;
+bool g_sd_mounted;
+gfx_ctxt_t g_gfx_ctxt;
+gfx_con_t g_gfx_con;
+
+char launcher_env_msg[0x100];
+u32 launcher_env_magic;
+u64 launcher_env_entry_ns;
+
+extern void (*ext_payload_ptr)();
+// Called once FatFs is loaded, see core/overlay.h.
+extern void fatfs_ovl_init();
+
+static bool _launched;
+
+void gfx_printf(gfx_con_t *con, const char *fmt, ...)
+{
+	u32 len = strlen(launcher_env_msg);
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(launcher_env_msg + len, sizeof(launcher_env_msg) - len, fmt, ap);
+	va_end(ap);
+}
+
+void gfx_end_ctxt(gfx_ctxt_t *ctxt) { }
+
+void reconfig_hw_workaround(bool extra_reconfig, u32 magic)
+{
+	launcher_env_magic = magic;
+}
+
+// The RAM disk is always there.
+int sdmmc_storage_init_sd(sdmmc_storage_t *storage, sdmmc_t *sdmmc, u32 id, u32 bus_width, u32 type) { return 1; }
+int sdmmc_storage_end(sdmmc_storage_t *storage) { return 1; }
+
+static void _payload_entry()
+{
+	_launched = true;
+	launcher_env_entry_ns = host_model_ns;
+}
+
+static int _map(u32 addr, u32 size)
+{
+	void *map = mmap((void *)(unsigned long)addr, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	return map == (void *)(unsigned long)addr;
+}
+
+int launcher_env_init(u32 fmt, u32 clusters, u32 csize_shift)
+{
+	if (!_map(IPL_LOAD_ADDR, IPL_MAP) || !_map(EXT_PAYLOAD_ADDR, EXT_MAP))
+	{
+		printf("launcher_env: can't map the payload addresses\n");
+		return 0;
+	}
+	ext_payload_ptr = _payload_entry;
+
+	if (!ramdisk_mkfs(fmt, clusters, csize_shift, 0))
+		return 0;
+	fatfs_ovl_init();
+	return sd_mount();
+}
+
+int launcher_env_write(const char *path, const void *data, u32 size)
+{
+	FIL fp;
+	UINT bw;
+
+	if (f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return 0;
+	int res = f_write(&fp, data, size, &bw) == FR_OK && bw == size;
+	return f_close(&fp) == FR_OK && res;
+}
+
+u32 launcher_env_encrypt(void *out, u32 mode, const u8 *seed, const void *data, u32 size)
+{
+	launcher_enc_hdr_t *hdr = (launcher_enc_hdr_t *)out;
+	u8 *enc = (u8 *)out + sizeof(launcher_enc_hdr_t);
+	u32 padded = ALIGN(size, 0x10);
+	u8 iv[0x10];
+
+	memset(hdr, 0, sizeof(launcher_enc_hdr_t));
+	hdr->magic = LAUNCHER_ENC_MAGIC;
+	hdr->mode = mode;
+	hdr->size = size;
+	for (u32 i = 0; i < 0x10; i++)
+		hdr->iv[i] = host_rand();
+	memcpy(hdr->seed, seed, 0x10);
+
+	memset(enc, 0, padded);
+	memcpy(enc, data, size);
+
+	int ks = keyslot_derive(KEYSLOT_SBK, seed);
+	if (ks < 0)
+		return 0;
+	memcpy(iv, hdr->iv, 0x10);
+	int res = mode == LAUNCHER_ENC_CBC ?
+		se_aes_crypt_cbc(ks, 1, enc, padded, enc, padded, iv) :
+		se_aes_crypt_ctr(ks, enc, padded, enc, padded, iv);
+	// The launcher has to unwrap the key itself.
+	keyslot_clear_all();
+
+	return res ? sizeof(launcher_enc_hdr_t) + padded : 0;
+}
+
+int launcher_env_launch(const char *path, u32 *size)
+{
+	// launch_payload() frees the path once it has the payload.
+	char *copy = malloc(strlen(path) + 1);
+	strcpy(copy, path);
+
+	_launched = false;
+	launcher_env_msg[0] = 0;
+	launch_payload(copy);
+
+	if (!_launched)
+	{
+		free(copy);
+		return 0;
+	}
+
+	*size = *(u32 *)(EXT_PAYLOAD_ADDR + PAYLOAD_END_OFF) - PAYLOAD_ENTRY;
+	return sd_mount();
+}
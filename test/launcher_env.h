@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LAUNCHER_ENV_H_
+#define _LAUNCHER_ENV_H_
+
+#include "utils/types.h"
+
+/*
+ * launch_payload() of launcher.c on the RAM disk, mounted through fs_utils.c,
+ * with the addresses it loads to mapped and the display and hardware calls
+ * around the launch stood in for.
+ */
+
+#define LAUNCHER_PAYLOAD_ADDR 0xC03C00A0
+#define LAUNCHER_PAYLOAD_MAX  0x30000
+
+// Same layout and values as enc_payload_hdr_t in launcher.c.
+#define LAUNCHER_ENC_MAGIC 0x50454944
+#define LAUNCHER_ENC_CTR   0
+#define LAUNCHER_ENC_CBC   1
+
+typedef struct _launcher_enc_hdr_t
+{
+	u32 magic;
+	u32 mode;
+	u32 size;
+	u32 rsvd;
+	u8  iv[0x10];
+	u8  seed[0x10];
+	u8  rsvd2[0x10];
+} launcher_enc_hdr_t;
+
+/*
+ * What the last launch_payload() call printed, the magic it passed to
+ * reconfig_hw_workaround() and the host_model_ns it jumped to the payload at.
+ */
+extern char launcher_env_msg[0x100];
+extern u32 launcher_env_magic;
+extern u64 launcher_env_entry_ns;
+
+/*
+ * Maps the payload addresses, formats the disk as ramdisk_mkfs() does and
+ * mounts it. Returns 1 on success.
+ */
+int launcher_env_init(u32 fmt, u32 clusters, u32 csize_shift);
+
+/* Writes a file of size bytes to the disk. Returns 1 on success. */
+int launcher_env_write(const char *path, const void *data, u32 size);
+
+/*
+ * Builds an encrypted payload in out, a header and the data padded to whole
+ * blocks, with the key the launcher unwraps from seed. Returns its size.
+ */
+u32 launcher_env_encrypt(void *out, u32 mode, const u8 *seed, const void *data, u32 size);
+
+/*
+ * Calls launch_payload() on path and mounts the disk again. Returns 1 when
+ * it jumped to the payload, with the size it told the relocator in *size.
+ */
+int launcher_env_launch(const char *path, u32 *size);
+
+#endif
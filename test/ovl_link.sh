@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Links stand-in host objects with src/link.ld and the fragments gen_ovl.py
+# writes for src/overlays.lst. Resident code calling an overlay function
+# through its stub has to link, calling it directly must not.
+#
+# usage: ovl_link.sh <build dir>
+
+set -e
+
+PYTHON=${PYTHON:-python3}
+AS=${AS:-as}
+LD=${LD:-ld}
+DIR=$1/ovl_link
+
+rm -rf "$DIR"
+mkdir -p "$DIR/obj"
+$PYTHON ../tools/gen_ovl.py script ../src/overlays.lst "$DIR"
+
+fn=$($PYTHON ../tools/gen_ovl.py wrap ../src/overlays.lst | sed 's/^-Wl,--wrap=\([^ ]*\).*/\1/')
+obj=$($PYTHON ../tools/gen_ovl.py objs ../src/overlays.lst | cut -d' ' -f1)
+
+# Input sections are matched by object path, as in the firmware build.
+printf '.text\n.globl %s\n%s: ret\n' "$fn" "$fn" | $AS -o "$DIR/obj/$obj"
+printf '.text\n.globl _start\n_start: call __wrap_%s\n.section .ovl_stubs, "ax"\n__wrap_%s: jmp %s\n' \
+	"$fn" "$fn" "$fn" | $AS -o "$DIR/stub.o"
+printf '.text\n.globl _start\n_start: call %s\n' "$fn" | $AS -o "$DIR/direct.o"
+
+link()
+{
+	$LD --no-warn-rwx-segments -L"$DIR" -T ../src/link.ld "$DIR/$1" "$DIR/obj/$obj" -o "$DIR/$1.elf" > "$DIR/$1.log" 2>&1
+}
+
+if ! link stub.o; then
+	cat "$DIR/stub.o.log"
+	echo "ovl_link: link through the stubs failed"
+	exit 1
+fi
+if link direct.o || ! grep -q 'prohibited cross reference' "$DIR/direct.o.log"; then
+	cat "$DIR/direct.o.log"
+	echo "ovl_link: direct call into an overlay was not refused"
+	exit 1
+fi
+echo "ovl_link: ok"
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libs/fatfs/ff.h"
+#include "libs/fatfs/diskio.h"
+#include "ramdisk.h"
+#include "host.h"
+
+#define SECTOR_SIZE 512
+#define RSVD_SECTORS 32
+
+u64 ramdisk_reads;
+u64 ramdisk_read_calls;
+u32 ramdisk_sectors;
+u32 ramdisk_cmd_ns;
+u32 ramdisk_sector_ns;
+
+static u8 *disk;
+
+static void _st16(u8 *p, u32 val)
+{
+	p[0] = val;
+	p[1] = val >> 8;
+}
+
+static void _st32(u8 *p, u32 val)
+{
+	_st16(p, val);
+	_st16(p + 2, val >> 16);
+}
+
+static void _fat32(u8 *bs, u32 clusters, u32 csize_shift, u32 part_start)
+{
+	u32 fat_sectors = ((clusters + 2) * 4 + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+	memcpy(bs, "\xEB\x58\x90" "MSDOS5.0", 11);
+	_st16(bs + 11, SECTOR_SIZE);
+	bs[13] = 1 << csize_shift;      // Sectors per cluster.
+	_st16(bs + 14, RSVD_SECTORS);
+	bs[16] = 2;                     // FATs.
+	bs[21] = 0xF8;                  // Media.
+	_st32(bs + 28, part_start);     // Hidden sectors.
+	_st32(bs + 32, ramdisk_sectors - part_start);
+	_st32(bs + 36, fat_sectors);
+	_st32(bs + 44, 2);              // Root directory cluster.
+	_st16(bs + 48, 1);              // FSInfo sector.
+	bs[66] = 0x29;
+	memcpy(bs + 71, "NO NAME    FAT32   ", 19);
+	_st16(bs + 510, 0xAA55);
+
+	// Media, EOC and the root directory cluster in both FATs.
+	for (u32 i = 0; i < 2; i++)
+	{
+		u8 *fat = bs + (RSVD_SECTORS + fat_sectors * i) * SECTOR_SIZE;
+		_st32(fat, 0x0FFFFFF8);
+		_st32(fat + 4, 0x0FFFFFFF);
+		_st32(fat + 8, 0x0FFFFFFF);
+	}
+}
+
+static void _exfat(u8 *bs, u32 clusters, u32 csize_shift, u32 part_start)
+{
+	u32 fat_sectors = ((clusters + 2) * 4 + SECTOR_SIZE - 1) / SECTOR_SIZE;
+	u32 cluster_size = SECTOR_SIZE << csize_shift;
+	u32 data_start = RSVD_SECTORS + fat_sectors;
+	// The allocation bitmap starts the heap, FatFs looks for it there.
+	u32 bitmap_size = (clusters + 7) / 8;
+	u32 bitmap_clusters = (bitmap_size + cluster_size - 1) / cluster_size;
+	u32 root = 2 + bitmap_clusters;
+
+	memcpy(bs, "\xEB\x76\x90" "EXFAT   ", 11);
+	_st32(bs + 64, part_start);
+	_st32(bs + 72, ramdisk_sectors - part_start);
+	_st32(bs + 80, RSVD_SECTORS);
+	_st32(bs + 84, fat_sectors);
+	_st32(bs + 88, data_start);
+	_st32(bs + 92, clusters);
+	_st32(bs + 96, root);
+	_st16(bs + 104, 0x100);         // Revision 1.0.
+	bs[108] = 9;                    // Bytes per sector shift.
+	bs[109] = csize_shift;
+	bs[110] = 1;                    // FATs.
+	bs[111] = 0x80;                 // Drive select.
+	_st16(bs + 510, 0xAA55);
+
+	// Bitmap chain, then the root directory cluster.
+	u8 *fat = bs + RSVD_SECTORS * SECTOR_SIZE;
+	_st32(fat, 0xFFFFFFF8);
+	_st32(fat + 4, 0xFFFFFFFF);
+	for (u32 c = 2; c < root; c++)
+		_st32(fat + c * 4, c + 1 < root ? c + 1 : 0xFFFFFFFF);
+	_st32(fat + root * 4, 0xFFFFFFFF);
+
+	u8 *heap = bs + data_start * SECTOR_SIZE;
+	for (u32 c = 0; c <= root - 2; c++)
+		heap[c / 8] |= 1 << (c % 8);
+
+	u8 *dir = heap + (root - 2) * cluster_size;
+	dir[0] = 0x81;                  // Allocation bitmap entry.
+	_st32(dir + 20, 2);
+	_st32(dir + 24, bitmap_size);
+}
+
+int ramdisk_mkfs(u32 fmt, u32 clusters, u32 csize_shift, u32 part_start)
+{
+	u32 fat_sectors = ((clusters + 2) * 4 + SECTOR_SIZE - 1) / SECTOR_SIZE;
+	u32 fats = fmt == FS_EXFAT ? 1 : 2;
+
+	free(disk);
+	disk = NULL;
+	ramdisk_sectors = 0;
+	if ((fmt != FS_FAT32 && fmt != FS_EXFAT) || (fmt == FS_FAT32 && clusters < 65526) || clusters < 16)
+		return 0;
+
+	ramdisk_sectors = part_start + RSVD_SECTORS + fat_sectors * fats + (clusters << csize_shift);
+	disk = calloc(ramdisk_sectors, SECTOR_SIZE);
+	if (!disk)
+		return 0;
+	ramdisk_reads = 0;
+	ramdisk_read_calls = 0;
+
+	if (part_start)
+	{
+		// An MBR with the volume as its first partition.
+		u8 *pte = disk + 446;
+		pte[4] = fmt == FS_EXFAT ? 0x07 : 0x0C;
+		_st32(pte + 8, part_start);
+		_st32(pte + 12, ramdisk_sectors - part_start);
+		_st16(disk + 510, 0xAA55);
+	}
+
+	if (fmt == FS_EXFAT)
+		_exfat(disk + part_start * SECTOR_SIZE, clusters, csize_shift, part_start);
+	else
+		_fat32(disk + part_start * SECTOR_SIZE, clusters, csize_shift, part_start);
+
+	return 1;
+}
+
+int ramdisk_format(u32 clusters)
+{
+	return ramdisk_mkfs(FS_FAT32, clusters < 65526 ? 65526 : clusters, 0, 0);
+}
+
+u8 *ramdisk_sector(u32 sector)
+{
+	return disk && sector < ramdisk_sectors ? disk + sector * SECTOR_SIZE : NULL;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+	return disk ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+	return disk_status(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+	if (!disk || sector >= ramdisk_sectors || count > ramdisk_sectors - sector)
+		return RES_PARERR;
+	memcpy(buff, disk + sector * SECTOR_SIZE, count * SECTOR_SIZE);
+	ramdisk_reads += count;
+	ramdisk_read_calls++;
+	host_model_ns += ramdisk_cmd_ns + (u64)count * ramdisk_sector_ns;
+	return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+	if (!disk || sector >= ramdisk_sectors || count > ramdisk_sectors - sector)
+		return RES_PARERR;
+	memcpy(disk + sector * SECTOR_SIZE, buff, count * SECTOR_SIZE);
+	return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+	switch (cmd)
+	{
+	case GET_SECTOR_COUNT:
+		*(DWORD *)buff = ramdisk_sectors;
+		break;
+	case GET_SECTOR_SIZE:
+		*(WORD *)buff = SECTOR_SIZE;
+		break;
+	case GET_BLOCK_SIZE:
+		*(DWORD *)buff = 1;
+		break;
+	}
+	return RES_OK;
+}
+
+// ffsystem.c allocates from the firmware heap.
+void *ff_memalloc(UINT msize)
+{
+	return malloc(msize);
+}
+
+void ff_memfree(void *mblock)
+{
+	free(mblock);
+}
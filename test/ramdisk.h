@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RAMDISK_H_
+#define _RAMDISK_H_
+
+#include "utils/types.h"
+
+/* Sectors read and disk_read calls since the last format, and the disk size. */
+extern u64 ramdisk_reads;
+extern u64 ramdisk_read_calls;
+extern u32 ramdisk_sectors;
+
+/*
+ * Time a disk_read() call and each sector it reads add to host_model_ns, as
+ * a command and the transfer on the SD bus. Zero until a benchmark sets it.
+ */
+extern u32 ramdisk_cmd_ns;
+extern u32 ramdisk_sector_ns;
+
+/*
+ * Replaces the SD card of diskio.c with a RAM disk holding an empty FAT32
+ * volume of more than 65525 clusters of one sector, so FatFs mounts it as
+ * FAT32. Returns 1 on success.
+ */
+int ramdisk_format(u32 clusters);
+
+/*
+ * The same for fmt FS_FAT32 or FS_EXFAT with 2^csize_shift sectors per
+ * cluster. With a part_start the volume is the first partition of an MBR.
+ */
+int ramdisk_mkfs(u32 fmt, u32 clusters, u32 csize_shift, u32 part_start);
+
+/* The sector itself, so tests can break what is on the disk. */
+u8 *ramdisk_sector(u32 sector);
+
+#endif
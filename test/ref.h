@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REF_H_
+#define _REF_H_
+
+#include "gfx/gfx.h"
+#include "utils/types.h"
+
+/*
+ * Plain reference implementations the firmware code is checked against.
+ * They are written from the specifications for clarity, not speed, and
+ * share nothing with the code under test.
+ */
+
+/* FIPS 180-4 SHA-256 compression of one 64-byte block. */
+void ref_sha256_block(u32 *h, const u8 *block);
+void ref_sha256(u8 *dst, const void *src, u32 size);
+
+/* FIPS-197 AES on a single block, in place, for 16, 24 and 32-byte keys. */
+typedef struct _ref_aes_t
+{
+	u8 rk[240];
+	u32 rounds;
+} ref_aes_t;
+
+void ref_aes_init(ref_aes_t *aes, const u8 *key, u32 size);
+void ref_aes_encrypt(const ref_aes_t *aes, u8 *block);
+void ref_aes_decrypt(const ref_aes_t *aes, u8 *block);
+
+/*
+ * Greedy LZ77 in the format of libs/compr/lz.c. dst needs room for
+ * size * 257 / 256 + 1 bytes. Returns the compressed size.
+ */
+u32 ref_lz_compress(u8 *dst, const u8 *src, u32 size);
+
+/* The per pixel console drawing gfx.c had before its glyph cache. */
+void ref_gfx_putc(gfx_con_t *con, char c);
+/* And its per pixel bitmap copies, the BMP one takes bottom up rows. */
+void ref_gfx_render_bmp_argb(gfx_ctxt_t *ctxt, const u32 *buf, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y,
+	bool transparent, u32 transparent_color);
+void ref_gfx_set_rect_argb(gfx_ctxt_t *ctxt, const u32 *buf, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y);
+/* The int counted store loop gfx_clear_color() had before memset32(). */
+void ref_gfx_clear_color(gfx_ctxt_t *ctxt, u32 color);
+
+/* Parses hex into dst, returns the number of bytes. */
+u32 ref_unhex(u8 *dst, const char *hex);
+
+#endif
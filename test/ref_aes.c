@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "ref.h"
+
+// FIPS-197 figure 7.
+static const u8 sbox[256] = {
+	0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+	0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+	0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+	0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+	0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+	0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+	0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+	0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+	0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+	0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+	0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+	0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+	0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+	0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+	0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+	0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16,
+};
+
+static u8 inv_sbox[256];
+
+static u8 _xtime(u8 x)
+{
+	return (x << 1) ^ ((x & 0x80) ? 0x1B : 0);
+}
+
+static u8 _mul(u8 a, u8 b)
+{
+	u8 res = 0;
+
+	for (; b; b >>= 1, a = _xtime(a))
+		if (b & 1)
+			res ^= a;
+	return res;
+}
+
+void ref_aes_init(ref_aes_t *aes, const u8 *key, u32 size)
+{
+	u32 nk = size / 4;
+	u32 words = 4 * (nk + 7);
+	u8 rcon = 1;
+
+	for (u32 i = 0; i < 256; i++)
+		inv_sbox[sbox[i]] = i;
+
+	aes->rounds = nk + 6;
+	memcpy(aes->rk, key, size);
+	for (u32 i = nk; i < words; i++)
+	{
+		u8 t[4];
+		memcpy(t, aes->rk + 4 * (i - 1), 4);
+		if (i % nk == 0)
+		{
+			u8 t0 = t[0];
+			t[0] = sbox[t[1]] ^ rcon;
+			t[1] = sbox[t[2]];
+			t[2] = sbox[t[3]];
+			t[3] = sbox[t0];
+			rcon = _xtime(rcon);
+		}
+		else if (nk > 6 && i % nk == 4)
+			for (int j = 0; j < 4; j++)
+				t[j] = sbox[t[j]];
+		for (int j = 0; j < 4; j++)
+			aes->rk[4 * i + j] = aes->rk[4 * (i - nk) + j] ^ t[j];
+	}
+}
+
+static void _add_round_key(u8 *s, const u8 *rk)
+{
+	for (int i = 0; i < 16; i++)
+		s[i] ^= rk[i];
+}
+
+void ref_aes_encrypt(const ref_aes_t *aes, u8 *s)
+{
+	u8 t[16];
+
+	_add_round_key(s, aes->rk);
+	for (u32 r = 1; r <= aes->rounds; r++)
+	{
+		// SubBytes and ShiftRows, the state is column major.
+		for (int i = 0; i < 16; i++)
+			t[i] = sbox[s[(i + 4 * (i % 4)) % 16]];
+		// MixColumns, skipped in the last round.
+		for (int c = 0; c < 4; c++)
+		{
+			u8 *col = t + 4 * c;
+			if (r == aes->rounds)
+				memcpy(s + 4 * c, col, 4);
+			else
+				for (int i = 0; i < 4; i++)
+					s[4 * c + i] = _mul(col[i], 2) ^ _mul(col[(i + 1) % 4], 3) ^ col[(i + 2) % 4] ^ col[(i + 3) % 4];
+		}
+		_add_round_key(s, aes->rk + 16 * r);
+	}
+}
+
+void ref_aes_decrypt(const ref_aes_t *aes, u8 *s)
+{
+	u8 t[16];
+
+	for (u32 r = aes->rounds; r >= 1; r--)
+	{
+		_add_round_key(s, aes->rk + 16 * r);
+		// InvMixColumns, skipped in the first round.
+		if (r != aes->rounds)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				u8 col[4];
+				memcpy(col, s + 4 * c, 4);
+				for (int i = 0; i < 4; i++)
+					s[4 * c + i] = _mul(col[i], 14) ^ _mul(col[(i + 1) % 4], 11) ^
+						_mul(col[(i + 2) % 4], 13) ^ _mul(col[(i + 3) % 4], 9);
+			}
+		}
+		// InvShiftRows and InvSubBytes.
+		for (int i = 0; i < 16; i++)
+			t[(i + 4 * (i % 4)) % 16] = inv_sbox[s[i]];
+		memcpy(s, t, 16);
+	}
+	_add_round_key(s, aes->rk);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gfx/gfx.h"
+#include "ref.h"
+
+// Defined in gfx/font.h, which gfx.c includes.
+extern const u8 _gfx_font[];
+
+// gfx_set_pixel() before it recorded dirty regions.
+static void _ref_gfx_pixel(gfx_ctxt_t *ctxt, u32 x, u32 y, u32 color)
+{
+	ctxt->fb[y + (ctxt->width - x) * ctxt->stride] = color;
+}
+
+void ref_gfx_putc(gfx_con_t *con, char c)
+{
+	u32 shift = 0;
+
+	if (c >= 32 && (unsigned char)c <= 175)
+	{
+		const u8 *cbuf = &_gfx_font[(CHAR_HEIGHT * CHAR_WIDTH) / 8 * ((unsigned char)c - 32)];
+		for (u32 i = 0; i < CHAR_HEIGHT * con->scale; i += con->scale)
+		{
+			for (u32 j = 0; j < CHAR_WIDTH; j++, shift++)
+			{
+				bool set = cbuf[shift >> 3] & (0x80 >> (shift & 7));
+				if (!set && !con->fillbg)
+					continue;
+				for (u32 z = 0; z < con->scale; z++)
+					for (u32 k = 0; k < con->scale; k++)
+						_ref_gfx_pixel(con->gfx_ctxt, con->x + k + j * con->scale, con->y + i + z,
+							set ? con->fgcol : con->bgcol);
+			}
+		}
+		con->x += CHAR_WIDTH * con->scale;
+	}
+	else if (c == '\n')
+	{
+		con->x = 0;
+		con->y += CHAR_HEIGHT * con->scale;
+		if (con->y > con->gfx_ctxt->height - CHAR_HEIGHT)
+			con->y = 0;
+	}
+}
+
+void ref_gfx_render_bmp_argb(gfx_ctxt_t *ctxt, const u32 *buf, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y,
+	bool transparent, u32 transparent_color)
+{
+	// Bottom up rows, one pixel at a time.
+	for (u32 y = pos_y; y < pos_y + size_y; y++)
+	{
+		for (u32 x = pos_x; x < pos_x + size_x; x++)
+		{
+			u32 color = buf[(size_y + pos_y - 1 - y) * size_x + x - pos_x];
+			if (!transparent || color != transparent_color)
+				_ref_gfx_pixel(ctxt, x, y, color);
+		}
+	}
+}
+
+void ref_gfx_set_rect_argb(gfx_ctxt_t *ctxt, const u32 *buf, u32 size_x, u32 size_y, u32 pos_x, u32 pos_y)
+{
+	for (u32 y = pos_y; y < pos_y + size_y; y++)
+		for (u32 x = pos_x; x < pos_x + size_x; x++)
+			ctxt->next[x + y * ctxt->stride] = *buf++;
+}
+
+void ref_gfx_clear_color(gfx_ctxt_t *ctxt, u32 color)
+{
+	for (int i = 0; i < ctxt->width * ctxt->stride; i++)
+		ctxt->fb[i] = color;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "ref.h"
+
+#define WINDOW 0x2000
+#define MIN_MATCH 4
+
+static u32 _put_var(u8 *dst, u32 x)
+{
+	u8 tmp[5];
+	u32 n = 0;
+
+	// Big endian groups of 7 bits, all but the last with bit 7 set.
+	do
+	{
+		tmp[n++] = x & 0x7F;
+		x >>= 7;
+	} while (x);
+	for (u32 i = 0; i < n; i++)
+		dst[i] = tmp[n - 1 - i] | (i < n - 1 ? 0x80 : 0);
+
+	return n;
+}
+
+u32 ref_lz_compress(u8 *dst, const u8 *src, u32 size)
+{
+	u32 hist[256] = { 0 };
+	u32 pos = 0, out = 1;
+	u8 marker = 0;
+
+	if (!size)
+		return 0;
+
+	for (u32 i = 0; i < size; i++)
+		hist[src[i]]++;
+	for (u32 i = 1; i < 256; i++)
+		if (hist[i] < hist[marker])
+			marker = i;
+	dst[0] = marker;
+
+	// Greedy brute force search, slow but obviously right.
+	while (pos < size)
+	{
+		u32 best_len = 0, best_off = 0;
+
+		for (u32 off = 1; off <= pos && off <= WINDOW; off++)
+		{
+			u32 len = 0;
+			while (pos + len < size && src[pos + len] == src[pos + len - off])
+				len++;
+			if (len > best_len)
+			{
+				best_len = len;
+				best_off = off;
+			}
+		}
+
+		if (best_len >= MIN_MATCH)
+		{
+			dst[out++] = marker;
+			out += _put_var(dst + out, best_len);
+			out += _put_var(dst + out, best_off);
+			pos += best_len;
+		}
+		else
+		{
+			dst[out++] = src[pos];
+			if (src[pos] == marker)
+				dst[out++] = 0;
+			pos++;
+		}
+	}
+
+	return out;
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "sec/se_t210.h"
+#include "ref.h"
+#include "se_model.h"
+#include "host.h"
+
+// Same layout as se_ll_t in se.c.
+typedef struct _se_model_ll_t
+{
+	u32 num;
+	u32 addr;
+	u32 size;
+} se_model_ll_t;
+
+#define REG(off) regs[(off) >> 2]
+
+u32 se_model_ops;
+u32 se_model_errors;
+u32 se_model_block_ns;
+
+static u32 regs[0x1000 / 4];
+static u32 keytable[TEGRA_SE_KEYSLOT_COUNT][16]; // Key words 0-7, original IV 8-11, updated IV 12-15.
+static u32 pending = ~0; // Offset of the last access, applied on the next one.
+static u64 pending_ns;    // And the time it was made at.
+static bool busy;
+static u64 busy_until;
+
+static void *_se_model_ptr(u32 addr)
+{
+	return (void *)(unsigned long)addr;
+}
+
+static u64 _se_model_reg64(u32 off)
+{
+	return REG(off) | (u64)REG(off + 4) << 32;
+}
+
+/*
+ * Hashes into SE_HASH_RESULT, from the IV on SHA_ENABLE or else from what is
+ * there. While message left stays above the input size only whole blocks are
+ * taken, the input that brings it to zero is padded with the message length.
+ */
+static int _se_model_sha(const u8 *src, u32 size)
+{
+	static const u32 iv[8] = {
+		0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+	};
+	u32 *h = &REG(SE_HASH_RESULT_REG_OFFSET);
+	u64 length = _se_model_reg64(SE_SHA_MSG_LENGTH_REG_OFFSET);
+	u64 left = _se_model_reg64(SE_SHA_MSG_LEFT_REG_OFFSET);
+	u64 bits = (u64)size << 3;
+	u8 last[128];
+	u32 i;
+
+	if (bits > left || (bits < left && (size & 0x3F)))
+		return 0;
+
+	if (REG(SE_SHA_CONFIG_REG_OFFSET) & SHA_ENABLE)
+		memcpy(h, iv, sizeof(iv));
+
+	for (i = 0; i + 64 <= size; i += 64)
+		ref_sha256_block(h, src + i);
+
+	left -= bits;
+	REG(SE_SHA_MSG_LEFT_REG_OFFSET) = left;
+	REG(SE_SHA_MSG_LEFT_REG_OFFSET + 4) = left >> 32;
+	if (left)
+		return 1;
+
+	u32 tail = size - i;
+	u32 last_size = tail < 56 ? 64 : 128;
+	memset(last, 0, sizeof(last));
+	memcpy(last, src + i, tail);
+	last[tail] = 0x80;
+	for (int j = 0; j < 8; j++)
+		last[last_size - 1 - j] = length >> (8 * j);
+	for (u32 j = 0; j < last_size; j += 64)
+		ref_sha256_block(h, last + j);
+
+	return 1;
+}
+
+static void _se_model_key(ref_aes_t *aes, u32 ks, u32 mode)
+{
+	static const u32 sizes[] = { 16, 24, 32, 16 };
+
+	ref_aes_init(aes, (const u8 *)keytable[ks], sizes[mode & 3]);
+}
+
+/*
+ * AES on SE_BLOCK_COUNT + 1 blocks. SE_CRYPTO picks the key slot, the core
+ * direction and the chaining: linear counter, CBC through the IV words of
+ * the slot, or none. Output goes to memory, clipped to the output buffer,
+ * or to the key slot of SE_CRYPTO_KEYTABLE_DST.
+ */
+static int _se_model_aes(u32 enc, u32 mode, u32 dst_sel, u8 *dst, u32 dst_size, const u8 *src, u32 src_size)
+{
+	u32 crypto = REG(SE_CRYPTO_REG_OFFSET);
+	u32 ks = (crypto >> SE_CRYPTO_KEY_INDEX_SHIFT) & 0xF;
+	u32 input = (crypto >> SE_CRYPTO_INPUT_SEL_SHIFT) & 3;
+	u32 vctram = (crypto >> SE_CRYPTO_VCTRAM_SEL_SHIFT) & 3;
+	u32 size = (REG(SE_BLOCK_COUNT_REG_OFFSET) + 1) << 4;
+	u8 *ctr = (u8 *)&REG(SE_CRYPTO_CTR_REG_OFFSET);
+	u8 *iv = (u8 *)&keytable[ks][12];
+	u8 block[16], prev[16];
+	ref_aes_t aes;
+
+	if (!src || src_size < size || ((crypto >> SE_CRYPTO_CORE_SEL_SHIFT) & 1) != enc)
+		return 0;
+	if (dst_sel == DST_KEYTAB ? size != 16 : (dst_sel != DST_MEMORY || !dst))
+		return 0;
+
+	_se_model_key(&aes, ks, mode);
+	if (((crypto >> SE_CRYPTO_IV_SEL_SHIFT) & 1) == IV_ORIGINAL)
+		memcpy(iv, &keytable[ks][8], 16);
+
+	for (u32 i = 0; i < size; i += 16)
+	{
+		memcpy(block, src + i, 16);
+		if (input == INPUT_LNR_CTR)
+		{
+			// Keystream from the counter, which counts up big endian.
+			u8 ks_block[16];
+			memcpy(ks_block, ctr, 16);
+			ref_aes_encrypt(&aes, ks_block);
+			for (int j = 0; j < 16; j++)
+				block[j] ^= ks_block[j];
+			for (int j = 15; j >= 0 && !++ctr[j]; j--)
+				;
+		}
+		else if (enc)
+		{
+			if (vctram == VCTRAM_AESOUT)
+				for (int j = 0; j < 16; j++)
+					block[j] ^= iv[j];
+			ref_aes_encrypt(&aes, block);
+			if (vctram == VCTRAM_AESOUT)
+				memcpy(iv, block, 16);
+		}
+		else
+		{
+			memcpy(prev, block, 16);
+			ref_aes_decrypt(&aes, block);
+			if (vctram == VCTRAM_PREVAHB)
+			{
+				for (int j = 0; j < 16; j++)
+					block[j] ^= iv[j];
+				memcpy(iv, prev, 16);
+			}
+		}
+
+		if (dst_sel == DST_KEYTAB)
+			memcpy(keytable[(REG(SE_CRYPTO_KEYTABLE_DST_REG_OFFSET) >> SE_KEY_INDEX_SHIFT) & 0xF], block, 16);
+		else if (i < dst_size)
+			memcpy(dst + i, block, MIN(16, dst_size - i));
+	}
+
+	return 1;
+}
+
+static void _se_model_run(u64 start)
+{
+	u32 config = REG(SE_CONFIG_REG_OFFSET);
+	se_model_ll_t *in = REG(SE_IN_LL_ADDR_REG_OFFSET) ? _se_model_ptr(REG(SE_IN_LL_ADDR_REG_OFFSET)) : NULL;
+	se_model_ll_t *out = REG(SE_OUT_LL_ADDR_REG_OFFSET) ? _se_model_ptr(REG(SE_OUT_LL_ADDR_REG_OFFSET)) : NULL;
+	const u8 *src = in ? _se_model_ptr(in->addr) : NULL;
+	u32 src_size = in ? in->size : 0;
+	u8 *dst = out ? _se_model_ptr(out->addr) : NULL;
+	u32 dst_size = out ? out->size : 0;
+	u32 dst_sel = (config >> SE_CONFIG_DST_SHIFT) & 7;
+	int res = 0;
+
+	// Error and interrupt status are write one to clear, se.c clears them before starting.
+	REG(SE_ERR_STATUS_0) = 0;
+	REG(SE_INT_STATUS_REG_OFFSET) = 0;
+	se_model_ops++;
+
+	switch ((config >> SE_CONFIG_ENC_ALG_SHIFT) & 0xF)
+	{
+	case ALG_AES_ENC:
+		res = _se_model_aes(1, config >> SE_CONFIG_ENC_MODE_SHIFT, dst_sel, dst, dst_size, src, src_size);
+		break;
+	case ALG_NOP:
+		if (((config >> SE_CONFIG_DEC_ALG_SHIFT) & 0xF) == ALG_AES_DEC)
+			res = _se_model_aes(0, config >> SE_CONFIG_DEC_MODE_SHIFT, dst_sel, dst, dst_size, src, src_size);
+		break;
+	case ALG_SHA:
+		if (dst_sel == DST_HASHREG &&
+			((config >> SE_CONFIG_ENC_MODE_SHIFT) & 0xF) == MODE_SHA256 && src)
+			res = _se_model_sha(src, src_size);
+		break;
+	}
+
+	if (!res)
+	{
+		se_model_errors++;
+		REG(SE_ERR_STATUS_0) = 1;
+		REG(SE_INT_STATUS_REG_OFFSET) |= SE_INT_ERROR(INT_SET);
+	}
+
+	busy = se_model_block_ns != 0;
+	busy_until = start + (u64)((src_size + 0xF) >> 4) * se_model_block_ns;
+	if (!busy)
+		REG(SE_INT_STATUS_REG_OFFSET) |= SE_INT_OP_DONE(INT_SET);
+}
+
+static void _se_model_apply(u32 off)
+{
+	u32 idx;
+
+	switch (off)
+	{
+	case SE_KEYTABLE_DATA0_REG_OFFSET:
+		idx = REG(SE_KEYTABLE_REG_OFFSET);
+		keytable[(idx >> SE_KEYTABLE_SLOT_SHIFT) & 0xF][idx & 0xF] = REG(off);
+		break;
+	case SE_OPERATION_REG_OFFSET:
+		if (REG(off) == SE_OPERATION(OP_START))
+		{
+			REG(off) = 0;
+			_se_model_run(pending_ns);
+		}
+		break;
+	}
+}
+
+vu32 *se_model_reg(u32 off)
+{
+	if (pending != ~0u)
+		_se_model_apply(pending);
+	pending = off;
+	pending_ns = host_model_ns;
+
+	if (busy && off == SE_INT_STATUS_REG_OFFSET)
+	{
+		if (host_model_ns >= busy_until)
+		{
+			busy = false;
+			REG(off) |= SE_INT_OP_DONE(INT_SET);
+		}
+		else
+			host_model_ns += SE_MODEL_POLL_NS;
+	}
+
+	return (vu32 *)&REG(off);
+}
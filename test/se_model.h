@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SE_MODEL_H_
+#define _SE_MODEL_H_
+
+#include "utils/types.h"
+
+/*
+ * Host model of the Security Engine registers for se.c, see shim/soc/t210.h.
+ *
+ * A register access is only seen as an address, so writes take effect on the
+ * next access: a keytable data write lands in the table and an OP_START runs
+ * the operation, which sets OP_DONE for the status read that follows.
+ * Buffers handed to the engine must be below 4GiB.
+ */
+vu32 *se_model_reg(u32 off);
+
+/*
+ * Time the engine takes per 16 byte block, zero until a benchmark sets it.
+ * With it set an operation is done that long after its OP_START on
+ * host_model_ns. Memory sees the result at once, but status reads before
+ * then find OP_DONE clear and take SE_MODEL_POLL_NS each, like the CPU
+ * polling the register.
+ */
+#define SE_MODEL_POLL_NS 100
+extern u32 se_model_block_ns;
+
+/* Operations run since the start, and the ones the model rejected. */
+extern u32 se_model_ops;
+extern u32 se_model_errors;
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Put first on the include path of ianos.c. Modules are ARM code and the
+ * loader aligns them as 32-bit addresses, so its allocations and the call
+ * into a module go to the test instead.
+ */
+
+#ifndef _SHIM_IANOS_H_
+#define _SHIM_IANOS_H_
+
+#include "../../../include/ianos/ianos.h"
+
+void *ianos_host_malloc(u32 size);
+void ianos_host_free(void *buf);
+void ianos_host_call(moduleEntrypoint_t entry, void *config, bdkParams_t params);
+
+#define malloc ianos_host_malloc
+#define free ianos_host_free
+#define entry(config, params) ianos_host_call(entry, config, params)
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Put first on the include path of drivers built against a register model,
+ * it routes their register accesses to the model instead of MMIO.
+ */
+
+#ifndef _SHIM_T210_H_
+#define _SHIM_T210_H_
+
+#include "../../../include/soc/t210.h"
+#include "se_model.h"
+
+#undef SE
+#define SE(off) (*se_model_reg(off))
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * blz.c on what tools/blz.py compressed, see fixtures/blz/gen.py, then on
+ * broken footers, truncated and mutated streams. Every buffer is sized
+ * exactly so ASan sees any access outside of it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libs/compr/blz.h"
+#include "host.h"
+
+#define FIXTURES "fixtures/blz/"
+#define FUZZ_ROUNDS 1000
+// Room past the data the fuzzed footers may ask for.
+#define SLACK 256
+
+static const char *names[] = { "text", "code", "mixed", "zeros", "small" };
+
+static u8 *_read(const char *name, const char *ext, u32 *size)
+{
+	char path[64];
+	u8 *buf = NULL;
+
+	snprintf(path, sizeof(path), FIXTURES "%s.%s", name, ext);
+	u8 *file = host_read_file(path, size);
+	CHECK(file != NULL);
+	if (file)
+	{
+		buf = malloc(*size);
+		memcpy(buf, file, *size);
+		host_free32(file, *size);
+	}
+
+	return buf;
+}
+
+static int _srcdest(const u8 *comp, u32 csize, u32 dst_size, u32 misalign, const u8 *expect, u32 size)
+{
+	u8 *in = malloc(csize);
+	u8 *out = malloc(dst_size + misalign);
+
+	memcpy(in, comp, csize);
+	memset(out, 0xCC, dst_size + misalign);
+	int res = blz_uncompress_srcdest(in, csize, out + misalign, dst_size);
+	if (expect && res)
+	{
+		CHECK(!memcmp(out + misalign, expect, size));
+		// Only the tail past the data is cleared.
+		for (u32 i = size; i < dst_size; i++)
+			CHECK(!out[misalign + i]);
+	}
+	free(out);
+	free(in);
+
+	return res;
+}
+
+static int _inplace(const u8 *comp, u32 csize, u32 buf_size, u32 misalign, const u8 *expect)
+{
+	blz_footer footer;
+	u8 *buf = malloc(buf_size + misalign);
+
+	if (!blz_get_footer(comp, csize, &footer))
+	{
+		free(buf);
+		return 0;
+	}
+	memcpy(buf + misalign, comp, csize);
+	int res = blz_uncompress_inplace(buf + misalign, csize, &footer);
+	if (expect && res)
+		CHECK(!memcmp(buf + misalign, expect, buf_size));
+	free(buf);
+
+	return res;
+}
+
+static void _fixture(const char *name)
+{
+	u32 size, csize;
+	u8 *data = _read(name, "bin", &size);
+	u8 *comp = _read(name, "blz", &csize);
+
+	if (!data || !comp)
+		return;
+
+	// Output at every alignment, so all segment copy paths run.
+	for (u32 a = 0; a < 4; a++)
+	{
+		CHECK(_inplace(comp, csize, size, a, data));
+		CHECK(_srcdest(comp, csize, size, a, data, size));
+		CHECK(_srcdest(comp, csize, size + 13, a, data, size));
+	}
+	CHECK(!_srcdest(comp, csize, size - 1, 0, NULL, size));
+
+	// Truncated streams, the footer is then read from the middle of the data.
+	for (u32 n = 0; n < csize; n += 1 + csize / 128)
+		_srcdest(comp, n, size + SLACK, 0, NULL, size);
+
+	// Mutated streams only have to stay within their buffers.
+	u8 *m = malloc(csize);
+	for (u32 r = 0; r < FUZZ_ROUNDS; r++)
+	{
+		memcpy(m, comp, csize);
+		for (u32 k = 1 + host_rand() % 4; k; k--)
+		{
+			// Mostly in the compressed stream, sometimes in the footer.
+			u32 pos = host_rand() & 7 ? host_rand() % csize : csize - 1 - host_rand() % 12;
+			m[pos] = host_rand();
+		}
+		_srcdest(m, csize, size + SLACK, host_rand() & 3, NULL, size);
+	}
+	free(m);
+
+	free(comp);
+	free(data);
+}
+
+static void _footers()
+{
+	static const struct
+	{
+		const char *name;
+		u32 cmp_and_hdr_size;
+		u32 header_size;
+		u32 addl_size;
+		int res;
+	} cases[] = {
+		{ "nothing compressed", 0, 0, 0, 1 },
+		{ "footer only", 12, 12, 0, 0 },
+		{ "header past the stream", 12, 13, 0, 0 },
+		{ "stream past the start", 17, 12, 0, 0 },
+		{ "no control byte", 12, 12, 4, 0 },
+		{ "output size overflow", 12, 12, 0xFFFFFFF8, 0 },
+	};
+	u8 in[16] = { 0xAA, 0xBB, 0xCC, 0xDD };
+
+	for (u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		blz_footer footer = { cases[i].cmp_and_hdr_size, cases[i].header_size, cases[i].addl_size };
+		memcpy(in + 4, &footer, sizeof(footer));
+		int res = _srcdest(in, sizeof(in), sizeof(in) + 8, 0, NULL, 0);
+		if (res != cases[i].res)
+			printf("%s: %d, expected %d\n", cases[i].name, res, cases[i].res);
+		CHECK(res == cases[i].res);
+	}
+
+	// The output end wraps to 8, below the size of the stream copied there.
+	blz_footer wrap = { 12, 12, 0xFFFFFFF8 };
+	memcpy(in + 4, &wrap, sizeof(wrap));
+	CHECK(!_srcdest(in, sizeof(in), 8, 0, NULL, 0));
+
+	// Too short for a footer.
+	for (u32 n = 0; n < sizeof(blz_footer); n++)
+		CHECK(!_srcdest(in, n, 64, 0, NULL, 0));
+}
+
+int main()
+{
+	_footers();
+	for (u32 i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+		_fixture(names[i]);
+
+	return host_done("test_blz");
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * elfload on the modules of fixtures/elf, written by fixtures/elf/gen.py.
+ * The words at DATA are compared after relocation, then every prefix and
+ * random mutations of the good modules are loaded under ASan.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libs/elfload/elfload.h"
+#include "host.h"
+
+#define FIXTURES "fixtures/elf/"
+
+// Layout of the fixtures, see gen.py.
+#define DATA 0x140
+#define FILE_SIZE 0x180
+#define MEM_SIZE 0x1C0
+#define FUNC 0x101
+
+#define IMG_SIZE 0x10000
+#define FUZZ_ROUNDS 5000
+
+// A word is expected to be base + val when rel is set.
+typedef struct _word_t
+{
+	u32 rel;
+	u32 val;
+} word_t;
+
+static const struct
+{
+	const char *name;
+	el_status init;
+	el_status reloc;
+	word_t words[5];
+} fixtures[] = {
+	{ "relative", EL_OK, EL_OK, { { 1, 0x10 }, { 1, 0x20 }, { 1, 0x30 }, { 1, 0x40 }, { 0, 0x55 } } },
+	{ "abs32", EL_OK, EL_OK, { { 1, FUNC + 4 }, { 0, 8 }, { 0, 0x55 } } },
+	{ "glob_dat", EL_OK, EL_OK, { { 1, FUNC }, { 0, 0 }, { 0, 0x55 } } },
+	{ "relcount_past_table", EL_OK, EL_OK, { { 1, 0x10 }, { 0, 0x20 } } },
+	{ "jump_slot", EL_OK, EL_OK, { { 1, FUNC }, { 0, 0 }, { 1, 0x10 } } },
+	{ "truncated", EL_BADFILE },
+	{ "bad_offset", EL_OK, EL_BADREL },
+	{ "bad_offset_sym", EL_OK, EL_BADREL },
+	{ "misaligned_offset", EL_OK, EL_BADREL },
+	{ "bad_table", EL_OK, EL_BADREL },
+	{ "bad_sym", EL_OK, EL_BADREL },
+	{ "no_symtab", EL_OK, EL_BADREL },
+	{ "undef_sym", EL_OK, EL_BADSYM },
+	{ "bad_type", EL_OK, EL_BADREL },
+};
+
+static u8 *_read(const char *name, u32 *size)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), FIXTURES "%s.elf", name);
+	u8 *data = host_read_file(path, size);
+	CHECK(data != NULL);
+
+	return data;
+}
+
+// Loads and relocates a copy of elf of exactly size bytes, so ASan catches over reads.
+static el_status _load(const u8 *elf, u32 size, u8 *img, el_status *init)
+{
+	u8 *copy = malloc(size ? size : 1);
+	el_ctx_t ctx;
+	el_status res;
+
+	memcpy(copy, elf, size);
+	res = el_init(&ctx, copy, size);
+	if (init)
+		*init = res;
+	if (res == EL_OK && ctx.memsz <= IMG_SIZE)
+	{
+		el_load(&ctx, img);
+		res = el_relocate(&ctx, img);
+	}
+	free(copy);
+
+	return res;
+}
+
+static void _fixtures(u8 *img)
+{
+	u32 base = (u32)img;
+
+	for (u32 i = 0; i < sizeof(fixtures) / sizeof(fixtures[0]); i++)
+	{
+		u32 size;
+		u8 *elf = _read(fixtures[i].name, &size);
+		el_status init, res;
+
+		memset(img, 0xCC, IMG_SIZE);
+		res = _load(elf, size, img, &init);
+		if (init != fixtures[i].init || (init == EL_OK && res != fixtures[i].reloc))
+			printf("%s: el_init %d, el_relocate %d\n", fixtures[i].name, init, res);
+		CHECK(init == fixtures[i].init);
+		if (init != EL_OK)
+			goto next;
+		CHECK(res == fixtures[i].reloc);
+		if (res != EL_OK)
+			goto next;
+
+		// bss cleared, nothing written past the image.
+		for (u32 j = FILE_SIZE; j < MEM_SIZE; j++)
+			CHECK(img[j] == 0);
+		CHECK(img[MEM_SIZE] == 0xCC);
+
+		const u32 *words = (const u32 *)&img[DATA];
+		for (u32 j = 0; j < 5; j++)
+		{
+			const word_t *w = &fixtures[i].words[j];
+			if (!w->rel && !w->val)
+				continue;
+			if (words[j] != (w->rel ? base : 0) + w->val)
+				printf("%s: word %u is %08X\n", fixtures[i].name, j, words[j] - (w->rel ? base : 0));
+			CHECK(words[j] == (w->rel ? base : 0) + w->val);
+		}
+
+	next:
+		host_free32(elf, size);
+	}
+}
+
+static void _header_checks()
+{
+	u32 size;
+	u8 *elf = _read("relative", &size);
+	el_ctx_t ctx;
+
+	CHECK(el_init(&ctx, elf, size) == EL_OK);
+	CHECK(ctx.memsz == MEM_SIZE && ctx.align == 0x10 && ctx.dyn_vaddr == 0x78);
+	CHECK(el_init(&ctx, elf + 4, size - 4) == EL_NOTELF);
+
+	elf[0x12] = 62; // e_machine, x86-64.
+	CHECK(el_init(&ctx, elf, size) == EL_WRONGARCH);
+	elf[0x12] = 40;
+	elf[0x10] = 2; // e_type, ET_EXEC.
+	CHECK(el_init(&ctx, elf, size) == EL_WRONGARCH);
+	elf[0x10] = 3;
+	elf[0x2C] = 0xFF; // e_phnum.
+	CHECK(el_init(&ctx, elf, size) == EL_BADFILE);
+	elf[0x2C] = 2;
+	CHECK(el_init(&ctx, elf, size) == EL_OK);
+
+	host_free32(elf, size);
+}
+
+static void _truncate_and_fuzz(u8 *img)
+{
+	for (u32 i = 0; i < sizeof(fixtures) / sizeof(fixtures[0]); i++)
+	{
+		if (fixtures[i].init != EL_OK || fixtures[i].reloc != EL_OK)
+			continue;
+
+		u32 size;
+		u8 *elf = _read(fixtures[i].name, &size);
+		u8 *mut = malloc(size);
+		el_status init;
+
+		for (u32 n = 0; n < size; n++)
+		{
+			_load(elf, n, img, &init);
+			CHECK(init != EL_OK);
+		}
+
+		for (u32 r = 0; r < FUZZ_ROUNDS; r++)
+		{
+			memcpy(mut, elf, size);
+			for (u32 k = 1 + host_rand() % 4; k; k--)
+				mut[host_rand() % size] = host_rand();
+			_load(mut, size, img, NULL);
+		}
+
+		free(mut);
+		host_free32(elf, size);
+	}
+}
+
+int main()
+{
+	u8 *img = host_alloc32(IMG_SIZE);
+
+	_fixtures(img);
+	_header_checks();
+	_truncate_and_fuzz(img);
+
+	host_free32(img, IMG_SIZE);
+
+	return host_done("test_elfload");
+}
@@ -0,0 +1,653 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * ffro.c against FatFs on FAT32 and exFAT RAM disks FatFs filled: short
+ * and long names, deep paths, directories over many clusters and files
+ * fragmented by interleaved writes. Then on broken boot sectors, FATs and
+ * directory entries, where it only has to stay within its buffers.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libs/fatfs/ff.h"
+#include "libs/fatfs/ffro.h"
+#include "host.h"
+#include "ramdisk.h"
+
+#define FILE_MAX (192 * 1024)
+#define MANY_FILES 100
+#define CONTIG_FILES 40
+#define FUZZ_ROUNDS 1000
+
+typedef struct _volume_t
+{
+	const char *name;
+	u32 fmt;
+	u32 clusters;
+	u32 csize_shift;
+	u32 part_start;
+} volume_t;
+
+static const volume_t volumes[] = {
+	{ "FAT32", FS_FAT32, 65526, 0, 0 },
+	{ "FAT32, 4 sector clusters, MBR", FS_FAT32, 65526, 2, 2048 },
+	{ "exFAT", FS_EXFAT, 8192, 0, 0 },
+	{ "exFAT, 8 sector clusters, MBR", FS_EXFAT, 4096, 3, 2048 },
+};
+
+typedef struct _file_t
+{
+	const char *path;
+	u32 size;
+} file_t;
+
+static const file_t files[] = {
+	{ "/SHORT.TXT", 100 },
+	{ "/payload.bin", 70000 },
+	{ "/empty.bin", 0 },
+	{ "/A Long File Name With Spaces.bin", 3000 },
+	{ "/bootloader/payloads/hekate_ctcaer_4.2.bin", 98304 },
+	{ "/bootloader/payloads/Fusee-Primary.bin", 513 },
+	{ "/bootloader/sys/libsys_lp0.bso", 512 },
+	// Only has an SFN alias FFRO can match.
+	{ "/many/caf\x82.bin", 10 },
+};
+
+static FATFS fs;
+static ffro_t ro;
+static const char *volume;
+// FatFs reads past the end of the path it is given.
+static char path[512];
+
+static u8 _byte(const char *name, u32 i)
+{
+	u32 h = 0x811C9DC5;
+	for (const char *p = name; *p; p++)
+		h = (h ^ (u8)*p) * 0x01000193;
+	h ^= i * 0x9E3779B1;
+	return h ^ (h >> 15) ^ (h >> 24);
+}
+
+static int _write(FIL *fp, const char *name, u32 from, u32 size)
+{
+	u8 buf[512];
+	UINT bw;
+
+	while (size)
+	{
+		u32 n = size < sizeof(buf) ? size : sizeof(buf);
+		for (u32 i = 0; i < n; i++)
+			buf[i] = _byte(name, from + i);
+		if (f_write(fp, buf, n, &bw) != FR_OK || bw != n)
+			return 0;
+		from += n;
+		size -= n;
+	}
+
+	return 1;
+}
+
+static int _create(const char *name, u32 size)
+{
+	FIL fp;
+
+	// Parent directories first.
+	strcpy(path, name);
+	for (char *p = path + 1; *p; p++)
+	{
+		if (*p != '/')
+			continue;
+		*p = 0;
+		FRESULT res = f_mkdir(path);
+		if (res != FR_OK && res != FR_EXIST)
+			return 0;
+		*p = '/';
+	}
+
+	if (f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return 0;
+	int ok = _write(&fp, name, 0, size);
+	return f_close(&fp) == FR_OK && ok;
+}
+
+// Two files written a cluster and a half at a time, so their chains interleave.
+static int _fragment(const char *a, const char *b, u32 size)
+{
+	FIL fa, fb;
+	u32 chunk = fs.csize * 512 * 3 / 2;
+
+	// Both in one directory, next to each other.
+	strcpy(path, a);
+	*strrchr(path, '/') = 0;
+	FRESULT res = f_mkdir(path);
+	if (res != FR_OK && res != FR_EXIST)
+		return 0;
+	strcpy(path, a);
+	if (f_open(&fa, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return 0;
+	strcpy(path, b);
+	if (f_open(&fb, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return 0;
+
+	int ok = 1;
+	for (u32 pos = 0; pos < size && ok; pos += chunk)
+	{
+		u32 n = size - pos < chunk ? size - pos : chunk;
+		ok = _write(&fa, a, pos, n) && _write(&fb, b, pos, n);
+	}
+
+	return f_close(&fa) == FR_OK && f_close(&fb) == FR_OK && ok;
+}
+
+static const char *_many(u32 i)
+{
+	static char name[64];
+
+	// Long and short names, so LFN entry runs cross sectors and clusters.
+	if (i & 1)
+		sprintf(name, "/many/f%03u.bin", i);
+	else
+		sprintf(name, "/many/A longer name for file number %03u.bin", i);
+	return name;
+}
+
+// cmp_lfn of FatFs R0.13b misses FAT32 names of FF_MAX_LFN, one less is the longest both open.
+static const char *_longest()
+{
+	static char name[300];
+
+	strcpy(name, "/bootloader/payloads/");
+	u32 len = strlen(name);
+	for (u32 i = 0; i < FF_MAX_LFN - 5; i++)
+		name[len + i] = 'a' + i % 26;
+	strcpy(name + len + FF_MAX_LFN - 5, ".bin");
+	return name;
+}
+
+static const char *_contig(u32 i)
+{
+	static char name[64];
+
+	sprintf(name, "/contig/Empty file with a long name %02u.bin", i);
+	return name;
+}
+
+static int _fill()
+{
+	for (u32 i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+		if (!_create(files[i].path, files[i].size))
+			return 0;
+	for (u32 i = 0; i < MANY_FILES; i++)
+		if (!_create(_many(i), i * 37))
+			return 0;
+	if (!_create("/many/zz.bin", 1) || !_create(_longest(), 1234))
+		return 0;
+	if (!_create("/craft/SFN.BIN", 10) || !_create("/craft/Long File Name.bin", 20))
+		return 0;
+	// Empty files, nothing is allocated between the directory's clusters.
+	for (u32 i = 0; i < CONTIG_FILES; i++)
+		if (!_create(_contig(i), 0))
+			return 0;
+
+	return _fragment("/frag/one.bin", "/frag/Second Fragmented File.bin", FILE_MAX);
+}
+
+// Reads through both, compares with what was written.
+static void _compare(const char *name, const char *as)
+{
+	FIL fp;
+	FILINFO fno;
+	ffro_file_t fo;
+	UINT br;
+
+	strcpy(path, name);
+	if (f_stat(path, &fno) != FR_OK)
+	{
+		printf("%s: %s not found by FatFs\n", volume, name);
+		CHECK(0);
+		return;
+	}
+	u32 size = fno.fsize;
+
+	FRESULT res = ffro_open(&ro, &fo, as);
+	if (res != FR_OK || fo.size != size)
+	{
+		printf("%s: %s: ffro_open %d, size %u, expected %u\n", volume, as, res, fo.size, size);
+		CHECK(0);
+		return;
+	}
+
+	u8 *ff_buf = malloc(size + 1);
+	u8 *ro_buf = malloc(size + 1);
+	CHECK(f_open(&fp, path, FA_READ) == FR_OK);
+	CHECK(f_read(&fp, ff_buf, size, &br) == FR_OK && br == size);
+	f_close(&fp);
+
+	// Whole, then prefixes around sector and cluster ends.
+	u32 cluster = 512 << ro.csize_shift;
+	u32 sizes[] = { size, 1, 511, 512, 513, cluster - 1, cluster, cluster + 1, size - 1 };
+	for (u32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		if (sizes[i] > size)
+			continue;
+		u8 *buf = malloc(sizes[i] + 1);
+		CHECK(ffro_read(&ro, &fo, buf, sizes[i]) == FR_OK);
+		if (memcmp(buf, ff_buf, sizes[i]))
+		{
+			printf("%s: %s: %u bytes read differently\n", volume, as, sizes[i]);
+			CHECK(0);
+		}
+		free(buf);
+	}
+	CHECK(ffro_read(&ro, &fo, ro_buf, size + 1) == FR_INVALID_PARAMETER);
+
+	for (u32 i = 0; i < size; i++)
+	{
+		if (ff_buf[i] != _byte(name, i))
+		{
+			printf("%s: %s: byte %u wrong through FatFs\n", volume, name, i);
+			CHECK(0);
+			break;
+		}
+	}
+
+	free(ro_buf);
+	free(ff_buf);
+}
+
+static void _lookups()
+{
+	static const struct
+	{
+		const char *path;
+		FRESULT res;
+	} cases[] = {
+		{ "/nope.bin", FR_NO_FILE },
+		{ "/SHORT.TX", FR_NO_FILE },
+		{ "/SHORT.TXTX", FR_NO_FILE },
+		{ "/SHORT.TXT/x", FR_NO_PATH },
+		{ "/bootloader", FR_NO_FILE },
+		{ "/bootloader/payloads/", FR_NO_FILE },
+		{ "/", FR_NO_FILE },
+		{ "/nope/payload.bin", FR_NO_FILE },
+		{ "/many/caf\x82.bin", FR_INVALID_NAME },
+		{ "/A Long File Name With Spaces.bi", FR_NO_FILE },
+		{ "/A Long File Name With Spaces.binx", FR_NO_FILE },
+	};
+	ffro_file_t fo;
+	char name[300];
+
+	for (u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		FRESULT res = ffro_open(&ro, &fo, cases[i].path);
+		if (res != cases[i].res)
+			printf("%s: %s: %d, expected %d\n", volume, cases[i].path, res, cases[i].res);
+		CHECK(res == cases[i].res);
+	}
+
+	// A component longer than any name.
+	memset(name, 'a', sizeof(name) - 1);
+	name[0] = '/';
+	name[sizeof(name) - 1] = 0;
+	CHECK(ffro_open(&ro, &fo, name) == FR_INVALID_NAME);
+}
+
+static u32 _dir_cluster(const char *name)
+{
+	DIR dir;
+
+	strcpy(path, name);
+	CHECK(f_opendir(&dir, path) == FR_OK);
+	u32 clst = dir.obj.sclust ? dir.obj.sclust : fs.dirbase;
+	f_closedir(&dir);
+
+	return clst;
+}
+
+static u32 _clst2sect(u32 clst)
+{
+	return fs.database + (clst - 2) * fs.csize;
+}
+
+// Contiguous clusters take one disk_read, a FAT sector in the cache none.
+static void _read_calls()
+{
+	ffro_file_t fo;
+	u8 *buf = malloc(70000);
+
+	CHECK(ffro_open(&ro, &fo, "/payload.bin") == FR_OK && fo.size == 70000);
+	u64 calls = ramdisk_read_calls;
+	CHECK(ffro_read(&ro, &fo, buf, fo.size) == FR_OK);
+	// Up to two FAT sectors, the run, and the partial last sector.
+	CHECK(ramdisk_read_calls - calls <= 4);
+
+	// Only as much of the chain as needed is walked.
+	CHECK(ffro_read(&ro, &fo, buf, 1) == FR_OK);
+	u64 reads = ramdisk_reads;
+	CHECK(ffro_read(&ro, &fo, buf, 1) == FR_OK);
+	CHECK(ramdisk_reads - reads == 1);
+
+	free(buf);
+}
+
+// Boot sectors ffro_mount has to turn down.
+static void _bpb(const volume_t *vol)
+{
+	static const struct
+	{
+		u32 fmt;
+		const char *name;
+		u32 off;
+		u32 size;
+		u32 val;
+	} cases[] = {
+		{ 0, "no signature", 510, 2, 0 },
+		{ FS_FAT32, "not FAT32", 82, 1, 'X' },
+		{ FS_FAT32, "1024 byte sectors", 11, 2, 1024 },
+		{ FS_FAT32, "no sectors per cluster", 13, 1, 0 },
+		{ FS_FAT32, "3 sectors per cluster", 13, 1, 3 },
+		{ FS_FAT32, "FATs past the volume", 36, 4, 0x01000000 },
+		{ FS_FAT32, "root cluster 1", 44, 4, 1 },
+		{ FS_FAT32, "root cluster past the FAT", 44, 4, 0x0FFFFFFF },
+		{ FS_EXFAT, "not exFAT", 3, 1, 'X' },
+		{ FS_EXFAT, "1024 byte sectors", 108, 1, 10 },
+		{ FS_EXFAT, "2^17 sectors per cluster", 109, 1, 17 },
+		{ FS_EXFAT, "root cluster 1", 96, 4, 1 },
+		{ FS_EXFAT, "root cluster past the FAT", 96, 4, 0xFFFFFFF0 },
+	};
+	u8 *vbr = ramdisk_sector(vol->part_start);
+	u8 save[512];
+
+	memcpy(save, vbr, sizeof(save));
+	for (u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		if (cases[i].fmt && cases[i].fmt != vol->fmt)
+			continue;
+		for (u32 b = 0; b < cases[i].size; b++)
+			vbr[cases[i].off + b] = cases[i].val >> (b * 8);
+		FRESULT res = ffro_mount(&ro);
+		if (res != FR_NO_FILESYSTEM || ro.fs_type)
+		{
+			printf("%s: %s: %d\n", volume, cases[i].name, res);
+			CHECK(0);
+		}
+		memcpy(vbr, save, sizeof(save));
+	}
+
+	// A partition table pointing next to the volume.
+	if (vol->part_start)
+	{
+		u8 *mbr = ramdisk_sector(0);
+		mbr[454]++;
+		CHECK(ffro_mount(&ro) == FR_NO_FILESYSTEM);
+		mbr[454]--;
+	}
+
+	CHECK(ffro_mount(&ro) == FR_OK);
+}
+
+// FatFs and ffro both find the file, or both don't.
+static void _agree(const char *what, const char *name, int found)
+{
+	FILINFO fno;
+	ffro_file_t fo;
+
+	// FatFs still holds the sector as it was.
+	f_mount(&fs, "", 1);
+	strcpy(path, name);
+	FRESULT res = f_stat(path, &fno);
+	FRESULT ro_res = ffro_open(&ro, &fo, name);
+	if ((res == FR_OK) != found || (ro_res == FR_OK) != found)
+	{
+		printf("%s: %s: %s FatFs %d, ffro %d\n", volume, what, name, res, ro_res);
+		CHECK(0);
+	}
+}
+
+// Directory entries FatFs doesn't write, in the first sector of /craft.
+static void _craft(const volume_t *vol)
+{
+	u8 *d = ramdisk_sector(_clst2sect(_dir_cluster("/craft")));
+	u8 save[512];
+
+	memcpy(save, d, sizeof(save));
+	if (vol->fmt == FS_FAT32)
+	{
+		// ".", "..", SFN.BIN, two LFN entries and LONGFI~1.BIN.
+		CHECK(!memcmp(d + 2 * 32, "SFN     BIN", 11) && d[3 * 32] == 0x42 && d[4 * 32] == 0x01 &&
+			!memcmp(d + 5 * 32, "LONGFI~1BIN", 11) && !d[6 * 32]);
+
+		d[5 * 32 + 7] = '2';
+		_agree("LFN checksum", "/craft/Long File Name.bin", 0);
+		_agree("LFN checksum", "/craft/LONGFI~2.BIN", 1);
+		memcpy(d, save, sizeof(save));
+
+		d[4 * 32 + 13]++;
+		_agree("LFN entries of two names", "/craft/Long File Name.bin", 0);
+		_agree("LFN entries of two names", "/craft/LONGFI~1.BIN", 1);
+		memcpy(d, save, sizeof(save));
+
+		d[2 * 32 + 11] |= 0x08;
+		_agree("volume label", "/craft/SFN.BIN", 0);
+		memcpy(d, save, sizeof(save));
+
+		memcpy(d + 6 * 32, d + 5 * 32, 32);
+		d[5 * 32] = 0xE5;
+		_agree("deleted entry after the LFN", "/craft/Long File Name.bin", 0);
+		_agree("deleted entry after the LFN", "/craft/LONGFI~1.BIN", 1);
+		memcpy(d, save, sizeof(save));
+	}
+	else
+	{
+		// SFN.BIN in 85 C0 C1, Long File Name.bin in 85 C0 C1 C1.
+		CHECK(d[0] == 0x85 && d[1] == 2 && d[3 * 32] == 0x85 && d[3 * 32 + 1] == 3 &&
+			d[6 * 32] == 0xC1 && !d[7 * 32]);
+
+		d[1 * 32 + 28] = 1;
+		_agree("4GiB file", "/craft/SFN.BIN", 0);
+		memcpy(d, save, sizeof(save));
+
+		d[3 * 32 + 1] = 2;
+		_agree("set without the end of the name", "/craft/Long File Name.bin", 0);
+		memcpy(d, save, sizeof(save));
+
+		memmove(d + 6 * 32, d + 5 * 32, 64);
+		d[5 * 32] &= 0x7F;
+		_agree("deleted entry in the set", "/craft/Long File Name.bin", 0);
+		memcpy(d, save, sizeof(save));
+	}
+
+	_agree("restored", "/craft/Long File Name.bin", 1);
+}
+
+// A directory chain that loops back to its start has to end the lookup.
+static void _loop(const char *name)
+{
+	ffro_file_t fo;
+	u32 start = _dir_cluster(name);
+	u32 clst = start;
+	u8 *entry;
+	while (1)
+	{
+		entry = ramdisk_sector(fs.fatbase + clst / 128) + clst % 128 * 4;
+		u32 next = entry[0] | entry[1] << 8 | entry[2] << 16 | (u32)entry[3] << 24;
+		if (fs.fs_type == FS_FAT32)
+			next &= 0x0FFFFFFF;
+		if (next < 2 || next >= fs.n_fatent)
+			break;
+		clst = next;
+	}
+	u8 save[4];
+	memcpy(save, entry, 4);
+
+	// No end of directory entry either, the free ones are marked deleted.
+	u32 size = fs.csize * 512;
+	u8 *last = ramdisk_sector(_clst2sect(clst));
+	u8 *last_save = malloc(size);
+	memcpy(last_save, last, size);
+	for (u32 i = 0; i < size; i += 32)
+		if (!last[i])
+			last[i] = fs.fs_type == FS_FAT32 ? 0xE5 : 0x05;
+
+	entry[0] = start;
+	entry[1] = start >> 8;
+	entry[2] = start >> 16;
+	entry[3] = start >> 24;
+
+	char missing[64];
+	sprintf(missing, "%s/missing.bin", name);
+	u64 start_ns = host_time_ns();
+	CHECK(ffro_open(&ro, &fo, missing) != FR_OK);
+	CHECK(host_time_ns() - start_ns < 2000000000ull);
+	memcpy(entry, save, 4);
+	memcpy(last, last_save, size);
+	free(last_save);
+}
+
+static void _volume(const volume_t *vol)
+{
+	FILINFO fno;
+	ffro_t unmounted = { 0 };
+	ffro_file_t fo;
+
+	CHECK(ffro_open(&unmounted, &fo, "/SHORT.TXT") == FR_NOT_ENABLED);
+
+	CHECK(ramdisk_mkfs(vol->fmt, vol->clusters, vol->csize_shift, vol->part_start));
+	CHECK(f_mount(&fs, "", 1) == FR_OK);
+	CHECK(fs.fs_type == vol->fmt);
+	CHECK(_fill());
+	CHECK(ffro_mount(&ro) == FR_OK);
+	CHECK(ro.fs_type == (vol->fmt == FS_EXFAT ? FFRO_EXFAT : FFRO_FAT32));
+
+	for (u32 i = 0; i < sizeof(files) / sizeof(files[0]) - 1; i++)
+		_compare(files[i].path, files[i].path);
+	for (u32 i = 0; i < MANY_FILES; i++)
+		_compare(_many(i), _many(i));
+	_compare("/many/zz.bin", "/many/zz.bin");
+	_compare(_longest(), _longest());
+	_compare("/frag/one.bin", "/frag/one.bin");
+	_compare("/frag/Second Fragmented File.bin", "/frag/Second Fragmented File.bin");
+	for (u32 i = 0; i < CONTIG_FILES; i++)
+		_compare(_contig(i), _contig(i));
+
+	// The second file starts within the first, so both have a FAT chain.
+	ffro_file_t two;
+	CHECK(ffro_open(&ro, &fo, "/frag/one.bin") == FR_OK && !fo.contig);
+	CHECK(ffro_open(&ro, &two, "/frag/Second Fragmented File.bin") == FR_OK && !two.contig);
+	CHECK(two.sclust > fo.sclust && two.sclust < fo.sclust + (FILE_MAX >> 9 >> ro.csize_shift));
+	if (vol->fmt == FS_EXFAT)
+	{
+		DIR dir;
+		CHECK(ffro_open(&ro, &fo, "/payload.bin") == FR_OK && fo.contig);
+		strcpy(path, "/contig");
+		CHECK(f_opendir(&dir, path) == FR_OK && dir.obj.stat == 2 && dir.obj.objsize > fs.csize * 512);
+		f_closedir(&dir);
+	}
+
+	// Other cases and separators, and the SFN aliases on FAT32.
+	_compare("/bootloader/payloads/hekate_ctcaer_4.2.bin", "\\BOOTLOADER\\Payloads\\HEKATE_CTCAER_4.2.BIN");
+	_compare("/payload.bin", "//Payload.BIN/");
+	if (vol->fmt == FS_FAT32)
+	{
+		char alias[64];
+		strcpy(path, "/A Long File Name With Spaces.bin");
+		CHECK(f_stat(path, &fno) == FR_OK);
+		sprintf(alias, "/%s", fno.altname);
+		_compare("/A Long File Name With Spaces.bin", alias);
+		strcpy(path, "/many/caf\x82.bin");
+		CHECK(f_stat(path, &fno) == FR_OK);
+		sprintf(alias, "/many/%s", fno.altname);
+		_compare("/many/caf\x82.bin", alias);
+	}
+
+	_lookups();
+	_read_calls();
+	_bpb(vol);
+	_craft(vol);
+	_loop("");
+	_loop("/many");
+}
+
+static void _fuzz(const volume_t *vol)
+{
+	static const char *const paths[] = {
+		"/payload.bin", "/bootloader/payloads/hekate_ctcaer_4.2.bin", "/frag/one.bin", "/many/zz.bin", "/nope.bin"
+	};
+	// Sectors holding what ffro_mount and ffro_open parse.
+	const u32 targets[] = {
+		vol->part_start,
+		fs.fatbase,
+		_clst2sect(_dir_cluster("/")),
+		_clst2sect(_dir_cluster("/bootloader")),
+		_clst2sect(_dir_cluster("/bootloader/payloads")),
+		_clst2sect(_dir_cluster("/many")),
+		_clst2sect(_dir_cluster("/frag")),
+	};
+	struct
+	{
+		u8 *p;
+		u8 val;
+	} undo[8];
+	ffro_file_t fo;
+
+	host_seed(vol->clusters + vol->csize_shift);
+	for (u32 r = 0; r < FUZZ_ROUNDS; r++)
+	{
+		u32 n = 1 + host_rand() % 8;
+		for (u32 k = 0; k < n; k++)
+		{
+			u32 t = host_rand() % (sizeof(targets) / sizeof(targets[0]));
+			// Mostly the fields at the start of the boot sector.
+			u32 off = t || host_rand() & 1 ? host_rand() % 512 : host_rand() % 120;
+			undo[k].p = ramdisk_sector(targets[t] + (t ? host_rand() % fs.csize : 0)) + off;
+			undo[k].val = *undo[k].p;
+			*undo[k].p = host_rand() & 3 ? host_rand() : *undo[k].p ^ (1 << host_rand() % 8);
+		}
+
+		if (ffro_mount(&ro) == FR_OK)
+		{
+			for (u32 i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+			{
+				if (ffro_open(&ro, &fo, paths[i]) != FR_OK || fo.size > FILE_MAX)
+					continue;
+				u8 *buf = malloc(fo.size);
+				ffro_read(&ro, &fo, buf, fo.size);
+				free(buf);
+			}
+		}
+
+		while (n--)
+			*undo[n].p = undo[n].val;
+	}
+
+	// Everything is back as it was.
+	CHECK(ffro_mount(&ro) == FR_OK);
+	_compare("/frag/one.bin", "/frag/one.bin");
+}
+
+int main()
+{
+	for (u32 i = 0; i < sizeof(volumes) / sizeof(volumes[0]); i++)
+	{
+		volume = volumes[i].name;
+		_volume(&volumes[i]);
+		_fuzz(&volumes[i]);
+	}
+
+	return host_done("test_ffro");
+}
@@ -0,0 +1,670 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * gfx.c on a host framebuffer, against the per pixel drawing it replaced.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gfx/gfx.h"
+#include "libs/fatfs/ff.h"
+#include "utils/util.h"
+#include "fb_model.h"
+#include "host.h"
+#include "ramdisk.h"
+#include "ref.h"
+
+static gfx_ctxt_t ctxt, ref;
+
+static u32 _buf_size()
+{
+	// Row 0 of the console is x = width, one row past the buffer.
+	return (FB_WIDTH + 1) * FB_STRIDE * 4;
+}
+
+static void _con(void)
+{
+	gfx_con_t con, ref_con;
+
+	memset(ctxt.fb, 0, _buf_size());
+	memset(ref.fb, 0, _buf_size());
+	gfx_con_init(&con, &ctxt);
+	gfx_con_init(&ref_con, &ref);
+
+	// More color pairs than glyph sets, so sets get replaced while in use.
+	for (u32 i = 0; i < 6000; i++)
+	{
+		char c = 32 + host_rand() % 144;
+		if (!(host_rand() % 40))
+			c = '\n';
+		if (!(i % 150))
+		{
+			con.scale = 1 + host_rand() % 3;
+			con.fillbg = host_rand() & 1;
+			con.fgcol = 0xFF000000 | host_rand() % 3 * 0x7F7F7F;
+			con.bgcol = 0xFF000000 | host_rand() % 6;
+		}
+		if (con.x + CHAR_WIDTH * con.scale > FB_WIDTH)
+			con.x = 0;
+		if (con.y + CHAR_HEIGHT * con.scale > FB_HEIGHT)
+			con.y = 0;
+
+		ref_con.x = con.x;
+		ref_con.y = con.y;
+		ref_con.scale = con.scale;
+		ref_con.fillbg = con.fillbg;
+		ref_con.fgcol = con.fgcol;
+		ref_con.bgcol = con.bgcol;
+		gfx_putc(&con, c);
+		ref_gfx_putc(&ref_con, c);
+		CHECK(con.x == ref_con.x && con.y == ref_con.y);
+	}
+
+	CHECK(!memcmp(ctxt.fb, ref.fb, _buf_size()));
+}
+
+#define TRANSPARENT 0xFF1D1919
+
+static void _blit(void)
+{
+	u32 *img = host_alloc32(FB_HEIGHT * FB_HEIGHT * 4);
+
+	for (u32 i = 0; i < 200; i++)
+	{
+		// Sizes off the 16 pixel tiles, positions anywhere they fit.
+		u32 size_x = 1 + host_rand() % (i < 100 ? 40 : FB_HEIGHT);
+		u32 size_y = 1 + host_rand() % (i < 100 ? 40 : FB_HEIGHT);
+		u32 pos_x = 1 + host_rand() % (FB_WIDTH - size_x);
+		u32 pos_y = host_rand() % (FB_HEIGHT - size_y + 1);
+		u32 mode = host_rand() % 4;
+
+		for (u32 j = 0; j < size_x * size_y; j++)
+			img[j] = host_rand() % 3 ? 0xFF000000 | host_rand() : TRANSPARENT;
+
+		switch (mode)
+		{
+		case 0:
+			gfx_render_bmp_argb(&ctxt, img, size_x, size_y, pos_x, pos_y);
+			ref_gfx_render_bmp_argb(&ref, img, size_x, size_y, pos_x, pos_y, true, TRANSPARENT);
+			break;
+		case 1:
+			gfx_blit(&ctxt, img + (size_y - 1) * size_x, -(int)size_x, size_x, size_y, pos_x, pos_y);
+			ref_gfx_render_bmp_argb(&ref, img, size_x, size_y, pos_x, pos_y, false, 0);
+			break;
+		default:
+			// Framebuffer orientation, into the back buffer.
+			pos_x = host_rand() % (FB_STRIDE - size_x + 1);
+			size_y = MIN(size_y, FB_WIDTH);
+			pos_y = host_rand() % (FB_WIDTH - size_y + 1);
+			gfx_set_rect_argb(&ctxt, img, size_x, size_y, pos_x, pos_y);
+			ref_gfx_set_rect_argb(&ref, img, size_x, size_y, pos_x, pos_y);
+			break;
+		}
+	}
+
+	CHECK(!memcmp(ctxt.fb, ref.fb, _buf_size()));
+	CHECK(!memcmp(ctxt.next, ref.next, _buf_size()));
+	host_free32(img, FB_HEIGHT * FB_HEIGHT * 4);
+}
+
+static bool _in_rects(const gfx_rect_t *rects, u32 num, u32 row, u32 col)
+{
+	for (u32 i = 0; i < num; i++)
+		if (row >= rects[i].row0 && row < rects[i].row1 && col >= rects[i].col0 && col < rects[i].col1)
+			return true;
+	return false;
+}
+
+/*
+ * Random frames of drawing into both buffers, then a swap. What changed in
+ * the back buffer has to be in the dirty regions and copied to the new back
+ * buffer, what was drawn into the shown buffer has to stay in it.
+ */
+static void _dirty(void)
+{
+	u32 size = FB_WIDTH * FB_STRIDE * 4;
+	u32 *n0 = host_alloc32(size), *n1 = host_alloc32(size), *f1 = host_alloc32(size);
+	u32 *img = host_alloc32(200 * 200 * 4);
+	gfx_rect_t rects[GFX_DIRTY_MAX];
+	gfx_con_t con;
+
+	gfx_con_init(&con, &ctxt);
+	gfx_swap_buffer(&ctxt);
+
+	for (u32 frame = 0; frame < 60; frame++)
+	{
+		bool front_only = frame % 4 == 0;
+
+		memcpy(n0, ctxt.next, size);
+		for (u32 op = 0; op < 1 + host_rand() % 12; op++)
+		{
+			u32 sx = 1 + host_rand() % 200, sy = 1 + host_rand() % 200;
+			u32 x = 1 + host_rand() % (FB_WIDTH - sx), y = host_rand() % (FB_HEIGHT - sy);
+
+			for (u32 i = 0; i < sx * sy; i++)
+				img[i] = 0xFF000000 | host_rand();
+
+			switch (host_rand() % (front_only ? 4 : 9))
+			{
+			case 0:
+				con.x = 1 + x % (FB_WIDTH - 10 * CHAR_WIDTH * 2);
+				con.y = y % (FB_HEIGHT - CHAR_HEIGHT * 2);
+				gfx_puts(&con, "Dragonboot");
+				break;
+			case 1:
+				gfx_blit(&ctxt, img, sx, sx, sy, x, y);
+				break;
+			case 2:
+				gfx_set_pixel(&ctxt, x, y, img[0]);
+				gfx_line(&ctxt, x, y, x + sx - 1, y + sy - 1, img[1]);
+				break;
+			case 3:
+				if (!(host_rand() % 8))
+					gfx_clear_color(&ctxt, img[0]);
+				break;
+			case 4:
+			case 5:
+				gfx_set_rect_argb(&ctxt, img, sy, sx, y, x);
+				break;
+			case 6:
+				gfx_set_rect_grey(&ctxt, (const u8 *)img, sy, sx, y, x);
+				break;
+			case 7:
+				gfx_clear_partial_grey(&ctxt, host_rand(), x, sx);
+				break;
+			default:
+				if (!(host_rand() % 8))
+					gfx_clear_grey(&ctxt, host_rand());
+				break;
+			}
+		}
+
+		u32 num = ctxt.dirty_num;
+		u32 *back = ctxt.next;
+		memcpy(rects, ctxt.dirty, sizeof(rects));
+		memcpy(n1, ctxt.next, size);
+		memcpy(f1, ctxt.fb, size);
+
+		u32 missed = 0, wrong = 0;
+		for (u32 row = 0; row < FB_WIDTH; row++)
+			for (u32 col = 0; col < FB_STRIDE; col++)
+				if (n1[row * FB_STRIDE + col] != n0[row * FB_STRIDE + col] && !_in_rects(rects, num, row, col))
+					missed++;
+		CHECK(!missed);
+
+		gfx_swap_buffer(&ctxt);
+		CHECK(ctxt.fb == back && fb_model.active == back);
+		for (u32 row = 0; row < FB_WIDTH; row++)
+			for (u32 col = 0; col < FB_STRIDE; col++)
+				if (ctxt.next[row * FB_STRIDE + col] != (_in_rects(rects, num, row, col) ? n1 : f1)[row * FB_STRIDE + col])
+					wrong++;
+		CHECK(!wrong);
+		if (front_only)
+			CHECK(!num && !ctxt.last_sync_bytes && ctxt.last_draw_bytes);
+	}
+
+	host_free32(img, 200 * 200 * 4);
+	host_free32(f1, size);
+	host_free32(n1, size);
+	host_free32(n0, size);
+}
+
+// Grey levels from 0x80 up fill the top byte too.
+static void _grey(void)
+{
+	static const u8 levels[] = { 0x00, 0x7F, 0x80, 0xFF };
+
+	for (u32 i = 0; i < sizeof(levels); i++)
+	{
+		u32 word = levels[i] * 0x01010101u;
+
+		gfx_clear_grey(&ctxt, levels[i]);
+		CHECK(ctxt.next[0] == word && ctxt.next[FB_WIDTH * FB_STRIDE - 1] == word);
+		gfx_clear_partial_grey(&ctxt, ~levels[i], 100, 2);
+		CHECK(ctxt.next[100 * FB_STRIDE] == ~word && ctxt.next[102 * FB_STRIDE - 1] == ~word);
+		CHECK(ctxt.next[100 * FB_STRIDE - 1] == word && ctxt.next[102 * FB_STRIDE] == word);
+		gfx_set_rect_grey(&ctxt, &levels[i], 1, 1, 5, 7);
+		CHECK(ctxt.next[5 + 7 * FB_STRIDE] == word);
+	}
+}
+
+// Larger than one GFX_BMP_CHUNK in gfx.c at 24 and 32 bits.
+#define BMP_MAX_W 701
+#define BMP_MAX_H 301
+
+typedef struct _bmp_case_t
+{
+	u32 info_size;
+	u32 bpp;
+	u32 compression;
+	u32 masks[4];
+	u32 num_masks;
+	u32 offset;
+	u32 width;
+	s32 height; // Negative for top down rows.
+	bool drawn;
+} bmp_case_t;
+
+// The pixels of the last file made, bottom up as ref_gfx_render_bmp_argb() takes them.
+static u32 *bmp_pixels;
+
+static void _put_u32(u8 *p, u32 v)
+{
+	memcpy(p, &v, 4);
+}
+
+// Masks are put at 54, as they follow or sit in the info header.
+static u32 _bmp_make(u8 *bmp, const bmp_case_t *c)
+{
+	u32 rows = c->height < 0 ? 0 - (u32)c->height : (u32)c->height;
+	u32 row_size = ALIGN(c->width * c->bpp / 8, 4);
+	u32 offset = c->offset ? c->offset : 14 + MAX(c->info_size, 40 + c->num_masks * 4);
+	u32 size = offset + row_size * rows;
+
+	memset(bmp, 0, size);
+	bmp[0] = 'B';
+	bmp[1] = 'M';
+	_put_u32(bmp + 2, size);
+	_put_u32(bmp + 10, offset);
+	_put_u32(bmp + 14, c->info_size);
+	_put_u32(bmp + 18, c->width);
+	_put_u32(bmp + 22, (u32)c->height);
+	bmp[26] = 1;
+	bmp[28] = c->bpp;
+	_put_u32(bmp + 30, c->compression);
+	for (u32 i = 0; i < c->num_masks; i++)
+		_put_u32(bmp + 54 + i * 4, c->masks[i]);
+
+	for (u32 y = 0; y < rows; y++)
+	{
+		u32 *row = &bmp_pixels[(c->height < 0 ? rows - 1 - y : y) * c->width];
+		for (u32 x = 0; x < c->width; x++)
+		{
+			row[x] = 0xFF000000 | host_rand();
+			memcpy(bmp + offset + y * row_size + x * c->bpp / 8, &row[x], c->bpp / 8);
+		}
+	}
+
+	return size;
+}
+
+static bool _bmp_drawn(u8 *bmp, u32 size, const bmp_case_t *c, bool file)
+{
+	// FatFs looks one byte past the end of the path.
+	static char path[16] = "test.bmp";
+	u32 rows = c->height < 0 ? 0 - (u32)c->height : (u32)c->height;
+	u32 pos_x = 1 + (FB_WIDTH - 1 - c->width) / 2, pos_y = (FB_HEIGHT - rows) / 2;
+	bool drawn;
+
+	memset(ctxt.fb, 0, FB_WIDTH * FB_STRIDE * 4);
+	if (file)
+	{
+		FIL fp;
+		UINT bw;
+		CHECK(f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+		CHECK(f_write(&fp, bmp, size, &bw) == FR_OK && bw == size);
+		f_close(&fp);
+		gfx_render_bmp_arg_file(&ctxt, path, 1, 0, FB_WIDTH - 1, FB_HEIGHT);
+	}
+	else
+		gfx_render_bmp_arg_bitmap(&ctxt, bmp, 1, 0, FB_WIDTH - 1, FB_HEIGHT);
+
+	drawn = ctxt.fb[0] != 0;
+	if (drawn)
+	{
+		// The background is the first pixel in the file.
+		gfx_clear_color(&ref, bmp_pixels[c->height < 0 ? (rows - 1) * c->width : 0]);
+		ref_gfx_render_bmp_argb(&ref, bmp_pixels, c->width, rows, pos_x, pos_y, true, TRANSPARENT);
+		CHECK(!memcmp(ctxt.fb, ref.fb, FB_WIDTH * FB_STRIDE * 4));
+	}
+
+	return drawn;
+}
+
+/*
+ * 24 and 32-bit files, bottom up and top down, some over several chunks.
+ * 32-bit BMP files are drawn as they are, so BI_BITFIELDS is only taken
+ * with the standard masks, alpha optional.
+ */
+static void _bmp(void)
+{
+	static const bmp_case_t cases[] = {
+		{ 40, 32, 0, { 0 }, 0, 0, 37, 23, true },
+		{ 40, 32, 0, { 0 }, 0, 0, 37, -23, true },
+		{ 40, 24, 0, { 0 }, 0, 0, 37, 23, true },
+		{ 40, 24, 0, { 0 }, 0, 0, 37, -23, true },
+		{ 40, 24, 0, { 0 }, 0, 0, BMP_MAX_W, BMP_MAX_H, true },
+		{ 40, 24, 0, { 0 }, 0, 0, BMP_MAX_W, -BMP_MAX_H, true },
+		{ 40, 32, 0, { 0 }, 0, 0, BMP_MAX_W, BMP_MAX_H, true },
+		{ 40, 32, 0, { 0 }, 0, 0, BMP_MAX_W, -BMP_MAX_H, true },
+		{ 40, 32, 3, { 0xFF0000, 0xFF00, 0xFF }, 3, 0, 37, 23, true },
+		{ 40, 32, 3, { 0xFF, 0xFF00, 0xFF0000 }, 3, 0, 37, 23, false },
+		{ 40, 32, 3, { 0xF800, 0x7E0, 0x1F }, 3, 0, 37, 23, false },
+		{ 40, 32, 3, { 0xFF0000, 0xFF00, 0xFF }, 3, 54, 37, 23, false },
+		{ 40, 24, 3, { 0xFF0000, 0xFF00, 0xFF }, 3, 0, 37, 23, false },
+		{ 40, 32, 1, { 0 }, 0, 0, 37, 23, false },
+		{ 56, 32, 3, { 0xFF0000, 0xFF00, 0xFF, 0xFF000000 }, 4, 0, 37, 23, true },
+		{ 56, 32, 3, { 0xFF0000, 0xFF00, 0xFF, 0 }, 4, 0, 37, 23, true },
+		{ 56, 32, 3, { 0xFF0000, 0xFF00, 0xFF, 0xFF }, 4, 0, 37, 23, false },
+		{ 124, 32, 3, { 0xFF0000, 0xFF00, 0xFF, 0xFF000000 }, 4, 0, 37, 23, true },
+		{ 124, 32, 3, { 0xFF0000, 0xFF00, 0xFF, 0xFF000000 }, 4, 0, BMP_MAX_W, -BMP_MAX_H, true },
+		{ 124, 32, 3, { 0xFF0000, 0xFF00, 0xFF00, 0xFF000000 }, 4, 0, 37, 23, false },
+	};
+	u32 bmp_size = 256 + BMP_MAX_W * BMP_MAX_H * 4;
+	u8 *bmp = host_alloc32(bmp_size);
+	FATFS fs;
+
+	bmp_pixels = malloc(BMP_MAX_W * BMP_MAX_H * 4);
+	CHECK(ramdisk_format(0) && f_mount(&fs, "", 1) == FR_OK);
+
+	for (u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		u32 size = _bmp_make(bmp, &cases[i]);
+		bool mem = _bmp_drawn(bmp, size, &cases[i], false);
+		bool file = _bmp_drawn(bmp, size, &cases[i], true);
+		if (mem != cases[i].drawn || file != cases[i].drawn)
+			printf("bmp case %u: drawn %d from memory, %d from file\n", i, mem, file);
+		CHECK(mem == cases[i].drawn && file == cases[i].drawn);
+	}
+
+	// Files too short for a header, or for their pixels.
+	for (u32 size = 0; size < 70; size += 7)
+		CHECK(!_bmp_drawn(bmp, size, &cases[0], true));
+	CHECK(!_bmp_drawn(bmp, _bmp_make(bmp, &cases[4]) - 1, &cases[4], true));
+
+	f_mount(NULL, "", 0);
+	free(bmp_pixels);
+	host_free32(bmp, bmp_size);
+}
+
+#define SPLASH_BMP "build/splash.bmp"
+#define SPLASH_BIN "build/splash.bin"
+
+static u32 _splash_file(const u8 *splash, u32 size)
+{
+	static char path[16] = "splash.bin";
+	FIL fp;
+	UINT bw;
+
+	CHECK(f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+	CHECK(f_write(&fp, splash, size, &bw) == FR_OK && bw == size);
+	f_close(&fp);
+
+	memset(ctxt.next, 0, FB_WIDTH * FB_STRIDE * 4);
+	return gfx_render_splash_file(&ctxt, path);
+}
+
+/*
+ * What tools/splash.py makes of a BMP, decoded by gfx_render_splash_file(),
+ * against gfx_render_splash() drawing the BMP itself. That one clears the
+ * front buffer to the first pixel, so the back buffer starts out with it.
+ */
+static void _splash(void)
+{
+	static const bmp_case_t cases[] = {
+		{ 40, 32, 0, { 0 }, 0, 0, FB_HEIGHT, FB_WIDTH, true },
+		{ 40, 32, 0, { 0 }, 0, 0, 301, FB_WIDTH, true },
+		{ 40, 32, 0, { 0 }, 0, 0, FB_HEIGHT, 200, true },
+		{ 40, 32, 0, { 0 }, 0, 0, 33, 57, true },
+	};
+	u32 bmp_size = 54 + FB_WIDTH * FB_HEIGHT * 4;
+	u8 *bmp = host_alloc32(bmp_size);
+	FATFS fs;
+
+	bmp_pixels = malloc(FB_WIDTH * FB_HEIGHT * 4);
+	CHECK(ramdisk_format(0) && f_mount(&fs, "", 1) == FR_OK);
+
+	for (u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		u32 size = _bmp_make(bmp, &cases[i]), splash_size;
+		FILE *f = fopen(SPLASH_BMP, "wb");
+		CHECK(f && fwrite(bmp, 1, size, f) == size);
+		fclose(f);
+		CHECK(!system("python3 ../tools/splash.py " SPLASH_BMP " " SPLASH_BIN " > /dev/null"));
+		u8 *splash = host_read_file(SPLASH_BIN, &splash_size);
+		CHECK(splash != NULL);
+		if (!splash)
+			continue;
+
+		memset32(ref.next, bmp_pixels[0], FB_WIDTH * FB_STRIDE * 4);
+		gfx_render_splash(&ref, bmp);
+		CHECK(_splash_file(splash, splash_size));
+		if (memcmp(ctxt.next, ref.next, FB_WIDTH * FB_STRIDE * 4))
+			printf("splash %ux%u differs\n", cases[i].width, cases[i].height);
+		CHECK(!memcmp(ctxt.next, ref.next, FB_WIDTH * FB_STRIDE * 4));
+
+		// Truncated streams and headers.
+		CHECK(!_splash_file(splash, splash_size - 1));
+		CHECK(!_splash_file(splash, splash_size / 2));
+		CHECK(!_splash_file(splash, sizeof(gfx_splash_hdr_t) - 1));
+		// A whole stream, but a row short of the header.
+		gfx_splash_hdr_t *hdr = (gfx_splash_hdr_t *)splash;
+		if (hdr->rows < FB_WIDTH)
+		{
+			hdr->rows++;
+			CHECK(!_splash_file(splash, splash_size));
+			hdr->rows--;
+		}
+		hdr->stride++;
+		CHECK(!_splash_file(splash, splash_size));
+
+		host_free32(splash, splash_size);
+	}
+
+	f_mount(NULL, "", 0);
+	free(bmp_pixels);
+	host_free32(bmp, bmp_size);
+}
+
+#define RING_STRIDE 1536
+// Console y along the scroll, rebased when the end gets near.
+#define TAPE 4096
+
+/*
+ * The ring console against a plain one drawing down an endless tape. The
+ * tape scrolls up like a terminal: lines go to the next free y, a line that
+ * would not fit in what is left of the ring starts a new ring length, and
+ * the screen shows the last FB_HEIGHT pixels cleared for lines.
+ */
+typedef struct _ring_ref_t
+{
+	gfx_ctxt_t tape;
+	gfx_con_t con;
+	u32 len;  // Ring length.
+	u32 base; // Tape y of ring y 0.
+	u32 y;    // Ring y of the current line.
+	u32 end;  // Tape y cleared up to.
+	u32 top;  // Tape y at the top of the screen.
+	u32 wraps, splits, scrolls;
+} ring_ref_t;
+
+static void _ring_ref_clear(ring_ref_t *r, u32 y0, u32 y1)
+{
+	for (u32 row = 0; row <= FB_WIDTH; row++)
+		for (u32 y = y0; y < y1; y++)
+			r->tape.fb[row * TAPE + y] = r->con.bgcol;
+}
+
+static void _ring_ref_line(ring_ref_t *r, u32 len)
+{
+	if (r->y + len > r->len)
+	{
+		r->splits += r->y < r->len;
+		r->wraps++;
+		_ring_ref_clear(r, r->end, r->base + r->len);
+		r->end = r->base + r->len;
+		r->base += r->len;
+		r->y = 0;
+	}
+	if (r->base + r->y + len > r->end)
+	{
+		_ring_ref_clear(r, r->end, r->base + r->y + len);
+		r->end = r->base + r->y + len;
+	}
+	if (r->end - r->top > FB_HEIGHT)
+	{
+		r->scrolls++;
+		r->top = r->end - FB_HEIGHT;
+	}
+
+	// Drop what scrolled off.
+	if (r->end + 2 * r->len > TAPE)
+	{
+		for (u32 row = 0; row <= FB_WIDTH; row++)
+			memmove(&r->tape.fb[row * TAPE], &r->tape.fb[row * TAPE + r->top], (TAPE - r->top) * 4);
+		r->base -= r->top;
+		r->end -= r->top;
+		r->top = 0;
+	}
+}
+
+static void _ring_ref_enable(ring_ref_t *r, const gfx_con_t *con)
+{
+	u32 line = CHAR_HEIGHT * con->scale;
+
+	r->con = *con;
+	r->con.gfx_ctxt = &r->tape;
+	r->len = (FB_HEIGHT + line - 1) / line * line;
+	r->base = 0;
+	r->y = 0;
+	r->end = 0;
+	r->top = 0;
+	_ring_ref_clear(r, 0, r->len);
+}
+
+static void _ring_ref_putc(ring_ref_t *r, const gfx_con_t *con, char c)
+{
+	u32 line = CHAR_HEIGHT * con->scale;
+
+	r->con.scale = con->scale;
+	r->con.fillbg = con->fillbg;
+	r->con.fgcol = con->fgcol;
+	r->con.bgcol = con->bgcol;
+	if (c == '\n')
+	{
+		r->con.x = 0;
+		r->y = MIN(r->y + line, r->len);
+		_ring_ref_line(r, line);
+		return;
+	}
+
+	_ring_ref_line(r, line);
+	r->con.y = r->base + r->y;
+	ref_gfx_putc(&r->con, c);
+}
+
+static bool _ring_screen_ok(const ring_ref_t *r, u32 *screen)
+{
+	fb_model_screen(screen);
+	for (u32 row = 0; row < FB_WIDTH; row++)
+		if (memcmp(&screen[row * FB_HEIGHT], &r->tape.fb[row * TAPE + r->top], FB_HEIGHT * 4))
+			return false;
+
+	return true;
+}
+
+static void _ring(void)
+{
+	static ring_ref_t r;
+	gfx_ctxt_t ring;
+	gfx_con_t con;
+	u32 *screen = malloc(FB_WIDTH * FB_HEIGHT * 4);
+	u32 top_wraps = 0, last_top = 0;
+
+	// Too narrow a stride for two copies of the screen.
+	gfx_con_init(&con, &ctxt);
+	CHECK(!gfx_con_ring(&con, true) && !con.ring);
+
+	// Not through gfx_init_ctxt(), the tape is never shown.
+	r.tape.fb = malloc((FB_WIDTH + 1) * TAPE * 4);
+	r.tape.width = FB_WIDTH;
+	r.tape.height = FB_HEIGHT;
+	r.tape.stride = TAPE;
+
+	fb_model_init(&ring, RING_STRIDE);
+	gfx_con_init(&con, &ring);
+
+	for (u32 i = 0; i < 20000; i++)
+	{
+		u32 step = host_rand() % 1000;
+		if (!i || step < 3)
+		{
+			// Enabled at one scale, so later lines of another don't divide the ring.
+			con.scale = 1 + host_rand() % 3;
+			con.bgcol = 0xFF000000 | host_rand() % 6;
+			CHECK(gfx_con_ring(&con, true));
+			CHECK(fb_model.offset == 0 && fb_model.stride == RING_STRIDE);
+			_ring_ref_enable(&r, &con);
+			last_top = 0;
+		}
+		else if (step < 15)
+		{
+			con.scale = 1 + host_rand() % 3;
+			con.fillbg = host_rand() & 1;
+			con.fgcol = 0xFF000000 | host_rand();
+			con.bgcol = 0xFF000000 | host_rand() % 6;
+		}
+
+		// Runs of empty lines scroll a screen at a time, else long lines.
+		u32 count = step < 25 ? 1 + host_rand() % 30 : 1;
+		for (u32 j = 0; j < count; j++)
+		{
+			char c = 32 + host_rand() % 144;
+			if (step < 25 || !(host_rand() % 60) || con.x + CHAR_WIDTH * con.scale > FB_WIDTH)
+				c = '\n';
+			gfx_putc(&con, c);
+			_ring_ref_putc(&r, &con, c);
+			CHECK(con.y == r.y);
+			CHECK(fb_model.offset == con.ring_top && con.ring_top == (r.top - r.base + 2 * r.len) % r.len);
+		}
+
+		top_wraps += con.ring_top < last_top;
+		last_top = con.ring_top;
+		if (!(i % 16) || step < 25)
+			CHECK(_ring_screen_ok(&r, screen));
+	}
+	CHECK(_ring_screen_ok(&r, screen));
+
+	// Each path was taken: ring wraps, lines split at its end, scrolls and the top wrapping around.
+	CHECK(r.wraps > 100 && r.splits > 10 && r.scrolls > 1000 && top_wraps > 100);
+
+	CHECK(gfx_con_ring(&con, false) && !con.ring && fb_model.offset == 0);
+
+	free(r.tape.fb);
+	free(screen);
+	fb_model_end(&ring);
+}
+
+int main()
+{
+	fb_model_init(&ref, FB_STRIDE);
+	fb_model_init(&ctxt, FB_STRIDE);
+
+	_con();
+	_blit();
+	_dirty();
+	_grey();
+	_bmp();
+	_splash();
+	_ring();
+
+	fb_model_end(&ctxt);
+	fb_model_end(&ref);
+
+	return host_done("test_gfx");
+}
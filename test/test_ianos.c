@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * ianos_loader() on the fixtures of fixtures/elf, read from the RAM disk.
+ * KEEP_IN_RAM modules are loaded once: later calls reuse the entry point
+ * without reading the card. Everything else is freed after its call or its
+ * failure. shim/ianos/ianos.h routes the allocations and the module calls
+ * of ianos.c here.
+ */
+
+#include <string.h>
+
+#include "ianos/ianos.h"
+#include "libs/fatfs/ff.h"
+#include "ramdisk.h"
+#include "host.h"
+
+#define FIXTURES "fixtures/elf/"
+// Layout of the fixtures, see gen.py.
+#define ENTRY 0x21
+#define DATA 0x140
+#define IANOS_CACHE_MAX 8
+#define ALLOCS_MAX 64
+
+// What main.c and heap.c define.
+gfx_ctxt_t g_gfx_ctxt;
+gfx_con_t g_gfx_con;
+heap_t _heap;
+
+static struct
+{
+	void *buf;
+	u32 size;
+} allocs[ALLOCS_MAX];
+static u32 allocs_num;
+
+// FatFs reads past the end of the path it is given.
+static char path_buf[64];
+
+static u32 mounts;
+static u32 calls;
+static moduleEntrypoint_t called;
+static void *called_config;
+
+void *ianos_host_malloc(u32 size)
+{
+	CHECK(allocs_num < ALLOCS_MAX);
+	if (allocs_num == ALLOCS_MAX)
+		return NULL;
+
+	void *buf = host_alloc32(size);
+	allocs[allocs_num].buf = buf;
+	allocs[allocs_num++].size = size;
+	return buf;
+}
+
+void ianos_host_free(void *buf)
+{
+	if (!buf)
+		return;
+
+	for (u32 i = 0; i < allocs_num; i++)
+	{
+		if (allocs[i].buf == buf)
+		{
+			host_free32(buf, allocs[i].size);
+			allocs[i] = allocs[--allocs_num];
+			return;
+		}
+	}
+	printf("free of %p, which wasn't allocated\n", buf);
+	CHECK(0);
+}
+
+void ianos_host_call(moduleEntrypoint_t module, void *config, bdkParams_t params)
+{
+	calls++;
+	called = module;
+	called_config = config;
+	CHECK(params->gfxCon == &g_gfx_con && params->gfxCtx == &g_gfx_ctxt && params->sharedHeap == &_heap);
+
+	// The module is still in place, relocated.
+	u8 *base = (u8 *)module - ENTRY;
+	u32 word;
+	memcpy(&word, base + DATA, 4);
+	CHECK(word == (u32)(unsigned long)base + 0x10);
+}
+
+bool sd_mount()
+{
+	mounts++;
+	return true;
+}
+
+// Paths of the same length collide, so the loader has to compare them as well.
+u32 crc32c(const void *buf, u32 len)
+{
+	return len;
+}
+
+static char *_path(const char *path)
+{
+	memset(path_buf, 0, sizeof(path_buf));
+	strcpy(path_buf, path);
+	return path_buf;
+}
+
+static int _write(const char *path, const char *fixture)
+{
+	char name[64];
+	FIL fp;
+	UINT bw;
+	u32 size;
+
+	snprintf(name, sizeof(name), FIXTURES "%s.elf", fixture);
+	u8 *data = host_read_file(name, &size);
+	if (!data || f_open(&fp, _path(path), FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+	{
+		host_free32(data, size);
+		return 0;
+	}
+	int res = f_write(&fp, data, size, &bw) == FR_OK && bw == size;
+	res = f_close(&fp) == FR_OK && res;
+	host_free32(data, size);
+
+	return res;
+}
+
+// Loads path, returns the result with the number of card reads and of allocations left.
+static int _load(const char *path, elfType_t type, u64 *reads, int *kept)
+{
+	u64 start_reads = ramdisk_read_calls;
+	u32 start_allocs = allocs_num;
+	char *buf = _path(path);
+
+	called = NULL;
+	int res = ianos_loader(true, buf, type, buf);
+	if (!res)
+		CHECK(called_config == buf);
+
+	*reads = ramdisk_read_calls - start_reads;
+	*kept = (int)allocs_num - (int)start_allocs;
+	return res;
+}
+
+static void _keep()
+{
+	char path[32];
+	u64 reads;
+	int kept;
+
+	CHECK(_write("keep.elf", "relative"));
+
+	u32 start_mounts = mounts;
+	CHECK(!_load("keep.elf", DRAM_LIB | KEEP_IN_RAM, &reads, &kept));
+	moduleEntrypoint_t first = called;
+	CHECK(first != NULL && reads && kept == 2); // The image and the path.
+	CHECK(mounts == start_mounts + 1);
+
+	// Cached by path, the file isn't needed any more.
+	CHECK(f_unlink(_path("keep.elf")) == FR_OK);
+	for (u32 i = 0; i < 2; i++)
+	{
+		CHECK(!_load("keep.elf", DRAM_LIB | KEEP_IN_RAM, &reads, &kept));
+		CHECK(called == first && !reads && !kept);
+	}
+	CHECK(mounts == start_mounts + 1);
+
+	// Once cached the type doesn't matter.
+	CHECK(!_load("keep.elf", DRAM_LIB, &reads, &kept));
+	CHECK(called == first && !reads && !kept);
+
+	// The cache takes IANOS_CACHE_MAX modules, then they are freed like any other.
+	for (u32 i = 1; i <= IANOS_CACHE_MAX; i++)
+	{
+		snprintf(path, sizeof(path), "keep%u.elf", i);
+		CHECK(_write(path, "relative"));
+		CHECK(!_load(path, EXEC_ELF | KEEP_IN_RAM, &reads, &kept));
+		CHECK(called != NULL && called != first && reads);
+		CHECK(kept == (i < IANOS_CACHE_MAX ? 2 : 0));
+	}
+}
+
+static void _free()
+{
+	u64 reads;
+	int kept;
+
+	CHECK(_write("lib.elf", "relative"));
+	for (u32 i = 0; i < 2; i++)
+	{
+		CHECK(!_load("lib.elf", i ? EXEC_ELF : DRAM_LIB, &reads, &kept));
+		CHECK(called != NULL && reads && !kept);
+	}
+
+	// Modules that fail to load or relocate are freed too.
+	static const char *const bad[] = { "truncated", "bad_offset", "undef_sym" };
+	for (u32 i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+	{
+		CHECK(_write("bad.elf", bad[i]));
+		u32 start_calls = calls;
+		CHECK(_load("bad.elf", DRAM_LIB | KEEP_IN_RAM, &reads, &kept) == 1);
+		CHECK(calls == start_calls && !kept);
+		// Nor are they cached.
+		CHECK(_load("bad.elf", DRAM_LIB | KEEP_IN_RAM, &reads, &kept) == 1);
+		CHECK(calls == start_calls && reads && !kept);
+	}
+
+	// AArch64 modules fail before the card is read, missing files after it.
+	CHECK(_load("lib.elf", DR64_LIB, &reads, &kept) == 1);
+	CHECK(!reads && !kept);
+	CHECK(_load("none.elf", DRAM_LIB, &reads, &kept) == 1);
+	CHECK(!kept);
+}
+
+int main()
+{
+	static FATFS fs;
+
+	CHECK(ramdisk_format(65526));
+	CHECK(f_mount(&fs, "", 1) == FR_OK);
+
+	_free();
+	_keep();
+	_free();
+
+	return host_done("test_ianos");
+}
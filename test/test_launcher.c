@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * launch_payload() on plain payloads, which take the ffro path, and on CTR
+ * and CBC encrypted ones, which FatFs reads and the SE decrypts in place.
+ * Payloads it has to refuse must be refused before anything is loaded.
+ */
+
+#include <string.h>
+
+#include "libs/fatfs/ff.h"
+#include "sec/keyslot.h"
+#include "sec/se.h"
+#include "utils/fs_utils.h"
+#include "utils/util.h"
+#include "launcher_env.h"
+#include "host.h"
+
+#define PATH   "payload.bin"
+#define FILL   0xA5
+#define FILE_MAX (sizeof(launcher_enc_hdr_t) + LAUNCHER_PAYLOAD_MAX + 0x20)
+
+static const u32 sizes[] = { 4, 5, 0x10, 0x3F1, 0x10000, 0x10001, 0x1FFF0, LAUNCHER_PAYLOAD_MAX };
+static u8 seed[0x10];
+
+static u8 *_payload()
+{
+	return (u8 *)(unsigned long)LAUNCHER_PAYLOAD_ADDR;
+}
+
+static void _launch(const u8 *data, u32 size)
+{
+	u32 reloc_size = 0;
+
+	memset(_payload(), FILL, LAUNCHER_PAYLOAD_MAX);
+	if (!launcher_env_launch(PATH, &reloc_size))
+	{
+		printf("0x%X byte payload not launched: %s\n", size, launcher_env_msg);
+		CHECK(0);
+		return;
+	}
+	CHECK(reloc_size == ALIGN(size, 0x10));
+	CHECK(!memcmp(_payload(), data, size));
+
+	u32 last;
+	memcpy(&last, data + size - sizeof(u32), sizeof(u32));
+	CHECK(launcher_env_magic == (byte_swap_32(last)));
+}
+
+static void _refuse(const char *msg)
+{
+	u32 reloc_size;
+
+	memset(_payload(), FILL, LAUNCHER_PAYLOAD_MAX);
+	CHECK(!launcher_env_launch(PATH, &reloc_size));
+	CHECK(!strcmp(launcher_env_msg, msg));
+	for (u32 i = 0; i < LAUNCHER_PAYLOAD_MAX; i++)
+	{
+		if (_payload()[i] != FILL)
+		{
+			printf("refused payload loaded, byte 0x%X\n", i);
+			CHECK(_payload()[i] == FILL);
+			break;
+		}
+	}
+}
+
+static void _plain(const u8 *data)
+{
+	for (u32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		CHECK(launcher_env_write(PATH, data, sizes[i]));
+		_launch(data, sizes[i]);
+	}
+
+	// The relocator is handed the last word.
+	for (u32 size = 0; size < sizeof(u32); size++)
+	{
+		CHECK(launcher_env_write(PATH, data, size));
+		_refuse("payload too small!\n");
+	}
+
+	CHECK(launcher_env_write(PATH, data, LAUNCHER_PAYLOAD_MAX + 1));
+	_refuse("payload too large!\n");
+}
+
+static void _encrypted(const u8 *data, u8 *file, u32 mode)
+{
+	launcher_enc_hdr_t *hdr = (launcher_enc_hdr_t *)file;
+	u32 file_size;
+
+	for (u32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		file_size = launcher_env_encrypt(file, mode, seed, data, sizes[i]);
+		CHECK(file_size);
+		CHECK(launcher_env_write(PATH, file, file_size));
+		_launch(data, sizes[i]);
+	}
+
+	// Sizes the header may not claim, with valid data behind it.
+	file_size = launcher_env_encrypt(file, mode, seed, data, 0x100);
+	static const u32 bad_sizes[] = { 0, 1, 2, 3, 0x101 };
+	for (u32 i = 0; i < sizeof(bad_sizes) / sizeof(bad_sizes[0]); i++)
+	{
+		hdr->size = bad_sizes[i];
+		CHECK(launcher_env_write(PATH, file, file_size));
+		_refuse("Invalid encrypted payload!\n");
+	}
+
+	hdr->size = 0x100;
+	hdr->mode = 2;
+	CHECK(launcher_env_write(PATH, file, file_size));
+	_refuse("Invalid encrypted payload!\n");
+
+	// CBC data is whole blocks, CTR data any length.
+	hdr->mode = mode;
+	hdr->size = 0x100 - 1;
+	CHECK(launcher_env_write(PATH, file, file_size - 1));
+	if (mode == LAUNCHER_ENC_CBC)
+		_refuse("Invalid encrypted payload!\n");
+	else
+		_launch(data, 0x100 - 1);
+
+	file_size = launcher_env_encrypt(file, mode, seed, data, LAUNCHER_PAYLOAD_MAX + 1);
+	CHECK(launcher_env_write(PATH, file, file_size));
+	_refuse("Invalid encrypted payload!\n");
+}
+
+int main()
+{
+	u8 sbk[0x10];
+
+	CHECK(launcher_env_init(FS_FAT32, 65526, 0));
+	if (!g_sd_mounted)
+		return host_done("test_launcher");
+
+	for (u32 i = 0; i < 0x10; i++)
+	{
+		sbk[i] = host_rand();
+		seed[i] = host_rand();
+	}
+	se_aes_key_set(KEYSLOT_SBK, sbk, 0x10);
+
+	u8 *data = host_alloc32(LAUNCHER_PAYLOAD_MAX + 1);
+	u8 *file = host_alloc32(FILE_MAX);
+	for (u32 i = 0; i < LAUNCHER_PAYLOAD_MAX + 1; i++)
+		data[i] = host_rand();
+
+	_plain(data);
+	_encrypted(data, file, LAUNCHER_ENC_CTR);
+	_encrypted(data, file, LAUNCHER_ENC_CBC);
+
+	// Missing files are left to the caller.
+	f_unlink(PATH);
+	_refuse("");
+
+	host_free32(file, FILE_MAX);
+	host_free32(data, LAUNCHER_PAYLOAD_MAX + 1);
+
+	return host_done("test_launcher");
+}
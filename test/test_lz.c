@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * LZ_Uncompress_safe() against the reference encoder and the original
+ * LZ_Uncompress(), then against broken and mutated streams. Every buffer
+ * is sized exactly so ASan sees any access outside of it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/types.h"
+#include "libs/compr/lz.h"
+#include "mem/sdram_param_t210.h"
+#include "mem/sdram_config_lz.inl"
+#include "host.h"
+#include "ref.h"
+
+#define MAX_SIZE 4096
+#define FUZZ_ROUNDS 200
+
+static void _gen(u8 *buf, u32 size, u32 kind)
+{
+	u32 pos = 0;
+
+	while (pos < size)
+	{
+		switch (kind)
+		{
+		case 0: // Incompressible.
+			buf[pos++] = host_rand();
+			break;
+		case 1: // Few symbols, the marker shows up as a literal.
+			buf[pos++] = "ab\0\1ab"[host_rand() % 6];
+			break;
+		default: // Literal runs and matches, short offsets included.
+			if (pos >= 4 && host_rand() & 1)
+			{
+				u32 off = 1 + host_rand() % (pos < 64 ? pos : 64);
+				for (u32 len = 4 + host_rand() % 80; len && pos < size; len--, pos++)
+					buf[pos] = buf[pos - off];
+			}
+			else
+			{
+				for (u32 len = 1 + host_rand() % 24; len && pos < size; len--)
+					buf[pos++] = host_rand();
+			}
+			break;
+		}
+	}
+}
+
+static int _decode(const u8 *in, u32 insize, u32 outsize, u32 misalign, u8 *expect)
+{
+	u8 *out = malloc(outsize + misalign + 1);
+	int res = LZ_Uncompress_safe(in, insize, out + misalign, outsize);
+
+	if (expect && res >= 0)
+		CHECK(!memcmp(out + misalign, expect, res));
+	free(out);
+
+	return res;
+}
+
+static void _round_trip(u8 *data, u32 size)
+{
+	u8 *comp = malloc(size * 257 / 256 + 2);
+	u32 csize = ref_lz_compress(comp, data, size);
+	u8 *in = malloc(csize);
+
+	memcpy(in, comp, csize);
+
+	// Output at every word alignment, so both copy paths run.
+	for (u32 a = 0; a < 4; a++)
+		CHECK(_decode(in, csize, size, a, data) == (int)size);
+	CHECK(_decode(in, csize, size + 100, 0, data) == (int)size);
+	if (size)
+		CHECK(_decode(in, csize, size - 1, 0, NULL) == -1);
+
+	// The original decoder reads one byte past a trailing marker, hence comp.
+	if (csize > 1)
+	{
+		u8 *out = malloc(size);
+		LZ_Uncompress(comp, out, csize);
+		CHECK(!memcmp(out, data, size));
+		free(out);
+	}
+
+	// Truncated streams stop early or fail, never reading past the end.
+	for (u32 n = 0; n < csize; n += 1 + csize / 64)
+	{
+		int res = _decode(in, n, size, 0, data);
+		CHECK(res <= (int)size);
+	}
+
+	// Mutated streams only have to stay within their buffers.
+	for (u32 r = 0; r < FUZZ_ROUNDS && csize > 1; r++)
+	{
+		u8 *m = malloc(csize);
+		memcpy(m, in, csize);
+		for (u32 k = 1 + host_rand() % 4; k; k--)
+			m[host_rand() % csize] = host_rand();
+		CHECK(_decode(m, csize, size, 0, NULL) <= (int)size);
+		free(m);
+	}
+
+	free(in);
+	free(comp);
+}
+
+static void _malformed()
+{
+	static const struct
+	{
+		const char *name;
+		u32 size;
+		u8 in[8];
+		int res;
+	} cases[] = {
+		{ "empty", 0, { 0 }, 0 },
+		{ "marker only", 1, { 0xAA }, 0 },
+		{ "literals", 4, { 0xAA, 1, 2, 3 }, 3 },
+		{ "escaped marker", 3, { 0xAA, 0xAA, 0 }, 1 },
+		{ "trailing marker", 3, { 0xAA, 1, 0xAA }, -1 },
+		{ "offset 0", 6, { 0xAA, 1, 2, 0xAA, 4, 0 }, -1 },
+		{ "offset past the start", 6, { 0xAA, 1, 2, 0xAA, 4, 3 }, -1 },
+		{ "offset 1", 5, { 0xAA, 7, 0xAA, 5, 1 }, 6 },
+		{ "truncated length", 4, { 0xAA, 1, 0xAA, 0x81 }, -1 },
+		{ "truncated offset", 5, { 0xAA, 1, 0xAA, 4, 0x81 }, -1 },
+		{ "length over 32 bits", 8, { 0xAA, 1, 0xAA, 0x90, 0x80, 0x80, 0x80, 0 }, -1 },
+		{ "length past the output", 5, { 0xAA, 1, 0xAA, 0x7F, 1 }, -1 },
+	};
+	static const u8 run[] = { 7, 7, 7, 7, 7, 7 };
+
+	for (u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		u8 *in = malloc(cases[i].size + 1);
+		memcpy(in, cases[i].in, cases[i].size);
+		int res = _decode(in, cases[i].size, 16, 0, NULL);
+		if (res != cases[i].res)
+			printf("%s: %d, expected %d\n", cases[i].name, res, cases[i].res);
+		CHECK(res == cases[i].res);
+		free(in);
+	}
+
+	CHECK(_decode((const u8 *)cases[7].in, 5, 6, 0, (u8 *)run) == 6);
+}
+
+int main()
+{
+	static u8 data[MAX_SIZE];
+	static u32 sizes[] = { 1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 63, 64, 65, 1000, MAX_SIZE };
+
+	_malformed();
+
+	for (u32 kind = 0; kind < 3; kind++)
+	{
+		for (u32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		{
+			_gen(data, sizes[i], kind);
+			_round_trip(data, sizes[i]);
+		}
+		for (u32 i = 0; i < 10; i++)
+		{
+			u32 size = host_rand() % MAX_SIZE;
+			_gen(data, size, kind);
+			_round_trip(data, size);
+		}
+	}
+
+	// The SDRAM parameters sdram_get_params() decodes at boot.
+	u8 *ref = malloc(sizeof(sdram_params_t) + 1);
+	LZ_Uncompress(_dram_cfg_base_lz, ref, sizeof(_dram_cfg_base_lz));
+	CHECK(_decode(_dram_cfg_base_lz, sizeof(_dram_cfg_base_lz), sizeof(sdram_params_t), 0, ref) == sizeof(sdram_params_t));
+	CHECK(_decode(_dram_cfg_base_lz, sizeof(_dram_cfg_base_lz), sizeof(sdram_params_t) - 1, 0, NULL) == -1);
+	free(ref);
+
+	return host_done("test_lz");
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The memset32 and memcpy32 kernels of mem32.s, run from their source by
+ * arm_model.c, and their C stand-ins the other host tests link, for every
+ * word alignment against a 32 byte block and every tail length.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/util.h"
+#include "arm_model.h"
+#include "host.h"
+
+#define MEM32_S "../src/utils/mem32.s"
+#define GUARD 0xDEADBEEF
+// Words around the buffers, and the longest run checked.
+#define PAD 16
+#define MAX_WORDS 80
+#define BUF_WORDS (PAD + 8 + MAX_WORDS + PAD)
+
+typedef void (*fill_t)(u32 *dst, u32 val, u32 len);
+typedef void (*copy_t)(u32 *dst, const u32 *src, u32 len);
+
+static arm_model_t model;
+
+static void _model_memset32(u32 *dst, u32 val, u32 len)
+{
+	// Callee saved registers have to come back as they were.
+	for (u32 r = 4; r < 12; r++)
+		model.r[r] = r * 0x01010101;
+	CHECK(arm_model_call(&model, "memset32", (u32)(unsigned long)dst, val, len, 100000));
+	for (u32 r = 4; r < 12; r++)
+		CHECK(model.r[r] == r * 0x01010101);
+}
+
+static void _model_memcpy32(u32 *dst, const u32 *src, u32 len)
+{
+	for (u32 r = 4; r < 12; r++)
+		model.r[r] = r * 0x01010101;
+	CHECK(arm_model_call(&model, "memcpy32", (u32)(unsigned long)dst, (u32)(unsigned long)src, len, 100000));
+	for (u32 r = 4; r < 12; r++)
+		CHECK(model.r[r] == r * 0x01010101);
+}
+
+static void _check_fill(u32 *buf, fill_t fill)
+{
+	// buf is 32 byte aligned, dst starts a words past a block.
+	for (u32 a = 0; a < 8; a++)
+	{
+		for (u32 n = 0; n <= MAX_WORDS; n++)
+		{
+			u32 *dst = buf + PAD + a;
+			u32 val = host_rand();
+			for (u32 i = 0; i < BUF_WORDS; i++)
+				buf[i] = GUARD;
+
+			// The low bits of len are ignored.
+			fill(dst, val, n * 4 + (n & 3));
+
+			for (u32 i = 0; i < BUF_WORDS; i++)
+			{
+				bool in = &buf[i] >= dst && &buf[i] < dst + n;
+				if (buf[i] != (in ? val : GUARD))
+				{
+					printf("fill: alignment %u, %u words, word %d wrong\n", a, n, (int)(&buf[i] - dst));
+					CHECK(buf[i] == (in ? val : GUARD));
+					break;
+				}
+			}
+		}
+	}
+}
+
+static void _check_copy(u32 *buf, u32 *src_buf, copy_t copy)
+{
+	for (u32 a = 0; a < 8; a++)
+	{
+		for (u32 b = 0; b < 8; b += 3)
+		{
+			for (u32 n = 0; n <= MAX_WORDS; n++)
+			{
+				u32 *dst = buf + PAD + a;
+				u32 *src = src_buf + PAD + b;
+				for (u32 i = 0; i < BUF_WORDS; i++)
+				{
+					buf[i] = GUARD;
+					src_buf[i] = host_rand();
+				}
+
+				copy(dst, src, n * 4);
+
+				for (u32 i = 0; i < BUF_WORDS; i++)
+				{
+					bool in = &buf[i] >= dst && &buf[i] < dst + n;
+					if (buf[i] != (in ? src[&buf[i] - dst] : GUARD))
+					{
+						printf("copy: alignment %u/%u, %u words, word %d wrong\n", a, b, n, (int)(&buf[i] - dst));
+						CHECK(buf[i] == (in ? src[&buf[i] - dst] : GUARD));
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	u32 size;
+	u8 *file = host_read_file(MEM32_S, &size);
+	CHECK(file != NULL);
+	if (!file)
+		return host_done("test_mem32");
+
+	char *src = malloc(size + 1);
+	memcpy(src, file, size);
+	src[size] = 0;
+	host_free32(file, size);
+	CHECK(arm_model_load(&model, src));
+	free(src);
+
+	u32 *buf = host_alloc32(BUF_WORDS * 4);
+	u32 *src_buf = host_alloc32(BUF_WORDS * 4);
+
+	_check_fill(buf, _model_memset32);
+	_check_copy(buf, src_buf, _model_memcpy32);
+	_check_fill(buf, memset32);
+	_check_copy(buf, src_buf, memcpy32);
+
+	host_free32(src_buf, BUF_WORDS * 4);
+	host_free32(buf, BUF_WORDS * 4);
+	arm_model_end(&model);
+
+	return host_done("test_mem32");
+}
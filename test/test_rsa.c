@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * RSA-2048 verification on the software SE backend, with the key header
+ * tools/payload_key.py makes for launcher.c. The fixtures were signed with
+ * openssl dgst -sha256 -sign, plain and with -sigopt rsa_padding_mode:pss.
+ */
+
+#include <string.h>
+
+#include "sec/rsa.h"
+#include "sec/se.h"
+#include "host.h"
+#include "payload_key.h"
+
+#define FIXTURES "fixtures/rsa/"
+
+// rsa2048_verify_file() hashes through fs_utils.c, here the host file is hashed instead.
+int sd_file_sha256(const char *path, void *hash, void *buf)
+{
+	u32 size;
+	u8 *data = host_read_file(path, &size);
+	int res = data && se_calc_sha256(hash, data, size);
+
+	host_free32(data, size);
+	return res;
+}
+
+static u8 *_read(const char *name, u32 *size)
+{
+	u8 *data = host_read_file(name, size);
+	CHECK(data != NULL);
+	return data;
+}
+
+int main()
+{
+	static const struct
+	{
+		const char *name;
+		u32 padding;
+	} sigs[] = {
+		{ FIXTURES "payload.bin.sig", RSA_PADDING_PKCS1_V15 },
+		{ FIXTURES "payload.bin.pss0", RSA_PADDING_PSS },
+		{ FIXTURES "payload.bin.pss32", RSA_PADDING_PSS },
+		{ FIXTURES "payload.bin.pssmax", RSA_PADDING_PSS },
+	};
+	rsa2048_key_t other;
+	u32 size, sig_size;
+	u8 *payload = _read(FIXTURES "payload.bin", &size);
+
+	// A different key, the modulus stays odd.
+	memcpy(&other, &_payload_key, sizeof(other));
+	other.mod[0x80] ^= 0x10;
+
+	for (u32 i = 0; i < sizeof(sigs) / sizeof(sigs[0]); i++)
+	{
+		u8 *sig = _read(sigs[i].name, &sig_size);
+		CHECK(sig_size == RSA2048_SIZE);
+
+		CHECK(rsa2048_verify(0, &_payload_key, sig, payload, size, sigs[i].padding));
+		CHECK(rsa2048_verify_file(0, &_payload_key, sig, FIXTURES "payload.bin", sigs[i].padding));
+		CHECK(!rsa2048_verify(0, &_payload_key, sig, payload, size, !sigs[i].padding));
+		CHECK(!rsa2048_verify(0, &_payload_key, sig, payload, size - 1, sigs[i].padding));
+
+		// The slot is reloaded when the key changes, and again when it changes back.
+		CHECK(!rsa2048_verify(0, &other, sig, payload, size, sigs[i].padding));
+		CHECK(rsa2048_verify(0, &_payload_key, sig, payload, size, sigs[i].padding));
+		CHECK(rsa2048_verify(1, &_payload_key, sig, payload, size, sigs[i].padding));
+
+		for (u32 bit = 0; bit < 2048; bit += 97)
+		{
+			sig[bit >> 3] ^= 1 << (bit & 7);
+			CHECK(!rsa2048_verify(0, &_payload_key, sig, payload, size, sigs[i].padding));
+			sig[bit >> 3] ^= 1 << (bit & 7);
+		}
+		for (u32 pos = 0; pos < size; pos += 301)
+		{
+			payload[pos] ^= 0x80;
+			CHECK(!rsa2048_verify(0, &_payload_key, sig, payload, size, sigs[i].padding));
+			payload[pos] ^= 0x80;
+		}
+
+		host_free32(sig, sig_size);
+	}
+
+	rsa2048_key_forget(0);
+	rsa2048_key_forget(1);
+
+	return host_done("test_rsa");
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * sdram_get_params() of sdram.c for every DRAM id the fuses can hold,
+ * against the tables tools/sdram_cfg.py --dump extracts from the same
+ * sdram_config_lz.inl. The table is decoded where it is at boot, so that
+ * address is mapped first.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "utils/types.h"
+#include "mem/sdram.h"
+#include "mem/sdram_param_t210.h"
+#include "host.h"
+
+#define PARAMS_ADDR 0x40030000
+#define PARAMS_MAP ((sizeof(sdram_params_t) + 0xFFF) & ~0xFFF)
+// Ids are 3 bits of the ODM fuse word 4.
+#define FUSE_IDS 8
+
+static u32 fuse_sdram_id;
+
+u32 fuse_read_odm(u32 idx)
+{
+	CHECK(idx == 4);
+	return (host_rand() & ~0x38) | (fuse_sdram_id << 3);
+}
+
+// Only sdram_init() calls these.
+void usleep(u32 ticks) { }
+int i2c_send_byte(u32 idx, u32 x, u32 y, u8 b) { return 1; }
+void panic(u32 code) { abort(); }
+
+int main()
+{
+	u32 size;
+	u8 *tables = host_read_file(SDRAM_TABLES, &size);
+	CHECK(tables != NULL);
+	if (!tables)
+		return host_done("test_sdram");
+
+	u32 ids = size / sizeof(sdram_params_t);
+	CHECK(ids && size == ids * sizeof(sdram_params_t));
+
+	void *map = mmap((void *)PARAMS_ADDR, PARAMS_MAP, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	CHECK(map == (void *)PARAMS_ADDR);
+	if (map != (void *)PARAMS_ADDR)
+		return host_done("test_sdram");
+
+	for (u32 id = 0; id < FUSE_IDS; id++)
+	{
+		// Left over from the previous id, every word has to be written.
+		memset(map, id * 0x11 + 0x80, PARAMS_MAP);
+		fuse_sdram_id = id;
+		CHECK(get_sdram_id() == id);
+
+		const u8 *params = sdram_get_params();
+		CHECK(params == map);
+		// Ids without a table of their own get the first one.
+		const u8 *expect = tables + (id < ids ? id : 0) * sizeof(sdram_params_t);
+		if (params && memcmp(params, expect, sizeof(sdram_params_t)))
+		{
+			u32 w = 0;
+			while (((const u32 *)params)[w] == ((const u32 *)expect)[w])
+				w++;
+			printf("DRAM id %u: word 0x%03X is 0x%08X, expected 0x%08X\n", id, w,
+				((const u32 *)params)[w], ((const u32 *)expect)[w]);
+			CHECK(0);
+		}
+	}
+
+	munmap(map, PARAMS_MAP);
+	host_free32(tables, size);
+
+	return host_done("test_sdram");
+}
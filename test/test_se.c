@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * AES modes of the se_* API: known answers, then random cross-checks
+ * against the reference AES. test_se runs se.c on the register model and
+ * test_se_sw runs se_sw.c, so both backends are held to the same results,
+ * including the byte exact CTR tail of _se_execute_one_block.
+ */
+
+#include <string.h>
+
+#include "sec/se.h"
+#include "sec/se_t210.h"
+#include "host.h"
+#include "ref.h"
+
+#define KS_DATA 8
+#define KS_TWEAK 9
+#define KS_KEK 10
+#define BUF_SIZE 0x2000
+#define CANARY 0xA5
+
+static u8 *src, *dst, *exp;
+
+static const char sp800_key[] = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char sp800_pt[] =
+	"6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+	"30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+
+static void _key_set(u32 ks, const char *hex)
+{
+	u8 key[32];
+	u32 size = ref_unhex(key, hex);
+
+	se_aes_key_set(ks, key, size);
+}
+
+static int _hex_eq(const u8 *buf, const char *hex)
+{
+	u8 tmp[0x200];
+	u32 size = ref_unhex(tmp, hex);
+
+	return !memcmp(buf, tmp, size);
+}
+
+static void _test_fips197()
+{
+	static const struct
+	{
+		const char *key;
+		const char *ct;
+	} vectors[] = {
+		// FIPS-197 appendix C, plaintext 00112233445566778899aabbccddeeff.
+		{ "000102030405060708090a0b0c0d0e0f", "69c4e0d86a7b0430d8cdb78070b4c55a" },
+		{ "000102030405060708090a0b0c0d0e0f1011121314151617", "dda97ca4864cdfe06eaf70a0ec0d7191" },
+		{ "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "8ea2b7ca516745bfeafc49904b496089" },
+	};
+	u8 key[32], block[16];
+
+	for (u32 i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+	{
+		ref_aes_t aes;
+		ref_aes_init(&aes, key, ref_unhex(key, vectors[i].key));
+		ref_unhex(block, "00112233445566778899aabbccddeeff");
+		ref_aes_encrypt(&aes, block);
+		CHECK(_hex_eq(block, vectors[i].ct));
+		ref_aes_decrypt(&aes, block);
+		CHECK(_hex_eq(block, "00112233445566778899aabbccddeeff"));
+	}
+
+	// The engine driver only sets up 128-bit keys.
+	_key_set(KS_DATA, vectors[0].key);
+	ref_unhex(src, "00112233445566778899aabbccddeeff");
+	CHECK(se_aes_crypt_block_ecb(KS_DATA, 1, dst, src));
+	CHECK(_hex_eq(dst, vectors[0].ct));
+	CHECK(se_aes_crypt_block_ecb(KS_DATA, 0, dst, dst));
+	CHECK(!memcmp(dst, src, 16));
+}
+
+static void _test_sp800_38a()
+{
+	u8 ctr[16];
+
+	_key_set(KS_DATA, sp800_key);
+	ref_unhex(src, sp800_pt);
+
+	// F.5.1 CTR-AES128, the counter carries out of its last byte on the second block.
+	ref_unhex(ctr, "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+	CHECK(se_aes_crypt_ctr(KS_DATA, dst, 64, src, 64, ctr));
+	CHECK(_hex_eq(dst,
+		"874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+		"5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee"));
+
+	// F.2.1 CBC-AES128.
+	ref_unhex(ctr, "000102030405060708090a0b0c0d0e0f");
+	CHECK(se_aes_crypt_cbc(KS_DATA, 1, dst, 64, src, 64, ctr));
+	CHECK(_hex_eq(dst,
+		"7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+		"73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7"));
+	CHECK(se_aes_crypt_cbc(KS_DATA, 0, dst, 64, dst, 64, ctr));
+	CHECK(!memcmp(dst, src, 64));
+}
+
+static void _test_ieee1619()
+{
+	// Vectors 1 and 4, both on data unit 0.
+	_key_set(KS_DATA, "00000000000000000000000000000000");
+	_key_set(KS_TWEAK, "00000000000000000000000000000000");
+	memset(src, 0, 32);
+	CHECK(se_aes_xts_crypt_sec(KS_TWEAK, KS_DATA, 1, 0, dst, src, 32));
+	CHECK(_hex_eq(dst, "917cf69ebd68b2ec9b9fe9a3eadda692cd43d2f59598ed858c02c2652fbf922e"));
+
+	_key_set(KS_DATA, "27182818284590452353602874713526");
+	_key_set(KS_TWEAK, "31415926535897932384626433832795");
+	for (u32 i = 0; i < 0x200; i++)
+		src[i] = i;
+	CHECK(se_aes_xts_crypt(KS_TWEAK, KS_DATA, 1, 0, dst, src, 0x200, 1));
+	CHECK(_hex_eq(dst, "27a7479befa1d476489f308cd4cfa6e2a96e4bbe3208ff25287dd3819616e89c"));
+}
+
+// Expected CTR output: the first MIN(src_size, dst_size) bytes, nothing past them.
+static void _ref_ctr(const ref_aes_t *aes, u8 *out, u32 dst_size, const u8 *in, u32 src_size, const u8 *ctr)
+{
+	u8 c[16], ks[16];
+
+	memcpy(c, ctr, 16);
+	for (u32 i = 0; i < MIN(src_size, dst_size); i++)
+	{
+		if (!(i & 0xF))
+		{
+			memcpy(ks, c, 16);
+			ref_aes_encrypt(aes, ks);
+			for (int j = 15; j >= 0 && !++c[j]; j--)
+				;
+		}
+		out[i] = in[i] ^ ks[i & 0xF];
+	}
+}
+
+static void _ref_xts(const ref_aes_t *data, const ref_aes_t *tweak, u32 enc, u64 sec, u8 *out, const u8 *in, u32 secsize)
+{
+	u8 t[16];
+
+	// Sector numbers go into the tweak big endian.
+	memset(t, 0, 16);
+	for (int i = 0; i < 8; i++)
+		t[15 - i] = sec >> (8 * i);
+	ref_aes_encrypt(tweak, t);
+
+	for (u32 i = 0; i < secsize; i += 16)
+	{
+		for (int j = 0; j < 16; j++)
+			out[i + j] = in[i + j] ^ t[j];
+		if (enc)
+			ref_aes_encrypt(data, out + i);
+		else
+			ref_aes_decrypt(data, out + i);
+		for (int j = 0; j < 16; j++)
+			out[i + j] ^= t[j];
+
+		u8 carry = t[15] >> 7;
+		for (int j = 15; j > 0; j--)
+			t[j] = t[j] << 1 | t[j - 1] >> 7;
+		t[0] = (t[0] << 1) ^ (carry ? 0x87 : 0);
+	}
+}
+
+static void _random_key(u8 *key, u32 ks, ref_aes_t *aes)
+{
+	for (int i = 0; i < 16; i++)
+		key[i] = host_rand();
+	se_aes_key_set(ks, key, 16);
+	ref_aes_init(aes, key, 16);
+}
+
+static void _test_random()
+{
+	ref_aes_t data, tweak;
+	u8 key[16], ctr[16], iv[16];
+
+	host_seed(32);
+	for (u32 i = 0; i < BUF_SIZE; i++)
+		src[i] = host_rand();
+
+	for (u32 iter = 0; iter < 400; iter++)
+	{
+		_random_key(key, KS_DATA, &data);
+		_random_key(key, KS_TWEAK, &tweak);
+		for (int i = 0; i < 16; i++)
+			ctr[i] = host_rand();
+		if (iter & 1)
+			memset(ctr + 8, 0xFF, 8); // Carries through the whole low half.
+
+		// CTR with every tail length and destinations shorter and longer than the source.
+		u32 src_size = host_rand() % 0x400;
+		u32 dst_size = src_size;
+		switch (iter % 4)
+		{
+		case 1:
+			dst_size = (src_size + 0xF) & ~0xF;
+			break;
+		case 2:
+			dst_size = src_size + 0x20;
+			break;
+		case 3:
+			dst_size = host_rand() % (src_size + 1);
+			break;
+		}
+		memset(dst, CANARY, BUF_SIZE);
+		memset(exp, CANARY, BUF_SIZE);
+		_ref_ctr(&data, exp, dst_size, src, src_size, ctr);
+		CHECK(se_aes_crypt_ctr(KS_DATA, dst, dst_size, src, src_size, ctr));
+		CHECK(!memcmp(dst, exp, BUF_SIZE));
+
+		// Asynchronous CTR, whole blocks only.
+		src_size &= ~0xF;
+		memset(dst, CANARY, BUF_SIZE);
+		memset(exp, CANARY, BUF_SIZE);
+		_ref_ctr(&data, exp, src_size, src, src_size, ctr);
+		CHECK(se_aes_crypt_ctr_start(KS_DATA, dst, src_size, src, src_size, ctr));
+		CHECK(se_job_wait());
+		CHECK(!memcmp(dst, exp, BUF_SIZE));
+
+		// ECB and CBC.
+		for (u32 i = 0; i < src_size; i += 16)
+		{
+			memcpy(exp + i, src + i, 16);
+			ref_aes_encrypt(&data, exp + i);
+		}
+		CHECK(se_aes_crypt_ecb(KS_DATA, 1, dst, src_size, src, src_size));
+		CHECK(!memcmp(dst, exp, src_size));
+		CHECK(se_aes_crypt_ecb(KS_DATA, 0, dst, src_size, dst, src_size));
+		CHECK(!memcmp(dst, src, src_size));
+
+		for (int i = 0; i < 16; i++)
+			iv[i] = host_rand();
+		for (u32 i = 0; i < src_size; i += 16)
+		{
+			for (int j = 0; j < 16; j++)
+				exp[i + j] = src[i + j] ^ (i ? exp[i + j - 16] : iv[j]);
+			ref_aes_encrypt(&data, exp + i);
+		}
+		CHECK(se_aes_crypt_cbc(KS_DATA, 1, dst, src_size, src, src_size, iv));
+		CHECK(!memcmp(dst, exp, src_size));
+		CHECK(se_aes_crypt_cbc(KS_DATA, 0, dst, src_size, dst, src_size, iv));
+		CHECK(!memcmp(dst, src, src_size));
+
+		// XTS, batched and per sector, on runs longer than the tweak buffer.
+		static const u32 secsizes[] = { 0x10, 0x200, 0x1000, 0x4000 };
+		u32 secsize = secsizes[iter % 3];
+		u32 num_secs = 1 + host_rand() % (BUF_SIZE / secsize);
+		u64 sec = iter & 2 ? host_rand() : (u64)host_rand() << 32 | host_rand();
+		u32 enc = iter & 1;
+		for (u32 i = 0; i < num_secs; i++)
+			_ref_xts(&data, &tweak, enc, sec + i, exp + i * secsize, src + i * secsize, secsize);
+		CHECK(se_aes_xts_crypt(KS_TWEAK, KS_DATA, enc, sec, dst, src, secsize, num_secs));
+		CHECK(!memcmp(dst, exp, secsize * num_secs));
+		CHECK(se_aes_xts_crypt_sec(KS_TWEAK, KS_DATA, enc, sec, dst, src, secsize));
+		CHECK(!memcmp(dst, exp, secsize));
+	}
+}
+
+static void _test_unwrap()
+{
+	ref_aes_t kek, key;
+	u8 raw[16], wrapped[16], block[16];
+
+	host_seed(33);
+	_random_key(raw, KS_KEK, &kek);
+	for (int i = 0; i < 16; i++)
+		raw[i] = host_rand();
+	memcpy(wrapped, raw, 16);
+	ref_aes_encrypt(&kek, wrapped);
+	memcpy(src, wrapped, 16);
+
+	CHECK(se_aes_unwrap_key(KS_DATA, KS_KEK, src));
+
+	ref_aes_init(&key, raw, 16);
+	memset(block, 0x3C, 16);
+	memcpy(src, block, 16);
+	ref_aes_encrypt(&key, block);
+	CHECK(se_aes_crypt_block_ecb(KS_DATA, 1, dst, src));
+	CHECK(!memcmp(dst, block, 16));
+}
+
+#ifdef SE_SW_BACKEND
+// Jobs that leave their result in the hash or RSA registers have nowhere to go.
+static void _test_register_jobs()
+{
+	static const u32 configs[] = {
+		SE_CONFIG_ENC_ALG(ALG_SHA) | SE_CONFIG_ENC_MODE(MODE_SHA256) | SE_CONFIG_DST(DST_HASHREG),
+		SE_CONFIG_ENC_ALG(ALG_RSA) | SE_CONFIG_DST(DST_RSAREG),
+	};
+	se_job_t job;
+
+	for (u32 i = 0; i < sizeof(configs) / sizeof(configs[0]); i++)
+	{
+		memset(&job, 0, sizeof(job));
+		job.type = i ? SE_OP_RSA : SE_OP_SHA256;
+		job.config = configs[i];
+		job.src = src;
+		job.src_size = 0x40;
+
+		se_reset_stats();
+		CHECK(!se_job_submit(&job));
+		CHECK(!se_job_start(&job));
+		CHECK(!se_job_wait());
+		CHECK(!se_get_stats()[job.type].ops);
+
+		// Nor do they write a buffer they are given.
+		job.dst = dst;
+		job.dst_size = 0x20;
+		memset(dst, CANARY, 0x20);
+		CHECK(!se_job_submit(&job));
+		for (u32 j = 0; j < 0x20; j++)
+			CHECK(dst[j] == CANARY);
+	}
+}
+#endif
+
+int main()
+{
+	src = host_alloc32(BUF_SIZE);
+	dst = host_alloc32(BUF_SIZE);
+	exp = host_alloc32(BUF_SIZE);
+
+	_test_fips197();
+	_test_sp800_38a();
+	_test_ieee1619();
+	_test_random();
+	_test_unwrap();
+#ifdef SE_SW_BACKEND
+	_test_register_jobs();
+#endif
+
+	return host_done("test_se");
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2018 DragonInjector Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SHA-256 known answers and streaming against the reference.
+ * test_sha256 runs se.c on the register model, test_sha256_sw runs se_sw.c.
+ */
+
+#include <string.h>
+
+#include "sec/se.h"
+#include "host.h"
+#include "ref.h"
+
+#define MAX_SIZE 0x1000
+
+static const struct
+{
+	const char *msg;
+	u32 repeat;
+	const char *digest;
+} kats[] = {
+	// FIPS 180-4 examples and the NIST CAVS long message.
+	{ "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+	{ "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+		"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 1,
+		"cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+	{ "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+};
+
+static se_sha256_ctx_t *ctx;
+
+static void _test_kats()
+{
+	u8 expected[32], digest[32];
+
+	for (u32 i = 0; i < sizeof(kats) / sizeof(kats[0]); i++)
+	{
+		u32 len = strlen(kats[i].msg);
+		u32 size = len * kats[i].repeat;
+		u8 *msg = host_alloc32(size);
+
+		for (u32 j = 0; j < kats[i].repeat; j++)
+			memcpy(msg + j * len, kats[i].msg, len);
+		ref_unhex(expected, kats[i].digest);
+
+		ref_sha256(digest, msg, size);
+		CHECK(!memcmp(digest, expected, 32));
+
+		memset(digest, 0, 32);
+		CHECK(se_calc_sha256(digest, msg, size));
+		CHECK(!memcmp(digest, expected, 32));
+
+		// Streamed in uneven chunks.
+		se_sha256_init(ctx);
+		for (u32 j = 0, n; j < size; j += n)
+		{
+			n = MIN(size - j, 1 + j % 1000);
+			CHECK(se_sha256_update(ctx, msg + j, n));
+		}
+		memset(digest, 0, 32);
+		CHECK(se_sha256_final(ctx, digest));
+		CHECK(!memcmp(digest, expected, 32));
+
+		host_free32(msg, size);
+	}
+}
+
+// Random lengths split at random points, through both update paths.
+static void _test_stream(u8 *msg)
+{
+	u8 expected[32], digest[32];
+
+	host_seed(31);
+	for (u32 i = 0; i < MAX_SIZE; i++)
+		msg[i] = host_rand();
+
+	for (u32 iter = 0; iter < 3000; iter++)
+	{
+		u32 size = iter < 300 ? iter : host_rand() % MAX_SIZE;
+		u32 async = host_rand() & 1;
+
+		ref_sha256(expected, msg, size);
+
+		se_sha256_init(ctx);
+		for (u32 j = 0, n; j < size; j += n)
+		{
+			switch (host_rand() % 4)
+			{
+			case 0:
+				n = host_rand() % 64;
+				break;
+			case 1:
+				n = (host_rand() % 8) * 64;
+				break;
+			default:
+				n = host_rand() % 300;
+				break;
+			}
+			n = MIN(n, size - j);
+			if (async)
+			{
+				// Block aligned chunks are started asynchronously, the rest falls back.
+				CHECK(se_sha256_update_start(ctx, msg + j, n));
+				CHECK(se_job_wait());
+			}
+			else
+				CHECK(se_sha256_update(ctx, msg + j, n));
+		}
+		memset(digest, 0, 32);
+		CHECK(se_sha256_final(ctx, digest));
+		CHECK(!memcmp(digest, expected, 32));
+
+		// One shot hash of the same message.
+		memset(digest, 0, 32);
+		CHECK(se_calc_sha256(digest, msg, size));
+		CHECK(!memcmp(digest, expected, 32));
+	}
+}
+
+int main()
+{
+	u8 *msg = host_alloc32(MAX_SIZE);
+	ctx = host_alloc32(sizeof(se_sha256_ctx_t));
+
+	_test_kats();
+	_test_stream(msg);
+
+	return host_done("test_sha256");
+}
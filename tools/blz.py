@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Backwards LZ (KIP style) compressor for libs/compr/blz.c.
+#
+# Output layout: uncompressed prefix, compressed stream, 0xFF padding to a
+# word and the 12 byte footer. The stream is decoded from its end towards the
+# start in place, so the prefix is chosen such that decoding never writes
+# over compressed bytes it has yet to read.
+#
+# usage: blz.py c <in> <out>
+#        blz.py d <in> <out>
+
+import struct
+import sys
+
+FOOTER_SIZE = 12
+MIN_MATCH = 3
+MAX_MATCH = 0xF + 3
+MAX_OFS = 0xFFF + 3
+MAX_CHAIN = 128
+
+def _tokens(rev):
+	# Greedy LZ over the reversed data, in the order the decoder produces it.
+	# A match never overlaps the bytes it copies, the in-place decoder reads
+	# the source before any of them were rewritten.
+	chains = {}
+	i = 0
+	while i < len(rev):
+		best_len, best_ofs = 0, 0
+		for j in reversed(chains.get(rev[i:i + MIN_MATCH], [])[-MAX_CHAIN:]):
+			ofs = i - j
+			if ofs > MAX_OFS:
+				break
+			limit = min(MAX_MATCH, ofs, len(rev) - i)
+			l = 0
+			while l < limit and rev[j + l] == rev[i + l]:
+				l += 1
+			if l > best_len:
+				best_len, best_ofs = l, ofs
+				if l == MAX_MATCH:
+					break
+
+		if best_len >= MIN_MATCH:
+			yield best_len, best_ofs
+			step = best_len
+		else:
+			yield 1, rev[i]  # Literal.
+			step = 1
+
+		for k in range(i, i + step):
+			chains.setdefault(rev[k:k + MIN_MATCH], []).append(k)
+		i += step
+
+def compress(data):
+	rev = data[::-1]
+
+	# Stream in decode order, reversed at the end. Track how far ahead the
+	# output runs of the input after each token to pick the prefix.
+	stream = bytearray()
+	ctrl_pos, ctrl_bit = 0, 0
+	out_done = 0
+	best_gain, best_cut, best_out = 0, 0, 0
+
+	for length, val in _tokens(rev):
+		if not ctrl_bit:
+			ctrl_pos = len(stream)
+			stream.append(0)
+			ctrl_bit = 0x80
+
+		if length == 1:
+			stream.append(val)
+		else:
+			seg = ((length - MIN_MATCH) << 12) | (val - MIN_MATCH)
+			stream[ctrl_pos] |= ctrl_bit
+			stream += bytes([seg >> 8, seg & 0xFF])
+		ctrl_bit >>= 1
+		out_done += length
+
+		gain = out_done - len(stream)
+		if gain > best_gain:
+			best_gain, best_cut, best_out = gain, len(stream), out_done
+
+	cmp = bytes(reversed(stream[:best_cut]))
+	prefix = data[:len(data) - best_out]
+	pad = (-(len(prefix) + len(cmp))) % 4
+	header_size = pad + FOOTER_SIZE
+	cmp_and_hdr_size = len(cmp) + header_size
+	total = len(prefix) + cmp_and_hdr_size
+	if total > len(data):
+		return None
+
+	footer = struct.pack('<III', cmp_and_hdr_size, header_size, len(data) - total)
+	return prefix + cmp + b'\xFF' * pad + footer
+
+def decompress(comp):
+	# Port of blz_uncompress_srcdest(), also checking that the stream can be
+	# decoded in place.
+	cmp_and_hdr_size, header_size, addl_size = struct.unpack('<III', comp[-FOOTER_SIZE:])
+	buf = bytearray(comp + bytes(addl_size))
+	base = len(comp) - cmp_and_hdr_size
+	cmp_ofs = cmp_and_hdr_size - header_size
+	out_ofs = cmp_and_hdr_size + addl_size
+
+	while out_ofs:
+		cmp_ofs -= 1
+		control = buf[base + cmp_ofs]
+		for _ in range(8):
+			if control & 0x80:
+				cmp_ofs -= 2
+				seg = (buf[base + cmp_ofs + 1] << 8) | buf[base + cmp_ofs]
+				size = min((seg >> 12) + 3, out_ofs)
+				ofs = (seg & 0xFFF) + 3
+				out_ofs -= size
+				for j in range(size):
+					buf[base + out_ofs + j] = buf[base + out_ofs + j + ofs]
+			else:
+				cmp_ofs -= 1
+				out_ofs -= 1
+				buf[base + out_ofs] = buf[base + cmp_ofs]
+			if cmp_ofs < 0 or out_ofs < cmp_ofs:
+				raise ValueError('corrupt stream')
+			control <<= 1
+			if not out_ofs:
+				break
+
+	return bytes(buf)
+
+def main(argv):
+	if len(argv) != 4 or argv[1] not in ('c', 'd'):
+		print('usage: %s c|d <in> <out>' % argv[0])
+		return 1
+
+	data = open(argv[2], 'rb').read()
+	if argv[1] == 'd':
+		out = decompress(data)
+	else:
+		out = compress(data)
+		if out is None:
+			print('%s does not compress' % argv[2])
+			return 1
+		if decompress(out) != data:
+			print('round trip failed')
+			return 1
+
+	with open(argv[3], 'wb') as f:
+		f.write(out)
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))
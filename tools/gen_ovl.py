@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Generates the overlay glue out of src/overlays.lst.
+#
+# The image is linked twice. The first link places each overlay at its DRAM
+# address with an empty blob table, its sections are then extracted and
+# compressed. The second link adds the compressed blobs at the end of the
+# image, which leaves every address the overlays depend on unchanged.
+#
+# usage: gen_ovl.py names|objs|wrap <overlays.lst>
+#          Prints overlay names, overlay objects or linker wrap flags.
+#        gen_ovl.py script <overlays.lst> <dir>
+#          Writes ovl.ld, ovl_xref.ld, ovl_stubs.s and the empty blob table
+#          ovl_empty.s.
+#        gen_ovl.py table <overlays.lst> <dir>
+#          Prints the blob table with <dir>/<overlay>.lz4 included.
+
+import sys
+
+OVL_ALIGN = 0x1000
+
+def parse(path):
+	ovls = {}
+	for n, line in enumerate(open(path), 1):
+		words = line.split('#', 1)[0].split()
+		if not words:
+			continue
+		if len(words) < 3 or words[1] not in ('objs', 'funcs'):
+			raise SystemExit('%s:%d: expected <overlay> objs|funcs <name>...' % (path, n))
+		ovl = ovls.setdefault(words[0], {'objs': [], 'funcs': []})
+		ovl[words[1]] += words[2:]
+
+	for name, ovl in ovls.items():
+		if not ovl['objs'] or not ovl['funcs']:
+			raise SystemExit('%s: overlay %s needs objects and functions' % (path, name))
+	return list(ovls.items())
+
+def linker_script(ovls):
+	out = ['/* Generated by tools/gen_ovl.py, do not edit. */']
+	for name, ovl in ovls:
+		out += [
+			'.ovl.%s ALIGN(0x%X) : {' % (name, OVL_ALIGN),
+			'\t__ovl_%s_start = .;' % name,
+		]
+		for o in ovl['objs']:
+			out.append('\t*/%s(.text* .rodata* .data*)' % o)
+		out += [
+			'\t. = ALIGN(4);',
+			'\t__ovl_%s_end = .;' % name,
+			'}',
+			'.ovl.%s.bss (NOLOAD) : {' % name,
+		]
+		for o in ovl['objs']:
+			out.append('\t*/%s(.bss* COMMON)' % o)
+		out += [
+			'\t. = ALIGN(4);',
+			'\t__ovl_%s_bss_end = .;' % name,
+			'}',
+		]
+	return '\n'.join(out) + '\n'
+
+def xref_script(ovls):
+	# Top level commands, link.ld includes this after SECTIONS.
+	out = ['/* Generated by tools/gen_ovl.py, do not edit. */']
+	for name, ovl in ovls:
+		# Resident code has to go through the stubs.
+		out.append('NOCROSSREFS_TO(.ovl.%s .text .data)' % name)
+	return '\n'.join(out) + '\n'
+
+def stubs(ovls):
+	out = [
+		'/* Generated by tools/gen_ovl.py, do not edit. */',
+		'',
+		'.section .ovl_stubs, "ax"',
+		'.arm',
+		'',
+		'.extern ovl_load',
+		'.type ovl_load, %function',
+	]
+	for idx, (name, ovl) in enumerate(ovls):
+		out += ['']
+		for fn in ovl['funcs']:
+			out += [
+				'.globl __wrap_%s' % fn,
+				'.type __wrap_%s, %%function' % fn,
+				'__wrap_%s:' % fn,
+				'\tLDR R12, =__real_%s' % fn,
+				'\tB _ovl_enter_%s' % name,
+			]
+		# R12 holds the real entry point, the arguments are passed through.
+		out += [
+			'_ovl_enter_%s:' % name,
+			'\tSTMFD SP!, {R0-R3, R12, LR}',
+			'\tLDR R0, =ovl_loaded',
+			'\tLDRB R0, [R0, #%d]' % idx,
+			'\tCMP R0, #0',
+			'\tBNE 1f',
+			'\tMOV R0, #%d' % idx,
+			'\tBL ovl_load',
+			'1:',
+			'\tLDMFD SP!, {R0-R3, R12, LR}',
+			'\tBX R12',
+		]
+	out += [
+		'',
+		'.pool',
+		'',
+		'.section .bss.ovl_loaded, "aw", %nobits',
+		'.globl ovl_loaded',
+		'ovl_loaded:',
+		'\t.space %d' % len(ovls),
+	]
+	return '\n'.join(out) + '\n'
+
+def table(ovls, blob_dir):
+	out = [
+		'/* Generated by tools/gen_ovl.py, do not edit. */',
+		'',
+		'.section .ovl_blob, "a"',
+		'.align 2',
+		'',
+		'.globl __ovl_table',
+		'__ovl_table:',
+	]
+	for name, ovl in ovls:
+		out += [
+			'.weak %s_ovl_init' % name,
+			'\t.word __ovl_%s_start, __ovl_%s_end, __ovl_%s_bss_end' % (name, name, name),
+			'\t.word _ovl_%s_blob, _ovl_%s_blob_end, %s_ovl_init' % (name, name, name),
+		]
+	for name, ovl in ovls:
+		out += ['_ovl_%s_blob:' % name]
+		if blob_dir is not None:
+			out += ['\t.incbin "%s/%s.lz4"' % (blob_dir, name)]
+		out += ['_ovl_%s_blob_end:' % name]
+	return '\n'.join(out) + '\n'
+
+def main(argv):
+	if len(argv) < 3:
+		print('usage: %s names|objs|wrap|script|table <overlays.lst> [dir]' % argv[0])
+		return 1
+
+	cmd = argv[1]
+	ovls = parse(argv[2])
+	if cmd == 'names':
+		print(' '.join(name for name, ovl in ovls))
+	elif cmd == 'objs':
+		print(' '.join(o for name, ovl in ovls for o in ovl['objs']))
+	elif cmd == 'wrap':
+		print(' '.join('-Wl,--wrap=%s' % fn for name, ovl in ovls for fn in ovl['funcs']))
+	elif cmd == 'script' and len(argv) == 4:
+		for fname, text in (('ovl.ld', linker_script(ovls)), ('ovl_xref.ld', xref_script(ovls)),
+				('ovl_stubs.s', stubs(ovls)), ('ovl_empty.s', table(ovls, None))):
+			with open('%s/%s' % (argv[3], fname), 'w') as f:
+				f.write(text)
+	elif cmd == 'table' and len(argv) == 4:
+		sys.stdout.write(table(ovls, argv[3]))
+	else:
+		print('usage: %s names|objs|wrap|script|table <overlays.lst> [dir]' % argv[0])
+		return 1
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Builds a self-decompressing image out of the plain one.
+#
+# The packed image is the code of start.s up to its header, followed by the
+# whole plain image as a raw LZ4 block. When loaded through RCM, _start moves
+# the block to the top of IRAM and decodes it straight to __ipl_start.
+#
+# usage: pack_ipl.py <ipl.bin> <ipl.lz4> <out.bin>
+#   ipl.lz4 is the raw LZ4 block of ipl.bin, as the Makefile makes it.
+
+import struct
+import sys
+
+PACK_MAGIC = 0x4B504244 # "DBPK", see _pack_hdr in start.s.
+PACK_HDR_MAX = 0x1000
+
+RCM_LOAD_ADDR = 0x40010000
+IPL_START = 0x40008000  # __ipl_start in link.ld.
+UNPACK_TOP = 0x4003FF00 # The unpacker and the stack live above this.
+
+def lz4_sequences(blob):
+	# Yields (input pos after the sequence's literals, literals, match length, offset).
+	i = 0
+	while i < len(blob):
+		token = blob[i]
+		i += 1
+		lit = token >> 4
+		if lit == 15:
+			while True:
+				b = blob[i]
+				i += 1
+				lit += b
+				if b != 255:
+					break
+		lits = blob[i:i + lit]
+		i += lit
+		if i >= len(blob):
+			yield i, lits, 0, 0
+			return
+
+		offset = blob[i] | (blob[i + 1] << 8)
+		i += 2
+		mlen = token & 15
+		if mlen == 15:
+			while True:
+				b = blob[i]
+				i += 1
+				mlen += b
+				if b != 255:
+					break
+		yield i, lits, mlen + 4, offset
+
+def unpack(blob, src, dst):
+	# Decodes like _unpack_lz4 and checks that no write lands on input it has yet to read.
+	out = bytearray()
+	for end, lits, mlen, offset in lz4_sequences(blob):
+		lit_start = end - len(lits)
+		if lits and dst + len(out) > src + lit_start:
+			return None
+		out += lits
+		if mlen:
+			if not offset or offset > len(out):
+				return None
+			# The offset and match length bytes come after the literals.
+			next_in = end
+			if dst + len(out) + mlen > src + next_in:
+				return None
+			for _ in range(mlen):
+				out.append(out[-offset])
+	return bytes(out)
+
+def main(argv):
+	if len(argv) != 4:
+		print('usage: %s <ipl.bin> <ipl.lz4> <out.bin>' % argv[0])
+		return 1
+
+	ipl = open(argv[1], 'rb').read()
+	blob = open(argv[2], 'rb').read()
+
+	hdr = ipl.find(struct.pack('<III', PACK_MAGIC, 0, 0), 0, PACK_HDR_MAX)
+	if hdr < 0 or hdr & 3:
+		print('%s has no pack header' % argv[1])
+		return 1
+	stub = ipl[:hdr] + struct.pack('<III', PACK_MAGIC, len(ipl), len(blob))
+
+	src = UNPACK_TOP - ((len(blob) + 3) & ~3)
+	if RCM_LOAD_ADDR + len(stub) > src:
+		print('%s is too large to be moved up for unpacking' % argv[2])
+		return 1
+	if unpack(blob, src, IPL_START) != ipl:
+		print('%s does not unpack in place to %s' % (argv[2], argv[1]))
+		return 1
+
+	packed = stub + blob
+	with open(argv[3], 'wb') as f:
+		f.write(packed)
+
+	print('%s: %d bytes, packed %d bytes, %d bytes saved' %
+		(argv[1], len(ipl), len(packed), len(ipl) - len(packed)))
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))
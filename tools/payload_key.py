@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Turns an RSA-2048 public key in PEM into the payload_key.h launcher.c
+# verifies payloads with, see 'make PAYLOAD_KEY=<key.pem>'.
+#
+# Payloads are signed next to them with PKCS#1 v1.5 and SHA-256:
+#   openssl dgst -sha256 -sign key.pem -out payload.bin.sig payload.bin
+#
+# usage: payload_key.py <key.pem>
+
+import base64
+import sys
+
+def der_read(data, pos, tag):
+	# Returns the contents of the element at pos and the position after it.
+	if data[pos] != tag:
+		raise SystemExit('unexpected DER tag 0x%02X' % data[pos])
+	size = data[pos + 1]
+	pos += 2
+	if size & 0x80:
+		n = size & 0x7F
+		size = int.from_bytes(data[pos:pos + n], 'big')
+		pos += n
+	return data[pos:pos + size], pos + size
+
+def read_key(pem):
+	lines = pem.strip().splitlines()
+	der = base64.b64decode(''.join(l for l in lines if not l.startswith('-----')))
+
+	seq, _ = der_read(der, 0, 0x30)
+	if 'BEGIN PUBLIC KEY' in lines[0]:
+		# SubjectPublicKeyInfo, the RSAPublicKey is in the BIT STRING.
+		_, pos = der_read(seq, 0, 0x30)
+		bits, _ = der_read(seq, pos, 0x03)
+		seq, _ = der_read(bits[1:], 0, 0x30)
+	elif 'BEGIN RSA PUBLIC KEY' not in lines[0]:
+		raise SystemExit('not a PEM public key, export it with openssl rsa -pubout')
+
+	mod, pos = der_read(seq, 0, 0x02)
+	exp, _ = der_read(seq, pos, 0x02)
+	mod = int.from_bytes(mod, 'big')
+	exp = int.from_bytes(exp, 'big')
+	if mod.bit_length() != 2048 or exp >= 1 << 32:
+		raise SystemExit('only RSA-2048 keys with a 32-bit exponent are supported')
+	return mod.to_bytes(256, 'big'), exp.to_bytes(4, 'big')
+
+def c_bytes(data):
+	return '\n'.join('\t\t' + ', '.join('0x%02X' % b for b in data[i:i + 16]) + ','
+		for i in range(0, len(data), 16))
+
+def main(argv):
+	if len(argv) != 2:
+		print('usage: %s <key.pem>' % argv[0])
+		return 1
+
+	mod, exp = read_key(open(argv[1]).read())
+	print('// Generated by tools/payload_key.py, do not edit.')
+	print('static const rsa2048_key_t _payload_key = {')
+	print('\t.mod = {')
+	print(c_bytes(mod))
+	print('\t},')
+	print('\t.exp = { %s }' % ', '.join('0x%02X' % b for b in exp))
+	print('};')
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Packs the per DRAM id sdram_params_t tables into include/mem/sdram_config_lz.inl.
+#
+# The table closest to all others is stored LZ77 compressed as the base, every
+# id then only carries the 32-bit words that differ from it. The output is
+# decoded again before it is written, so a bad pack never reaches the tree.
+#
+# usage: sdram_cfg.py <tables.bin> <count> <out.inl>
+#   tables.bin is <count> raw sdram_params_t back to back, indexed by DRAM id.
+#   --dump <in.inl> <tables.bin> extracts them again from a generated file.
+
+import re
+import struct
+import sys
+
+HEADER = '''/*
+ * Copyright (c) 2018 naehrwert
+ * Copyright (c) 2018 balika011
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Generated by tools/sdram_cfg.py, do not edit.
+'''
+
+MIN_MATCH = 4
+MAX_CHAIN = 64
+
+def _var_size(x):
+	out = [x & 0x7F]
+	x >>= 7
+	while x:
+		out.append((x & 0x7F) | 0x80)
+		x >>= 7
+	return bytes(reversed(out))
+
+def lz_compress(data):
+	# Same stream as libs/compr/lz.c: marker byte, literals, and
+	# marker + varsize length + varsize offset for matches.
+	hist = [0] * 256
+	for b in data:
+		hist[b] += 1
+	marker = hist.index(min(hist))
+
+	out = bytearray([marker])
+	chains = {}
+	i = 0
+	while i < len(data):
+		best_len, best_off = 0, 0
+		for j in reversed(chains.get(data[i:i + MIN_MATCH], [])[-MAX_CHAIN:]):
+			l = 0
+			while i + l < len(data) and data[j + l] == data[i + l]:
+				l += 1
+			if l > best_len:
+				best_len, best_off = l, i - j
+
+		enc = _var_size(best_len) + _var_size(best_off)
+		if best_len > len(enc) + 1:
+			out += bytes([marker]) + enc
+			step = best_len
+		else:
+			out += bytes([marker, 0]) if data[i] == marker else bytes([data[i]])
+			step = 1
+
+		for k in range(i, i + step):
+			chains.setdefault(data[k:k + MIN_MATCH], []).append(k)
+		i += step
+
+	return bytes(out)
+
+def lz_uncompress(data):
+	out = bytearray()
+	if not data:
+		return bytes(out)
+	marker = data[0]
+	i = 1
+
+	def var_size(i):
+		y = 0
+		while True:
+			b = data[i]
+			i += 1
+			y = (y << 7) | (b & 0x7F)
+			if not b & 0x80:
+				return y, i
+
+	while i < len(data):
+		b = data[i]
+		i += 1
+		if b != marker:
+			out.append(b)
+			continue
+		if data[i] == 0:
+			out.append(marker)
+			i += 1
+			continue
+		length, i = var_size(i)
+		offset, i = var_size(i)
+		for _ in range(length):
+			out.append(out[-offset])
+
+	return bytes(out)
+
+def pack(tables):
+	words = [struct.unpack('<%dI' % (len(t) // 4), t) for t in tables]
+
+	def distance(a, b):
+		return sum(x != y for x, y in zip(words[a], words[b]))
+
+	base = min(range(len(tables)), key=lambda a: sum(distance(a, b) for b in range(len(tables))))
+
+	idx = []
+	deltas = []
+	for t in words:
+		idx.append(len(deltas))
+		deltas += [(i, v) for i, (v, ref) in enumerate(zip(t, words[base])) if v != ref]
+	idx.append(len(deltas))
+
+	return base, lz_compress(tables[base]), idx, deltas
+
+def unpack(base_lz, idx, deltas, sdram_id):
+	base = lz_uncompress(base_lz)
+	t = list(struct.unpack('<%dI' % (len(base) // 4), base))
+	for off, val in deltas[idx[sdram_id]:idx[sdram_id + 1]]:
+		t[off] = val
+	return struct.pack('<%dI' % len(t), *t)
+
+def emit(base, base_lz, idx, deltas, size):
+	s = HEADER + '\n'
+	s += '#define SDRAM_CFG_IDS %d\n' % (len(idx) - 1)
+	s += '#define SDRAM_CFG_BASE_ID %d\n\n' % base
+
+	s += '// sdram_params_t of SDRAM_CFG_BASE_ID, %d bytes once decoded.\n' % size
+	s += 'static const u8 _dram_cfg_base_lz[%d] = {\n' % len(base_lz)
+	for i in range(0, len(base_lz), 12):
+		s += '\t' + ', '.join('0x%02X' % b for b in base_lz[i:i + 12]) + ',\n'
+	s = s[:-2] + '\n};\n\n'
+
+	s += '// Words that differ from the base, id n owns [_dram_cfg_delta_idx[n], _dram_cfg_delta_idx[n + 1]).\n'
+	s += 'static const u16 _dram_cfg_delta_idx[SDRAM_CFG_IDS + 1] = {\n'
+	s += '\t' + ', '.join('%d' % i for i in idx) + '\n};\n\n'
+
+	# Split arrays so the u16 offsets do not get padded to the u32 values.
+	for name, ctype, fmt, field in (('_dram_cfg_delta_off', 'u16', '0x%03X', 0), ('_dram_cfg_delta_val', 'u32', '0x%08X', 1)):
+		s += 'static const %s %s[%d] = {\n' % (ctype, name, max(len(deltas), 1))
+		for sdram_id in range(len(idx) - 1):
+			entries = deltas[idx[sdram_id]:idx[sdram_id + 1]]
+			if not entries:
+				continue
+			s += '\t// DRAM id %d.\n' % sdram_id
+			for i in range(0, len(entries), 8 if field else 12):
+				s += '\t' + ', '.join(fmt % e[field] for e in entries[i:i + (8 if field else 12)]) + ',\n'
+		if not deltas:
+			s += '\t0,\n'
+		s = s[:-2] + '\n};\n\n'
+
+	return s[:-1]
+
+def parse(text):
+	def array(name):
+		m = re.search(r'%s\[[^\]]*\] = \{(.*?)\};' % name, text, re.S)
+		return [int(x, 0) for x in re.findall(r'0x[0-9A-Fa-f]+|\d+', re.sub(r'//.*', '', m.group(1)))]
+
+	base_lz = bytes(array('_dram_cfg_base_lz'))
+	idx = array('_dram_cfg_delta_idx')
+	deltas = list(zip(array('_dram_cfg_delta_off'), array('_dram_cfg_delta_val')))[:idx[-1]]
+	return base_lz, idx, deltas
+
+def main(argv):
+	if len(argv) == 4 and argv[1] == '--dump':
+		base_lz, idx, deltas = parse(open(argv[2]).read())
+		with open(argv[3], 'wb') as f:
+			for sdram_id in range(len(idx) - 1):
+				f.write(unpack(base_lz, idx, deltas, sdram_id))
+		return 0
+
+	if len(argv) != 4:
+		print('usage: %s <tables.bin> <count> <out.inl>' % argv[0])
+		print('       %s --dump <in.inl> <tables.bin>' % argv[0])
+		return 1
+
+	data = open(argv[1], 'rb').read()
+	count = int(argv[2], 0)
+	if not count or len(data) % count or (len(data) // count) % 4:
+		print('%s does not hold %d word aligned tables' % (argv[1], count))
+		return 1
+
+	size = len(data) // count
+	tables = [data[i * size:(i + 1) * size] for i in range(count)]
+	base, base_lz, idx, deltas = pack(tables)
+	if max(off for off, _ in deltas or [(0, 0)]) > 0xFFFF or idx[-1] > 0xFFFF:
+		print('tables are too large for 16-bit delta indices')
+		return 1
+
+	text = emit(base, base_lz, idx, deltas, size)
+
+	# Round trip through the emitted source, exactly what sdram.c will see.
+	base_lz, idx, deltas = parse(text)
+	for sdram_id, t in enumerate(tables):
+		if unpack(base_lz, idx, deltas, sdram_id) != t:
+			print('round trip failed for DRAM id %d' % sdram_id)
+			return 1
+
+	with open(argv[3], 'w') as f:
+		f.write(text)
+
+	print('%d tables of %d bytes: base id %d, %d bytes packed, %d deltas' %
+		(count, size, base, len(base_lz), len(deltas)))
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 DragonInjector Project
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Converts a splash BMP to the compressed format of gfx_render_splash_file.
+#
+# The BMP is laid out like the one gfx_render_splash takes, already in
+# framebuffer orientation. Its rows are centered and padded to whole
+# framebuffer rows with the colour of its first pixel, then the lot is
+# compressed with the lz4 tool. The decoder only has to place the rows.
+#
+# usage: splash.py <in.bmp> <out.bin>
+
+import struct
+import subprocess
+import sys
+
+SPLASH_MAGIC = 0x50534244 # "DBSP", GFX_SPLASH_MAGIC in gfx.h.
+
+FB_ROWS = 1280
+FB_ROW_PIXELS = 720
+FB_STRIDE = 768
+
+def read_bmp(data):
+	# Returns the rows top to bottom as lists of ARGB words, and the first pixel.
+	if data[:2] != b'BM':
+		raise SystemExit('not a BMP file')
+	offset, = struct.unpack_from('<I', data, 10)
+	width, height, planes, bpp, compression = struct.unpack_from('<iiHHI', data, 18)
+	if bpp not in (24, 32) or compression not in (0, 3) or (bpp == 24 and compression):
+		raise SystemExit('only uncompressed 24 and 32-bit BMP files are supported')
+
+	top_down = height < 0
+	height = abs(height)
+	row_size = (width * bpp // 8 + 3) & ~3
+	if width <= 0 or not height or offset + row_size * height > len(data):
+		raise SystemExit('truncated BMP file')
+
+	rows = []
+	for y in range(height):
+		row = data[offset + y * row_size:offset + y * row_size + width * bpp // 8]
+		if bpp == 32:
+			rows.append(list(struct.unpack('<%dI' % width, row)))
+		else:
+			rows.append([0xFF000000 | row[i] | row[i + 1] << 8 | row[i + 2] << 16
+				for i in range(0, len(row), 3)])
+	first = rows[0][0]
+	if not top_down:
+		rows.reverse()
+	return rows, first
+
+def main(argv):
+	if len(argv) != 3:
+		print('usage: %s <in.bmp> <out.bin>' % argv[0])
+		return 1
+
+	bmp = open(argv[1], 'rb').read()
+	rows, bg = read_bmp(bmp)
+	width = len(rows[0])
+	if width > FB_ROW_PIXELS or len(rows) > FB_ROWS:
+		print('%s is larger than %dx%d' % (argv[1], FB_ROW_PIXELS, FB_ROWS))
+		return 1
+
+	left = (FB_ROW_PIXELS - width) >> 1
+	right = FB_STRIDE - left - width
+	pixels = b''.join(struct.pack('<%dI' % FB_STRIDE, *([bg] * left + row + [bg] * right)) for row in rows)
+
+	lz4 = subprocess.run(['lz4', '-c', '-f', '-l', '-9'], input=pixels, stdout=subprocess.PIPE, check=True).stdout
+
+	with open(argv[2], 'wb') as f:
+		f.write(struct.pack('<IHHI', SPLASH_MAGIC, FB_STRIDE, len(rows), bg))
+		f.write(lz4)
+
+	print('%s: %d bytes, splash %d bytes' % (argv[1], len(bmp), 12 + len(lz4)))
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))